@@ -44,7 +44,10 @@ import argparse
 import m5
 from gem5.utils.requires import requires
 from gem5.components.boards.x86_board import X86Board
-from gem5.components.memory.single_channel import DIMM_DDR5_4400, SingleChannelDDR4_3200
+from gem5.components.memory.single_channel import DIMM_DDR5_4400, SingleChannelDDR4_3200, SingleChannelNVM_2400
+from gem5.components.memory.simple import SingleChannelSimpleMemory
+from gem5.components.memory.hetero import HeteroMemory
+from gem5.components.memory.flash import FlashMemory
 from gem5.components.processors.simple_switchable_processor import (
     SimpleSwitchableProcessor,
 )
@@ -75,28 +78,106 @@ parser.add_argument('--test_cmd', type=str, choices=['lmbench_cxl.sh',
                                                      ], default='lmbench_cxl.sh', help='Choose a test to run.')
 parser.add_argument('--num_cpus', type=int, default=1, help='Number of CPUs')
 parser.add_argument('--cpu_type', type=str, choices=['TIMING', 'O3'], default='TIMING', help='CPU type')
-parser.add_argument('--cxl_mem_type', type=str, choices=['Simple', 'DRAM'], default='DRAM', help='CXL memory type')
+parser.add_argument('--cxl_mem_type', type=str, choices=['Simple', 'DRAM', 'NVM', 'Hybrid', 'Flash'], default='DRAM', help='CXL memory type: DRAM, NVM, half DRAM and half NVM behind one controller, or flash behind a DRAM cache')
+parser.add_argument('--cxl_flash_cache', type=str, default='512MiB', help='Internal DRAM cache of each flash CXL device')
+parser.add_argument('--cxl_flash_read_lat', type=str, default='3us', help='Page read latency of the flash of the CXL devices')
+parser.add_argument('--cxl_link_lanes', type=int, choices=[1, 2, 4, 8, 16], default=16, help='Width of the CXL link')
+parser.add_argument('--cxl_link_gen', type=str, choices=['PCIe5', 'PCIe6'], default='PCIe5', help='PCIe generation of the CXL link')
+parser.add_argument('--cxl_flit_size', type=int, choices=[68, 256], default=68, help='CXL flit size in bytes')
+parser.add_argument('--cxl_num_devices', type=int, choices=[1, 2, 4, 8, 16], default=1, help='Number of interleaved CXL devices')
+parser.add_argument('--cxl_intlv_gran', type=int, choices=[256, 512, 1024, 2048, 4096, 8192, 16384], default=4096, help='HDM interleave granularity in bytes')
+parser.add_argument('--cxl_switch', action='store_true', help='Put the CXL devices behind a CXL switch')
+parser.add_argument('--cxl_pool_hosts', type=int, default=1, help='Number of host partitions pooling a single CXL device')
+parser.add_argument('--cxl_dc_block', type=str, default='256MiB', help='Dynamic capacity block size of a pooled CXL device')
+parser.add_argument('--cxl_shared_blocks', type=int, default=0, help='Dynamic capacity blocks of a pooled CXL device shared by all host partitions')
+parser.add_argument('--cxl_hotness_page', type=str, default=None, help='Page size of the hotness tracker of the CXL devices, off if not given')
+parser.add_argument('--cxl_hotness_decay', type=str, default='0ns', help='Period after which the CXL hotness counters are halved')
+parser.add_argument('--cxl_snoop_filter', type=int, default=0, help='Lines tracked by the snoop filter of an HDM-DB CXL device, 0 for HDM-H')
+parser.add_argument('--cxl_migration_region', type=str, default=None, help='Host DRAM reserved for hot pages migrated out of the CXL memory, off if not given')
+parser.add_argument('--cxl_migration_interval', type=str, default='100us', help='Interval between two rounds of CXL page migration')
+parser.add_argument('--cxl_migration_threshold', type=int, default=64, help='Accesses in an interval that make a CXL page hot')
+parser.add_argument('--cxl_dram_cache', type=str, default=None, help='Host DRAM used as a memory-side cache in front of the CXL memory, off if not given')
+parser.add_argument('--cxl_dram_cache_assoc', type=int, default=1, help='Associativity of the DRAM cache, 1 for direct-mapped')
+parser.add_argument('--cxl_dram_cache_tags', type=str, choices=['Sram', 'Ecc'], default='Sram', help='Tags of the DRAM cache in an SRAM tag store or in the ECC bits of host DRAM')
+parser.add_argument('--cxl_backdoor_lat', type=str, default='0ns', help='Media latency of the atomic accesses a CXL device serves through the backdoor of its media, 0 to send them to the media')
+parser.add_argument('--cache_hierarchy', type=str, choices=['classic', 'mesi_three_level', 'chi'], default='classic', help='Classic caches, or Ruby MESI_Three_Level or CHI caches with a directory or subordinate node for the CXL memory (needs a build of that protocol)')
+parser.add_argument('--chi_dmt', type=str, choices=['True', 'False'], default='True', help='Let the CHI memory controllers send read data straight to the requestor (direct memory transfer)')
+parser.add_argument('--cxl_preload', type=str, action='append', default=[], metavar='FILE[@OFFSET]', help='Host file copied into the CXL memory before the simulation, at the given offset (default 0); may be repeated')
+parser.add_argument('--cxl_latency_breakdown', action='store_true', help='Break the latency of every CXL access down into its stages')
+parser.add_argument('--cxl_latency_trace', type=str, default=None, help='Binary file in the output directory the latency breakdown of every CXL access is written to')
+parser.add_argument('--cxl_scheduler', type=str, choices=['FIFO', 'ReadFirst', 'BankAware'], default='FIFO', help='Policy a CXL device picks the next request for its media with')
+parser.add_argument('--cxl_qos_throttle', action='store_true', help='Throttle the host requests to the CXL devices by the DevLoad they report')
+parser.add_argument('--cxl_no_numa', action='store_true', help='Do not describe the CXL memory as a NUMA node in the ACPI tables, e.g. for a kernel patched to find it')
+parser.add_argument('--cxl_compressor', type=str, choices=['BDI', 'CPack', 'FPC', 'Zero'], default=None, help='Compress the media of the CXL devices inline with this algorithm, off if not given')
+parser.add_argument('--cxl_compression_page', type=str, default=None, help='Compress the CXL media in pages of this size rather than in lines')
+parser.add_argument('--cxl_prefetcher', type=str, choices=['Stride', 'BOP', 'SPP'], default=None, help='Read the CXL media ahead into a prefetch buffer in the device with this prefetcher, off if not given')
+parser.add_argument('--cxl_prefetch_buffer', type=int, default=64, help='Lines the prefetch buffer of each CXL device holds')
+parser.add_argument('--cxl_nmp', type=str, default=None, help='Give each CXL device a near-memory processing engine with a buffer of this size, off if not given')
 
 args = parser.parse_args()
 
-# Here we setup a MESI Three Level Cache Hierarchy.
-cache_hierarchy = PrivateL1PrivateL2SharedL3CacheHierarchy(
-    l1d_size="48kB",
-    l1d_assoc=6,
-    l1i_size="32kB",
-    l1i_assoc=8,
-    l2_size="2MB",
-    l2_assoc=16,
-    l3_size="96MB",
-    l3_assoc=48,
-)
+cxl_preload = []
+for spec in args.cxl_preload:
+    path, sep, offset = spec.rpartition('@')
+    cxl_preload.append((path, int(offset, 0)) if sep else (spec, 0))
+
+# Here we setup the cache hierarchy, classic or Ruby.
+if args.cache_hierarchy == 'mesi_three_level':
+    from gem5.components.cachehierarchies.ruby.mesi_three_level_cache_hierarchy import (
+        MESIThreeLevelCacheHierarchy,
+    )
+
+    cache_hierarchy = MESIThreeLevelCacheHierarchy(
+        l1d_size="48kB",
+        l1d_assoc=6,
+        l1i_size="32kB",
+        l1i_assoc=8,
+        l2_size="2MB",
+        l2_assoc=16,
+        l3_size="96MB",
+        l3_assoc=48,
+        num_l3_banks=1,
+    )
+elif args.cache_hierarchy == 'chi':
+    from gem5.components.cachehierarchies.chi.private_l1_cache_hierarchy import (
+        PrivateL1CacheHierarchy,
+    )
+
+    cache_hierarchy = PrivateL1CacheHierarchy(
+        size="48kB",
+        assoc=6,
+        enable_dmt=(args.chi_dmt == 'True'),
+    )
+else:
+    cache_hierarchy = PrivateL1PrivateL2SharedL3CacheHierarchy(
+        l1d_size="48kB",
+        l1d_assoc=6,
+        l1i_size="32kB",
+        l1i_assoc=8,
+        l2_size="2MB",
+        l2_assoc=16,
+        l3_size="96MB",
+        l3_assoc=48,
+    )
 
 # Setup the system memory.
 memory = DIMM_DDR5_4400(size="3GB")
-if args.is_asic:
-    cxl_memory = DIMM_DDR5_4400(size="8GB")
-else:
-    cxl_memory = SingleChannelDDR4_3200(size="8GB")
+# every device brings its own media, the devices share the 8GB window
+cxl_dev_mb = 8192 // args.cxl_num_devices
+cxl_dev_size = f"{cxl_dev_mb}MB"
+def cxl_media():
+    if args.cxl_mem_type == 'Simple':
+        return SingleChannelSimpleMemory(latency="50ns", latency_var="0ns", bandwidth="32GiB/s", size=cxl_dev_size)
+    if args.cxl_mem_type == 'NVM':
+        return SingleChannelNVM_2400(size=cxl_dev_size)
+    if args.cxl_mem_type == 'Hybrid':
+        return HeteroMemory(dram_size=f"{cxl_dev_mb // 2}MB", nvm_size=f"{cxl_dev_mb // 2}MB")
+    if args.cxl_mem_type == 'Flash':
+        return FlashMemory(size=cxl_dev_size, cache_size=args.cxl_flash_cache, read_latency=args.cxl_flash_read_lat)
+    if args.is_asic:
+        return DIMM_DDR5_4400(size=cxl_dev_size)
+    return SingleChannelDDR4_3200(size=cxl_dev_size)
+cxl_memory = [cxl_media() for _ in range(args.cxl_num_devices)]
 # Here we setup the processor. This is a special switchable processor in which
 # a starting core type and a switch core type must be specified. Once a
 # configuration is instantiated a user may call `processor.switch()` to switch
@@ -118,7 +199,36 @@ board = X86Board(
     memory=memory,
     cache_hierarchy=cache_hierarchy,
     cxl_memory=cxl_memory,
-    is_asic=(args.is_asic == 'True')
+    is_asic=(args.is_asic == 'True'),
+    cxl_link_lanes=args.cxl_link_lanes,
+    cxl_link_gen=args.cxl_link_gen,
+    cxl_flit_size=args.cxl_flit_size,
+    cxl_intlv_granularity=args.cxl_intlv_gran,
+    cxl_switch=args.cxl_switch,
+    cxl_pool_hosts=args.cxl_pool_hosts,
+    cxl_dc_block_size=args.cxl_dc_block,
+    cxl_pool_shared_blocks=args.cxl_shared_blocks,
+    cxl_snoop_filter_entries=args.cxl_snoop_filter,
+    cxl_hotness_page_size=args.cxl_hotness_page,
+    cxl_hotness_decay=args.cxl_hotness_decay,
+    cxl_migration_region_size=args.cxl_migration_region,
+    cxl_migration_interval=args.cxl_migration_interval,
+    cxl_migration_threshold=args.cxl_migration_threshold,
+    cxl_dram_cache_size=args.cxl_dram_cache,
+    cxl_dram_cache_assoc=args.cxl_dram_cache_assoc,
+    cxl_dram_cache_tags=args.cxl_dram_cache_tags,
+    cxl_backdoor_media_latency=args.cxl_backdoor_lat,
+    cxl_preload=cxl_preload,
+    cxl_latency_breakdown=args.cxl_latency_breakdown,
+    cxl_latency_trace=args.cxl_latency_trace,
+    cxl_scheduler=args.cxl_scheduler,
+    cxl_qos_throttle=args.cxl_qos_throttle,
+    cxl_numa=not args.cxl_no_numa,
+    cxl_compressor=args.cxl_compressor,
+    cxl_compression_page_size=args.cxl_compression_page,
+    cxl_prefetcher=args.cxl_prefetcher,
+    cxl_prefetch_buffer_entries=args.cxl_prefetch_buffer,
+    cxl_nmp_buffer_size=args.cxl_nmp,
 )
 
 # Here we set the Full System workload.
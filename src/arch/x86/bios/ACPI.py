@@ -137,6 +137,158 @@ class X86ACPIMadtLAPICOverride(X86ACPIMadtRecord):
     address = Param.Addr(0, "64-bit Physical Address of Local APIC")
 
 
+class X86ACPISratRecord(SimObject):
+    type = "X86ACPISratRecord"
+    cxx_class = "gem5::X86ISA::ACPI::SRAT::Record"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    abstract = True
+
+
+class X86ACPISrat(X86ACPISysDescTable):
+    type = "X86ACPISrat"
+    cxx_class = "gem5::X86ISA::ACPI::SRAT::SRAT"
+    cxx_header = "arch/x86/bios/acpi.hh"
+
+    records = VectorParam.X86ACPISratRecord([], "Records in this SRAT")
+
+
+class X86ACPISratLAPICAffinity(X86ACPISratRecord):
+    type = "X86ACPISratLAPICAffinity"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    cxx_class = "gem5::X86ISA::ACPI::SRAT::LAPICAffinity"
+
+    proximity_domain = Param.UInt32(0, "Proximity domain of the processor")
+    apic_id = Param.UInt8(0, "APIC ID")
+    flags = Param.UInt32(1, "Flags (bit 0: enabled)")
+    clock_domain = Param.UInt32(0, "Clock domain of the processor")
+
+
+class X86ACPISratMemAffinity(X86ACPISratRecord):
+    type = "X86ACPISratMemAffinity"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    cxx_class = "gem5::X86ISA::ACPI::SRAT::MemAffinity"
+
+    proximity_domain = Param.UInt32(0, "Proximity domain of the memory")
+    base = Param.Addr(0, "Base address of the memory range")
+    size = Param.MemorySize("0B", "Size of the memory range")
+    flags = Param.UInt32(
+        1, "Flags (bit 0: enabled, bit 1: hot-pluggable, bit 2: non-volatile)"
+    )
+
+
+class X86ACPISlit(X86ACPISysDescTable):
+    type = "X86ACPISlit"
+    cxx_class = "gem5::X86ISA::ACPI::SLIT"
+    cxx_header = "arch/x86/bios/acpi.hh"
+
+    localities = Param.UInt32(0, "Number of proximity domains")
+    distances = VectorParam.UInt8(
+        [],
+        "Relative distance between each pair of proximity domains, row by "
+        "row, 10 for a domain to itself",
+    )
+
+
+class X86ACPIHmatRecord(SimObject):
+    type = "X86ACPIHmatRecord"
+    cxx_class = "gem5::X86ISA::ACPI::HMAT::Record"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    abstract = True
+
+
+class X86ACPIHmat(X86ACPISysDescTable):
+    type = "X86ACPIHmat"
+    cxx_class = "gem5::X86ISA::ACPI::HMAT::HMAT"
+    cxx_header = "arch/x86/bios/acpi.hh"
+
+    records = VectorParam.X86ACPIHmatRecord([], "Records in this HMAT")
+
+
+class X86ACPIHmatProximityDomain(X86ACPIHmatRecord):
+    type = "X86ACPIHmatProximityDomain"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    cxx_class = "gem5::X86ISA::ACPI::HMAT::ProximityDomain"
+
+    flags = Param.UInt16(0, "Flags (bit 0: initiator domain valid)")
+    initiator_domain = Param.UInt32(
+        0, "Proximity domain of the initiator attached to the memory"
+    )
+    memory_domain = Param.UInt32(0, "Proximity domain of the memory")
+
+
+class X86ACPIHmatLocality(X86ACPIHmatRecord):
+    type = "X86ACPIHmatLocality"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    cxx_class = "gem5::X86ISA::ACPI::HMAT::Locality"
+
+    flags = Param.UInt8(0, "Memory hierarchy (0: memory, 1-3: cache level)")
+    data_type = Param.UInt8(
+        0,
+        "Data type (0-2: access, read, write latency, 3-5: access, read, "
+        "write bandwidth)",
+    )
+    min_transfer_size = Param.UInt8(0, "Minimum transfer size")
+    entry_base_unit = Param.UInt64(
+        1,
+        "Multiplier of the entries, giving picoseconds or MB/s",
+    )
+    initiator_domains = VectorParam.UInt32([], "Initiator proximity domains")
+    target_domains = VectorParam.UInt32([], "Target proximity domains")
+    entries = VectorParam.UInt16(
+        [], "Latency or bandwidth from each initiator to each target, row "
+        "by row of initiators"
+    )
+
+
+class X86ACPICedtRecord(SimObject):
+    type = "X86ACPICedtRecord"
+    cxx_class = "gem5::X86ISA::ACPI::CEDT::Record"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    abstract = True
+
+
+class X86ACPICedt(X86ACPISysDescTable):
+    type = "X86ACPICedt"
+    cxx_class = "gem5::X86ISA::ACPI::CEDT::CEDT"
+    cxx_header = "arch/x86/bios/acpi.hh"
+
+    records = VectorParam.X86ACPICedtRecord([], "Records in this CEDT")
+
+
+class X86ACPICedtCHBS(X86ACPICedtRecord):
+    type = "X86ACPICedtCHBS"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    cxx_class = "gem5::X86ISA::ACPI::CEDT::CHBS"
+
+    uid = Param.UInt32(0, "UID of the CXL host bridge")
+    cxl_version = Param.UInt32(1, "CXL version (0: 1.1, 1: 2.0 or later)")
+    base = Param.Addr(0, "Base address of the host bridge registers")
+    length = Param.UInt64(0, "Size of the host bridge registers")
+
+
+class X86ACPICedtCFMWS(X86ACPICedtRecord):
+    type = "X86ACPICedtCFMWS"
+    cxx_header = "arch/x86/bios/acpi.hh"
+    cxx_class = "gem5::X86ISA::ACPI::CEDT::CFMWS"
+
+    base = Param.Addr(0, "Base host physical address of the window")
+    size = Param.MemorySize("0B", "Size of the window")
+    interleave_ways = Param.UInt8(
+        0, "Encoded number of host bridges interleaved, log2 of the ways"
+    )
+    interleave_arithmetic = Param.UInt8(0, "0: modulo, 1: modulo XOR")
+    granularity = Param.UInt32(
+        0, "Encoded host bridge interleave granularity, log2 of it minus 8"
+    )
+    restrictions = Param.UInt16(
+        0,
+        "Window restrictions (bit 0: device coherent, bit 1: host-only "
+        "coherent, bit 2: volatile, bit 3: persistent, bit 4: fixed)",
+    )
+    qtg_id = Param.UInt16(0, "QoS throttling group of the window")
+    targets = VectorParam.UInt32([], "UIDs of the interleaved host bridges")
+
+
 # Root System Description Pointer Structure
 class X86ACPIRSDP(SimObject):
     type = "X86ACPIRSDP"
@@ -331,6 +331,284 @@ MADT::LAPICOverride::prepareBuf(std::vector<uint8_t>& mem) const
     Record::prepareBuf(mem);
 }
 
+//// SRAT
+SRAT::SRAT::SRAT(const Params& p) :
+    SysDescTable(p, "SRAT", 3),
+    records(p.records)
+{}
+
+Addr
+SRAT::SRAT::writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+        std::vector<uint8_t>& mem) const
+{
+    // Since this table ends with a variably sized array, it can't be extended
+    // by another table type.
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    // the first reserved field is 1 for backward compatibility
+    Mem* header = reinterpret_cast<Mem*>(mem.data());
+    header->_reserved0 = 1;
+
+    for (const auto& record : records) {
+        auto entry = record->prepare();
+        mem.insert(mem.end(), entry.begin(), entry.end());
+    }
+
+    DPRINTF(ACPI, "SRAT: writing %d records (size: %d)\n",
+            records.size(), mem.size());
+
+    return SysDescTable::writeBuf(phys_proxy, alloc, mem);
+}
+
+void
+SRAT::Record::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.size() >= sizeof(Mem));
+    DPRINTF(ACPI, "SRAT: writing record type %d (size: %d)\n",
+            type, mem.size());
+
+    Mem* header = reinterpret_cast<Mem*>(mem.data());
+    header->type = type;
+    header->length = mem.size();
+}
+
+void
+SRAT::LAPICAffinity::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    // the proximity domain is split into its low byte and the three
+    // bytes above it
+    Mem* data = reinterpret_cast<Mem*>(mem.data());
+    const uint32_t domain = params().proximity_domain;
+    data->proximityDomainLo = domain;
+    data->proximityDomainHi[0] = domain >> 8;
+    data->proximityDomainHi[1] = domain >> 16;
+    data->proximityDomainHi[2] = domain >> 24;
+    data->apicId = params().apic_id;
+    data->flags = params().flags;
+    data->clockDomain = params().clock_domain;
+
+    Record::prepareBuf(mem);
+}
+
+void
+SRAT::MemAffinity::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    Mem* data = reinterpret_cast<Mem*>(mem.data());
+    data->proximityDomain = params().proximity_domain;
+    data->baseAddress = params().base;
+    data->length = params().size;
+    data->flags = params().flags;
+
+    Record::prepareBuf(mem);
+}
+
+//// SLIT
+SLIT::SLIT(const Params& p) :
+    SysDescTable(p, "SLIT", 1)
+{
+    fatal_if(p.distances.size() != p.localities * p.localities,
+             "SLIT: need a distance for every pair of %d localities.\n",
+             p.localities);
+}
+
+Addr
+SLIT::writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+        std::vector<uint8_t>& mem) const
+{
+    // Since this table ends with a variably sized array, it can't be extended
+    // by another table type.
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    Mem* header = reinterpret_cast<Mem*>(mem.data());
+    header->localities = params().localities;
+
+    mem.insert(mem.end(), params().distances.begin(),
+               params().distances.end());
+
+    DPRINTF(ACPI, "SLIT: writing %d localities (size: %d)\n",
+            params().localities, mem.size());
+
+    return SysDescTable::writeBuf(phys_proxy, alloc, mem);
+}
+
+//// HMAT
+HMAT::HMAT::HMAT(const Params& p) :
+    SysDescTable(p, "HMAT", 2),
+    records(p.records)
+{}
+
+Addr
+HMAT::HMAT::writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+        std::vector<uint8_t>& mem) const
+{
+    // Since this table ends with a variably sized array, it can't be extended
+    // by another table type.
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    for (const auto& record : records) {
+        auto entry = record->prepare();
+        mem.insert(mem.end(), entry.begin(), entry.end());
+    }
+
+    DPRINTF(ACPI, "HMAT: writing %d records (size: %d)\n",
+            records.size(), mem.size());
+
+    return SysDescTable::writeBuf(phys_proxy, alloc, mem);
+}
+
+void
+HMAT::Record::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.size() >= sizeof(Mem));
+    DPRINTF(ACPI, "HMAT: writing record type %d (size: %d)\n",
+            type, mem.size());
+
+    Mem* header = reinterpret_cast<Mem*>(mem.data());
+    header->type = type;
+    header->length = mem.size();
+}
+
+void
+HMAT::ProximityDomain::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    Mem* data = reinterpret_cast<Mem*>(mem.data());
+    data->flags = params().flags;
+    data->initiatorDomain = params().initiator_domain;
+    data->memoryDomain = params().memory_domain;
+
+    Record::prepareBuf(mem);
+}
+
+HMAT::Locality::Locality(const Params& p) : Record(p, 1)
+{
+    fatal_if(p.entries.size() !=
+             p.initiator_domains.size() * p.target_domains.size(),
+             "HMAT: need an entry for every initiator and target domain.\n");
+}
+
+void
+HMAT::Locality::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    Mem* data = reinterpret_cast<Mem*>(mem.data());
+    data->flags = params().flags;
+    data->dataType = params().data_type;
+    data->minTransferSize = params().min_transfer_size;
+    data->numInitiators = params().initiator_domains.size();
+    data->numTargets = params().target_domains.size();
+    data->entryBaseUnit = params().entry_base_unit;
+
+    // the domain lists and then the entries, row by row of initiators
+    auto append = [&mem](const auto &values) {
+        for (auto value : values) {
+            auto bytes = reinterpret_cast<const uint8_t *>(&value);
+            mem.insert(mem.end(), bytes, bytes + sizeof(value));
+        }
+    };
+    append(params().initiator_domains);
+    append(params().target_domains);
+    append(params().entries);
+
+    Record::prepareBuf(mem);
+}
+
+//// CEDT
+CEDT::CEDT::CEDT(const Params& p) :
+    SysDescTable(p, "CEDT", 1),
+    records(p.records)
+{}
+
+Addr
+CEDT::CEDT::writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+        std::vector<uint8_t>& mem) const
+{
+    // Since this table ends with a variably sized array, it can't be extended
+    // by another table type.
+    assert(mem.empty());
+    mem.resize(sizeof(SysDescTable::Mem));
+
+    for (const auto& record : records) {
+        auto entry = record->prepare();
+        mem.insert(mem.end(), entry.begin(), entry.end());
+    }
+
+    DPRINTF(ACPI, "CEDT: writing %d records (size: %d)\n",
+            records.size(), mem.size());
+
+    return SysDescTable::writeBuf(phys_proxy, alloc, mem);
+}
+
+void
+CEDT::Record::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.size() >= sizeof(Mem));
+    DPRINTF(ACPI, "CEDT: writing record type %d (size: %d)\n",
+            type, mem.size());
+
+    Mem* header = reinterpret_cast<Mem*>(mem.data());
+    header->type = type;
+    header->length = mem.size();
+}
+
+void
+CEDT::CHBS::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    Mem* data = reinterpret_cast<Mem*>(mem.data());
+    data->uid = params().uid;
+    data->cxlVersion = params().cxl_version;
+    data->base = params().base;
+    data->length = params().length;
+
+    Record::prepareBuf(mem);
+}
+
+CEDT::CFMWS::CFMWS(const Params& p) : Record(p, 1)
+{
+    fatal_if(p.targets.size() != (size_t(1) << p.interleave_ways),
+             "CFMWS: need a target host bridge for each of the %d "
+             "interleave ways.\n", 1 << p.interleave_ways);
+}
+
+void
+CEDT::CFMWS::prepareBuf(std::vector<uint8_t>& mem) const
+{
+    assert(mem.empty());
+    mem.resize(sizeof(Mem));
+
+    Mem* data = reinterpret_cast<Mem*>(mem.data());
+    data->baseHPA = params().base;
+    data->windowSize = params().size;
+    data->interleaveWays = params().interleave_ways;
+    data->interleaveArithmetic = params().interleave_arithmetic;
+    data->granularity = params().granularity;
+    data->restrictions = params().restrictions;
+    data->qtgId = params().qtg_id;
+
+    for (uint32_t target : params().targets) {
+        auto bytes = reinterpret_cast<const uint8_t *>(&target);
+        mem.insert(mem.end(), bytes, bytes + sizeof(target));
+    }
+
+    Record::prepareBuf(mem);
+}
+
 } // namespace ACPI
 
 } // namespace X86ISA
@@ -46,6 +46,14 @@
 #include "base/compiler.hh"
 #include "base/types.hh"
 #include "debug/ACPI.hh"
+#include "params/X86ACPICedt.hh"
+#include "params/X86ACPICedtCFMWS.hh"
+#include "params/X86ACPICedtCHBS.hh"
+#include "params/X86ACPICedtRecord.hh"
+#include "params/X86ACPIHmat.hh"
+#include "params/X86ACPIHmatLocality.hh"
+#include "params/X86ACPIHmatProximityDomain.hh"
+#include "params/X86ACPIHmatRecord.hh"
 #include "params/X86ACPIMadt.hh"
 #include "params/X86ACPIMadtIOAPIC.hh"
 #include "params/X86ACPIMadtIntSourceOverride.hh"
@@ -55,6 +63,11 @@
 #include "params/X86ACPIMadtRecord.hh"
 #include "params/X86ACPIRSDP.hh"
 #include "params/X86ACPIRSDT.hh"
+#include "params/X86ACPISlit.hh"
+#include "params/X86ACPISrat.hh"
+#include "params/X86ACPISratLAPICAffinity.hh"
+#include "params/X86ACPISratMemAffinity.hh"
+#include "params/X86ACPISratRecord.hh"
 #include "params/X86ACPISysDescTable.hh"
 #include "params/X86ACPIXSDT.hh"
 #include "sim/sim_object.hh"
@@ -359,6 +372,343 @@ class MADT : public SysDescTable
 
 } // namespace MADT
 
+namespace SRAT
+{
+class Record : public SimObject
+{
+  protected:
+    PARAMS(X86ACPISratRecord);
+
+    struct GEM5_PACKED Mem
+    {
+        uint8_t type = 0;
+        uint8_t length = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    uint8_t type;
+
+    virtual void prepareBuf(std::vector<uint8_t>& mem) const = 0;
+
+  public:
+    Record(const Params& p, uint8_t _type) : SimObject(p), type(_type) {}
+
+    std::vector<uint8_t>
+    prepare() const
+    {
+        std::vector<uint8_t> mem;
+        prepareBuf(mem);
+        return mem;
+    }
+};
+
+class LAPICAffinity : public Record
+{
+  protected:
+    PARAMS(X86ACPISratLAPICAffinity);
+
+    struct GEM5_PACKED Mem : public Record::Mem
+    {
+        uint8_t proximityDomainLo = 0;
+        uint8_t apicId = 0;
+        uint32_t flags = 0;
+        uint8_t localSapicEid = 0;
+        uint8_t proximityDomainHi[3] = {};
+        uint32_t clockDomain = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    void prepareBuf(std::vector<uint8_t>& mem) const override;
+
+  public:
+    LAPICAffinity(const Params& p) : Record(p, 0) {}
+};
+
+class MemAffinity : public Record
+{
+  protected:
+    PARAMS(X86ACPISratMemAffinity);
+
+    struct GEM5_PACKED Mem : public Record::Mem
+    {
+        uint32_t proximityDomain = 0;
+        uint16_t _reserved0 = 0;
+        uint64_t baseAddress = 0;
+        uint64_t length = 0;
+        uint32_t _reserved1 = 0;
+        uint32_t flags = 0;
+        uint64_t _reserved2 = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    void prepareBuf(std::vector<uint8_t>& mem) const override;
+
+  public:
+    MemAffinity(const Params& p) : Record(p, 1) {}
+};
+
+/**
+ * System Resource Affinity Table, which puts the processors and the
+ * memory ranges into proximity domains, i.e. NUMA nodes.
+ */
+class SRAT : public SysDescTable
+{
+  protected:
+    PARAMS(X86ACPISrat);
+
+    struct GEM5_PACKED Mem : public SysDescTable::Mem
+    {
+        uint32_t _reserved0 = 0;
+        uint64_t _reserved1 = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    std::vector<Record *> records;
+
+    Addr writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+            std::vector<uint8_t>& mem) const override;
+
+  public:
+    SRAT(const Params &p);
+};
+
+} // namespace SRAT
+
+/**
+ * System Locality Information Table, the relative distances between
+ * the proximity domains.
+ */
+class SLIT : public SysDescTable
+{
+  protected:
+    PARAMS(X86ACPISlit);
+
+    struct GEM5_PACKED Mem : public SysDescTable::Mem
+    {
+        uint64_t localities = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    Addr writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+            std::vector<uint8_t>& mem) const override;
+
+  public:
+    SLIT(const Params &p);
+};
+
+namespace HMAT
+{
+class Record : public SimObject
+{
+  protected:
+    PARAMS(X86ACPIHmatRecord);
+
+    struct GEM5_PACKED Mem
+    {
+        uint16_t type = 0;
+        uint16_t _reserved = 0;
+        uint32_t length = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    uint16_t type;
+
+    virtual void prepareBuf(std::vector<uint8_t>& mem) const = 0;
+
+  public:
+    Record(const Params& p, uint16_t _type) : SimObject(p), type(_type) {}
+
+    std::vector<uint8_t>
+    prepare() const
+    {
+        std::vector<uint8_t> mem;
+        prepareBuf(mem);
+        return mem;
+    }
+};
+
+class ProximityDomain : public Record
+{
+  protected:
+    PARAMS(X86ACPIHmatProximityDomain);
+
+    struct GEM5_PACKED Mem : public Record::Mem
+    {
+        uint16_t flags = 0;
+        uint16_t _reserved0 = 0;
+        uint32_t initiatorDomain = 0;
+        uint32_t memoryDomain = 0;
+        uint32_t _reserved1 = 0;
+        uint64_t _reserved2 = 0;
+        uint64_t _reserved3 = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    void prepareBuf(std::vector<uint8_t>& mem) const override;
+
+  public:
+    ProximityDomain(const Params& p) : Record(p, 0) {}
+};
+
+class Locality : public Record
+{
+  protected:
+    PARAMS(X86ACPIHmatLocality);
+
+    struct GEM5_PACKED Mem : public Record::Mem
+    {
+        uint8_t flags = 0;
+        uint8_t dataType = 0;
+        uint8_t minTransferSize = 0;
+        uint8_t _reserved0 = 0;
+        uint32_t numInitiators = 0;
+        uint32_t numTargets = 0;
+        uint32_t _reserved1 = 0;
+        uint64_t entryBaseUnit = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    void prepareBuf(std::vector<uint8_t>& mem) const override;
+
+  public:
+    Locality(const Params& p);
+};
+
+/**
+ * Heterogeneous Memory Attribute Table, the latencies and bandwidths
+ * the initiator domains see to the memory domains.
+ */
+class HMAT : public SysDescTable
+{
+  protected:
+    PARAMS(X86ACPIHmat);
+
+    struct GEM5_PACKED Mem : public SysDescTable::Mem
+    {
+        uint32_t _reserved = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    std::vector<Record *> records;
+
+    Addr writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+            std::vector<uint8_t>& mem) const override;
+
+  public:
+    HMAT(const Params &p);
+};
+
+} // namespace HMAT
+
+namespace CEDT
+{
+class Record : public SimObject
+{
+  protected:
+    PARAMS(X86ACPICedtRecord);
+
+    struct GEM5_PACKED Mem
+    {
+        uint8_t type = 0;
+        uint8_t _reserved = 0;
+        uint16_t length = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    uint8_t type;
+
+    virtual void prepareBuf(std::vector<uint8_t>& mem) const = 0;
+
+  public:
+    Record(const Params& p, uint8_t _type) : SimObject(p), type(_type) {}
+
+    std::vector<uint8_t>
+    prepare() const
+    {
+        std::vector<uint8_t> mem;
+        prepareBuf(mem);
+        return mem;
+    }
+};
+
+class CHBS : public Record
+{
+  protected:
+    PARAMS(X86ACPICedtCHBS);
+
+    struct GEM5_PACKED Mem : public Record::Mem
+    {
+        uint32_t uid = 0;
+        uint32_t cxlVersion = 0;
+        uint32_t _reserved = 0;
+        uint64_t base = 0;
+        uint64_t length = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    void prepareBuf(std::vector<uint8_t>& mem) const override;
+
+  public:
+    CHBS(const Params& p) : Record(p, 0) {}
+};
+
+class CFMWS : public Record
+{
+  protected:
+    PARAMS(X86ACPICedtCFMWS);
+
+    struct GEM5_PACKED Mem : public Record::Mem
+    {
+        uint32_t _reserved0 = 0;
+        uint64_t baseHPA = 0;
+        uint64_t windowSize = 0;
+        uint8_t interleaveWays = 0;
+        uint8_t interleaveArithmetic = 0;
+        uint16_t _reserved1 = 0;
+        uint32_t granularity = 0;
+        uint16_t restrictions = 0;
+        uint16_t qtgId = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<Mem>,
+            "Type not suitable for memcpy.");
+
+    void prepareBuf(std::vector<uint8_t>& mem) const override;
+
+  public:
+    CFMWS(const Params& p);
+};
+
+/**
+ * CXL Early Discovery Table, the CXL host bridges and the windows of
+ * host physical addresses they decode to CXL memory.
+ */
+class CEDT : public SysDescTable
+{
+  protected:
+    PARAMS(X86ACPICedt);
+
+    std::vector<Record *> records;
+
+    Addr writeBuf(PortProxy& phys_proxy, Allocator& alloc,
+            std::vector<uint8_t>& mem) const override;
+
+  public:
+    CEDT(const Params &p);
+};
+
+} // namespace CEDT
+
 } // namespace ACPI
 
 } // namespace X86ISA
@@ -2529,6 +2529,149 @@ class SparseHistogram : public SparseHistBase<SparseHistogram, SparseHistStor>
     }
 };
 
+template <class Stat>
+class LogHistInfoProxy : public InfoProxy<Stat, LogHistInfo>
+{
+  public:
+    LogHistInfoProxy(Stat &stat) : InfoProxy<Stat, LogHistInfo>(stat) {}
+};
+
+/**
+ * Implementation of a log-linear histogram stat. The storage class is
+ * determined by the Storage template.
+ */
+template <class Derived, class Stor>
+class LogHistBase : public DataWrap<Derived, LogHistInfoProxy>
+{
+  public:
+    typedef LogHistInfoProxy<Derived> Info;
+    typedef Stor Storage;
+    typedef typename Stor::Params Params;
+
+  protected:
+    /** The storage for this stat. */
+    char storage[sizeof(Storage)];
+
+  protected:
+    /**
+     * Retrieve the storage.
+     * @return The storage object for this stat.
+     */
+    Storage *
+    data()
+    {
+        return reinterpret_cast<Storage *>(storage);
+    }
+
+    /**
+     * Retrieve a const pointer to the storage.
+     * @return A const pointer to the storage object for this stat.
+     */
+    const Storage *
+    data() const
+    {
+        return reinterpret_cast<const Storage *>(storage);
+    }
+
+    void
+    doInit()
+    {
+        new (storage) Storage(this->info()->getStorageParams());
+        this->setInit();
+    }
+
+  public:
+    LogHistBase(Group *parent, const char *name,
+                const units::Base *unit,
+                const char *desc)
+        : DataWrap<Derived, LogHistInfoProxy>(parent, name, unit, desc)
+    {
+    }
+
+    /**
+     * Add a value to the distribtion n times. Calls sample on the storage
+     * class.
+     * @param v The value to add.
+     * @param n The number of times to add it, defaults to 1.
+     */
+    template <typename U>
+    void sample(const U &v, int n = 1) { data()->sample(v, n); }
+
+    /**
+     * Return the number of entries in this stat.
+     * @return The number of entries.
+     */
+    size_type size() const { return data()->size(); }
+    /**
+     * Return true if no samples have been added.
+     * @return True if there haven't been any samples.
+     */
+    bool zero() const { return data()->zero(); }
+
+    void
+    prepare()
+    {
+        Info *info = this->info();
+        data()->prepare(info->getStorageParams(), info->data);
+    }
+
+    /**
+     * Reset stat value to default
+     */
+    void
+    reset()
+    {
+        data()->reset(this->info()->getStorageParams());
+    }
+};
+
+/**
+ * A histogram whose buckets grow exponentially with the values, split
+ * linearly within every power of two, so that it needs no range. It
+ * reports the median and tail percentiles along with the buckets.
+ * @sa LogHistStor
+ */
+class LogHistogram : public LogHistBase<LogHistogram, LogHistStor>
+{
+  public:
+    LogHistogram(Group *parent = nullptr)
+        : LogHistBase<LogHistogram, LogHistStor>(parent, nullptr,
+            units::Unspecified::get(), nullptr)
+    {
+    }
+
+    LogHistogram(Group *parent, const char *name,
+                 const char *desc = nullptr)
+        : LogHistBase<LogHistogram, LogHistStor>(parent, name,
+            units::Unspecified::get(), desc)
+    {
+    }
+
+    LogHistogram(Group *parent, const char *name, const units::Base *unit,
+                 const char *desc = nullptr)
+        : LogHistBase<LogHistogram, LogHistStor>(parent, name, unit, desc)
+    {
+    }
+
+    /**
+     * Set the parameters of this histogram. @sa LogHistStor::Params
+     * @param sub_bits The number of sub-buckets per power of two, as a
+     * number of bits, which bounds the relative error of a bucket to
+     * 2^-sub_bits
+     * @return A reference to this histogram.
+     */
+    LogHistogram &
+    init(unsigned sub_bits = 4)
+    {
+        fatal_if(sub_bits > 16, "A log-linear histogram has at most 2^16 "
+                 "sub-buckets per power of two.");
+        LogHistStor::Params *params = new LogHistStor::Params(sub_bits);
+        this->setParams(params);
+        this->doInit();
+        return this->self();
+    }
+};
+
 class Temp;
 /**
  * A formula for statistics that is calculated when printed. A formula is
@@ -198,6 +198,12 @@ Hdf5::visit(const SparseHistInfo &info)
     warn_once("HDF5 stat files don't support sparse histograms.\n");
 }
 
+void
+Hdf5::visit(const LogHistInfo &info)
+{
+    warn_once("HDF5 stat files don't support log-linear histograms.\n");
+}
+
 H5::DataSet
 Hdf5::appendVectorInfo(const VectorInfo &info)
 {
@@ -254,6 +254,13 @@ class SparseHistInfo : public Info
     SparseHistData data;
 };
 
+class LogHistInfo : public Info
+{
+  public:
+    /** Local storage for the entry values, used for printing. */
+    LogHistData data;
+};
+
 typedef std::map<std::string, Info *> NameMapType;
 NameMapType &nameMap();
 
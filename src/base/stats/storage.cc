@@ -41,7 +41,11 @@
 
 #include "base/stats/storage.hh"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+
+#include "base/intmath.hh"
 
 namespace gem5
 {
@@ -226,5 +230,110 @@ HistStor::add(HistStor *hs)
         cvec[i] += hs->cvec[i];
 }
 
+size_type
+LogHistStor::bucket(uint64_t val) const
+{
+    const uint64_t sub_buckets = 1ULL << subBits;
+    if (val < sub_buckets)
+        return val;
+
+    // the top subBits + 1 bits of the value pick the bucket
+    const unsigned shift = floorLog2(val) - subBits;
+    return (shift + 1) * sub_buckets + (val >> shift) - sub_buckets;
+}
+
+uint64_t
+LogHistStor::bucketLow(size_type index) const
+{
+    const uint64_t sub_buckets = 1ULL << subBits;
+    if (index < sub_buckets)
+        return index;
+
+    const unsigned shift = index / sub_buckets - 1;
+    return (index % sub_buckets + sub_buckets) << shift;
+}
+
+uint64_t
+LogHistStor::bucketHigh(size_type index) const
+{
+    const uint64_t sub_buckets = 1ULL << subBits;
+    if (index < sub_buckets)
+        return index;
+
+    const unsigned shift = index / sub_buckets - 1;
+    return bucketLow(index) + (1ULL << shift) - 1;
+}
+
+void
+LogHistStor::sample(Counter val, int number)
+{
+    uint64_t bucket_val;
+    if (val <= 0)
+        bucket_val = 0;
+    else if (val >= std::ldexp(1.0, 64))
+        bucket_val = std::numeric_limits<uint64_t>::max();
+    else
+        bucket_val = val;
+
+    size_type index = bucket(bucket_val);
+    if (index >= cvec.size())
+        cvec.resize(index + 1, Counter());
+    cvec[index] += number;
+
+    if (val < minVal)
+        minVal = val;
+    if (val > maxVal)
+        maxVal = val;
+
+    sum += val * number;
+    squares += val * val * number;
+    samples += number;
+}
+
+void
+LogHistStor::prepare(const StorageParams* const storage_params,
+                     LogHistData &data)
+{
+    data.low.clear();
+    data.high.clear();
+    data.cvec.clear();
+    for (size_type i = 0; i < cvec.size(); ++i) {
+        if (cvec[i] == Counter())
+            continue;
+        data.low.push_back(bucketLow(i));
+        data.high.push_back(bucketHigh(i));
+        data.cvec.push_back(cvec[i]);
+    }
+
+    data.min_val = (minVal == CounterLimits::max()) ? 0 : minVal;
+    data.max_val = (maxVal == CounterLimits::min()) ? 0 : maxVal;
+    data.sum = sum;
+    data.squares = squares;
+    data.samples = samples;
+
+    // the samples are taken to be spread evenly over their bucket
+    static const std::pair<const char *, double> points[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p99.9", 0.999}
+    };
+    data.percentiles.clear();
+    for (const auto &[name, fraction] : points) {
+        Result value = std::numeric_limits<Result>::quiet_NaN();
+        Counter target = fraction * samples;
+        Counter below = 0;
+        for (size_type i = 0; samples && i < data.cvec.size(); ++i) {
+            if (below + data.cvec[i] >= target) {
+                Result width = data.high[i] - data.low[i] + 1;
+                value = data.low[i] +
+                    width * (target - below) / data.cvec[i];
+                value = std::clamp<Result>(value, data.min_val,
+                                           data.max_val);
+                break;
+            }
+            below += data.cvec[i];
+        }
+        data.percentiles.emplace_back(name, value);
+    }
+}
+
 } // namespace statistics
 } // namespace gem5
@@ -781,6 +781,98 @@ class SparseHistStor
     }
 };
 
+/**
+ * Templatized storage and interface for a log-linear histogram stat, as
+ * in HdrHistogram. Every power of two is split into the same number of
+ * equal sub-buckets, so the buckets need no range and the relative error
+ * of a bucket is bounded by one over the number of sub-buckets, however
+ * large the values grow. Values below the number of sub-buckets are
+ * counted exactly. Samples are truncated to non-negative integers for
+ * bucketing, the mean and deviation use them as given.
+ */
+class LogHistStor
+{
+  private:
+    /** Sub-buckets per power of two, as a number of bits. */
+    unsigned subBits;
+
+    /** The smallest value sampled. */
+    Counter minVal;
+    /** The largest value sampled. */
+    Counter maxVal;
+    /** The sum of all samples. */
+    Counter sum;
+    /** The sum of squares of all samples. */
+    Counter squares;
+    /** The number of samples. */
+    Counter samples;
+    /** Counter for each bucket, grown up to the largest one sampled. */
+    VCounter cvec;
+
+  public:
+    /** The parameters for a log-linear histogram stat. */
+    struct Params : public StorageParams
+    {
+        /** Sub-buckets per power of two, as a number of bits. */
+        const unsigned subBits;
+
+        Params(unsigned sub_bits) : subBits(sub_bits) {}
+    };
+
+    LogHistStor(const StorageParams* const storage_params)
+        : subBits(safe_cast<const Params *>(storage_params)->subBits)
+    {
+        reset(storage_params);
+    }
+
+    /** The bucket of a value. */
+    size_type bucket(uint64_t val) const;
+
+    /** The lowest and highest value of a bucket. */
+    uint64_t bucketLow(size_type index) const;
+    uint64_t bucketHigh(size_type index) const;
+
+    /**
+     * Add a value to the distribution for the given number of times.
+     * @param val The value to add.
+     * @param number The number of times to add the value.
+     */
+    void sample(Counter val, int number);
+
+    /**
+     * Return the number of buckets in this distribution.
+     * @return the number of buckets.
+     */
+    size_type size() const { return cvec.size(); }
+
+    /**
+     * Returns true if any calls to sample have been made.
+     * @return True if any values have been sampled.
+     */
+    bool
+    zero() const
+    {
+        return samples == Counter();
+    }
+
+    void prepare(const StorageParams* const storage_params,
+                 LogHistData &data);
+
+    /**
+     * Reset stat value to default
+     */
+    void
+    reset(const StorageParams* const storage_params)
+    {
+        minVal = CounterLimits::max();
+        maxVal = CounterLimits::min();
+        sum = Counter();
+        squares = Counter();
+        samples = Counter();
+        cvec.clear();
+    }
+};
+
 } // namespace statistics
 } // namespace gem5
 
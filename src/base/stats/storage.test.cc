@@ -30,6 +30,7 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <limits>
 
 #include "base/gtest/cur_tick_fake.hh"
 #include "base/gtest/logging.hh"
@@ -1214,3 +1215,116 @@ TEST(StatsSparseHistStorTest, SamplePrepare)
     }
     ASSERT_EQ(data.samples, total_samples);
 }
+
+/**
+ * Test whether zero is correctly set as the reset value. The test order is
+ * to check if it is initially zero on creation, then it is made non zero,
+ * and finally reset to zero.
+ */
+TEST(StatsLogHistStorTest, ZeroReset)
+{
+    statistics::LogHistStor::Params params(4);
+    statistics::LogHistStor stor(&params);
+    statistics::Counter val = 10;
+    statistics::Counter num_samples = 5;
+
+    ASSERT_TRUE(stor.zero());
+
+    stor.reset(&params);
+    stor.sample(val, num_samples);
+    ASSERT_FALSE(stor.zero());
+
+    stor.reset(&params);
+    ASSERT_TRUE(stor.zero());
+    ASSERT_EQ(stor.size(), 0);
+}
+
+/** Test that values land in buckets bounding their relative error. */
+TEST(StatsLogHistStorTest, Buckets)
+{
+    statistics::LogHistStor::Params params(2);
+    statistics::LogHistStor stor(&params);
+
+    // values below the number of sub-buckets are exact
+    for (uint64_t val = 0; val < 4; val++) {
+        ASSERT_EQ(stor.bucket(val), val);
+        ASSERT_EQ(stor.bucketLow(val), val);
+        ASSERT_EQ(stor.bucketHigh(val), val);
+    }
+
+    // then every power of two is split in four
+    ASSERT_EQ(stor.bucket(4), 4);
+    ASSERT_EQ(stor.bucket(7), 7);
+    ASSERT_EQ(stor.bucket(8), 8);
+    ASSERT_EQ(stor.bucket(9), 8);
+    ASSERT_EQ(stor.bucket(10), 9);
+    ASSERT_EQ(stor.bucket(15), 11);
+    ASSERT_EQ(stor.bucket(16), 12);
+    ASSERT_EQ(stor.bucketLow(9), 10);
+    ASSERT_EQ(stor.bucketHigh(9), 11);
+    ASSERT_EQ(stor.bucketLow(12), 16);
+    ASSERT_EQ(stor.bucketHigh(12), 19);
+
+    // every value is within its bucket, and the buckets are contiguous
+    for (uint64_t val = 0; val < 4096; val++) {
+        statistics::size_type index = stor.bucket(val);
+        ASSERT_LE(stor.bucketLow(index), val);
+        ASSERT_GE(stor.bucketHigh(index), val);
+        ASSERT_EQ(stor.bucketHigh(index) + 1, stor.bucketLow(index + 1));
+    }
+    uint64_t max = std::numeric_limits<uint64_t>::max();
+    ASSERT_EQ(stor.bucketHigh(stor.bucket(max)), max);
+}
+
+/** Test setting and getting value from storage. */
+TEST(StatsLogHistStorTest, SamplePrepare)
+{
+    statistics::LogHistStor::Params params(4);
+    statistics::LogHistStor stor(&params);
+    statistics::LogHistData data;
+
+    // Simple test with one value being sampled
+    stor.sample(10, 5);
+    stor.prepare(&params, data);
+    ASSERT_EQ(data.cvec.size(), 1);
+    ASSERT_EQ(data.low[0], 10);
+    ASSERT_EQ(data.high[0], 10);
+    ASSERT_EQ(data.cvec[0], 5);
+    ASSERT_EQ(data.samples, 5);
+    ASSERT_EQ(data.sum, 50);
+    ASSERT_EQ(data.squares, 500);
+    ASSERT_EQ(data.min_val, 10);
+    ASSERT_EQ(data.max_val, 10);
+    ASSERT_EQ(data.percentiles.size(), 4);
+    for (const auto &[name, value] : data.percentiles)
+        ASSERT_EQ(value, 10);
+
+    // Reset storage, and make sure all data has been cleared
+    stor.reset(&params);
+    stor.prepare(&params, data);
+    ASSERT_EQ(data.cvec.size(), 0);
+    ASSERT_EQ(data.samples, 0);
+    ASSERT_EQ(data.min_val, 0);
+    ASSERT_EQ(data.max_val, 0);
+    for (const auto &[name, value] : data.percentiles)
+        ASSERT_TRUE(std::isnan(value));
+
+    // One sample each of 1 to 1000, only the non-empty buckets show up
+    for (int val = 1; val <= 1000; val++)
+        stor.sample(val, 1);
+    stor.sample(1000000, 1);
+    stor.prepare(&params, data);
+    ASSERT_EQ(data.samples, 1001);
+    ASSERT_EQ(data.min_val, 1);
+    ASSERT_EQ(data.max_val, 1000000);
+    ASSERT_EQ(data.cvec.size(), stor.bucket(1000) + 1);
+    ASSERT_EQ(data.low.back(), stor.bucketLow(stor.bucket(1000000)));
+
+    // the percentiles are within the relative error of a bucket
+    ASSERT_EQ(data.percentiles[0].first, "p50");
+    ASSERT_EQ(data.percentiles[3].first, "p99.9");
+    ASSERT_NEAR(data.percentiles[0].second, 500.5, 500.5 / 16);
+    ASSERT_NEAR(data.percentiles[1].second, 900.9, 900.9 / 16);
+    ASSERT_NEAR(data.percentiles[2].second, 991, 991.0 / 16);
+    ASSERT_NEAR(data.percentiles[3].second, 1000, 1000.0 / 16);
+}
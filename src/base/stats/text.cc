@@ -800,6 +800,95 @@ Text::visit(const SparseHistInfo &info)
     print(*stream);
 }
 
+/*
+  This struct implements the output methods for the log-linear
+  histogram stat
+*/
+struct LogHistPrint : public BasePrint
+{
+    std::string separatorString;
+
+    const LogHistData &data;
+
+    LogHistPrint(const Text *text, const LogHistInfo &info);
+    void operator()(std::ostream &stream) const;
+};
+
+LogHistPrint::LogHistPrint(const Text *text, const LogHistInfo &info)
+    : data(info.data)
+{
+    setup(text->statName(info.name), info.flags, info.precision,
+        text->descriptions, info.desc, text->enableUnits,
+        info.unit->getUnitString(), text->spaces);
+    separatorString = info.separatorString;
+}
+
+void
+LogHistPrint::operator()(std::ostream &stream) const
+{
+    std::string base = name + separatorString;
+
+    ScalarPrint print(spaces);
+    print.setup(base + "samples", flags, precision, descriptions, desc,
+        enableUnits, unitStr, spaces);
+    print.pdf = Nan;
+    print.cdf = Nan;
+    print.value = data.samples;
+    print(stream);
+
+    print.name = base + "mean";
+    print.value = data.samples ? data.sum / data.samples : Nan;
+    print(stream);
+
+    Result stdev = Nan;
+    if (data.samples)
+        stdev = sqrt((data.samples * data.squares - data.sum * data.sum) /
+                     (data.samples * (data.samples - 1.0)));
+    print.name = base + "stdev";
+    print.value = stdev;
+    print(stream);
+
+    print.name = base + "min_value";
+    print.value = data.min_val;
+    print(stream);
+
+    print.name = base + "max_value";
+    print.value = data.max_val;
+    print(stream);
+
+    for (const auto &[point, value] : data.percentiles) {
+        print.name = base + point;
+        print.value = value;
+        print(stream);
+    }
+
+    if (data.samples) {
+        print.pdf = 0.0;
+        print.cdf = 0.0;
+    }
+
+    for (off_type i = 0; i < data.cvec.size(); ++i) {
+        std::stringstream namestr;
+        namestr << base << data.low[i];
+        if (data.low[i] < data.high[i])
+            namestr << "-" << data.high[i];
+
+        print.name = namestr.str();
+        print.update(data.cvec[i], data.samples);
+        print(stream);
+    }
+}
+
+void
+Text::visit(const LogHistInfo &info)
+{
+    if (noOutput(info))
+        return;
+
+    LogHistPrint print(this, info);
+    print(*stream);
+}
+
 Output *
 initText(const std::string &filename, bool desc, bool spaces)
 {
@@ -31,6 +31,8 @@
 
 #include <limits>
 #include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "base/compiler.hh"
@@ -87,6 +89,24 @@ struct SparseHistData
     Counter samples;
 };
 
+/** Data structure of log-linear histogram */
+struct LogHistData
+{
+    /** Lowest and highest value and count of every non-empty bucket. */
+    VCounter low;
+    VCounter high;
+    VCounter cvec;
+
+    Counter min_val;
+    Counter max_val;
+    Counter sum;
+    Counter squares;
+    Counter samples;
+
+    /** Name and estimate of the percentiles reported. */
+    std::vector<std::pair<std::string, Result>> percentiles;
+};
+
 } // namespace statistics
 } // namespace gem5
 
@@ -1,5 +1,12 @@
 from m5.params import *
 from m5.objects.PciDevice import *
+from m5.objects.Bridge import CXLLinkGen
+from m5.objects.Compressors import BaseCacheCompressor
+from m5.objects.Prefetcher import BasePrefetcher
+
+
+class CXLMemScheduler(ScopedEnum):
+    vals = ["FIFO", "ReadFirst", "BankAware"]
 
 
 class CXLMemory(PciDevice):
@@ -14,12 +21,58 @@ class CXLMemory(PciDevice):
         "This port sends requests to and receives responses from the back-end memory media"
     )
 
-    rsp_size = Param.Unsigned(48, "The number of responses to buffer")
-    req_size = Param.Unsigned(48, "The number of requests to buffer")
+    rsp_size = Param.Unsigned(48, "The number of S2M DRS responses, i.e. of reads, to buffer")
+    req_size = Param.Unsigned(48, "The number of M2S Req requests, i.e. of reads, to buffer")
+    ndr_size = Param.Unsigned(48, "The number of S2M NDR responses, i.e. of writes, to buffer")
+    rwd_size = Param.Unsigned(48, "The number of M2S RwD requests, i.e. of writes, to buffer")
+
+    scheduler = Param.CXLMemScheduler("FIFO", "Policy picking the next request sent to the media: FIFO in arrival order, ReadFirst sends reads ahead of writes, BankAware does too and prefers the bank with the fewest accesses in flight")
+    write_high_thresh_perc = Param.Percent(85, "Share of the M2S RwD credits held by queued writes at which the writes are drained ahead of the reads")
+    write_low_thresh_perc = Param.Percent(50, "Share of the M2S RwD credits held by queued writes at which draining the writes stops")
+    sched_banks = Param.Unsigned(16, "Number of banks of the media the bank-aware scheduler spreads the requests over")
+    sched_bank_interleave = Param.MemorySize("1KiB", "Bytes mapped to a bank of the media before the next bank, as in the address mapping of the media")
     
     proto_proc_lat = Param.Latency("15ns", "Latency of the CXL controller processing CXL.mem sub-protocol packets")
     cxl_mem_range = Param.AddrRange("2GB", "CXL expander memory range that can be identified as system memory")
 
+    link_lanes = Param.Unsigned(16, "Number of lanes of the CXL link")
+    link_gen = Param.CXLLinkGen(
+        "PCIe5", "PCIe generation (per-lane rate) of the CXL link"
+    )
+    flit_size = Param.Unsigned(68, "CXL flit size in bytes (68 or 256)")
+
+    devload_optimal_perc = Param.Percent(25, "Occupancy of the fuller of the request and response queues from which the DevLoad in the S2M responses reports an optimal load rather than a light one")
+    devload_moderate_perc = Param.Percent(70, "Queue occupancy from which the DevLoad reports a moderate overload")
+    devload_severe_perc = Param.Percent(90, "Queue occupancy from which the DevLoad reports a severe overload")
+
+    ld_ranges = VectorParam.AddrRange([], "Host physical window of each logical device (LD) of a pooled device, indexed by the LD-ID the CXL switch assigns; empty for a single host using cxl_mem_range")
+    dc_block_size = Param.MemorySize("0", "Dynamic capacity block size, 0 maps cxl_mem_range straight onto the media")
+    dpa_range = Param.AddrRange("0", "Range of the media the dynamic capacity is allocated from")
+    dc_initial_blocks = VectorParam.Unsigned([], "Dynamic capacity blocks assigned to each LD at start-up, from the start of its window")
+    mailbox_lat = Param.Latency("1us", "Latency of an access to the mailbox registers")
+    dc_shared_blocks = Param.Unsigned(0, "Media blocks mapped at the start of every LD window, as memory shared by the hosts")
+    hotness_page_size = Param.MemorySize("0", "Page size of the hotness tracker, which counts the media accesses per page; 0 turns it off")
+    hotness_decay = Param.Latency("0", "Period after which the hotness counters are halved, 0 never decays them")
+    backdoor_media_latency = Param.Latency("0", "Media latency charged per atomic access the device serves straight through the backdoor of its media, which keeps atomic fast-forwarding fast; 0 sends atomic accesses to the media and hands its backdoor out to the host when nothing in the device needs to see the accesses")
+    preload_files = VectorParam.String([], "Host files, such as embedding tables or graph datasets, copied into the memory before the simulation starts and not when restoring a checkpoint")
+    preload_offsets = VectorParam.Addr([], "Offset of each preloaded file from the start of cxl_mem_range, or of dpa_range for a pooled device")
+    snoop_filter_entries = Param.Unsigned(0, "Lines tracked by the inclusive snoop filter of an HDM-DB device, which back-invalidates the host copies; 0 for an HDM-H device")
+    compressor = Param.BaseCacheCompressor(NULL, "Compressor of the lines written to the media, e.g. BDI, CPack, FPC or ZeroCompressor; the data is stored uncompressed in the backing store, only its size and latency are modelled; none turns compression off")
+    compression_page_size = Param.MemorySize("0", "Unit the compressed data is allocated and described in, 0 for single lines")
+    compression_slot_size = Param.MemorySize("16B", "Granularity a compressed unit is allocated in, a power of two")
+    compression_latency = Param.Latency("0", "Latency of compressing a written line, 0 for the estimate of the compressor")
+    decompression_latency = Param.Latency("0", "Latency of decompressing a line read, 0 for the estimate of the compressor")
+    compression_md_bits = Param.Unsigned(8, "Metadata bits describing a compression unit")
+    compression_md_cache_entries = Param.Unsigned(1024, "Lines of metadata the metadata cache holds")
+    compression_md_cache_latency = Param.Latency("2ns", "Lookup latency of the metadata cache")
+    prefetcher = Param.BasePrefetcher(NULL, "Prefetcher trained on the M2S reads, reading lines ahead into the prefetch buffer")
+    prefetch_buffer_entries = Param.Unsigned(64, "Lines the prefetch buffer holds")
+    prefetch_buffer_latency = Param.Latency("5ns", "Latency of a read served from the prefetch buffer")
+    prefetch_max_inflight = Param.Unsigned(16, "Prefetches in flight to the media at most")
+    nmp_buffer_size = Param.MemorySize("0", "Data the near-memory processing engine works on at a time, 0 for no engine")
+    nmp_max_inflight = Param.Unsigned(16, "Media accesses the NMP engine has in flight at most")
+    nmp_line_latency = Param.Cycles(2, "Cycles the NMP engine computes on each line it reads")
+
     VendorID = 0x8086
     DeviceID = 0X7890
     Command = 0x0
@@ -34,3 +87,9 @@ class CXLMemory(PciDevice):
     # Primary
     BAR0 = PciMemBar(size='2GB')
     BAR1 = PciMemUpperBar()
+    # Mailbox registers for dynamic capacity management
+    BAR2 = PciMemBar(size='4kB')
+    # Hotness tracker registers and per-page access counters
+    BAR3 = PciMemBar(size='4kB')
+    # Doorbell and status registers of the near-memory processing engine
+    BAR4 = PciMemBar(size='4kB')
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * Implementation of the accounting of the space compressed lines take
+ * up in the media of a CXL memory device.
+ */
+
+#include "dev/storage/cxl_compressed_space.hh"
+
+#include "base/intmath.hh"
+
+namespace gem5
+{
+
+CXLCompressedSpace::CXLCompressedSpace(unsigned _line_size, Addr _unit,
+                                       Addr _slot)
+    : lineSize(_line_size), unit(_unit), slot(_slot)
+{
+}
+
+void
+CXLCompressedSpace::record(Addr line, unsigned bytes, Cycles decomp_cycles)
+{
+    Line now{uint16_t(bytes),
+             uint16_t(bytes < lineSize ? decomp_cycles : Cycles(0))};
+
+    // a unit takes up whole slots for the compressed lines it holds
+    auto [it, seen_first] = lines.try_emplace(line, now);
+    uint64_t &unit_bytes = units[line / unit];
+    stored -= roundUp(unit_bytes, slot);
+    if (seen_first)
+        raw += lineSize;
+    else
+        unit_bytes -= it->second.bytes;
+    it->second = now;
+    unit_bytes += now.bytes;
+    stored += roundUp(unit_bytes, slot);
+}
+
+void
+CXLCompressedSpace::release(Addr start, Addr size)
+{
+    for (auto it = lines.begin(); it != lines.end();) {
+        if (it->first < start || it->first >= start + size) {
+            ++it;
+            continue;
+        }
+
+        auto unit_it = units.find(it->first / unit);
+        stored -= roundUp(unit_it->second, slot);
+        unit_it->second -= it->second.bytes;
+        stored += roundUp(unit_it->second, slot);
+        if (!unit_it->second)
+            units.erase(unit_it);
+        raw -= lineSize;
+        it = lines.erase(it);
+    }
+}
+
+const CXLCompressedSpace::Line *
+CXLCompressedSpace::find(Addr line) const
+{
+    auto it = lines.find(line);
+    return it == lines.end() ? nullptr : &it->second;
+}
+
+} // namespace gem5
@@ -0,0 +1,91 @@
+/**
+ * @file
+ * Declaration of the accounting of the space compressed lines take up
+ * in the media of a CXL memory device.
+ */
+
+#ifndef __DEV_STORAGE_CXL_COMPRESSED_SPACE_HH__
+#define __DEV_STORAGE_CXL_COMPRESSED_SPACE_HH__
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/**
+ * Keeps the compressed size of the lines seen by a compressor, and the
+ * space they take up in the media. The media is allocated in units of
+ * whole lines, and a unit takes up as many slots as the compressed
+ * lines it holds need.
+ */
+class CXLCompressedSpace
+{
+  public:
+
+    /** A line seen by the compressor. */
+    struct Line
+    {
+        /** Compressed size, the line size if it does not compress. */
+        uint16_t bytes;
+        /** Cycles to decompress it. */
+        uint16_t decompCycles;
+    };
+
+    /**
+     * Constructor for the CXLCompressedSpace.
+     *
+     * @param _line_size the cache line size
+     * @param _unit bytes compressed data is described and allocated in,
+     *        a multiple of the line size
+     * @param _slot granularity the units are allocated in, a power of
+     *        two
+     */
+    CXLCompressedSpace(unsigned _line_size, Addr _unit, Addr _slot);
+
+    /**
+     * Record the compressed size of a line.
+     *
+     * @param line the address of the line
+     * @param bytes its compressed size, the line size if it does not
+     *        compress
+     * @param decomp_cycles the cycles to decompress it
+     */
+    void record(Addr line, unsigned bytes, Cycles decomp_cycles);
+
+    /**
+     * Forget the lines of a range of the media, which then take up no
+     * space until they are seen again.
+     */
+    void release(Addr start, Addr size);
+
+    /** Look up a line, null if it has not been seen. */
+    const Line *find(Addr line) const;
+
+    /** Bytes of the lines seen. */
+    uint64_t rawBytes() const { return raw; }
+
+    /** Bytes the lines seen take up in whole slots. */
+    uint64_t storedBytes() const { return stored; }
+
+  private:
+
+    const unsigned lineSize;
+    const Addr unit;
+    const Addr slot;
+
+    /** The lines seen. */
+    std::unordered_map<Addr, Line> lines;
+
+    /** Compressed bytes of the lines seen of each unit. */
+    std::unordered_map<Addr, uint64_t> units;
+
+    uint64_t raw = 0;
+    uint64_t stored = 0;
+};
+
+} // namespace gem5
+
+#endif // __DEV_STORAGE_CXL_COMPRESSED_SPACE_HH__
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "dev/storage/cxl_compressed_space.hh"
+
+using namespace gem5;
+
+/** Lines that do not compress take up a line, and decompress for free. */
+TEST(CXLCompressedSpaceTest, Incompressible)
+{
+    CXLCompressedSpace space(64, 64, 16);
+    EXPECT_EQ(space.find(0), nullptr);
+
+    space.record(0, 64, Cycles(5));
+    ASSERT_NE(space.find(0), nullptr);
+    EXPECT_EQ(space.find(0)->bytes, 64);
+    EXPECT_EQ(space.find(0)->decompCycles, 0);
+    EXPECT_EQ(space.rawBytes(), 64);
+    EXPECT_EQ(space.storedBytes(), 64);
+}
+
+/** A compressed line of its own unit takes up whole slots. */
+TEST(CXLCompressedSpaceTest, WholeSlots)
+{
+    CXLCompressedSpace space(64, 64, 16);
+
+    space.record(0, 20, Cycles(5));
+    EXPECT_EQ(space.find(0)->bytes, 20);
+    EXPECT_EQ(space.find(0)->decompCycles, 5);
+    EXPECT_EQ(space.storedBytes(), 32);
+
+    space.record(0x40, 1, Cycles(1));
+    EXPECT_EQ(space.rawBytes(), 128);
+    EXPECT_EQ(space.storedBytes(), 48);
+}
+
+/** The lines of a unit share its slots. */
+TEST(CXLCompressedSpaceTest, SharedUnit)
+{
+    CXLCompressedSpace space(64, 4096, 64);
+
+    space.record(0, 20, Cycles(5));
+    space.record(0x40, 30, Cycles(5));
+    EXPECT_EQ(space.rawBytes(), 128);
+    EXPECT_EQ(space.storedBytes(), 64);
+
+    // the unit needs a second slot once it holds more than one
+    space.record(0x80, 20, Cycles(5));
+    EXPECT_EQ(space.storedBytes(), 128);
+
+    // a line of another unit does not share them
+    space.record(4096, 10, Cycles(5));
+    EXPECT_EQ(space.rawBytes(), 256);
+    EXPECT_EQ(space.storedBytes(), 192);
+}
+
+/** A line written again takes the size of its new data. */
+TEST(CXLCompressedSpaceTest, Rewrite)
+{
+    CXLCompressedSpace space(64, 4096, 64);
+
+    space.record(0, 20, Cycles(5));
+    space.record(0x40, 30, Cycles(5));
+    EXPECT_EQ(space.storedBytes(), 64);
+
+    space.record(0, 64, Cycles(5));
+    EXPECT_EQ(space.find(0)->bytes, 64);
+    EXPECT_EQ(space.find(0)->decompCycles, 0);
+    EXPECT_EQ(space.rawBytes(), 128);
+    EXPECT_EQ(space.storedBytes(), 128);
+
+    space.record(0, 2, Cycles(3));
+    EXPECT_EQ(space.find(0)->decompCycles, 3);
+    EXPECT_EQ(space.rawBytes(), 128);
+    EXPECT_EQ(space.storedBytes(), 64);
+}
+
+/** Released lines no longer take up space, the others keep theirs. */
+TEST(CXLCompressedSpaceTest, Release)
+{
+    CXLCompressedSpace space(64, 128, 64);
+
+    space.record(0, 20, Cycles(5));
+    space.record(0x40, 30, Cycles(5));
+    space.record(0x80, 64, Cycles(5));
+    space.record(0xc0, 10, Cycles(5));
+    EXPECT_EQ(space.rawBytes(), 256);
+    EXPECT_EQ(space.storedBytes(), 192);
+
+    // a range that ends within a unit leaves the rest of the unit
+    space.release(0x40, 0x80);
+    EXPECT_NE(space.find(0), nullptr);
+    EXPECT_EQ(space.find(0x40), nullptr);
+    EXPECT_EQ(space.find(0x80), nullptr);
+    EXPECT_NE(space.find(0xc0), nullptr);
+    EXPECT_EQ(space.rawBytes(), 128);
+    EXPECT_EQ(space.storedBytes(), 128);
+
+    space.release(0, 0x100);
+    EXPECT_EQ(space.rawBytes(), 0);
+    EXPECT_EQ(space.storedBytes(), 0);
+
+    space.record(0x40, 20, Cycles(5));
+    EXPECT_EQ(space.rawBytes(), 64);
+    EXPECT_EQ(space.storedBytes(), 64);
+}
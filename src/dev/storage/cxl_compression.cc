@@ -0,0 +1,225 @@
+/**
+ * @file
+ * Implementation of the compression stage of a CXL memory device.
+ */
+
+#include "dev/storage/cxl_compression.hh"
+
+#include <cstring>
+#include <memory>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+CXLCompressionStage::CXLCompressionStage(ClockedObject &_owner,
+                                         CXLMediaInterface &_media,
+                                         const CXLMemoryParams &p,
+                                         RequestorID _requestorId)
+    : Named(_owner.name() + ".compression"), owner(_owner), media(_media),
+    compressor(p.compressor), blkSize(p.system->cacheLineSize()),
+    compUnit(p.compression_page_size ? p.compression_page_size : blkSize),
+    compLat(p.compression_latency), decompLat(p.decompression_latency),
+    mdUnitsPerLine(p.compression_md_bits ?
+                   blkSize * 8 / p.compression_md_bits : 0),
+    mdEntries(p.compression_md_cache_entries),
+    mdLat(p.compression_md_cache_latency),
+    requestorId(_requestorId),
+    space(blkSize, compUnit, p.compression_slot_size),
+    stats(*this, &_owner)
+{
+    fatal_if(compUnit % blkSize || !mdUnitsPerLine || !mdEntries ||
+             !isPowerOf2(p.compression_slot_size),
+             "%s: compression needs units of whole lines, metadata that "
+             "fits in a line, a metadata cache and allocation slots of a "
+             "power of two.\n", _owner.name());
+}
+
+CXLCompressionStage::CompressionStats::CompressionStats(
+    CXLCompressionStage &stage, statistics::Group *parent)
+    : statistics::Group(parent),
+      ADD_STAT(compWrites, statistics::units::Count::get(),
+               "Number of lines compressed as they were written"),
+      ADD_STAT(decompressions, statistics::units::Count::get(),
+               "Number of reads of compressed lines"),
+      ADD_STAT(compRawBytes, statistics::units::Byte::get(),
+               "Bytes of the lines the compressor has seen"),
+      ADD_STAT(compStoredBytes, statistics::units::Byte::get(),
+               "Bytes the lines the compressor has seen take up in the "
+               "media"),
+      ADD_STAT(compRatio, statistics::units::Ratio::get(),
+               "Effective capacity per byte of media of the lines seen",
+               compRawBytes / compStoredBytes),
+      ADD_STAT(mdHits, statistics::units::Count::get(),
+               "Number of metadata lookups that hit in the metadata cache"),
+      ADD_STAT(mdMisses, statistics::units::Count::get(),
+               "Number of metadata lookups that missed"),
+      ADD_STAT(mdWritebacks, statistics::units::Count::get(),
+               "Number of dirty metadata lines evicted"),
+      ADD_STAT(mdBytes, statistics::units::Byte::get(),
+               "Bytes of metadata read from and written back to the media"),
+      ADD_STAT(mdHeldReqs, statistics::units::Count::get(),
+               "Number of requests held for a metadata read")
+{
+    compRawBytes.method(&stage.space, &CXLCompressedSpace::rawBytes);
+    compStoredBytes.method(&stage.space, &CXLCompressedSpace::storedBytes);
+}
+
+Cycles
+CXLCompressionStage::recordCompressed(Addr line, const uint8_t *data)
+{
+    std::vector<uint64_t> words(blkSize / sizeof(uint64_t));
+    std::memcpy(words.data(), data, blkSize);
+
+    Cycles comp_lat, decomp_lat;
+    std::size_t bytes =
+        compressor->compress(words.data(), comp_lat, decomp_lat)->getSize();
+    space.record(line, bytes, decomp_lat);
+
+    return comp_lat;
+}
+
+bool
+CXLCompressionStage::request(PacketPtr pkt, Tick &when, bool timing)
+{
+    const Addr line = pkt->getBlockAddr(blkSize);
+
+    if (pkt->isWrite()) {
+        // a partial write is merged into the line, which keeps the size
+        // it had until it is read again
+        Cycles comp_lat(0);
+        if (pkt->getAddr() == line && pkt->getSize() == blkSize) {
+            comp_lat = recordCompressed(line, pkt->getConstPtr<uint8_t>());
+            stats.compWrites++;
+        }
+        when += compLat ? compLat : owner.cyclesToTicks(comp_lat);
+    }
+
+    // the metadata says where, and how large, the line is in the media
+    const Addr md = line / compUnit / mdUnitsPerLine;
+    when += mdLat;
+    auto md_it = mdCache.find(md);
+    if (md_it != mdCache.end()) {
+        stats.mdHits++;
+        mdLru.splice(mdLru.begin(), mdLru, md_it->second.lru);
+        md_it->second.dirty |= pkt->isWrite();
+        return true;
+    }
+    stats.mdMisses++;
+
+    // the metadata region is not part of the address map, so the
+    // metadata is read at the line, which is as far as the media goes
+    if (!timing) {
+        Packet fill(std::make_shared<Request>(line, blkSize, 0,
+                                              requestorId),
+                    MemCmd::ReadReq);
+        fill.allocate();
+        when += media.sendAtomic(&fill);
+        stats.mdBytes += blkSize;
+        mdInsert(md, pkt->isWrite());
+        return true;
+    }
+
+    auto [wait_it, first] = mdWaiting.try_emplace(md);
+    if (first) {
+        RequestPtr req = std::make_shared<Request>(line, blkSize, 0,
+                                                   requestorId);
+        PacketPtr fill = new Packet(req, MemCmd::ReadReq);
+        fill->allocate();
+        mdReads[req] = md;
+        stats.mdBytes += blkSize;
+        media.queueMedia(fill, when);
+    }
+    wait_it->second.emplace_back(pkt, when);
+    ++mdHeld[cxlChannel(pkt)];
+    stats.mdHeldReqs++;
+    return false;
+}
+
+Tick
+CXLCompressionStage::atomic(PacketPtr pkt)
+{
+    Tick when = curTick();
+    [[maybe_unused]] bool proceed = request(pkt, when, false);
+    assert(proceed);
+    return when - curTick();
+}
+
+Tick
+CXLCompressionStage::decompress(PacketPtr pkt)
+{
+    if (!pkt->isRead() || !pkt->hasData())
+        return 0;
+
+    // the stored form of the line follows from the data read
+    const Addr line = pkt->getBlockAddr(blkSize);
+    if (pkt->getAddr() == line && pkt->getSize() == blkSize)
+        recordCompressed(line, pkt->getConstPtr<uint8_t>());
+
+    const CXLCompressedSpace::Line *stored = space.find(line);
+    if (!stored || stored->bytes >= blkSize)
+        return 0;
+
+    stats.decompressions++;
+    return decompLat ? decompLat :
+        owner.cyclesToTicks(Cycles(stored->decompCycles));
+}
+
+void
+CXLCompressionStage::mdInsert(Addr md, bool dirty)
+{
+    if (mdCache.size() >= mdEntries) {
+        Addr victim = mdLru.back();
+        if (mdCache[victim].dirty) {
+            stats.mdWritebacks++;
+            stats.mdBytes += blkSize;
+        }
+        mdCache.erase(victim);
+        mdLru.pop_back();
+    }
+    mdLru.push_front(md);
+    mdCache.emplace(md, MdItem{dirty, mdLru.begin()});
+}
+
+void
+CXLCompressionStage::response(PacketPtr pkt)
+{
+    auto read = mdReads.find(pkt->req);
+    const Addr md = read->second;
+    mdReads.erase(read);
+    Tick ready = owner.clockEdge() + pkt->headerDelay + pkt->payloadDelay;
+    delete pkt;
+
+    auto wait_it = mdWaiting.find(md);
+    assert(wait_it != mdWaiting.end());
+    auto waiting = std::move(wait_it->second);
+    mdWaiting.erase(wait_it);
+
+    bool dirty = false;
+    for (const auto &held : waiting)
+        dirty |= held.first->isWrite();
+    mdInsert(md, dirty);
+
+    // the requests go on in the order they came
+    for (const auto &[held, when] : waiting) {
+        --mdHeld[cxlChannel(held)];
+        media.queueMedia(held, std::max(when, ready));
+    }
+}
+
+bool
+CXLCompressionStage::trySatisfyFunctional(PacketPtr pkt) const
+{
+    for (const auto &[md, waiting] : mdWaiting) {
+        for (const auto &held : waiting) {
+            if (pkt->trySatisfyFunctional(held.first))
+                return true;
+        }
+    }
+    return false;
+}
+
+} // namespace gem5
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * Declaration of the compression stage of a CXL memory device.
+ */
+
+#ifndef __DEV_STORAGE_CXL_COMPRESSION_HH__
+#define __DEV_STORAGE_CXL_COMPRESSION_HH__
+
+#include <array>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/named.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "dev/storage/cxl_compressed_space.hh"
+#include "dev/storage/cxl_media_if.hh"
+#include "mem/cache/compressors/base.hh"
+#include "mem/cxl_link.hh"
+#include "mem/packet.hh"
+#include "params/CXLMemory.hh"
+#include "sim/clocked_object.hh"
+
+namespace gem5
+{
+
+/**
+ * The compression stage in front of the media of a CXL memory device.
+ * Lines are compressed as they are written, and decompressed as they
+ * are read. The metadata saying where, and how large, a line is in the
+ * media is looked up in a metadata cache, and read from the media on a
+ * miss, which holds the requests to the line until it is back.
+ */
+class CXLCompressionStage : public Named
+{
+  public:
+
+    /**
+     * Constructor for the CXLCompressionStage.
+     *
+     * @param _owner the device, whose clock and statistics the stage uses
+     * @param _media the way of the stage to the media
+     * @param p the parameters of the device
+     * @param _requestorId requestor ID of the metadata reads
+     */
+    CXLCompressionStage(ClockedObject &_owner, CXLMediaInterface &_media,
+                        const CXLMemoryParams &p, RequestorID _requestorId);
+
+    /**
+     * Pass a request to the media through the stage. A write is
+     * compressed, and the metadata of the line is looked up in the
+     * metadata cache, and read from the media on a miss.
+     *
+     * @param pkt the request, at its device address
+     * @param when tick the request is ready, moved back by the
+     *        compression and the metadata lookup
+     * @param timing true in timing mode
+     * @return false if the request is held until its metadata has
+     *         been read
+     */
+    bool request(PacketPtr pkt, Tick &when, bool timing);
+
+    /** Extra latency of a request in atomic mode. */
+    Tick atomic(PacketPtr pkt);
+
+    /**
+     * Decompress the data a read of the media returned.
+     *
+     * @return the decompression latency, 0 if the line is stored
+     *         uncompressed
+     */
+    Tick decompress(PacketPtr pkt);
+
+    /** Is a response from the media for a metadata read of the stage. */
+    bool isMetadataRead(const RequestPtr &req) const
+    {
+        return mdReads.count(req);
+    }
+
+    /** Pass on the requests waiting for a metadata read. */
+    void response(PacketPtr pkt);
+
+    /** Number of requests held for metadata on an M2S channel. */
+    unsigned held(CXLMemChannel channel) const { return mdHeld[channel]; }
+
+    /**
+     * Forget the compressed lines of a range of the media given back to
+     * the pool. The metadata lines that describe it stay cached, as
+     * they describe the units around it as well.
+     */
+    void release(Addr start, Addr size) { space.release(start, size); }
+
+    /** Satisfy a functional access from the requests held. */
+    bool trySatisfyFunctional(PacketPtr pkt) const;
+
+  private:
+
+    /**
+     * Compress a line and account for the space it takes up.
+     *
+     * @return the cycles the compression took
+     */
+    Cycles recordCompressed(Addr line, const uint8_t *data);
+
+    /** Insert a line into the metadata cache. */
+    void mdInsert(Addr md, bool dirty);
+
+    ClockedObject &owner;
+
+    CXLMediaInterface &media;
+
+    /** Compressor of the data of the media. */
+    compression::Base *compressor;
+
+    /** Cache line size of the system. */
+    const unsigned blkSize;
+
+    /** Bytes compressed data is described and allocated in. */
+    const Addr compUnit;
+
+    /**
+     * Latency of compressing and decompressing a line, 0 for the
+     * estimate of the compressor.
+     */
+    const Tick compLat;
+    const Tick decompLat;
+
+    /** Compression units whose metadata fits in a line. */
+    const unsigned mdUnitsPerLine;
+
+    /** Lines the metadata cache holds, and its lookup latency. */
+    const unsigned mdEntries;
+    const Tick mdLat;
+
+    /** Requestor ID of the metadata reads. */
+    const RequestorID requestorId;
+
+    /** The lines seen by the compressor, at device addresses. */
+    CXLCompressedSpace space;
+
+    /** An entry of the metadata cache. */
+    struct MdItem
+    {
+        bool dirty;
+        std::list<Addr>::iterator lru;
+    };
+
+    /** Metadata lines cached, most recently used first. */
+    std::unordered_map<Addr, MdItem> mdCache;
+    std::list<Addr> mdLru;
+
+    /**
+     * Requests waiting for a metadata line being read from the media,
+     * with the tick each is ready.
+     */
+    std::unordered_map<Addr, std::vector<std::pair<PacketPtr, Tick>>>
+        mdWaiting;
+
+    /**
+     * Metadata reads sent to the media, and their metadata line. They
+     * are kept by request, as a device cache behind a DCOH answers the
+     * lines it holds dirty with a packet of its own.
+     */
+    std::unordered_map<RequestPtr, Addr> mdReads;
+
+    /** Number of requests held for metadata, per M2S channel. */
+    std::array<unsigned, NumCXLMemChannels> mdHeld = {};
+
+    struct CompressionStats : public statistics::Group
+    {
+        CompressionStats(CXLCompressionStage &stage,
+                         statistics::Group *parent);
+
+        statistics::Scalar compWrites;
+        statistics::Scalar decompressions;
+        statistics::Value compRawBytes;
+        statistics::Value compStoredBytes;
+        statistics::Formula compRatio;
+        statistics::Scalar mdHits;
+        statistics::Scalar mdMisses;
+        statistics::Scalar mdWritebacks;
+        statistics::Scalar mdBytes;
+        statistics::Scalar mdHeldReqs;
+    } stats;
+};
+
+} // namespace gem5
+
+#endif // __DEV_STORAGE_CXL_COMPRESSION_HH__
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * Declaration of the interface the engines of a CXL memory device use
+ * to reach the media and the hosts.
+ */
+
+#ifndef __DEV_STORAGE_CXL_MEDIA_IF_HH__
+#define __DEV_STORAGE_CXL_MEDIA_IF_HH__
+
+#include "base/types.hh"
+#include "mem/cxl_link.hh"
+#include "mem/packet.hh"
+#include "sim/eventq.hh"
+
+namespace gem5
+{
+
+/**
+ * What the engines inside a CXL memory device see of the device. The
+ * device is the protocol front end: it owns the ports, the credits and
+ * the address map, and hands each engine the requests and responses
+ * that are its own.
+ */
+class CXLMediaInterface
+{
+  public:
+    virtual ~CXLMediaInterface() = default;
+
+    /**
+     * Queue a request for the media through the prefetch buffer and
+     * the compression stage.
+     */
+    virtual void toMedia(PacketPtr pkt, Tick when) = 0;
+
+    /**
+     * Queue a request of the device itself for the media, past the
+     * prefetch buffer and the compression stage. It is not bound by
+     * the credits of the hosts.
+     */
+    virtual void queueMedia(PacketPtr pkt, Tick when) = 0;
+
+    /** Is there a credit left of an M2S channel for the device. */
+    virtual bool hasCredit(CXLMemChannel channel) const = 0;
+
+    /**
+     * Access the media in atomic mode through the compression stage.
+     * A write drops the lines it changes from the prefetch buffer.
+     */
+    virtual Tick atomicAccess(PacketPtr pkt) = 0;
+
+    /** Access the media in atomic mode, past the engines. */
+    virtual Tick sendAtomic(PacketPtr pkt) = 0;
+
+    /**
+     * Decompress the data a read of the media returned.
+     *
+     * @return the decompression latency
+     */
+    virtual Tick decompress(PacketPtr pkt) = 0;
+
+    /** Send the response to a request of a host. */
+    virtual void respond(PacketPtr pkt, Tick when) = 0;
+
+    /** Let the host retry a request stalled on the credits of a channel. */
+    virtual void retryStalledReq(CXLMemChannel channel) = 0;
+
+    /**
+     * Find the media address of a host physical address in the window
+     * of an LD.
+     *
+     * @return false if the address is not in the memory of the device
+     */
+    virtual bool mediaAddr(unsigned ld, Addr hpa, Addr &dpa) const = 0;
+
+    /** Write to host memory by DMA. */
+    virtual void hostWrite(Addr addr, int size, Event *event,
+                           uint8_t *data) = 0;
+
+    /** Is the system in timing mode. */
+    virtual bool timingMode() const = 0;
+};
+
+} // namespace gem5
+
+#endif // __DEV_STORAGE_CXL_MEDIA_IF_HH__
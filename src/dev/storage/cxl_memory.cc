@@ -2,18 +2,38 @@
 #include "dev/storage/cxl_memory.hh"
 #include "debug/CXLMemory.hh"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include "base/bitfield.hh"
+#include "base/cast.hh"
+#include "base/chunk_generator.hh"
+#include "base/intmath.hh"
+#include "mem/cxl_latency.hh"
+#include "mem/physical.hh"
+#include "sim/system.hh"
+
 namespace gem5
 {
 
 CXLMemory::CXLResponsePort::CXLResponsePort(const std::string& _name,
                                         CXLMemory& _cxlMemory,
                                         CXLRequestPort& _memReqPort,
-                                        Cycles _protoProcLat, int _resp_limit,
+                                        Cycles _protoProcLat, int _drs_limit,
+                                        int _ndr_limit,
                                         AddrRange _cxlMemRange)
     : ResponsePort(_name), cxlMemory(_cxlMemory),
     memReqPort(_memReqPort), protoProcLat(_protoProcLat),
-    cxlMemRange(_cxlMemRange), outstandingResponses(0), 
-    retryReq(false), respQueueLimit(_resp_limit),
+    cxlMemRange(_cxlMemRange), outstandingResponses{0, 0},
+    retryReq(false),
+    respQueueLimit{unsigned(_drs_limit), unsigned(_ndr_limit)},
     sendEvent([this]{ trySendTiming(); }, _name)
 {
 }
@@ -21,10 +41,17 @@ CXLMemory::CXLResponsePort::CXLResponsePort(const std::string& _name,
 CXLMemory::CXLRequestPort::CXLRequestPort(const std::string& _name,
                                     CXLMemory& _cxlMemory,
                                     CXLResponsePort& _cxlRspPort,
-                                    Cycles _protoProcLat, int _req_limit)
+                                    Cycles _protoProcLat, int _req_limit,
+                                    int _rwd_limit,
+                                    const CXLMemoryParams &p)
     : RequestPort(_name), cxlMemory(_cxlMemory),
     cxlRspPort(_cxlRspPort),
-    protoProcLat(_protoProcLat), reqQueueLimit(_req_limit),
+    protoProcLat(_protoProcLat),
+    reqQueueLimit{unsigned(_req_limit), unsigned(_rwd_limit)},
+    scheduler(_name, p.scheduler, p.system->cacheLineSize(),
+              _rwd_limit * p.write_high_thresh_perc / 100.0,
+              _rwd_limit * p.write_low_thresh_perc / 100.0,
+              p.sched_banks, p.sched_bank_interleave),
     sendEvent([this]{ trySendTiming(); }, _name)
 {
 }
@@ -32,18 +59,102 @@ CXLMemory::CXLRequestPort::CXLRequestPort(const std::string& _name,
 CXLMemory::CXLMemory(const Params &p)
     : PciDevice(p),
     cxlRspPort(p.name + ".cxl_rsp_port", *this, memReqPort,
-            ticksToCycles(p.proto_proc_lat), p.rsp_size, p.cxl_mem_range),
+            ticksToCycles(p.proto_proc_lat), p.rsp_size, p.ndr_size,
+            p.cxl_mem_range),
     memReqPort(p.name + ".mem_req_port", *this, cxlRspPort,
-            ticksToCycles(p.proto_proc_lat), p.req_size),
-    preRspTick(0),        
+            ticksToCycles(p.proto_proc_lat), p.req_size, p.rwd_size, p),
+    s2mLink(p.link_lanes, p.link_gen == enums::PCIe6 ? 64 : 32,
+            p.flit_size),
+    devLoadOptimal(p.devload_optimal_perc),
+    devLoadModerate(p.devload_moderate_perc),
+    devLoadSevere(p.devload_severe_perc),
+    preRspTick(0),
+    ldRanges(p.ld_ranges.empty() ? std::vector<AddrRange>{p.cxl_mem_range} :
+             p.ld_ranges),
+    dcBlockSize(p.dc_block_size), dpaRange(p.dpa_range),
+    dcSharedBlocks(p.dc_shared_blocks),
+    mailboxLat(p.mailbox_lat),
+    hotPageSize(p.hotness_page_size), hotDecay(p.hotness_decay),
+    hotRange(p.dc_block_size ? p.dpa_range : p.cxl_mem_range),
+    hotCount(hotPageSize ? divCeil(hotRange.size(), hotPageSize) : 0, 0),
+    hotEpoch(hotCount.size(), 0),
+    backdoorLat(p.backdoor_media_latency),
+    preloadFiles(p.preload_files), preloadOffsets(p.preload_offsets),
+    sfEntries(p.snoop_filter_entries),
+    blkSize(p.system->cacheLineSize()),
+    compression(p.compressor ?
+                new CXLCompressionStage(*this, *this, p,
+                                        dmaPort.requestorId) : nullptr),
+    prefetch(p.prefetcher ? new CXLPrefetchBuffer(*this, *this, p) :
+             nullptr),
+    nmp(*this, *this, p),
     stats(*this)
     {
         DPRINTF(CXLMemory, "BAR0_addr:0x%lx, BAR0_size:0x%lx\n",
             p.BAR0->addr(), p.BAR0->size());
+
+        fatal_if(HotCounters + hotCount.size() * 4 > p.BAR3->size(),
+                 "%s: the hotness BAR needs %#x bytes.\n", name(),
+                 HotCounters + hotCount.size() * 4);
+
+        fatal_if(devLoadOptimal > devLoadModerate ||
+                 devLoadModerate > devLoadSevere,
+                 "%s: the DevLoad thresholds must not decrease.\n", name());
+
+        fatal_if(p.nmp_buffer_size && pooled(),
+                 "%s: the NMP engine of a pooled device is not "
+                 "supported.\n", name());
+
+        fatal_if(preloadFiles.size() != preloadOffsets.size(),
+                 "%s: every preloaded file needs an offset.\n", name());
+
+        fatal_if(ldRanges.size() > 256,
+                 "%s: a pooled device has at most 256 LDs.\n", name());
+        fatal_if(sfEntries && ldRanges.size() > 8 * sizeof(SnoopMask),
+                 "%s: the snoop filter tracks at most %d LDs.\n", name(),
+                 8 * sizeof(SnoopMask));
+        if (pooled()) {
+            fatal_if(dpaRange.size() == 0 || dpaRange.size() % dcBlockSize,
+                     "%s: the media range must be a non-empty multiple of "
+                     "the dynamic capacity block size.\n", name());
+            dcUsed.resize(dpaRange.size() / dcBlockSize, false);
+            for (const auto &window : ldRanges) {
+                fatal_if(window.interleaved() || window.size() % dcBlockSize,
+                         "%s: LD window %s must be contiguous and a multiple "
+                         "of the dynamic capacity block size.\n", name(),
+                         window.to_string());
+                dcMap.emplace_back(window.size() / dcBlockSize, -1);
+            }
+
+            // the shared blocks start the media and every LD window
+            fatal_if(dcSharedBlocks > dcUsed.size(),
+                     "%s: more shared blocks than the media holds.\n",
+                     name());
+            for (unsigned b = 0; b < dcSharedBlocks; ++b) {
+                dcUsed[b] = true;
+                for (auto &map : dcMap) {
+                    fatal_if(b >= map.size(), "%s: an LD window is too "
+                             "small for the shared blocks.\n", name());
+                    map[b] = b;
+                }
+            }
+
+            fatal_if(p.dc_initial_blocks.size() > ldRanges.size(),
+                     "%s: more initial capacity assignments than LDs.\n",
+                     name());
+            for (unsigned ld = 0; ld < p.dc_initial_blocks.size(); ++ld) {
+                Addr length = p.dc_initial_blocks[ld] * dcBlockSize;
+                if (length && addCapacity(ld, dcSharedBlocks * dcBlockSize,
+                                          length) != MboxSuccess) {
+                    fatal("%s: cannot assign %d blocks to LD %d.\n", name(),
+                          p.dc_initial_blocks[ld], ld);
+                }
+            }
+        }
     }
 
 CXLMemory::CXLCtrlStats::CXLCtrlStats(CXLMemory &_cxlMemory)
-    : statistics::Group(&_cxlMemory),
+    : statistics::Group(&_cxlMemory), cxlMemory(_cxlMemory),
 
       ADD_STAT(reqQueFullEvents, statistics::units::Count::get(),
                "Number of times the request queue has become full"),
@@ -63,28 +174,115 @@ CXLMemory::CXLCtrlStats::CXLCtrlStats(CXLMemory &_cxlMemory)
       ADD_STAT(rspQueueLenDist, "Response queue length distribution (Count)"),
       ADD_STAT(rspOutStandDist, "outstandingResponses distribution (Count)"),
       ADD_STAT(reqQueueLatDist, "Response queue latency distribution (Tick)"),
+      ADD_STAT(readQueueLat, statistics::units::Tick::get(),
+               "Time reads spent in the request queue"),
+      ADD_STAT(reqReordered, statistics::units::Count::get(),
+               "Number of requests sent to the media ahead of an older "
+               "request"),
+      ADD_STAT(writeDrains, statistics::units::Count::get(),
+               "Number of times the queued writes reached the high "
+               "threshold and were drained ahead of the reads"),
       ADD_STAT(rspQueueLatDist, "Response queue latency distribution (Tick)"),
       ADD_STAT(memToCXLCtrlRsp, "Distribution of the time intervals between "
-               "consecutive mem responses from the memory media to the CXLCtrl (Cycle)")
+               "consecutive mem responses from the memory media to the CXLCtrl (Cycle)"),
+      ADD_STAT(linkMsgs, statistics::units::Count::get(),
+               "Number of CXL.mem messages sent on the S2M link"),
+      ADD_STAT(linkFlits, statistics::units::Count::get(),
+               "Number of flits sent on the S2M link"),
+      ADD_STAT(linkDelay, statistics::units::Tick::get(),
+               "Total time S2M messages spent waiting for and being "
+               "serialised onto the link"),
+      ADD_STAT(avgLinkDelay, statistics::units::Rate<
+                    statistics::units::Tick, statistics::units::Count>::get(),
+               "Average S2M link delay per message",
+               linkDelay / linkMsgs),
+      ADD_STAT(devLoad, statistics::units::Count::get(),
+               "Number of S2M responses by the DevLoad they reported"),
+      ADD_STAT(dcUnmapped, statistics::units::Count::get(),
+               "Number of accesses to capacity not assigned to the host"),
+      ADD_STAT(dcAdds, statistics::units::Count::get(),
+               "Number of dynamic capacity assignments"),
+      ADD_STAT(dcReleases, statistics::units::Count::get(),
+               "Number of dynamic capacity releases"),
+      ADD_STAT(ldReqs, statistics::units::Count::get(),
+               "Number of media accesses per logical device"),
+      ADD_STAT(biSnoops, statistics::units::Count::get(),
+               "Number of back-invalidate snoops sent to the hosts"),
+      ADD_STAT(biDirty, statistics::units::Count::get(),
+               "Number of back-invalidate snoops answered with dirty data"),
+      ADD_STAT(biConflicts, statistics::units::Count::get(),
+               "Number of requests that took a line from other hosts"),
+      ADD_STAT(sfEvictions, statistics::units::Count::get(),
+               "Number of lines evicted from the snoop filter"),
+      ADD_STAT(biHeldReqs, statistics::units::Count::get(),
+               "Number of requests held for the dirty data of a "
+               "back-invalidation"),
+      ADD_STAT(biLatency, statistics::units::Tick::get(),
+               "Round trip time of the back-invalidate snoops"),
+      ADD_STAT(pageHotness, statistics::units::Count::get(),
+               "Decayed access count of each tracked page"),
+      ADD_STAT(backdoorAccesses, statistics::units::Count::get(),
+               "Number of atomic accesses served through the backdoor of "
+               "the media")
 {
+    ldReqs
+        .init(_cxlMemory.ldRanges.size())
+        .flags(statistics::nozero);
+    devLoad
+        .init(NumCXLDevLoads)
+        .subname(CXLLightLoad, "light")
+        .subname(CXLOptimalLoad, "optimal")
+        .subname(CXLModerateOverload, "moderate")
+        .subname(CXLSevereOverload, "severe")
+        .flags(statistics::nozero);
+    for (unsigned i = 0; i < _cxlMemory.ldRanges.size(); ++i)
+        ld.emplace_back(new CXLLdStats(this, i));
     reqQueueLenDist
-        .init(0, 49, 10)
+        .init()
         .flags(statistics::nozero);
     rspQueueLenDist
-        .init(0, 49, 10)
+        .init()
         .flags(statistics::nozero);
     rspOutStandDist
-        .init(0, 49, 10)
+        .init()
         .flags(statistics::nozero);
     reqQueueLatDist
-        .init(12000, 41999, 1000)
+        .init()
+        .flags(statistics::nozero);
+    readQueueLat
+        .init()
         .flags(statistics::nozero);
     rspQueueLatDist
-        .init(12000, 41999, 1000)
+        .init()
         .flags(statistics::nozero);
     memToCXLCtrlRsp
-        .init(0, 299, 10)
+        .init()
         .flags(statistics::nozero);
+    biLatency
+        .init()
+        .flags(statistics::nozero);
+    pageHotness
+        .init(std::max<size_t>(_cxlMemory.hotCount.size(), 1))
+        .flags(statistics::nozero);
+}
+
+CXLMemory::CXLLdStats::CXLLdStats(statistics::Group *parent, unsigned ld)
+    : statistics::Group(parent, csprintf("ld%d", ld).c_str()),
+      ADD_STAT(latency, statistics::units::Tick::get(),
+               "Device latency of the media accesses of the logical device")
+{
+    latency
+        .init()
+        .flags(statistics::nozero);
+}
+
+void
+CXLMemory::CXLCtrlStats::preDumpStats()
+{
+    statistics::Group::preDumpStats();
+
+    for (Addr page = 0; page < cxlMemory.hotCount.size(); ++page)
+        pageHotness[page] = cxlMemory.hotness(page);
 }
 
 Port & 
@@ -109,6 +307,91 @@ CXLMemory::init()
     cxlRspPort.sendRangeChange();
 }
 
+void
+CXLMemory::regProbePoints()
+{
+    PciDevice::regProbePoints();
+
+    if (prefetch)
+        prefetch->regProbePoints(getProbeManager());
+}
+
+void
+CXLMemory::initState()
+{
+    PciDevice::initState();
+
+    for (unsigned i = 0; i < preloadFiles.size(); ++i)
+        preload(preloadFiles[i], preloadOffsets[i]);
+}
+
+void
+CXLMemory::preload(const std::string &path, Addr offset)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    fatal_if(fd < 0, "%s: cannot open %s: %s.\n", name(), path,
+             strerror(errno));
+    struct stat st;
+    fatal_if(fstat(fd, &st) < 0, "%s: cannot stat %s: %s.\n", name(), path,
+             strerror(errno));
+    Addr size = st.st_size;
+
+    const AddrRange &range = pooled() ? dpaRange : ldRanges[0];
+    fatal_if(offset + size > range.end() - range.start(),
+             "%s: %s (%#x bytes) does not fit at offset %#x of %s.\n",
+             name(), path, size, offset, range.to_string());
+    if (size == 0) {
+        close(fd);
+        return;
+    }
+
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    fatal_if(map == MAP_FAILED, "%s: cannot map %s: %s.\n", name(), path,
+             strerror(errno));
+    const uint8_t *data = static_cast<const uint8_t *>(map);
+    Addr start = range.start() + offset;
+
+    const auto &physmem = sys->getPhysMem();
+    const auto backing_store = physmem.getBackingStore();
+    Addr copied = 0;
+
+    // an interleaved device only holds every n-th chunk of its window
+    for (ChunkGenerator gen(start, size,
+                            range.interleaved() ? range.granularity() : 0);
+         !gen.done(); gen.next()) {
+        if (!range.contains(gen.addr()))
+            continue;
+
+        const uint8_t *src = data + (gen.addr() - start);
+        AddrRange chunk = RangeSize(gen.addr(), gen.size());
+        auto store = std::find_if(backing_store.begin(), backing_store.end(),
+            [&chunk](const memory::BackingStoreEntry &entry) {
+                return chunk.isSubset(entry.range);
+            });
+        if (store != backing_store.end()) {
+            std::memcpy(store->pmem + gen.addr() - store->range.start(), src,
+                        gen.size());
+        } else {
+            // media without a backing store in the system, write it line
+            // by line through the memory controller
+            for (ChunkGenerator line(gen.addr(), gen.size(), blkSize);
+                 !line.done(); line.next()) {
+                auto req = std::make_shared<Request>(line.addr(),
+                    line.size(), 0, Request::funcRequestorId);
+                Packet pkt(req, MemCmd::WriteReq);
+                pkt.dataStaticConst(src + (line.addr() - gen.addr()));
+                memReqPort.sendFunctional(&pkt);
+            }
+        }
+        copied += gen.size();
+    }
+
+    munmap(map, size);
+    DPRINTF(CXLMemory, "Preloaded %#x bytes of %s at %#x\n", copied, path,
+            start);
+}
+
 AddrRangeList
 CXLMemory::getAddrRanges() const
 {
@@ -116,9 +399,9 @@ CXLMemory::getAddrRanges() const
 }
 
 bool
-CXLMemory::CXLResponsePort::respQueueFull() const
+CXLMemory::CXLResponsePort::respQueueFull(CXLMemChannel channel) const
 {
-    if (outstandingResponses == respQueueLimit) {
+    if (outstandingResponses[channel] == respQueueLimit[channel]) {
         cxlMemory.stats.rspQueFullEvents++;
         return true;
     } else {
@@ -127,9 +410,11 @@ CXLMemory::CXLResponsePort::respQueueFull() const
 }
 
 bool
-CXLMemory::CXLRequestPort::reqQueueFull() const
+CXLMemory::CXLRequestPort::reqQueueFull(CXLMemChannel channel) const
 {
-    if (transmitList.size() == reqQueueLimit) {
+    // requests held for back-invalidations, metadata or prefetches take
+    // their entry with them
+    if (!hasCredit(channel)) {
         cxlMemory.stats.reqQueFullEvents++;
         return true;
     } else {
@@ -147,6 +432,26 @@ CXLMemory::CXLRequestPort::recvTimingResp(PacketPtr pkt)
 
     DPRINTF(CXLMemory, "Request queue size: %d\n", transmitList.size());
 
+    CXLLatencyExtension::stamp(pkt, CXLLatencyExtension::MediaOut);
+
+    scheduler.done(pkt->getAddr());
+
+    if (cxlMemory.compression &&
+        cxlMemory.compression->isMetadataRead(pkt->req)) {
+        cxlMemory.compression->response(pkt);
+        return true;
+    }
+
+    if (cxlMemory.prefetch && cxlMemory.prefetch->isPrefetch(pkt->req)) {
+        cxlMemory.prefetch->response(pkt);
+        return true;
+    }
+
+    if (cxlMemory.nmp.isAccess(pkt->req)) {
+        cxlMemory.nmp.response(pkt);
+        return true;
+    }
+
     if (cxlMemory.preRspTick == -1) {
         cxlMemory.preRspTick = cxlMemory.clockEdge();
     } else {
@@ -160,8 +465,14 @@ CXLMemory::CXLRequestPort::recvTimingResp(PacketPtr pkt)
     Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
     pkt->headerDelay = pkt->payloadDelay = 0;
 
-    cxlRspPort.schedTimingResp(pkt, cxlMemory.clockEdge(protoProcLat) +
-                              receive_delay);
+    Tick when = cxlMemory.s2mTransmit(pkt,
+        cxlMemory.clockEdge(protoProcLat) + receive_delay +
+        cxlMemory.decompress(pkt));
+
+    if (cxlMemory.pooled())
+        cxlMemory.poolResponse(pkt, when);
+
+    cxlRspPort.schedTimingResp(pkt, when);
 
     return true;
 }
@@ -178,29 +489,41 @@ CXLMemory::CXLResponsePort::recvTimingReq(PacketPtr pkt)
     if (retryReq)
         return false;
 
-    DPRINTF(CXLMemory, "Response queue size: %d outresp: %d\n",
-            transmitList.size(), outstandingResponses);
+    DPRINTF(CXLMemory, "Response queue size: %d outresp: %d/%d\n",
+            transmitList.size(), outstandingResponses[CXLReqChannel],
+            outstandingResponses[CXLRwDChannel]);
+
+    // reads and writes hold credits of their own channels, so a burst
+    // of writes does not keep the reads out
+    CXLMemChannel channel = cxlChannel(pkt);
 
     // if the request queue is full then there is no hope
-    if (memReqPort.reqQueueFull()) {
+    if (memReqPort.reqQueueFull(channel)) {
         DPRINTF(CXLMemory, "Request queue full\n");
         retryReq = true;
+        stalledChannel = channel;
+        stalledOnReq = true;
     } else {
         // look at the response queue if we expect to see a response
         bool expects_response = pkt->needsResponse();
         if (expects_response) {
-            if (respQueueFull()) {
+            if (respQueueFull(channel)) {
                 DPRINTF(CXLMemory, "Response queue full\n");
                 retryReq = true;
+                stalledChannel = channel;
+                stalledOnReq = false;
             } else {
                 // ok to send the request with space for the response
                 DPRINTF(CXLMemory, "Reserving space for response\n");
-                assert(outstandingResponses != respQueueLimit);
-                ++outstandingResponses;
+                assert(outstandingResponses[channel] !=
+                       respQueueLimit[channel]);
+                ++outstandingResponses[channel];
 
                 // no need to set retryReq to false as this is already the
                 // case
-                cxlMemory.stats.rspOutStandDist.sample(outstandingResponses);
+                cxlMemory.stats.rspOutStandDist.sample(
+                    outstandingResponses[CXLReqChannel] +
+                    outstandingResponses[CXLRwDChannel]);
             }
         }
 
@@ -208,8 +531,29 @@ CXLMemory::CXLResponsePort::recvTimingReq(PacketPtr pkt)
             Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
             pkt->headerDelay = pkt->payloadDelay = 0;
 
-            memReqPort.schedTimingReq(pkt, cxlMemory.clockEdge(protoProcLat) +
-                                      receive_delay);
+            CXLLatencyExtension::stamp(pkt, CXLLatencyExtension::DeviceIn);
+
+            if (cxlMemory.pooled() && !cxlMemory.poolRequest(pkt)) {
+                // no capacity is assigned to the host at this address,
+                // the controller answers without accessing the media
+                if (pkt->needsResponse()) {
+                    schedTimingResp(pkt, cxlMemory.s2mTransmit(pkt,
+                        cxlMemory.clockEdge(protoProcLat) + receive_delay));
+                } else {
+                    pendingDelete.reset(pkt);
+                }
+                return true;
+            }
+
+            cxlMemory.trackHotness(pkt);
+
+            Tick when = cxlMemory.clockEdge(protoProcLat) + receive_delay;
+            if (cxlMemory.sfEntries &&
+                !cxlMemory.snoopFilterRequest(pkt, when, true)) {
+                // the request waits for the hosts' dirty data
+                return true;
+            }
+            cxlMemory.toMedia(pkt, when);
         }
     }
 
@@ -221,9 +565,9 @@ CXLMemory::CXLResponsePort::recvTimingReq(PacketPtr pkt)
 }
 
 void
-CXLMemory::CXLResponsePort::retryStalledReq()
+CXLMemory::CXLResponsePort::retryStalledReq(CXLMemChannel channel)
 {
-    if (retryReq) {
+    if (retryReq && (!stalledOnReq || stalledChannel == channel)) {
         DPRINTF(CXLMemory, "Request waiting for retry, now retrying\n");
         retryReq = false;
         sendRetryReq();
@@ -237,14 +581,25 @@ CXLMemory::CXLRequestPort::schedTimingReq(PacketPtr pkt, Tick when)
     // If we're about to put this packet at the head of the queue, we
     // need to schedule an event to do the transmit.  Otherwise there
     // should already be an event scheduled for sending the head
-    // packet.
+    // packet, or the queue waits for a retry. A scheduler that
+    // reorders may send this packet before the ones ahead of it.
     if (transmitList.empty()) {
         cxlMemory.schedule(sendEvent, when);
+    } else if (scheduler.reorders() && sendEvent.scheduled() &&
+               when < sendEvent.when()) {
+        cxlMemory.reschedule(sendEvent, when);
     }
 
-    assert(transmitList.size() != reqQueueLimit);
+    // the dirty lines the hosts send back for back-invalidations, and
+    // the metadata the device reads itself, go regardless of the credits
+    // the requests use
+    CXLMemChannel channel = cxlChannel(pkt);
+    assert(queued[channel] < reqQueueLimit[channel] || pkt->isEviction() ||
+           (cxlMemory.compression &&
+            cxlMemory.compression->isMetadataRead(pkt->req)));
 
     transmitList.emplace_back(pkt, when);
+    ++queued[channel];
 
     cxlMemory.stats.reqQueueLenDist.sample(transmitList.size());
 }
@@ -266,7 +621,23 @@ CXLMemory::CXLRequestPort::trySendTiming()
 {
     assert(!transmitList.empty());
 
-    DeferredPacket req = transmitList.front();
+    if (scheduler.updateDrain(queued[CXLRwDChannel]))
+        cxlMemory.stats.writeDrains++;
+
+    Tick next_ready;
+    int index = scheduler.pick(transmitList,
+        [](const DeferredPacket &req) {
+            return CXLReqScheduler::Entry{req.pkt->getAddr(),
+                                          req.pkt->isWrite(), req.tick};
+        }, curTick(), next_ready);
+    if (index < 0) {
+        // the ready requests have to wait for older ones to the line
+        assert(next_ready != MaxTick);
+        cxlMemory.schedule(sendEvent, next_ready);
+        return;
+    }
+
+    DeferredPacket req = transmitList[index];
 
     assert(req.tick <= curTick());
 
@@ -275,21 +646,40 @@ CXLMemory::CXLRequestPort::trySendTiming()
     DPRINTF(CXLMemory, "trySend request addr 0x%x, queue size %d\n",
             pkt->getAddr(), transmitList.size());
 
+    // the media may free a request it does not respond to
+    const bool is_read = pkt->isRead();
+    const CXLMemChannel channel = cxlChannel(pkt);
+    const bool needs_response = pkt->needsResponse();
+    const Addr addr = pkt->getAddr();
+
+    CXLLatencyExtension::stamp(pkt, CXLLatencyExtension::MediaIn);
     if (sendTimingReq(pkt)) {
         // send successful
         cxlMemory.stats.reqSendSucceed++;
         cxlMemory.stats.reqQueueLatDist.sample(curTick() - req.entryTime);
+        if (is_read)
+            cxlMemory.stats.readQueueLat.sample(curTick() - req.entryTime);
+        if (index > 0)
+            cxlMemory.stats.reqReordered++;
 
-        transmitList.pop_front();
+        if (needs_response)
+            scheduler.sent(addr);
+
+        transmitList.erase(transmitList.begin() + index);
+        --queued[channel];
 
         cxlMemory.stats.reqQueueLenDist.sample(transmitList.size());
         DPRINTF(CXLMemory, "trySend request successful\n");
 
         // If there are more packets to send, schedule event to try again.
         if (!transmitList.empty()) {
-            DeferredPacket next_req = transmitList.front();
+            Tick next = transmitList.front().tick;
+            if (scheduler.reorders()) {
+                for (const auto &next_req : transmitList)
+                    next = std::min(next, next_req.tick);
+            }
             DPRINTF(CXLMemory, "Scheduling next send\n");
-            cxlMemory.schedule(sendEvent, std::max(next_req.tick,
+            cxlMemory.schedule(sendEvent, std::max(next,
                                                 cxlMemory.clockEdge()));
         }
 
@@ -297,7 +687,13 @@ CXLMemory::CXLRequestPort::trySendTiming()
         // then send a retry at this point, also note that if the
         // request we stalled was waiting for the response queue
         // rather than the request queue we might stall it again
-        cxlRspPort.retryStalledReq();
+        cxlRspPort.retryStalledReq(channel);
+
+        // a prefetch or the NMP engine takes the credit if the hosts
+        // leave it
+        if (cxlMemory.prefetch)
+            cxlMemory.prefetch->schedulePrefetch();
+        cxlMemory.nmp.retry();
     } else {
         cxlMemory.stats.reqSendFaild++;
     }
@@ -316,10 +712,12 @@ CXLMemory::CXLResponsePort::trySendTiming()
     assert(resp.tick <= curTick());
 
     PacketPtr pkt = resp.pkt;
+    const CXLMemChannel channel = cxlChannel(pkt);
 
     DPRINTF(CXLMemory, "trySend response addr 0x%x, outstanding %d\n",
-            pkt->getAddr(), outstandingResponses);
+            pkt->getAddr(), outstandingResponses[channel]);
 
+    CXLLatencyExtension::stamp(pkt, CXLLatencyExtension::DeviceOut);
     if (sendTimingResp(pkt)) {
         // send successful
         cxlMemory.stats.rspSendSucceed++;
@@ -330,10 +728,12 @@ CXLMemory::CXLResponsePort::trySendTiming()
         cxlMemory.stats.rspQueueLenDist.sample(transmitList.size());
         DPRINTF(CXLMemory, "trySend response successful\n");
 
-        assert(outstandingResponses != 0);
-        --outstandingResponses;
+        assert(outstandingResponses[channel] != 0);
+        --outstandingResponses[channel];
 
-        cxlMemory.stats.rspOutStandDist.sample(outstandingResponses);
+        cxlMemory.stats.rspOutStandDist.sample(
+            outstandingResponses[CXLReqChannel] +
+            outstandingResponses[CXLRwDChannel]);
 
         // If there are more packets to send, schedule event to try again.
         if (!transmitList.empty()) {
@@ -343,10 +743,12 @@ CXLMemory::CXLResponsePort::trySendTiming()
                                                 cxlMemory.clockEdge()));
         }
 
-        // if there is space in the request queue and we were stalling
-        // a request, it will definitely be possible to accept it now
-        // since there is guaranteed space in the response queue
-        if (!memReqPort.reqQueueFull() && retryReq) {
+        // if a request stalled on the response credits of this channel,
+        // or on request credits that are free by now, it will
+        // definitely be possible to accept it now
+        if (retryReq && (stalledOnReq ?
+                         !memReqPort.reqQueueFull(stalledChannel) :
+                         stalledChannel == channel)) {
             DPRINTF(CXLMemory, "Request waiting for retry, now retrying\n");
             retryReq = false;
             sendRetryReq();
@@ -382,7 +784,37 @@ CXLMemory::CXLResponsePort::recvAtomic(PacketPtr pkt)
     
     Cycles delay = processCXLMem(pkt);
 
-    Tick access_delay = memReqPort.sendAtomic(pkt);
+    if (cxlMemory.pooled()) {
+        Addr hpa = pkt->getAddr();
+        Addr dpa;
+        if (!cxlMemory.translate(pkt->cxl_ld_id, hpa, dpa)) {
+            cxlMemory.unmappedAccess(pkt);
+            return delay * cxlMemory.clockPeriod();
+        }
+        cxlMemory.stats.ldReqs[pkt->cxl_ld_id]++;
+        pkt->setAddr(dpa);
+        cxlMemory.trackHotness(pkt);
+        Tick access_delay = cxlMemory.snoopFilterAtomic(pkt);
+        if (!cxlMemory.prefetch ||
+            !cxlMemory.prefetch->atomic(pkt, access_delay)) {
+            if (cxlMemory.compression)
+                access_delay += cxlMemory.compression->atomic(pkt);
+            access_delay += cxlMemory.atomicMedia(pkt);
+            access_delay += cxlMemory.decompress(pkt);
+        }
+        pkt->setAddr(hpa);
+        return delay * cxlMemory.clockPeriod() + access_delay;
+    }
+
+    cxlMemory.trackHotness(pkt);
+    Tick access_delay = cxlMemory.snoopFilterAtomic(pkt);
+    if (!cxlMemory.prefetch ||
+        !cxlMemory.prefetch->atomic(pkt, access_delay)) {
+        if (cxlMemory.compression)
+            access_delay += cxlMemory.compression->atomic(pkt);
+        access_delay += cxlMemory.atomicMedia(pkt);
+        access_delay += cxlMemory.decompress(pkt);
+    }
 
     DPRINTF(CXLMemory, "access_delay=%ld, proto_proc_lat=%ld, total=%ld\n",
             access_delay, delay, delay * cxlMemory.clockPeriod() + access_delay);
@@ -393,12 +825,138 @@ Tick
 CXLMemory::CXLResponsePort::recvAtomicBackdoor(
     PacketPtr pkt, MemBackdoorPtr &backdoor)
 {
+    // a backdoor would expose the media at device physical addresses,
+    // and would bypass the snoop filter, the hotness tracker and the
+    // latency of the device
+    if (!cxlMemory.exposesBackdoor())
+        return recvAtomic(pkt);
+
     Cycles delay = processCXLMem(pkt);
 
     return delay * cxlMemory.clockPeriod() + memReqPort.sendAtomicBackdoor(
         pkt, backdoor);
 }
 
+void
+CXLMemory::CXLResponsePort::recvMemBackdoorReq(
+    const MemBackdoorReq &req, MemBackdoorPtr &backdoor)
+{
+    if (cxlMemory.exposesBackdoor())
+        memReqPort.sendMemBackdoorReq(req, backdoor);
+}
+
+Tick
+CXLMemory::atomicMedia(PacketPtr pkt)
+{
+    if (!backdoorLat)
+        return memReqPort.sendAtomic(pkt);
+
+    // plain reads and writes are copied straight from and to the media,
+    // anything else takes the way through the memory controller
+    auto it = mediaBackdoors.contains(pkt->getAddrRange());
+    if (it == mediaBackdoors.end() || pkt->isRead() == pkt->isWrite() ||
+        pkt->isLLSC() || (pkt->isWrite() && !it->second->writeable())) {
+        MemBackdoorPtr bd = nullptr;
+        Tick lat = memReqPort.sendAtomicBackdoor(pkt, bd);
+        if (bd && bd->ptr() &&
+            mediaBackdoors.insert(bd->range(), bd) != mediaBackdoors.end()) {
+            bd->addInvalidationCallback([this](const MemBackdoor &backdoor) {
+                for (auto bd_it = mediaBackdoors.begin();
+                     bd_it != mediaBackdoors.end(); ++bd_it) {
+                    if (bd_it->second == &backdoor) {
+                        mediaBackdoors.erase(bd_it);
+                        return;
+                    }
+                }
+                panic("Got invalidation for unknown memory backdoor.");
+            });
+        }
+        return lat;
+    }
+
+    uint8_t *media = it->second->ptr() + pkt->getAddr() -
+        it->second->range().start();
+    if (pkt->isRead())
+        pkt->setData(media);
+    else
+        pkt->writeData(media);
+    if (pkt->needsResponse())
+        pkt->makeResponse();
+    stats.backdoorAccesses++;
+    return backdoorLat;
+}
+
+void
+CXLMemory::CXLResponsePort::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    // check the response queue
+    for (const auto &resp : transmitList) {
+        if (pkt->trySatisfyFunctional(resp.pkt)) {
+            pkt->makeResponse();
+            pkt->popLabel();
+            return;
+        }
+    }
+
+    // everything past the response queue is at device physical
+    // addresses
+    Addr hpa = pkt->getAddr();
+    if (cxlMemory.pooled()) {
+        Addr dpa;
+        if (!cxlMemory.translate(pkt->cxl_ld_id, hpa, dpa)) {
+            // unassigned capacity reads as zeros and ignores writes
+            if (pkt->isRead())
+                std::memset(pkt->getPtr<uint8_t>(), 0, pkt->getSize());
+            pkt->makeResponse();
+            pkt->popLabel();
+            return;
+        }
+        pkt->setAddr(dpa);
+    }
+
+    // the prefetch buffer never holds newer data than the media
+    if (cxlMemory.prefetch && pkt->isWrite())
+        cxlMemory.prefetch->invalidate(pkt);
+
+    // requests held for back-invalidations or metadata, then the
+    // request queue
+    bool found = false;
+    for (auto it = cxlMemory.biLines.begin();
+         !found && it != cxlMemory.biLines.end(); ++it) {
+        for (auto held : it->second.waiting) {
+            if (pkt->trySatisfyFunctional(held)) {
+                pkt->makeResponse();
+                found = true;
+                break;
+            }
+        }
+    }
+    if (!found && cxlMemory.compression &&
+        cxlMemory.compression->trySatisfyFunctional(pkt)) {
+        pkt->makeResponse();
+        found = true;
+    }
+    if (!found && !memReqPort.trySatisfyFunctional(pkt))
+        memReqPort.sendFunctional(pkt);
+
+    pkt->setAddr(hpa);
+    pkt->popLabel();
+}
+
+bool
+CXLMemory::CXLRequestPort::trySatisfyFunctional(PacketPtr pkt)
+{
+    for (const auto &req : transmitList) {
+        if (pkt->trySatisfyFunctional(req.pkt)) {
+            pkt->makeResponse();
+            return true;
+        }
+    }
+    return false;
+}
+
 Cycles
 CXLMemory::CXLResponsePort::processCXLMem(PacketPtr pkt) {
     if (pkt->cxl_cmd == MemCmd::M2SReq) {
@@ -412,8 +970,811 @@ CXLMemory::CXLResponsePort::processCXLMem(PacketPtr pkt) {
 AddrRangeList
 CXLMemory::CXLResponsePort::getAddrRanges() const {
     AddrRangeList ranges = cxlMemory.getAddrRanges();
-    ranges.push_back(cxlMemRange);
+    if (cxlMemory.ldRanges.size() > 1) {
+        ranges.insert(ranges.end(), cxlMemory.ldRanges.begin(),
+                      cxlMemory.ldRanges.end());
+    } else {
+        ranges.push_back(cxlMemRange);
+    }
     return ranges;
 }
 
+Tick
+CXLMemory::s2mTransmit(PacketPtr pkt, Tick when)
+{
+    if (pkt->cxl_cmd == MemCmd::M2SReq || pkt->cxl_cmd == MemCmd::M2SRwD) {
+        // turn the response into its S2M message and serialise it onto
+        // the S2M direction of the link
+        pkt->cxl_cmd = pkt->cxl_cmd.responseCommand();
+        pkt->cxl_dev_load = devLoad();
+        stats.devLoad[pkt->cxl_dev_load]++;
+        uint64_t flits = s2mLink.flitsSent();
+        Tick sent = s2mLink.transmit(pkt, when);
+        stats.linkMsgs++;
+        stats.linkFlits += s2mLink.flitsSent() - flits;
+        stats.linkDelay += sent - when;
+        when = sent;
+    }
+    return when;
+}
+
+CXLDevLoad
+CXLMemory::devLoad() const
+{
+    unsigned int occupancy = std::max(memReqPort.occupancy(),
+                                      cxlRspPort.occupancy());
+    if (occupancy >= devLoadSevere)
+        return CXLSevereOverload;
+    else if (occupancy >= devLoadModerate)
+        return CXLModerateOverload;
+    else if (occupancy >= devLoadOptimal)
+        return CXLOptimalLoad;
+    else
+        return CXLLightLoad;
+}
+
+bool
+CXLMemory::translate(unsigned ld, Addr hpa, Addr &dpa) const
+{
+    if (ld >= ldRanges.size() || !ldRanges[ld].contains(hpa))
+        return false;
+
+    Addr offset = hpa - ldRanges[ld].start();
+    int64_t block = dcMap[ld][offset / dcBlockSize];
+    if (block < 0)
+        return false;
+
+    dpa = dpaRange.start() + block * dcBlockSize + offset % dcBlockSize;
+    return true;
+}
+
+void
+CXLMemory::unmappedAccess(PacketPtr pkt)
+{
+    DPRINTF(CXLMemory, "LD %d %s to unassigned capacity at 0x%x\n",
+            pkt->cxl_ld_id, pkt->cmdString(), pkt->getAddr());
+    stats.dcUnmapped++;
+    if (pkt->needsResponse()) {
+        if (pkt->isRead())
+            std::memset(pkt->getPtr<uint8_t>(), 0, pkt->getSize());
+        pkt->makeResponse();
+    }
+}
+
+bool
+CXLMemory::poolRequest(PacketPtr pkt)
+{
+    Addr dpa;
+    if (!translate(pkt->cxl_ld_id, pkt->getAddr(), dpa)) {
+        unmappedAccess(pkt);
+        return false;
+    }
+
+    stats.ldReqs[pkt->cxl_ld_id]++;
+    if (pkt->needsResponse())
+        pkt->pushSenderState(new PoolSenderState(pkt->getAddr(), curTick()));
+    pkt->setAddr(dpa);
+    return true;
+}
+
+void
+CXLMemory::poolResponse(PacketPtr pkt, Tick when)
+{
+    auto *state = safe_cast<PoolSenderState *>(pkt->popSenderState());
+    pkt->setAddr(state->hpa);
+    stats.ld[pkt->cxl_ld_id]->latency.sample(when - state->entry);
+    delete state;
+}
+
+bool
+CXLMemory::hostAddr(unsigned ld, Addr dpa, Addr &hpa) const
+{
+    if (!pooled()) {
+        hpa = dpa;
+        return true;
+    }
+
+    Addr offset = dpa - dpaRange.start();
+    int64_t block = offset / dcBlockSize;
+    const auto &map = dcMap[ld];
+    for (Addr b = 0; b < map.size(); ++b) {
+        if (map[b] == block) {
+            hpa = ldRanges[ld].start() + b * dcBlockSize +
+                offset % dcBlockSize;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+CXLMemory::snoopFilterRequest(PacketPtr pkt, Tick &when, bool timing)
+{
+    const Addr line = pkt->getBlockAddr(blkSize);
+    const SnoopMask req_mask = SnoopMask(1) << pkt->cxl_ld_id;
+    const bool allocates = pkt->isRead() && pkt->fromCache();
+
+    // a host that misses on a line holds no copy of it, whatever the
+    // filter still has after the host dropped a clean line silently
+    auto sf_it = cachedLines.find(line);
+    if (allocates && sf_it != cachedLines.end())
+        sf_it->second.holder &= ~req_mask;
+
+    // requests keep their order behind the back-invalidations of the
+    // line they access
+    if (biLines.count(line)) {
+        biLines[line].waiting.push_back(pkt);
+        ++biHeld[cxlChannel(pkt)];
+        stats.biHeldReqs++;
+        return false;
+    }
+
+    if (sf_it != cachedLines.end()) {
+        SnoopItem &item = sf_it->second;
+        if (pkt->isEviction()) {
+            item.holder &= ~req_mask;
+        } else if (allocates || (pkt->isWrite() && !pkt->fromCache())) {
+            // the device hands out exclusive copies only, so a host
+            // that caches or writes a line takes it from all others
+            SnoopMask others = item.holder & ~req_mask;
+            if (others) {
+                stats.biConflicts++;
+                item.holder &= ~others;
+                when = std::max(when,
+                                backInvalidate(line, others, when, timing));
+            }
+        }
+        if (!item.holder) {
+            sfLru.erase(item.lru);
+            cachedLines.erase(sf_it);
+            sf_it = cachedLines.end();
+        }
+    }
+
+    if (allocates) {
+        if (sf_it == cachedLines.end()) {
+            if (cachedLines.size() >= sfEntries) {
+                // the filter is inclusive, so the victim line has to go
+                // from all the host caches
+                Addr victim = sfLru.back();
+                SnoopMask holders = cachedLines[victim].holder;
+                sfLru.pop_back();
+                cachedLines.erase(victim);
+                stats.sfEvictions++;
+                backInvalidate(victim, holders, when, timing);
+            }
+            sfLru.push_front(line);
+            sf_it = cachedLines.emplace(line,
+                                        SnoopItem{0, sfLru.begin()}).first;
+        } else {
+            sfLru.splice(sfLru.begin(), sfLru, sf_it->second.lru);
+        }
+        sf_it->second.holder |= req_mask;
+    }
+
+    if (biLines.count(line)) {
+        biLines[line].waiting.push_back(pkt);
+        ++biHeld[cxlChannel(pkt)];
+        stats.biHeldReqs++;
+        return false;
+    }
+    return true;
+}
+
+Tick
+CXLMemory::snoopFilterAtomic(PacketPtr pkt)
+{
+    if (!sfEntries)
+        return 0;
+
+    Tick when = curTick();
+    [[maybe_unused]] bool proceed = snoopFilterRequest(pkt, when, false);
+    assert(proceed);
+    return when - curTick();
+}
+
+Tick
+CXLMemory::backInvalidate(Addr line, SnoopMask holders, Tick when,
+                          bool timing)
+{
+    Tick done = when;
+
+    for (unsigned ld = 0; holders; ++ld, holders >>= 1) {
+        Addr hpa;
+        if (!(holders & 1) || !hostAddr(ld, line, hpa))
+            continue;
+
+        // BISnpInv, the host gives up its copy and sends back dirty
+        // data, which the host caches do for an express ReadExReq snoop
+        RequestPtr req = std::make_shared<Request>(
+            hpa, blkSize, 0, dmaPort.requestorId);
+        PacketPtr snp = new Packet(req, MemCmd::ReadExReq);
+        snp->allocate();
+        snp->setExpressSnoop();
+        snp->cxl_ld_id = ld;
+        snp->cxl_cmd = MemCmd::S2MBISnp;
+        stats.biSnoops++;
+
+        DPRINTF(CXLMemory, "BISnp LD %d line 0x%x at 0x%x\n", ld, line, hpa);
+
+        if (timing) {
+            uint64_t flits = s2mLink.flitsSent();
+            Tick sent = s2mLink.transmit(snp, when);
+            stats.linkMsgs++;
+            stats.linkFlits += s2mLink.flitsSent() - flits;
+            stats.linkDelay += sent - when;
+
+            snp->headerDelay = sent - curTick();
+            cxlRspPort.sendTimingSnoopReq(snp);
+
+            if (snp->cacheResponding()) {
+                // the data follows in a snoop response
+                biSnoops[req] = BISnoop{line, curTick()};
+                biLines[line].outstanding++;
+                stats.biDirty++;
+            } else {
+                // the BIRsp takes one flit back
+                Tick rsp = curTick() + snp->headerDelay + s2mLink.flitTime();
+                stats.biLatency.sample(rsp - curTick());
+                done = std::max(done, rsp);
+            }
+        } else {
+            Tick lat = cxlRspPort.sendAtomicSnoop(snp);
+            if (snp->cacheResponding()) {
+                Packet wb(std::make_shared<Request>(line, blkSize, 0,
+                                                    dmaPort.requestorId),
+                          MemCmd::WritebackDirty);
+                wb.dataStatic(snp->getPtr<uint8_t>());
+                lat += memReqPort.sendAtomic(&wb);
+                stats.biDirty++;
+            }
+            stats.biLatency.sample(lat);
+            done = std::max(done, when + lat);
+        }
+        delete snp;
+    }
+
+    return done;
+}
+
+bool
+CXLMemory::CXLResponsePort::recvTimingSnoopResp(PacketPtr pkt)
+{
+    DPRINTF(CXLMemory, "recvTimingSnoopResp: %s addr 0x%x\n",
+            pkt->cmdString(), pkt->getAddr());
+    cxlMemory.biResponse(pkt);
+    return true;
+}
+
+void
+CXLMemory::biResponse(PacketPtr pkt)
+{
+    auto snoop = biSnoops.find(pkt->req);
+    assert(snoop != biSnoops.end());
+    const Addr line = snoop->second.line;
+    Tick ready = clockEdge() + pkt->headerDelay + pkt->payloadDelay;
+    stats.biLatency.sample(ready - snoop->second.start);
+    biSnoops.erase(snoop);
+
+    // the dirty line reaches the media before any request waiting
+    // for it, as they queue up behind it
+    RequestPtr req = std::make_shared<Request>(line, blkSize, 0,
+                                               dmaPort.requestorId);
+    PacketPtr wb = new Packet(req, MemCmd::WritebackDirty);
+    wb->allocate();
+    wb->setData(pkt->getConstPtr<uint8_t>());
+    delete pkt;
+    toMedia(wb, ready);
+
+    BIWait &wait = biLines[line];
+    assert(wait.outstanding);
+    wait.ready = std::max(wait.ready, ready);
+    if (--wait.outstanding == 0)
+        releaseLine(line);
+}
+
+void
+CXLMemory::releaseLine(Addr line)
+{
+    auto it = biLines.find(line);
+    BIWait wait = std::move(it->second);
+    biLines.erase(it);
+
+    // the requests go through the filter again in order, and may well
+    // start the next back-invalidations of the line
+    for (auto pkt : wait.waiting) {
+        --biHeld[cxlChannel(pkt)];
+        Tick when = std::max(wait.ready, clockEdge());
+        if (snoopFilterRequest(pkt, when, true))
+            toMedia(pkt, when);
+    }
+}
+
+Tick
+CXLMemory::decompress(PacketPtr pkt)
+{
+    return compression ? compression->decompress(pkt) : 0;
+}
+
+void
+CXLMemory::toMedia(PacketPtr pkt, Tick when)
+{
+    // the prefetcher is trained on, and serves, the reads of the hosts
+    if (prefetch && (pkt->isWrite() ||
+                     pkt->req->requestorId() != nmp.requestorId()) &&
+        !prefetch->request(pkt, when)) {
+        return;
+    }
+    if (compression && !compression->request(pkt, when, true))
+        return;
+    memReqPort.schedTimingReq(pkt, when);
+}
+
+void
+CXLMemory::queueMedia(PacketPtr pkt, Tick when)
+{
+    memReqPort.schedTimingReq(pkt, when);
+}
+
+bool
+CXLMemory::hasCredit(CXLMemChannel channel) const
+{
+    return memReqPort.hasCredit(channel);
+}
+
+Tick
+CXLMemory::atomicAccess(PacketPtr pkt)
+{
+    if (prefetch && pkt->isWrite())
+        prefetch->invalidate(pkt);
+    Tick lat = compression ? compression->atomic(pkt) : 0;
+    lat += atomicMedia(pkt);
+    return lat + decompress(pkt);
+}
+
+Tick
+CXLMemory::sendAtomic(PacketPtr pkt)
+{
+    return memReqPort.sendAtomic(pkt);
+}
+
+void
+CXLMemory::respond(PacketPtr pkt, Tick when)
+{
+    when = s2mTransmit(pkt, when);
+    if (pooled())
+        poolResponse(pkt, when);
+    cxlRspPort.schedTimingResp(pkt, when);
+}
+
+void
+CXLMemory::retryStalledReq(CXLMemChannel channel)
+{
+    cxlRspPort.retryStalledReq(channel);
+}
+
+bool
+CXLMemory::mediaAddr(unsigned ld, Addr hpa, Addr &dpa) const
+{
+    if (pooled())
+        return translate(ld, hpa, dpa);
+
+    for (const auto &window : ldRanges) {
+        if (window.contains(hpa)) {
+            dpa = hpa;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+CXLMemory::hostWrite(Addr addr, int size, Event *event, uint8_t *data)
+{
+    dmaWrite(addr, size, event, data);
+}
+
+bool
+CXLMemory::timingMode() const
+{
+    return sys->isTimingMode();
+}
+
+unsigned
+CXLMemory::held(CXLMemChannel channel) const
+{
+    return biHeld[channel] +
+        (compression ? compression->held(channel) : 0) +
+        (prefetch ? prefetch->held(channel) : 0);
+}
+
+uint64_t
+CXLMemory::freeBlocks() const
+{
+    return std::count(dcUsed.begin(), dcUsed.end(), false);
+}
+
+CXLMemory::MboxRetCode
+CXLMemory::addCapacity(unsigned ld, Addr offset, Addr length)
+{
+    if (!pooled())
+        return MboxUnsupported;
+    if (ld >= dcMap.size() || length == 0 || offset % dcBlockSize ||
+        length % dcBlockSize || offset + length > ldRanges[ld].size())
+        return MboxInvalidInput;
+
+    auto &map = dcMap[ld];
+    Addr first = offset / dcBlockSize;
+    Addr last = first + length / dcBlockSize;
+    for (Addr b = first; b < last; ++b) {
+        if (map[b] >= 0)
+            return MboxInvalidInput;
+    }
+    if (freeBlocks() < last - first)
+        return MboxNoCapacity;
+
+    // the media blocks of an extent need not be contiguous
+    int64_t block = 0;
+    for (Addr b = first; b < last; ++b) {
+        while (dcUsed[block])
+            ++block;
+        dcUsed[block] = true;
+        map[b] = block;
+    }
+
+    DPRINTF(CXLMemory, "LD %d assigned %#x bytes at window offset %#x\n",
+            ld, length, offset);
+    stats.dcAdds++;
+    return MboxSuccess;
+}
+
+CXLMemory::MboxRetCode
+CXLMemory::releaseCapacity(unsigned ld, Addr offset, Addr length)
+{
+    if (!pooled())
+        return MboxUnsupported;
+    if (ld >= dcMap.size() || length == 0 || offset % dcBlockSize ||
+        length % dcBlockSize || offset + length > ldRanges[ld].size())
+        return MboxInvalidInput;
+
+    auto &map = dcMap[ld];
+    Addr first = offset / dcBlockSize;
+    Addr last = first + length / dcBlockSize;
+    for (Addr b = first; b < last; ++b) {
+        if (map[b] < 0)
+            return MboxInvalidInput;
+    }
+    for (Addr b = first; b < last; ++b) {
+        // the other LDs keep the shared blocks
+        if (map[b] >= int64_t(dcSharedBlocks)) {
+            sanitize(dpaRange.start() + map[b] * dcBlockSize, dcBlockSize);
+            dcUsed[map[b]] = false;
+        }
+        map[b] = -1;
+    }
+
+    DPRINTF(CXLMemory, "LD %d released %#x bytes at window offset %#x\n",
+            ld, length, offset);
+    stats.dcReleases++;
+    return MboxSuccess;
+}
+
+void
+CXLMemory::sanitize(Addr start, Addr size)
+{
+    const auto &physmem = sys->getPhysMem();
+    const auto backing_store = physmem.getBackingStore();
+    AddrRange block = RangeSize(start, size);
+    auto store = std::find_if(backing_store.begin(), backing_store.end(),
+        [&block](const memory::BackingStoreEntry &entry) {
+            return block.isSubset(entry.range);
+        });
+    if (store != backing_store.end()) {
+        std::memset(store->pmem + start - store->range.start(), 0, size);
+    } else {
+        std::vector<uint8_t> zeros(blkSize, 0);
+        for (Addr line = start; line < start + size; line += blkSize) {
+            auto req = std::make_shared<Request>(line, blkSize, 0,
+                                                 Request::funcRequestorId);
+            Packet pkt(req, MemCmd::WriteReq);
+            pkt.dataStaticConst(zeros.data());
+            memReqPort.sendFunctional(&pkt);
+        }
+    }
+
+    // the snoop filter is small, so it is walked rather than the block
+    for (auto sf_it = cachedLines.begin(); sf_it != cachedLines.end();) {
+        if (block.contains(sf_it->first)) {
+            sfLru.erase(sf_it->second.lru);
+            sf_it = cachedLines.erase(sf_it);
+        } else {
+            ++sf_it;
+        }
+    }
+
+    // pages the block shares with others keep their counts
+    if (hotPageSize) {
+        Addr offset = hotRange.getOffset(start);
+        for (Addr page = divCeil(offset, hotPageSize);
+             page < (offset + size) / hotPageSize; ++page) {
+            hotCount[page] = 0;
+        }
+    }
+
+    if (prefetch)
+        prefetch->invalidate(start, size);
+    if (compression)
+        compression->release(start, size);
+
+    DPRINTF(CXLMemory, "Sanitised %#x bytes at DPA %#x\n", size, start);
+}
+
+void
+CXLMemory::executeMailbox()
+{
+    unsigned ld = mboxArgs[0];
+    Addr offset = mboxArgs[1];
+    Addr length = mboxArgs[2];
+
+    switch (mboxCmd & mask(16)) {
+      case MboxGetDCConfig:
+        mboxStatus = pooled() ? MboxSuccess : MboxUnsupported;
+        mboxOut[0] = dcBlockSize;
+        break;
+      case MboxAddDC:
+        mboxStatus = addCapacity(ld, offset, length);
+        break;
+      case MboxReleaseDC:
+        mboxStatus = releaseCapacity(ld, offset, length);
+        break;
+      default:
+        mboxStatus = MboxUnsupported;
+        break;
+    }
+
+    if ((mboxCmd & mask(16)) != MboxGetDCConfig && ld < dcMap.size()) {
+        mboxOut[0] = (dcMap[ld].size() - std::count(dcMap[ld].begin(),
+                          dcMap[ld].end(), -1)) * dcBlockSize;
+    }
+    mboxOut[1] = pooled() ? freeBlocks() : 0;
+
+    DPRINTF(CXLMemory, "mailbox command %#x returned %#x\n", mboxCmd,
+            mboxStatus);
+}
+
+uint64_t
+CXLMemory::mailboxReg(Addr offset) const
+{
+    switch (offset) {
+      case MboxCap:
+        // number of LDs and of dynamic capacity blocks
+        return ldRanges.size() | uint64_t(dcUsed.size()) << 32;
+      case MboxCtrl:
+        // commands complete immediately, so the doorbell reads clear
+        return 0;
+      case MboxCmd:
+        return mboxCmd;
+      case MboxStatus:
+        return mboxStatus;
+      case MboxArgLd:
+      case MboxArgOffset:
+      case MboxArgLength:
+        return mboxArgs[(offset - MboxArgLd) / 8];
+      case MboxOut0:
+      case MboxOut1:
+        return mboxOut[(offset - MboxOut0) / 8];
+      default:
+        return 0;
+    }
+}
+
+Tick
+CXLMemory::mailboxRead(PacketPtr pkt, Addr offset)
+{
+    panic_if((pkt->getSize() != 4 && pkt->getSize() != 8) ||
+             offset % pkt->getSize(),
+             "%s: invalid mailbox access of %d bytes at %#x\n", name(),
+             pkt->getSize(), offset);
+
+    // the registers are 64 bits wide, either half can be read with a
+    // 32-bit access
+    uint64_t val = mailboxReg(offset & ~Addr(0x7)) >> ((offset & 0x4) * 8);
+    if (pkt->getSize() == 8)
+        pkt->setLE<uint64_t>(val);
+    else
+        pkt->setLE<uint32_t>(val);
+
+    pkt->makeAtomicResponse();
+    return mailboxLat;
+}
+
+Tick
+CXLMemory::mailboxWrite(PacketPtr pkt, Addr offset)
+{
+    panic_if((pkt->getSize() != 4 && pkt->getSize() != 8) ||
+             offset % pkt->getSize(),
+             "%s: invalid mailbox access of %d bytes at %#x\n", name(),
+             pkt->getSize(), offset);
+
+    uint64_t val = pkt->getSize() == 8 ? pkt->getLE<uint64_t>() :
+        pkt->getLE<uint32_t>();
+    unsigned shift = (offset & 0x4) * 8;
+    auto write_reg = [&](uint64_t &reg) {
+        if (pkt->getSize() == 8)
+            reg = val;
+        else
+            reg = (reg & ~(mask(32) << shift)) | (val << shift);
+    };
+
+    Addr reg = offset & ~Addr(0x7);
+    switch (reg) {
+      case MboxCtrl:
+        // ringing the doorbell executes the command
+        if (shift == 0 && (val & 0x1))
+            executeMailbox();
+        break;
+      case MboxCmd:
+        write_reg(mboxCmd);
+        break;
+      case MboxArgLd:
+      case MboxArgOffset:
+      case MboxArgLength:
+        write_reg(mboxArgs[(reg - MboxArgLd) / 8]);
+        break;
+      default:
+        // the other registers are read-only
+        break;
+    }
+
+    pkt->makeAtomicResponse();
+    return mailboxLat;
+}
+
+void
+CXLMemory::trackHotness(PacketPtr pkt)
+{
+    if (!hotPageSize || !hotRange.contains(pkt->getAddr()))
+        return;
+
+    Addr page = hotRange.getOffset(pkt->getAddr()) / hotPageSize;
+    uint32_t count = hotness(page);
+    if (count != std::numeric_limits<uint32_t>::max())
+        hotCount[page] = count + 1;
+    hotTouched.insert(page);
+}
+
+std::vector<std::pair<Addr, uint32_t>>
+CXLMemory::hotPages(unsigned max_pages, uint32_t threshold)
+{
+    std::vector<std::pair<Addr, uint32_t>> pages;
+    if (pooled()) {
+        // the pages are tracked at device physical addresses, which
+        // the hosts may map anywhere
+        hotTouched.clear();
+        return pages;
+    }
+
+    for (Addr page : hotTouched) {
+        uint32_t count = hotness(page);
+        if (count >= threshold) {
+            Addr offset = page * hotPageSize;
+            Addr hpa = hotRange.addIntlvBits(
+                hotRange.removeIntlvBits(hotRange.start()) + offset);
+            pages.emplace_back(hpa, count);
+        }
+    }
+    hotTouched.clear();
+
+    std::sort(pages.begin(), pages.end(),
+              [](const auto &a, const auto &b) { return a.second > b.second; });
+    if (pages.size() > max_pages)
+        pages.resize(max_pages);
+    return pages;
+}
+
+uint32_t
+CXLMemory::hotness(Addr page)
+{
+    // the counters are halved lazily, once they are looked at again
+    uint64_t epoch = hotDecay ? curTick() / hotDecay : 0;
+    uint64_t age = epoch - hotEpoch[page];
+    if (age) {
+        hotCount[page] = age < 32 ? hotCount[page] >> age : 0;
+        hotEpoch[page] = epoch;
+    }
+    return hotCount[page];
+}
+
+Tick
+CXLMemory::hotnessRead(PacketPtr pkt, Addr offset)
+{
+    panic_if((pkt->getSize() != 4 && pkt->getSize() != 8) ||
+             offset % pkt->getSize(),
+             "%s: invalid hotness access of %d bytes at %#x\n", name(),
+             pkt->getSize(), offset);
+
+    uint64_t val = 0;
+    if (offset >= HotCounters) {
+        // a 64-bit access reads two neighbouring counters
+        Addr page = (offset - HotCounters) / 4;
+        for (unsigned i = 0; i < pkt->getSize() / 4; ++i) {
+            if (page + i < hotCount.size())
+                val |= uint64_t(hotness(page + i)) << (32 * i);
+        }
+    } else {
+        switch (offset & ~Addr(0x7)) {
+          case HotPageSize:
+            val = hotPageSize;
+            break;
+          case HotNumPages:
+            val = hotCount.size();
+            break;
+          case HotEpoch:
+            val = hotDecay ? curTick() / hotDecay : 0;
+            break;
+          default:
+            break;
+        }
+        val >>= (offset & 0x4) * 8;
+    }
+
+    if (pkt->getSize() == 8)
+        pkt->setLE<uint64_t>(val);
+    else
+        pkt->setLE<uint32_t>(val);
+
+    pkt->makeAtomicResponse();
+    return mailboxLat;
+}
+
+Tick
+CXLMemory::hotnessWrite(PacketPtr pkt, Addr offset)
+{
+    panic_if((pkt->getSize() != 4 && pkt->getSize() != 8) ||
+             offset % pkt->getSize(),
+             "%s: invalid hotness access of %d bytes at %#x\n", name(),
+             pkt->getSize(), offset);
+
+    // the counters are read-only, software can only clear them all
+    if (offset == HotClear && (pkt->getSize() == 8 ?
+            pkt->getLE<uint64_t>() : pkt->getLE<uint32_t>()) & 0x1) {
+        std::fill(hotCount.begin(), hotCount.end(), 0);
+    }
+
+    pkt->makeAtomicResponse();
+    return mailboxLat;
+}
+
+Tick
+CXLMemory::read(PacketPtr pkt)
+{
+    int bar;
+    Addr offset;
+    if (getBAR(pkt->getAddr(), bar, offset)) {
+        if (bar == mailboxBar)
+            return mailboxRead(pkt, offset);
+        if (bar == hotnessBar)
+            return hotnessRead(pkt, offset);
+        if (bar == nmpBar)
+            return nmp.read(pkt, offset);
+    }
+    return cxlRspPort.recvAtomic(pkt);
+}
+
+Tick
+CXLMemory::write(PacketPtr pkt)
+{
+    int bar;
+    Addr offset;
+    if (getBAR(pkt->getAddr(), bar, offset)) {
+        if (bar == mailboxBar)
+            return mailboxWrite(pkt, offset);
+        if (bar == hotnessBar)
+            return hotnessWrite(pkt, offset);
+        if (bar == nmpBar)
+            return nmp.write(pkt, offset);
+    }
+    return cxlRspPort.recvAtomic(pkt);
+}
+
 } // namespace gem5
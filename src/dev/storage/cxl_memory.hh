@@ -1,13 +1,30 @@
 #ifndef __DEV_STORAGE_CXL_MEMORY_HH__
 #define __DEV_STORAGE_CXL_MEMORY_HH__
 
+#include <algorithm>
+#include <array>
 #include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/addr_range.hh"
+#include "base/addr_range_map.hh"
 #include "base/trace.hh"
 #include "base/types.hh"
 #include "base/statistics.hh"
 #include "dev/pci/device.hh"
+#include "dev/storage/cxl_compression.hh"
+#include "dev/storage/cxl_media_if.hh"
+#include "dev/storage/cxl_nmp.hh"
+#include "dev/storage/cxl_prefetch_buffer.hh"
+#include "dev/storage/cxl_req_scheduler.hh"
+#include "mem/backdoor.hh"
+#include "mem/cxl_link.hh"
 #include "mem/packet.hh"
 #include "mem/packet_access.hh"
 #include "mem/port.hh"
@@ -18,7 +35,7 @@
 namespace gem5
 {
 
-class CXLMemory : public PciDevice 
+class CXLMemory : public PciDevice, public CXLMediaInterface
 {
     protected:
 
@@ -29,10 +46,12 @@ class CXLMemory : public PciDevice
         class DeferredPacket
         {
         public:
-            const Tick tick;
-            const PacketPtr pkt;
+            // not const, the request scheduler takes packets out of
+            // the middle of the queue
+            Tick tick;
+            PacketPtr pkt;
             /** When did pkt enter the transmitList */
-            const Tick entryTime;
+            Tick entryTime;
             DeferredPacket(PacketPtr _pkt, Tick _tick) : 
                 tick(_tick), pkt(_pkt),
                 entryTime(curTick())
@@ -72,14 +91,25 @@ class CXLMemory : public PciDevice
                 */
                 std::deque<DeferredPacket> transmitList;
 
-                /** Counter to track the outstanding responses. */
-                unsigned int outstandingResponses;
+                /**
+                * Counter to track the outstanding responses, per S2M
+                * channel (DRS for reads, NDR for writes).
+                */
+                std::array<unsigned int, NumCXLMemChannels> outstandingResponses;
 
                 /** If we should send a retry when space becomes available. */
                 bool retryReq;
 
-                /** Max queue size for reserved responses. */
-                unsigned int respQueueLimit;
+                /**
+                * The channel the stalled request waits for a credit of,
+                * and if it waits for the request rather than the response
+                * queue.
+                */
+                CXLMemChannel stalledChannel = CXLReqChannel;
+                bool stalledOnReq = false;
+
+                /** Max queue size for reserved responses, per S2M channel. */
+                const std::array<unsigned int, NumCXLMemChannels> respQueueLimit;
 
                 /**
                 * Upstream caches need this packet until true is returned, so
@@ -90,9 +120,10 @@ class CXLMemory : public PciDevice
                 /**
                 * Is this side blocked from accepting new response packets.
                 *
+                * @param channel the S2M channel the response would use
                 * @return true if the reserved space has reached the set limit
                 */
-                bool respQueueFull() const;
+                bool respQueueFull(CXLMemChannel channel) const;
 
                 /**
                 * Handle send event, scheduled when the packet at the head of
@@ -112,12 +143,14 @@ class CXLMemory : public PciDevice
                 * @param _cxlMemory the structural owner
                 * @param _memReqPort the request port of CXLMemory
                 * @param _protoProcLat the delay in cycles from receiving to sending
-                * @param _resp_limit the size of the response queue
+                * @param _drs_limit the S2M DRS credits of the response queue
+                * @param _ndr_limit the S2M NDR credits of the response queue
                 * @param _cxlMemRange the address range of the CXLMemory
                 */
                 CXLResponsePort(const std::string& _name, CXLMemory& _cxlMemory,
                                 CXLRequestPort& _memReqPort, Cycles _protoProcLat,
-                                int _resp_limit, AddrRange _cxlMemRange);
+                                int _drs_limit, int _ndr_limit,
+                                AddrRange _cxlMemRange);
 
                 /**
                 * Queue a response packet to be sent out later and also schedule
@@ -131,9 +164,25 @@ class CXLMemory : public PciDevice
                 /**
                 * Retry any stalled request that we have failed to accept at
                 * an earlier point in time. This call will do nothing if no
-                * request is waiting.
+                * request is waiting, or if it waits for the request credits of
+                * another channel than the one freed.
+                *
+                * @param channel channel whose request credit was freed
                 */
-                void retryStalledReq();
+                void retryStalledReq(CXLMemChannel channel);
+
+                /**
+                * Share of the response queue reserved, in percent, of
+                * the fuller channel.
+                */
+                unsigned int occupancy() const
+                {
+                    return std::max(
+                        outstandingResponses[CXLReqChannel] * 100 /
+                            respQueueLimit[CXLReqChannel],
+                        outstandingResponses[CXLRwDChannel] * 100 /
+                            respQueueLimit[CXLRwDChannel]);
+                }
 
             // protected:
                 /** When receiving a timing request from the Host,
@@ -152,9 +201,16 @@ class CXLMemory : public PciDevice
                     PacketPtr pkt, MemBackdoorPtr &backdoor) override;
 
                 void recvMemBackdoorReq(
-                    const MemBackdoorReq &req, MemBackdoorPtr &backdoor) override {};
+                    const MemBackdoorReq &req, MemBackdoorPtr &backdoor) override;
 
-                void recvFunctional(PacketPtr pkt) override {};
+                /** When receiving a Functional request from the Host,
+                    check the packets in flight in the device and pass
+                    it to the back-end memory media. */
+                void recvFunctional(PacketPtr pkt) override;
+
+                /** When receiving the dirty data of a back-invalidated
+                    line from the Host, write it to the memory media. */
+                bool recvTimingSnoopResp(PacketPtr pkt) override;
 
                 /** When receiving a address range request the Host,
                     pass it to the back-end memory media. */
@@ -190,13 +246,19 @@ class CXLMemory : public PciDevice
                 */
                 std::deque<DeferredPacket> transmitList;
 
-                /** Max queue size for request packets */
-                const unsigned int reqQueueLimit;
+                /** Max queue size for request packets, per M2S channel */
+                const std::array<unsigned int, NumCXLMemChannels> reqQueueLimit;
+
+                /** Request packets queued, per M2S channel. */
+                std::array<unsigned int, NumCXLMemChannels> queued = {};
+
+                /** Picks the next request sent to the media. */
+                CXLReqScheduler scheduler;
 
                 /**
-                * Handle send event, scheduled when the packet at the head of
-                * the outbound queue is ready to transmit (for timing
-                * accesses only).
+                * Handle send event, scheduled when a packet in the
+                * outbound queue is ready to transmit (for timing accesses
+                * only).
                 */
                 void trySendTiming();
 
@@ -211,18 +273,47 @@ class CXLMemory : public PciDevice
                 * @param _cxlMemory the structural owner
                 * @param _cxlRspPort the response port of CXLMemory
                 * @param _protoProcLat the delay in cycles from receiving to sending
-                * @param _req_limit the size of the request queue
+                * @param _req_limit the M2S Req credits of the request queue
+                * @param _rwd_limit the M2S RwD credits of the request queue
+                * @param p the parameters of the request scheduler
                 */
                 CXLRequestPort(const std::string& _name, CXLMemory& _cxlMemory,
                                 CXLResponsePort& _cxlRspPort, Cycles _protoProcLat,
-                                int _req_limit);
+                                int _req_limit, int _rwd_limit,
+                                const CXLMemoryParams &p);
 
                 /**
                 * Is this side blocked from accepting new request packets.
                 *
+                * @param channel the M2S channel of the request
                 * @return true if the occupied space has reached the set limit
                 */
-                bool reqQueueFull() const;
+                bool reqQueueFull(CXLMemChannel channel) const;
+
+                /**
+                * Is there a credit left of an M2S channel, counting the
+                * requests the device holds back.
+                */
+                bool hasCredit(CXLMemChannel channel) const
+                {
+                    return queued[channel] + cxlMemory.held(channel) <
+                        reqQueueLimit[channel];
+                }
+
+                /**
+                * Share of the request queue occupied, in percent, of the
+                * fuller channel.
+                */
+                unsigned int occupancy() const
+                {
+                    unsigned int pct = 0;
+                    for (int c = 0; c < NumCXLMemChannels; ++c) {
+                        pct = std::max(pct,
+                            (queued[c] + cxlMemory.held(CXLMemChannel(c))) *
+                            100 / reqQueueLimit[c]);
+                    }
+                    return pct;
+                }
 
                 /**
                 * Queue a request packet to be sent out later and also schedule
@@ -233,6 +324,16 @@ class CXLMemory : public PciDevice
                 */
                 void schedTimingReq(PacketPtr pkt, Tick when);
 
+                /**
+                * Check a functional request against the packets in our
+                * request queue.
+                *
+                * @param pkt packet to check against
+                *
+                * @return true if we find a match
+                */
+                bool trySatisfyFunctional(PacketPtr pkt);
+
             protected:
                 /** When receiving a timing request from the back-end memory media,
                     pass it to the Host. */
@@ -249,11 +350,423 @@ class CXLMemory : public PciDevice
         /** Request port of the CXLMemory. */
         CXLRequestPort memReqPort;
 
+        /** Transmitter of the S2M direction of the CXL link. */
+        CXLLink s2mLink;
+
+        /**
+        * Queue occupancy, in percent, from which the device reports an
+        * optimal load, a moderate and a severe overload.
+        */
+        const unsigned int devLoadOptimal;
+        const unsigned int devLoadModerate;
+        const unsigned int devLoadSevere;
+
+        /**
+        * The DevLoad of the device, from the fuller of its request
+        * and response queues.
+        */
+        CXLDevLoad devLoad() const;
+
         Tick preRspTick = -1;
 
+        /**
+        * Sender state that remembers the host physical address of a
+        * request to a pooled device while the media is accessed at the
+        * device physical address.
+        */
+        class PoolSenderState : public Packet::SenderState
+        {
+        public:
+            PoolSenderState(Addr _hpa, Tick _entry)
+                : hpa(_hpa), entry(_entry)
+            { }
+
+            const Addr hpa;
+            /** When did the request reach the device */
+            const Tick entry;
+        };
+
+        /** Return codes of the mailbox commands. */
+        enum MboxRetCode : uint64_t
+        {
+            MboxSuccess = 0x0,
+            MboxInvalidInput = 0x2,
+            MboxUnsupported = 0x3,
+            MboxNoCapacity = 0x4
+        };
+
+        /** Mailbox command opcodes, as in the CXL DCD command set. */
+        enum MboxOpcode : uint64_t
+        {
+            MboxGetDCConfig = 0x4800,
+            MboxAddDC = 0x4802,
+            MboxReleaseDC = 0x4803
+        };
+
+        /** Mailbox register offsets within the mailbox BAR. */
+        enum MboxReg : Addr
+        {
+            MboxCap = 0x00,
+            MboxCtrl = 0x08,
+            MboxCmd = 0x10,
+            MboxStatus = 0x18,
+            MboxArgLd = 0x20,
+            MboxArgOffset = 0x28,
+            MboxArgLength = 0x30,
+            MboxOut0 = 0x38,
+            MboxOut1 = 0x40
+        };
+
+        /** The BAR holding the mailbox registers. */
+        static constexpr int mailboxBar = 2;
+
+        /**
+        * Layout of the hotness BAR, a few registers followed by the
+        * 32-bit access counter of every page.
+        */
+        enum HotReg : Addr
+        {
+            HotPageSize = 0x00,
+            HotNumPages = 0x08,
+            HotEpoch = 0x10,
+            HotClear = 0x18,
+            HotCounters = 0x40
+        };
+
+        /** The BAR holding the hotness counters. */
+        static constexpr int hotnessBar = 3;
+
+        /**
+        * Host physical window of each logical device (LD), indexed by
+        * the LD-ID the CXL switch puts in the packets.
+        */
+        const std::vector<AddrRange> ldRanges;
+
+        /** Dynamic capacity block size, 0 if dynamic capacity is off. */
+        const Addr dcBlockSize;
+
+        /** Device physical range of the media capacity is taken from. */
+        const AddrRange dpaRange;
+
+        /**
+        * The media block each block of an LD window maps to, -1 if no
+        * capacity is assigned there.
+        */
+        std::vector<std::vector<int64_t>> dcMap;
+
+        /** Which media blocks are assigned to an LD. */
+        std::vector<bool> dcUsed;
+
+        /**
+        * Number of media blocks at the start of the media that are
+        * mapped at the start of every LD window, as memory shared by
+        * the hosts.
+        */
+        const unsigned dcSharedBlocks;
+
+        /** Latency of a mailbox register access. */
+        const Tick mailboxLat;
+
+        /** Mailbox registers that hold state. */
+        uint64_t mboxCmd = 0;
+        uint64_t mboxStatus = MboxSuccess;
+        uint64_t mboxArgs[3] = {0, 0, 0};
+        uint64_t mboxOut[2] = {0, 0};
+
+        /** Tracked page size, 0 if the hotness tracker is off. */
+        const Addr hotPageSize;
+
+        /** Period after which the counters are halved, 0 if never. */
+        const Tick hotDecay;
+
+        /** Device address range the tracked pages cover. */
+        const AddrRange hotRange;
+
+        /** Access counter of every page, saturating. */
+        std::vector<uint32_t> hotCount;
+
+        /** Decay period each counter was last brought up to date in. */
+        std::vector<uint64_t> hotEpoch;
+
+        /** Pages accessed since the hot pages were last looked up. */
+        std::unordered_set<Addr> hotTouched;
+
+        /**
+        * Count an access to the media in the page it falls into.
+        *
+        * @param pkt the request, at its device address
+        */
+        void trackHotness(PacketPtr pkt);
+
+        /** The counter of a page, decayed up to now. */
+        uint32_t hotness(Addr page);
+
+        /** Access the hotness BAR. */
+        Tick hotnessRead(PacketPtr pkt, Addr offset);
+        Tick hotnessWrite(PacketPtr pkt, Addr offset);
+
+        /**
+        * Media latency charged for an atomic access served through the
+        * backdoor of the media, 0 to send atomic accesses to the media.
+        */
+        const Tick backdoorLat;
+
+        /** Backdoors of the media, by the device range they cover. */
+        AddrRangeMap<MemBackdoorPtr, 1> mediaBackdoors;
+
+        /**
+        * Access the media in atomic mode, straight through its backdoor
+        * if backdoorLat is set and the media has one.
+        *
+        * @param pkt the request, at its device address
+        * @return the latency of the media
+        */
+        Tick atomicMedia(PacketPtr pkt);
+
+        /** Host files copied into the memory before the simulation. */
+        const std::vector<std::string> preloadFiles;
+
+        /**
+        * Offset of each file in the host window of the device, or in the
+        * media of a pooled device.
+        */
+        const std::vector<Addr> preloadOffsets;
+
+        /**
+        * Copy a host file into the memory, from a mapping of the file
+        * straight into the backing store of the media. Parts of the file
+        * that fall into the interleave ways of other devices are left to
+        * them.
+        *
+        * @param path the file on the host
+        * @param offset where the file starts in the memory of the device
+        */
+        void preload(const std::string &path, Addr offset);
+
+        /**
+        * Can the host get the backdoor of the media, which bypasses
+        * everything the device does.
+        */
+        bool exposesBackdoor() const
+        {
+            return !pooled() && !sfEntries && !hotPageSize && !backdoorLat &&
+                !compression && !prefetch;
+        }
+
+        /** Is the device shared through dynamic capacity. */
+        bool pooled() const { return dcBlockSize != 0; }
+
+        /**
+        * Translate the host physical address of an LD to the device
+        * physical address of the media.
+        *
+        * @return false if no capacity is assigned at the address
+        */
+        bool translate(unsigned ld, Addr hpa, Addr &dpa) const;
+
+        /**
+        * Move a request to a pooled device to the device physical
+        * address space. Requests to unassigned capacity are turned into
+        * their response (reads return zeros, writes are dropped).
+        *
+        * @return false if the request must not go to the media
+        */
+        bool poolRequest(PacketPtr pkt);
+
+        /**
+        * Answer an access to unassigned capacity from the controller:
+        * reads return zeros and writes are dropped.
+        */
+        void unmappedAccess(PacketPtr pkt);
+
+        /** Restore the host physical address of a pooled response. */
+        void poolResponse(PacketPtr pkt, Tick when);
+
+        /**
+        * Assign or release dynamic capacity of an LD. The blocks an LD
+        * releases are sanitised before they go back to the pool, the
+        * shared blocks the other LDs keep are left as they are. The host
+        * is expected to have written back and stopped using the extent
+        * before it releases it.
+        */
+        MboxRetCode addCapacity(unsigned ld, Addr offset, Addr length);
+        MboxRetCode releaseCapacity(unsigned ld, Addr offset, Addr length);
+
+        /**
+        * Sanitise a media block going back to the pool: zero it, so the
+        * next LD it is assigned to does not read the data of the last
+        * one, and drop what the device keeps about its lines (snoop
+        * filter entries, hotness counters, prefetched lines and their
+        * compressed sizes).
+        */
+        void sanitize(Addr start, Addr size);
+
+        /** Number of media blocks not assigned to any LD. */
+        uint64_t freeBlocks() const;
+
+        /** Execute the command in the mailbox registers. */
+        void executeMailbox();
+
+        /** Access the mailbox registers. */
+        uint64_t mailboxReg(Addr offset) const;
+        Tick mailboxRead(PacketPtr pkt, Addr offset);
+        Tick mailboxWrite(PacketPtr pkt, Addr offset);
+
+        /** One bit per LD whose host may hold a copy of a line. */
+        typedef uint64_t SnoopMask;
+
+        /**
+        * An entry of the device snoop filter, the hosts holding the
+        * line and its position in the replacement order.
+        */
+        struct SnoopItem
+        {
+            SnoopMask holder;
+            std::list<Addr>::iterator lru;
+        };
+
+        /** A line with back-invalidations that wait for dirty data. */
+        struct BIWait
+        {
+            /** Dirty lines the hosts still have to send back. */
+            unsigned outstanding = 0;
+            /** Tick the last of the data has been received. */
+            Tick ready = 0;
+            /** Requests to the line, held until the data is written. */
+            std::vector<PacketPtr> waiting;
+        };
+
+        /** A back-invalidate snoop the host committed to answer. */
+        struct BISnoop
+        {
+            Addr line;
+            Tick start;
+        };
+
+        /**
+        * Number of entries of the inclusive snoop filter of an HDM-DB
+        * device, 0 for an HDM-H device that leaves coherency to the
+        * host.
+        */
+        const unsigned sfEntries;
+
+        /** Cache line size of the system. */
+        const unsigned blkSize;
+
+        /** Lines (device physical) the hosts may hold copies of. */
+        std::unordered_map<Addr, SnoopItem> cachedLines;
+
+        /** Lines of the snoop filter, most recently used first. */
+        std::list<Addr> sfLru;
+
+        /** Lines waiting for the dirty data of back-invalidations. */
+        std::unordered_map<Addr, BIWait> biLines;
+
+        /** Back-invalidate snoops the hosts will send data for. */
+        std::unordered_map<RequestPtr, BISnoop> biSnoops;
+
+        /** Number of requests held in biLines, per M2S channel. */
+        std::array<unsigned, NumCXLMemChannels> biHeld = {};
+
+        /**
+        * Number of requests the device holds back on an M2S channel,
+        * for back-invalidations, metadata or prefetches. They keep the
+        * credits they took.
+        */
+        unsigned held(CXLMemChannel channel) const;
+
+        /**
+        * Find the host physical address an LD sees a device physical
+        * address at.
+        *
+        * @return false if the LD has no capacity mapped there
+        */
+        bool hostAddr(unsigned ld, Addr dpa, Addr &hpa) const;
+
+        /**
+        * Track a request to the media in the snoop filter. A host that
+        * caches or writes a line takes it from all other hosts, and a
+        * new line that does not fit evicts the least recently used
+        * one, both by back-invalidating the copies of the hosts.
+        *
+        * @param pkt the request, at its device physical address
+        * @param when tick the request is ready, moved back by the
+        *        back-invalidations it waits for
+        * @param timing true in timing mode
+        * @return false if the request is held until the hosts have
+        *         written back their dirty copies
+        */
+        bool snoopFilterRequest(PacketPtr pkt, Tick &when, bool timing);
+
+        /** Extra latency of a request in atomic mode. */
+        Tick snoopFilterAtomic(PacketPtr pkt);
+
+        /**
+        * Send BISnp to the hosts holding a line.
+        *
+        * @return tick the hosts without dirty data have answered
+        */
+        Tick backInvalidate(Addr line, SnoopMask holders, Tick when,
+                            bool timing);
+
+        /** Write back the dirty data a host answered a BISnp with. */
+        void biResponse(PacketPtr pkt);
+
+        /** Pass on the requests held for a line. */
+        void releaseLine(Addr line);
+
+        /** The compression stage in front of the media, null if off. */
+        std::unique_ptr<CXLCompressionStage> compression;
+
+        void queueMedia(PacketPtr pkt, Tick when) override;
+        bool hasCredit(CXLMemChannel channel) const override;
+        Tick atomicAccess(PacketPtr pkt) override;
+        Tick sendAtomic(PacketPtr pkt) override;
+        Tick decompress(PacketPtr pkt) override;
+        void respond(PacketPtr pkt, Tick when) override;
+        void retryStalledReq(CXLMemChannel channel) override;
+        bool mediaAddr(unsigned ld, Addr hpa, Addr &dpa) const override;
+        void hostWrite(Addr addr, int size, Event *event,
+                       uint8_t *data) override;
+        bool timingMode() const override;
+
+        /**
+        * Queue a request for the media, serving it from the prefetch
+        * buffer or compressing it first.
+        */
+        void toMedia(PacketPtr pkt, Tick when) override;
+
+        /** The prefetch buffer in front of the media, null if off. */
+        std::unique_ptr<CXLPrefetchBuffer> prefetch;
+
+        /** The BAR holding the registers of the NMP engine. */
+        static constexpr int nmpBar = 4;
+
+        /** The near-memory processing (NMP) engine. */
+        CXLNmpEngine nmp;
+
+        /**
+        * Serialise a response onto the S2M direction of the link.
+        *
+        * @return tick when the response has been received by the host
+        */
+        Tick s2mTransmit(PacketPtr pkt, Tick when);
+
+        /** The statistics of one logical device of the device. */
+        struct CXLLdStats : public statistics::Group
+        {
+            CXLLdStats(statistics::Group *parent, unsigned ld);
+
+            statistics::LogHistogram latency;
+        };
+
         struct CXLCtrlStats : public statistics::Group
         {
             CXLCtrlStats(CXLMemory &cxlMemory);
+
+            void preDumpStats() override;
+
+            CXLMemory &cxlMemory;
     
             statistics::Scalar reqQueFullEvents;
             statistics::Scalar reqRetryCounts;
@@ -262,28 +775,65 @@ class CXLMemory : public PciDevice
             statistics::Scalar rspSendFaild;
             statistics::Scalar reqSendSucceed;
             statistics::Scalar rspSendSucceed;
-            statistics::Distribution reqQueueLenDist;
-            statistics::Distribution rspQueueLenDist;
-            statistics::Distribution rspOutStandDist;
-            statistics::Distribution reqQueueLatDist;
-            statistics::Distribution rspQueueLatDist;
-            statistics::Distribution memToCXLCtrlRsp;
+            statistics::LogHistogram reqQueueLenDist;
+            statistics::LogHistogram rspQueueLenDist;
+            statistics::LogHistogram rspOutStandDist;
+            statistics::LogHistogram reqQueueLatDist;
+            statistics::LogHistogram readQueueLat;
+            statistics::Scalar reqReordered;
+            statistics::Scalar writeDrains;
+            statistics::LogHistogram rspQueueLatDist;
+            statistics::LogHistogram memToCXLCtrlRsp;
+            statistics::Scalar linkMsgs;
+            statistics::Scalar linkFlits;
+            statistics::Scalar linkDelay;
+            statistics::Formula avgLinkDelay;
+            statistics::Vector devLoad;
+            statistics::Scalar dcUnmapped;
+            statistics::Scalar dcAdds;
+            statistics::Scalar dcReleases;
+            statistics::Vector ldReqs;
+            statistics::Scalar biSnoops;
+            statistics::Scalar biDirty;
+            statistics::Scalar biConflicts;
+            statistics::Scalar sfEvictions;
+            statistics::Scalar biHeldReqs;
+            statistics::LogHistogram biLatency;
+            statistics::Vector pageHotness;
+            statistics::Scalar backdoorAccesses;
+
+            std::vector<std::unique_ptr<CXLLdStats>> ld;
         };
     
         CXLCtrlStats stats;
 
     public:
-        Tick read(PacketPtr pkt) override {
-            return cxlRspPort.recvAtomic(pkt);
-        }
-        Tick write(PacketPtr pkt) override {
-            return cxlRspPort.recvAtomic(pkt);
-        }
+        /**
+        * Look up the pages accessed since the last lookup whose
+        * counter reached a threshold, for a migration engine.
+        *
+        * @param max_pages the number of pages to return at most
+        * @param threshold the counter value a page needs
+        * @return host physical address and counter of the pages,
+        *         hottest first, none for a pooled device
+        */
+        std::vector<std::pair<Addr, uint32_t>> hotPages(unsigned max_pages,
+                                                        uint32_t threshold);
+
+        /** Page size of the hotness tracker, 0 if it is off. */
+        Addr hotnessPageSize() const { return hotPageSize; }
+
+        Tick read(PacketPtr pkt) override;
+        Tick write(PacketPtr pkt) override;
         Port &getPort(const std::string &if_name,
             PortID idx=InvalidPortID) override;
 
         void init() override;
 
+        void initState() override;
+
+        void regProbePoints() override;
+
         AddrRangeList getAddrRanges() const override;
 
         PARAMS(CXLMemory);
@@ -0,0 +1,547 @@
+/**
+ * @file
+ * Implementation of the near-memory processing (NMP) engine of a CXL
+ * memory device.
+ */
+
+#include "dev/storage/cxl_nmp.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "base/bitfield.hh"
+#include "base/chunk_generator.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CXLMemory.hh"
+#include "sim/byteswap.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+CXLNmpEngine::CXLNmpEngine(ClockedObject &_owner, CXLMediaInterface &_media,
+                           const CXLMemoryParams &p)
+    : Named(_owner.name() + ".nmp"), owner(_owner), media(_media),
+    blkSize(p.system->cacheLineSize()), bufSize(p.nmp_buffer_size),
+    maxInflight(p.nmp_max_inflight), lineLat(p.nmp_line_latency),
+    regLat(p.mailbox_lat),
+    _requestorId(p.system->getRequestorId(&_owner, "nmp")),
+    event([this]{ advance(); }, name()),
+    stats(&_owner)
+{
+    fatal_if(bufSize && (bufSize < blkSize || !maxInflight),
+             "%s: the NMP engine needs a line of buffer and accesses in "
+             "flight.\n", _owner.name());
+}
+
+CXLNmpEngine::NmpStats::NmpStats(statistics::Group *parent)
+    : statistics::Group(parent),
+      ADD_STAT(nmpCommands, statistics::units::Count::get(),
+               "Number of NMP commands run, per kernel"),
+      ADD_STAT(nmpErrors, statistics::units::Count::get(),
+               "Number of NMP commands that failed"),
+      ADD_STAT(nmpReadBytes, statistics::units::Byte::get(),
+               "Bytes the NMP engine read from the media"),
+      ADD_STAT(nmpWriteBytes, statistics::units::Byte::get(),
+               "Bytes the NMP engine wrote to the media"),
+      ADD_STAT(nmpLatency, statistics::units::Tick::get(),
+               "Time from fetching an NMP command to completing it")
+{
+    nmpCommands
+        .init(NumNmpOpcodes)
+        .subname(NmpMemcpy, "memcpy")
+        .subname(NmpMemset, "memset")
+        .subname(NmpGather, "gather")
+        .subname(NmpScatter, "scatter")
+        .subname(NmpReduceSum, "reduce_sum")
+        .subname(NmpEmbeddingBag, "embedding_bag")
+        .flags(statistics::nozero);
+    nmpLatency
+        .init()
+        .flags(statistics::nozero);
+}
+
+uint64_t
+CXLNmpEngine::reg(Addr offset) const
+{
+    switch (offset) {
+      case NmpCap:
+        // the kernels the engine runs, and the bytes of a round
+        return bufSize ?
+            (mask(NumNmpOpcodes) & ~uint64_t(1)) | bufSize << 32 : 0;
+      case NmpQueueBase:
+        return queueBase;
+      case NmpQueueSize:
+        return queueSize;
+      case NmpHead:
+        return head;
+      case NmpTail:
+        return tail;
+      case NmpDone:
+        return done;
+      case NmpStatus:
+        return status;
+      case NmpResult:
+        return result;
+      default:
+        return 0;
+    }
+}
+
+Tick
+CXLNmpEngine::read(PacketPtr pkt, Addr offset)
+{
+    panic_if((pkt->getSize() != 4 && pkt->getSize() != 8) ||
+             offset % pkt->getSize(),
+             "%s: invalid NMP register access of %d bytes at %#x\n",
+             name(), pkt->getSize(), offset);
+
+    uint64_t val = reg(offset & ~Addr(0x7)) >> ((offset & 0x4) * 8);
+    if (pkt->getSize() == 8)
+        pkt->setLE<uint64_t>(val);
+    else
+        pkt->setLE<uint32_t>(val);
+
+    pkt->makeAtomicResponse();
+    return regLat;
+}
+
+Tick
+CXLNmpEngine::write(PacketPtr pkt, Addr offset)
+{
+    panic_if((pkt->getSize() != 4 && pkt->getSize() != 8) ||
+             offset % pkt->getSize(),
+             "%s: invalid NMP register access of %d bytes at %#x\n",
+             name(), pkt->getSize(), offset);
+
+    uint64_t val = pkt->getSize() == 8 ? pkt->getLE<uint64_t>() :
+        pkt->getLE<uint32_t>();
+    unsigned shift = (offset & 0x4) * 8;
+    auto write_reg = [&](uint64_t &reg) {
+        if (pkt->getSize() == 8)
+            reg = val;
+        else
+            reg = (reg & ~(mask(32) << shift)) | (val << shift);
+    };
+
+    switch (offset & ~Addr(0x7)) {
+      case NmpQueueBase:
+        write_reg(queueBase);
+        break;
+      case NmpQueueSize:
+        write_reg(queueSize);
+        break;
+      case NmpTail:
+        // ringing the doorbell hands the commands up to the tail over
+        write_reg(tail);
+        if (bufSize)
+            fetch();
+        break;
+      default:
+        // the other registers are read-only
+        break;
+    }
+
+    pkt->makeAtomicResponse();
+    return regLat;
+}
+
+void
+CXLNmpEngine::fetch()
+{
+    if (busy || head == tail)
+        return;
+
+    // a queue the engine cannot read stops it until the host rings the
+    // doorbell again
+    cmd = NmpCommand{};
+    in.assign(sizeof(NmpCommand), 0);
+    if (!queueSize || !access(queueBase + (head % queueSize) *
+                              sizeof(NmpCommand), sizeof(NmpCommand), 0)) {
+        pending.clear();
+        status = NmpBadAddress;
+        stats.nmpErrors++;
+        return;
+    }
+
+    busy = true;
+    start = curTick();
+    stage = Stage::Fetch;
+    lines = 0;
+    ready = curTick();
+    issue();
+}
+
+bool
+CXLNmpEngine::access(Addr addr, Addr size, size_t offset)
+{
+    if (addr + size < addr)
+        return false;
+
+    for (ChunkGenerator gen(addr, size, blkSize); !gen.done(); gen.next()) {
+        Addr dpa;
+        if (!media.mediaAddr(0, gen.addr(), dpa))
+            return false;
+        pending.push_back(Access{dpa, unsigned(gen.size()),
+                                 offset + (gen.addr() - addr)});
+    }
+    return true;
+}
+
+void
+CXLNmpEngine::issue()
+{
+    const bool write = stage == Stage::Write;
+    const CXLMemChannel channel = write ? CXLRwDChannel : CXLReqChannel;
+    const bool timing = media.timingMode();
+
+    while (!pending.empty() && inflight.size() < maxInflight) {
+        // the requests of the hosts go first, the engine takes a credit
+        // they leave and otherwise waits for the next request sent
+        if (timing && !media.hasCredit(channel))
+            return;
+
+        Access acc = pending.front();
+        pending.pop_front();
+
+        RequestPtr req = std::make_shared<Request>(acc.addr, acc.size, 0,
+                                                   _requestorId);
+        PacketPtr pkt = new Packet(req, write ? MemCmd::WriteReq :
+                                                MemCmd::ReadReq);
+        pkt->allocate();
+        if (write) {
+            pkt->setData(out.data() + acc.offset);
+            stats.nmpWriteBytes += acc.size;
+        } else {
+            ++lines;
+            stats.nmpReadBytes += acc.size;
+        }
+
+        if (timing) {
+            inflight[req] = acc.offset;
+            media.toMedia(pkt, owner.clockEdge());
+            continue;
+        }
+
+        // in atomic mode the accesses of a stage overlap completely
+        Tick lat = media.atomicAccess(pkt);
+        ready = std::max(ready, curTick() + lat);
+        if (!write) {
+            std::memcpy(in.data() + acc.offset,
+                        pkt->getConstPtr<uint8_t>(), acc.size);
+        }
+        delete pkt;
+    }
+
+    if (pending.empty() && inflight.empty())
+        stageDone();
+}
+
+void
+CXLNmpEngine::response(PacketPtr pkt)
+{
+    auto it = inflight.find(pkt->req);
+    if (pkt->isRead()) {
+        std::memcpy(in.data() + it->second, pkt->getConstPtr<uint8_t>(),
+                    pkt->getSize());
+    }
+    ready = std::max(ready, owner.clockEdge() + pkt->headerDelay +
+                     pkt->payloadDelay + media.decompress(pkt));
+    inflight.erase(it);
+    delete pkt;
+
+    issue();
+}
+
+void
+CXLNmpEngine::retry()
+{
+    if (!pending.empty())
+        issue();
+}
+
+void
+CXLNmpEngine::stageDone()
+{
+    // the engine computes on what a round read before it writes
+    Cycles compute_lat(stage == Stage::Read ?
+                       lines * uint64_t(lineLat) : 0);
+    owner.schedule(event, std::max(ready, owner.clockEdge(compute_lat)));
+}
+
+void
+CXLNmpEngine::advance()
+{
+    switch (stage) {
+      case Stage::Fetch:
+        std::memcpy(&cmd, in.data(), sizeof(cmd));
+        cmd.elemSize = letoh(cmd.elemSize);
+        cmd.src = letoh(cmd.src);
+        cmd.dst = letoh(cmd.dst);
+        cmd.index = letoh(cmd.index);
+        cmd.count = letoh(cmd.count);
+        cmd.arg = letoh(cmd.arg);
+        cmd.completion = letoh(cmd.completion);
+        cmd.tag = letoh(cmd.tag);
+
+        if (cmd.opcode == 0 || cmd.opcode >= NumNmpOpcodes) {
+            complete(NmpInvalidOpcode);
+            return;
+        }
+        stats.nmpCommands[cmd.opcode]++;
+
+        if (((cmd.opcode == NmpGather || cmd.opcode == NmpScatter ||
+              cmd.opcode == NmpEmbeddingBag) &&
+             (!cmd.elemSize || cmd.elemSize > bufSize)) ||
+            ((cmd.opcode == NmpReduceSum ||
+              cmd.opcode == NmpEmbeddingBag) && cmd.type > NmpFloat32) ||
+            (cmd.opcode == NmpEmbeddingBag &&
+             (!cmd.arg || cmd.count % cmd.arg ||
+              cmd.elemSize % (cmd.type == NmpInt64 ? 8 : 4)))) {
+            complete(NmpInvalidInput);
+            return;
+        }
+
+        first = 0;
+        items = 0;
+        sumInt = 0;
+        sumFloat = 0;
+        bagInt.assign(cmd.elemSize / 8, 0);
+        bagFloat.assign(cmd.elemSize / 4, 0);
+        round();
+        return;
+
+      case Stage::Index:
+        {
+            index.resize(items);
+            for (uint64_t i = 0; i < items; ++i) {
+                std::memcpy(&index[i], in.data() + i * 8, 8);
+                index[i] = letoh(index[i]);
+            }
+
+            // scatter reads its rows in order, gather and pooling read
+            // the rows the indices name
+            const Addr row = cmd.elemSize;
+            stage = Stage::Read;
+            lines = 0;
+            ready = curTick();
+            in.assign(items * row, 0);
+            bool ok = true;
+            if (cmd.opcode == NmpScatter) {
+                ok = access(cmd.src + first * row, items * row, 0);
+            } else {
+                for (uint64_t i = 0; ok && i < items; ++i)
+                    ok = access(cmd.src + index[i] * row, row, i * row);
+            }
+            if (!ok) {
+                complete(NmpBadAddress);
+                return;
+            }
+            issue();
+        }
+        return;
+
+      case Stage::Read:
+        compute();
+        return;
+
+      case Stage::Write:
+        first += items;
+        round();
+        return;
+    }
+}
+
+void
+CXLNmpEngine::round()
+{
+    if (first >= cmd.count) {
+        complete(NmpSuccess);
+        return;
+    }
+
+    // a round takes as many bytes, rows, elements or indices as the
+    // buffer holds, the kernels on rows read their indices first
+    const bool rows = cmd.opcode == NmpGather ||
+        cmd.opcode == NmpScatter || cmd.opcode == NmpEmbeddingBag;
+    Addr item = 1;
+    if (rows)
+        item = cmd.elemSize;
+    else if (cmd.opcode == NmpReduceSum)
+        item = cmd.type == NmpInt64 ? 8 : 4;
+    items = std::min<uint64_t>(cmd.count - first, bufSize / item);
+    lines = 0;
+    ready = curTick();
+
+    bool ok = true;
+    if (rows) {
+        stage = Stage::Index;
+        in.assign(items * 8, 0);
+        ok = access(cmd.index + first * 8, items * 8, 0);
+    } else {
+        stage = Stage::Read;
+        in.assign(items * item, 0);
+        if (cmd.opcode != NmpMemset)
+            ok = access(cmd.src + first * item, items * item, 0);
+    }
+    if (!ok) {
+        complete(NmpBadAddress);
+        return;
+    }
+    issue();
+}
+
+void
+CXLNmpEngine::compute()
+{
+    const Addr row = cmd.elemSize;
+
+    auto int_at = [&](size_t offset) {
+        int64_t val;
+        std::memcpy(&val, in.data() + offset, sizeof(val));
+        return letoh(val);
+    };
+    auto float_at = [&](size_t offset) {
+        uint32_t bits;
+        std::memcpy(&bits, in.data() + offset, sizeof(bits));
+        bits = letoh(bits);
+        float val;
+        std::memcpy(&val, &bits, sizeof(val));
+        return val;
+    };
+
+    stage = Stage::Write;
+    out.clear();
+    bool ok = true;
+    switch (cmd.opcode) {
+      case NmpMemcpy:
+        out.swap(in);
+        ok = access(cmd.dst + first, items, 0);
+        break;
+      case NmpMemset:
+        out.assign(items, uint8_t(cmd.arg));
+        ok = access(cmd.dst + first, items, 0);
+        break;
+      case NmpGather:
+        out.swap(in);
+        ok = access(cmd.dst + first * row, items * row, 0);
+        break;
+      case NmpScatter:
+        out.swap(in);
+        for (uint64_t i = 0; ok && i < items; ++i)
+            ok = access(cmd.dst + index[i] * row, row, i * row);
+        break;
+      case NmpReduceSum:
+        for (uint64_t i = 0; i < items; ++i) {
+            if (cmd.type == NmpInt64)
+                sumInt += int_at(i * 8);
+            else
+                sumFloat += float_at(i * 4);
+        }
+        // the sum goes to memory once it is complete, if asked for
+        if (first + items == cmd.count && cmd.dst) {
+            if (cmd.type == NmpInt64) {
+                int64_t val = htole(sumInt);
+                out.resize(sizeof(val));
+                std::memcpy(out.data(), &val, sizeof(val));
+            } else {
+                float val = sumFloat;
+                uint32_t bits;
+                std::memcpy(&bits, &val, sizeof(bits));
+                bits = htole(bits);
+                out.resize(sizeof(bits));
+                std::memcpy(out.data(), &bits, sizeof(bits));
+            }
+            ok = access(cmd.dst, out.size(), 0);
+        }
+        break;
+      case NmpEmbeddingBag:
+        for (uint64_t i = 0; ok && i < items; ++i) {
+            const size_t lanes = row / (cmd.type == NmpInt64 ? 8 : 4);
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                if (cmd.type == NmpInt64)
+                    bagInt[lane] += int_at(i * row + lane * 8);
+                else
+                    bagFloat[lane] += float_at(i * row + lane * 4);
+            }
+            if ((first + i + 1) % cmd.arg)
+                continue;
+
+            // the bag is complete, its sum is the output row of the bag
+            size_t offset = out.size();
+            out.resize(offset + row);
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                if (cmd.type == NmpInt64) {
+                    int64_t val = htole(bagInt[lane]);
+                    std::memcpy(out.data() + offset + lane * 8, &val, 8);
+                    bagInt[lane] = 0;
+                } else {
+                    uint32_t bits;
+                    std::memcpy(&bits, &bagFloat[lane], 4);
+                    bits = htole(bits);
+                    std::memcpy(out.data() + offset + lane * 4, &bits, 4);
+                    bagFloat[lane] = 0;
+                }
+            }
+            ok = access(cmd.dst + (first + i) / cmd.arg * row, row, offset);
+        }
+        break;
+    }
+
+    if (!ok) {
+        complete(NmpBadAddress);
+        return;
+    }
+    lines = 0;
+    ready = curTick();
+    issue();
+}
+
+void
+CXLNmpEngine::complete(NmpRetCode ret)
+{
+    pending.clear();
+
+    uint64_t value = 0;
+    if (ret == NmpSuccess && cmd.opcode == NmpReduceSum) {
+        if (cmd.type == NmpInt64) {
+            value = sumInt;
+        } else {
+            float sum = sumFloat;
+            uint32_t bits;
+            std::memcpy(&bits, &sum, sizeof(bits));
+            value = bits;
+        }
+    }
+    if (ret != NmpSuccess)
+        stats.nmpErrors++;
+    stats.nmpLatency.sample(curTick() - start);
+
+    DPRINTF(CXLMemory, "NMP command %d tag %#x returned %#x\n",
+            cmd.opcode, cmd.tag, ret);
+
+    status = ret;
+    result = value;
+    ++head;
+    ++done;
+
+    // the completion record, the tag, status and result, goes to the
+    // host by DMA
+    if (cmd.completion) {
+        auto *record = new uint64_t[3]{htole(cmd.tag),
+                                       htole(uint64_t(ret)),
+                                       htole(value)};
+        media.hostWrite(cmd.completion, 3 * sizeof(uint64_t),
+                        new EventFunctionWrapper(
+                            [record]{ delete [] record; },
+                            name() + ".record", true),
+                        reinterpret_cast<uint8_t *>(record));
+    }
+
+    busy = false;
+    fetch();
+}
+
+} // namespace gem5
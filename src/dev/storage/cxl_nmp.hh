@@ -0,0 +1,276 @@
+/**
+ * @file
+ * Declaration of the near-memory processing (NMP) engine of a CXL
+ * memory device.
+ */
+
+#ifndef __DEV_STORAGE_CXL_NMP_HH__
+#define __DEV_STORAGE_CXL_NMP_HH__
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "base/named.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "dev/storage/cxl_media_if.hh"
+#include "mem/packet.hh"
+#include "params/CXLMemory.hh"
+#include "sim/clocked_object.hh"
+#include "sim/eventq.hh"
+
+namespace gem5
+{
+
+/**
+ * The near-memory processing (NMP) engine of a CXL memory device. The
+ * host puts commands into a queue in the memory of the device and rings
+ * a doorbell register, the engine then fetches the commands and runs
+ * their kernels on the media, a buffer of data at a time, and reports
+ * their outcome in its registers and in a completion record in host
+ * memory. The registers are there without an engine as well, whose
+ * capability register then reads as 0.
+ */
+class CXLNmpEngine : public Named
+{
+  public:
+
+    /**
+     * Constructor for the CXLNmpEngine.
+     *
+     * @param _owner the device, whose clock, events and statistics the
+     *        engine uses
+     * @param _media the way of the engine to the media and the hosts
+     * @param p the parameters of the device
+     */
+    CXLNmpEngine(ClockedObject &_owner, CXLMediaInterface &_media,
+                 const CXLMemoryParams &p);
+
+    /** Access the registers. */
+    Tick read(PacketPtr pkt, Addr offset);
+    Tick write(PacketPtr pkt, Addr offset);
+
+    /** Requestor ID of the media accesses of the engine. */
+    RequestorID requestorId() const { return _requestorId; }
+
+    /** Is a response from the media for an access of the engine. */
+    bool isAccess(const RequestPtr &req) const { return inflight.count(req); }
+
+    /** Take the response of an access of the stage. */
+    void response(PacketPtr pkt);
+
+    /** Send the accesses waiting for a credit, once one is free. */
+    void retry();
+
+  private:
+
+    /** Kernels the engine runs. */
+    enum NmpOpcode : uint8_t
+    {
+        NmpMemcpy = 1,
+        NmpMemset = 2,
+        NmpGather = 3,
+        NmpScatter = 4,
+        NmpReduceSum = 5,
+        NmpEmbeddingBag = 6,
+        NumNmpOpcodes
+    };
+
+    /** Registers of the engine. */
+    enum NmpReg : Addr
+    {
+        NmpCap = 0x00,
+        NmpQueueBase = 0x08,
+        NmpQueueSize = 0x10,
+        NmpHead = 0x18,
+        NmpTail = 0x20,
+        NmpDone = 0x28,
+        NmpStatus = 0x30,
+        NmpResult = 0x38
+    };
+
+    /** Element types of the kernels that compute. */
+    enum NmpType : uint8_t
+    {
+        NmpInt64 = 0,
+        NmpFloat32 = 1
+    };
+
+    /** Completion status of a command. */
+    enum NmpRetCode : uint64_t
+    {
+        NmpSuccess = 0x0,
+        NmpInvalidOpcode = 0x1,
+        NmpInvalidInput = 0x2,
+        NmpBadAddress = 0x3
+    };
+
+    /**
+     * A command of the engine, a line in the command queue in the
+     * memory of the device. Addresses are host physical addresses in
+     * the memory of the device, but for the completion record, which
+     * is written anywhere in host memory.
+     */
+    struct NmpCommand
+    {
+        uint8_t opcode;
+        uint8_t type;
+        uint16_t reserved;
+        /** Bytes of a row of gather, scatter and embedding bags. */
+        uint32_t elemSize;
+        Addr src;
+        Addr dst;
+        /** Array of 64-bit row indices. */
+        Addr index;
+        /** Bytes, rows or indices, depending on the kernel. */
+        uint64_t count;
+        /** Byte of memset, or indices per bag of embedding bags. */
+        uint64_t arg;
+        /** Host address of the completion record, 0 for none. */
+        Addr completion;
+        uint64_t tag;
+    };
+
+    static_assert(sizeof(NmpCommand) == 64,
+                  "an NMP command takes up a line");
+
+    /** What the engine does with the memory. */
+    enum class Stage
+    {
+        Fetch,
+        Index,
+        Read,
+        Write
+    };
+
+    /** A piece of an access, within a line. */
+    struct Access
+    {
+        Addr addr;
+        unsigned size;
+        /** Offset in the data of the stage. */
+        size_t offset;
+    };
+
+    /** The value of a register. */
+    uint64_t reg(Addr offset) const;
+
+    /** Fetch the next command, if the engine is idle. */
+    void fetch();
+
+    /**
+     * Add an access of the stage, in pieces within lines.
+     *
+     * @return false if it is not all in the memory of the device
+     */
+    bool access(Addr addr, Addr size, size_t offset);
+
+    /** Send the accesses of the stage, as credits allow. */
+    void issue();
+
+    /** Move on once the accesses of the stage are done. */
+    void stageDone();
+
+    /** Go on with the command after a stage. */
+    void advance();
+
+    /** Start the next round of the command, or complete it. */
+    void round();
+
+    /** Compute on the data read in a round, and plan the writes. */
+    void compute();
+
+    /** Complete the command and fetch the next one. */
+    void complete(NmpRetCode status);
+
+    ClockedObject &owner;
+
+    CXLMediaInterface &media;
+
+    /** Cache line size of the system. */
+    const unsigned blkSize;
+
+    /** Bytes the engine works on at a time, 0 for no engine. */
+    const Addr bufSize;
+
+    /** Media accesses the engine has in flight at most. */
+    const unsigned maxInflight;
+
+    /** Cycles the engine computes on each line it reads. */
+    const Cycles lineLat;
+
+    /** Latency of a register access. */
+    const Tick regLat;
+
+    const RequestorID _requestorId;
+
+    /** The command queue, and where the host and engine are in it. */
+    uint64_t queueBase = 0;
+    uint64_t queueSize = 0;
+    uint64_t head = 0;
+    uint64_t tail = 0;
+
+    /** Commands completed, and the outcome of the last one. */
+    uint64_t done = 0;
+    uint64_t status = NmpSuccess;
+    uint64_t result = 0;
+
+    /** If the engine runs a command. */
+    bool busy = false;
+
+    /** The command it runs, and when it fetched it. */
+    NmpCommand cmd;
+    Tick start;
+
+    /** The stage of the command the engine is in. */
+    Stage stage;
+
+    /** The first item of the current round, and the items in it. */
+    uint64_t first;
+    uint64_t items;
+
+    /** Data read in the stage, and data to be written. */
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+
+    /** The row indices of the round. */
+    std::vector<uint64_t> index;
+
+    /** Sum of a reduction, and of the bag being pooled. */
+    int64_t sumInt;
+    double sumFloat;
+    std::vector<int64_t> bagInt;
+    std::vector<float> bagFloat;
+
+    /** Accesses of the stage not yet sent to the media. */
+    std::deque<Access> pending;
+
+    /**
+     * Accesses in flight, and the offset of their data. They are kept
+     * by request, as a device cache behind a DCOH answers the lines it
+     * holds dirty with a packet of its own.
+     */
+    std::unordered_map<RequestPtr, size_t> inflight;
+
+    /** Lines read in the stage, and when its atomic accesses end. */
+    uint64_t lines;
+    Tick ready;
+
+    EventFunctionWrapper event;
+
+    struct NmpStats : public statistics::Group
+    {
+        NmpStats(statistics::Group *parent);
+
+        statistics::Vector nmpCommands;
+        statistics::Scalar nmpErrors;
+        statistics::Scalar nmpReadBytes;
+        statistics::Scalar nmpWriteBytes;
+        statistics::LogHistogram nmpLatency;
+    } stats;
+};
+
+} // namespace gem5
+
+#endif // __DEV_STORAGE_CXL_NMP_HH__
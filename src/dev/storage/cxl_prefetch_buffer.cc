@@ -0,0 +1,302 @@
+/**
+ * @file
+ * Implementation of the prefetch buffer of a CXL memory device.
+ */
+
+#include "dev/storage/cxl_prefetch_buffer.hh"
+
+#include <algorithm>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CXLMemory.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+CXLPrefetchBuffer::CXLPrefetchBuffer(ClockedObject &_owner,
+                                     CXLMediaInterface &_media,
+                                     const CXLMemoryParams &p)
+    : Named(_owner.name() + ".prefetch_buffer"), owner(_owner),
+    media(_media), prefetcher(p.prefetcher),
+    blkSize(p.system->cacheLineSize()),
+    pfEntries(p.prefetch_buffer_entries),
+    pfLat(p.prefetch_buffer_latency),
+    pfMaxInflight(p.prefetch_max_inflight),
+    pfAccessor(*this),
+    prefetchEvent([this]{ issuePrefetches(); }, name()),
+    stats(&_owner)
+{
+    fatal_if(!pfEntries || !pfMaxInflight,
+             "%s: the prefetcher needs a prefetch buffer and prefetches "
+             "in flight.\n", _owner.name());
+    prefetcher->setParentInfo(p.system, _owner.getProbeManager(), blkSize);
+}
+
+CXLPrefetchBuffer::PrefetchStats::PrefetchStats(statistics::Group *parent)
+    : statistics::Group(parent),
+      ADD_STAT(pfIssued, statistics::units::Count::get(),
+               "Number of prefetches sent to the media"),
+      ADD_STAT(pfHits, statistics::units::Count::get(),
+               "Number of reads served from the prefetch buffer"),
+      ADD_STAT(pfLateHits, statistics::units::Count::get(),
+               "Number of reads that waited for a prefetch in flight"),
+      ADD_STAT(pfMisses, statistics::units::Count::get(),
+               "Number of reads the prefetches did not cover"),
+      ADD_STAT(pfUnused, statistics::units::Count::get(),
+               "Number of prefetched lines evicted or written before a "
+               "read"),
+      ADD_STAT(pfDropped, statistics::units::Count::get(),
+               "Number of prefetches outside the memory of the device"),
+      ADD_STAT(pfWastedBytes, statistics::units::Byte::get(),
+               "Bytes read from the media for prefetches never used"),
+      ADD_STAT(pfAccuracy, statistics::units::Ratio::get(),
+               "Share of the prefetches a read used",
+               (pfHits + pfLateHits) / pfIssued),
+      ADD_STAT(pfCoverage, statistics::units::Ratio::get(),
+               "Share of the reads covered by a prefetch",
+               (pfHits + pfLateHits) / (pfHits + pfLateHits + pfMisses))
+{
+}
+
+void
+CXLPrefetchBuffer::regProbePoints(ProbeManager *pm)
+{
+    ppHit = new ProbePointArg<CacheAccessProbeArg>(pm, "Hit");
+    ppMiss = new ProbePointArg<CacheAccessProbeArg>(pm, "Miss");
+    ppFill = new ProbePointArg<CacheAccessProbeArg>(pm, "Fill");
+}
+
+bool
+CXLPrefetchBuffer::request(PacketPtr pkt, Tick when)
+{
+    if (pkt->isWrite()) {
+        invalidate(pkt);
+        return true;
+    }
+    if (!pkt->isRead())
+        return true;
+
+    // the prefetcher is trained on the host addresses, and reads ahead
+    // in the window of the LD it last saw
+    pfLd = pkt->cxl_ld_id;
+
+    const Addr line = pkt->getBlockAddr(blkSize);
+    const bool in_line = pkt->getAddr() + pkt->getSize() <= line + blkSize;
+
+    auto buf = pfBuffer.find(line);
+    if (in_line && buf != pfBuffer.end()) {
+        // the line goes on to the host, which caches it from now on
+        ppHit->notify(CacheAccessProbeArg(pkt, pfAccessor));
+        stats.pfHits++;
+        PfLine hit = std::move(buf->second);
+        pfLru.erase(hit.lru);
+        pfBuffer.erase(buf);
+        respond(pkt, hit.data.data(), std::max(when, hit.ready) + pfLat);
+        schedulePrefetch();
+        return false;
+    }
+
+    ppMiss->notify(CacheAccessProbeArg(pkt, pfAccessor));
+    schedulePrefetch();
+
+    auto pf = pfInflight.find(line);
+    if (in_line && pf != pfInflight.end() && !pf->second.stale) {
+        // rather than reading the line twice, wait for the prefetch
+        stats.pfLateHits++;
+        pf->second.waiting.emplace_back(pkt, when);
+        ++pfHeld[cxlChannel(pkt)];
+        return false;
+    }
+
+    stats.pfMisses++;
+    prefetcher->incrDemandMhsrMisses();
+    return true;
+}
+
+bool
+CXLPrefetchBuffer::atomic(PacketPtr pkt, Tick &lat)
+{
+    if (pkt->isWrite()) {
+        invalidate(pkt);
+        return false;
+    }
+
+    // the prefetcher is not run in atomic mode, as in the caches, but
+    // the lines it has read ahead are still served
+    const Addr line = pkt->getBlockAddr(blkSize);
+    auto buf = pfBuffer.find(line);
+    if (!pkt->isRead() || buf == pfBuffer.end() ||
+        pkt->getAddr() + pkt->getSize() > line + blkSize) {
+        return false;
+    }
+
+    stats.pfHits++;
+    pkt->setData(buf->second.data.data() + pkt->getAddr() - line);
+    if (pkt->needsResponse())
+        pkt->makeResponse();
+    pfLru.erase(buf->second.lru);
+    pfBuffer.erase(buf);
+    lat += pfLat;
+    return true;
+}
+
+void
+CXLPrefetchBuffer::invalidate(PacketPtr pkt)
+{
+    for (Addr line = pkt->getBlockAddr(blkSize);
+         line < pkt->getAddr() + pkt->getSize(); line += blkSize) {
+        auto buf = pfBuffer.find(line);
+        if (buf != pfBuffer.end()) {
+            pfLru.erase(buf->second.lru);
+            pfBuffer.erase(buf);
+            prefetcher->prefetchUnused();
+            stats.pfUnused++;
+            stats.pfWastedBytes += blkSize;
+        }
+
+        // a prefetch in flight may have read the line before the write
+        auto pf = pfInflight.find(line);
+        if (pf != pfInflight.end())
+            pf->second.stale = true;
+    }
+}
+
+void
+CXLPrefetchBuffer::invalidate(Addr start, Addr size)
+{
+    // the buffer is small, so it is walked rather than the range
+    for (auto buf = pfBuffer.begin(); buf != pfBuffer.end();) {
+        if (buf->first < start || buf->first >= start + size) {
+            ++buf;
+            continue;
+        }
+        pfLru.erase(buf->second.lru);
+        buf = pfBuffer.erase(buf);
+        prefetcher->prefetchUnused();
+        stats.pfUnused++;
+        stats.pfWastedBytes += blkSize;
+    }
+
+    // a prefetch in flight may have read its line before the change
+    for (auto &[line, pf] : pfInflight) {
+        if (line >= start && line < start + size)
+            pf.stale = true;
+    }
+}
+
+void
+CXLPrefetchBuffer::respond(PacketPtr pkt, const uint8_t *line, Tick when)
+{
+    pkt->setData(line + pkt->getAddr() - pkt->getBlockAddr(blkSize));
+    pkt->makeResponse();
+    media.respond(pkt, when);
+}
+
+void
+CXLPrefetchBuffer::response(PacketPtr pkt)
+{
+    auto read = pfReads.find(pkt->req);
+    const Addr line = read->second;
+    pfReads.erase(read);
+    Tick ready = owner.clockEdge() + pkt->headerDelay + pkt->payloadDelay +
+        media.decompress(pkt);
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    auto pf_it = pfInflight.find(line);
+    assert(pf_it != pfInflight.end());
+    PfRead pf = std::move(pf_it->second);
+    pfInflight.erase(pf_it);
+
+    // the prefetcher learns of the fill at the address it asked for
+    pkt->setAddr(pf.hpa);
+    ppFill->notify(CacheAccessProbeArg(pkt, pfAccessor));
+
+    // the reads that came while it was in flight take the line
+    for (const auto &[held, when] : pf.waiting) {
+        --pfHeld[cxlChannel(held)];
+        respond(held, pkt->getConstPtr<uint8_t>(),
+                std::max(when, ready) + pfLat);
+    }
+
+    if (!pf.waiting.empty()) {
+        media.retryStalledReq(CXLReqChannel);
+    } else if (pf.stale) {
+        prefetcher->prefetchUnused();
+        stats.pfUnused++;
+        stats.pfWastedBytes += blkSize;
+    } else {
+        if (pfBuffer.size() >= pfEntries) {
+            Addr victim = pfLru.back();
+            pfLru.pop_back();
+            pfBuffer.erase(victim);
+            prefetcher->prefetchUnused();
+            stats.pfUnused++;
+            stats.pfWastedBytes += blkSize;
+        }
+        pfLru.push_front(line);
+        const uint8_t *data = pkt->getConstPtr<uint8_t>();
+        pfBuffer.emplace(line, PfLine{
+            std::vector<uint8_t>(data, data + blkSize), ready,
+            pfLru.begin()});
+    }
+
+    delete pkt;
+    schedulePrefetch();
+}
+
+void
+CXLPrefetchBuffer::issuePrefetches()
+{
+    while (pfInflight.size() < pfMaxInflight &&
+           prefetcher->nextPrefetchReadyTime() <= curTick()) {
+        // the reads of the hosts go first, a prefetch takes a credit
+        // they leave and otherwise waits for the next request sent
+        if (!media.hasCredit(CXLReqChannel))
+            return;
+
+        PacketPtr pkt = prefetcher->getPacket();
+        if (!pkt)
+            return;
+
+        Addr line;
+        if (!media.mediaAddr(pfLd, pkt->getBlockAddr(blkSize), line)) {
+            stats.pfDropped++;
+            delete pkt;
+        } else if (pfBuffer.count(line)) {
+            prefetcher->pfHitInCache();
+            delete pkt;
+        } else if (pfInflight.count(line)) {
+            prefetcher->pfHitInMSHR();
+            delete pkt;
+        } else {
+            DPRINTF(CXLMemory, "Prefetch addr 0x%x\n", line);
+            pfInflight[line].hpa = pkt->getAddr();
+            pkt->setAddr(line);
+            pfReads[pkt->req] = line;
+            stats.pfIssued++;
+            media.queueMedia(pkt, owner.clockEdge());
+        }
+    }
+    schedulePrefetch();
+}
+
+void
+CXLPrefetchBuffer::schedulePrefetch()
+{
+    if (pfInflight.size() >= pfMaxInflight)
+        return;
+
+    Tick next = prefetcher->nextPrefetchReadyTime();
+    if (next == MaxTick)
+        return;
+
+    next = std::max(next, owner.clockEdge());
+    if (!prefetchEvent.scheduled())
+        owner.schedule(prefetchEvent, next);
+    else if (next < prefetchEvent.when())
+        owner.reschedule(prefetchEvent, next);
+}
+
+} // namespace gem5
@@ -0,0 +1,230 @@
+/**
+ * @file
+ * Declaration of the prefetch buffer of a CXL memory device.
+ */
+
+#ifndef __DEV_STORAGE_CXL_PREFETCH_BUFFER_HH__
+#define __DEV_STORAGE_CXL_PREFETCH_BUFFER_HH__
+
+#include <array>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/named.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "dev/storage/cxl_media_if.hh"
+#include "mem/cache/cache_probe_arg.hh"
+#include "mem/cache/prefetch/base.hh"
+#include "mem/cxl_link.hh"
+#include "mem/packet.hh"
+#include "params/CXLMemory.hh"
+#include "sim/clocked_object.hh"
+#include "sim/eventq.hh"
+#include "sim/probe/probe.hh"
+
+namespace gem5
+{
+
+/**
+ * The prefetch buffer of a CXL memory device. A prefetcher is trained
+ * on the reads of the hosts, as on a cache, and the lines it asks for
+ * are read ahead from the media into the buffer. A read that finds its
+ * line in the buffer is served from it, and a read of a line being
+ * prefetched waits for the prefetch. The hosts cache the lines they
+ * read, so a line leaves the buffer once it is read.
+ */
+class CXLPrefetchBuffer : public Named
+{
+  public:
+
+    /**
+     * Constructor for the CXLPrefetchBuffer.
+     *
+     * @param _owner the device, whose clock, events, probes and
+     *        statistics the buffer uses
+     * @param _media the way of the buffer to the media and the hosts
+     * @param p the parameters of the device
+     */
+    CXLPrefetchBuffer(ClockedObject &_owner, CXLMediaInterface &_media,
+                      const CXLMemoryParams &p);
+
+    /** Register the probes the prefetcher listens to, as on a cache. */
+    void regProbePoints(ProbeManager *pm);
+
+    /**
+     * Pass a request of a host to the media through the buffer. A read
+     * trains the prefetcher, and is served from the buffer on a hit,
+     * or waits for a prefetch of its line in flight. A write drops the
+     * line from the buffer.
+     *
+     * @param pkt the request, at its device address
+     * @param when tick the request is ready
+     * @return false if the request does not go to the media
+     */
+    bool request(PacketPtr pkt, Tick when);
+
+    /**
+     * Serve an atomic read from the buffer, or drop the line a write
+     * changes from it.
+     *
+     * @param lat the latency, the buffer latency is added on a hit
+     * @return true if the read has been served
+     */
+    bool atomic(PacketPtr pkt, Tick &lat);
+
+    /** Drop the lines a write changes from the buffer. */
+    void invalidate(PacketPtr pkt);
+
+    /**
+     * Drop the lines of a range of the media from the buffer, and keep
+     * the prefetches of the range in flight out of it.
+     */
+    void invalidate(Addr start, Addr size);
+
+    /** Is a response from the media for a prefetch of the buffer. */
+    bool isPrefetch(const RequestPtr &req) const
+    {
+        return pfReads.count(req);
+    }
+
+    /** Put a prefetch the media answered into the buffer. */
+    void response(PacketPtr pkt);
+
+    /** Number of requests held for a prefetch on an M2S channel. */
+    unsigned held(CXLMemChannel channel) const { return pfHeld[channel]; }
+
+    /**
+     * Schedule the next prefetch once one is ready, unless as many as
+     * allowed are in flight.
+     */
+    void schedulePrefetch();
+
+  private:
+
+    /** Respond to a read with a line read ahead. */
+    void respond(PacketPtr pkt, const uint8_t *line, Tick when);
+
+    /** Send the prefetches that are ready, as credits allow. */
+    void issuePrefetches();
+
+    ClockedObject &owner;
+
+    CXLMediaInterface &media;
+
+    /** Prefetcher trained on the reads of the hosts. */
+    prefetch::Base *prefetcher;
+
+    /** Cache line size of the system. */
+    const unsigned blkSize;
+
+    /** Lines the buffer holds, and its hit latency. */
+    const unsigned pfEntries;
+    const Tick pfLat;
+
+    /** Prefetches in flight to the media at most. */
+    const unsigned pfMaxInflight;
+
+    /** A prefetched line waiting for a read. */
+    struct PfLine
+    {
+        std::vector<uint8_t> data;
+        /** Tick the line is in the buffer at. */
+        Tick ready;
+        std::list<Addr>::iterator lru;
+    };
+
+    /** The buffer, at device addresses. */
+    std::unordered_map<Addr, PfLine> pfBuffer;
+
+    /** Lines of the buffer, most recently filled first. */
+    std::list<Addr> pfLru;
+
+    /** A prefetch sent to the media. */
+    struct PfRead
+    {
+        /** Host address the prefetcher asked for. */
+        Addr hpa;
+        /** If a write to the line came after it was sent. */
+        bool stale = false;
+        /** Reads waiting for it, with the tick each is ready. */
+        std::vector<std::pair<PacketPtr, Tick>> waiting;
+    };
+
+    /** Prefetches in flight, by the line they read. */
+    std::unordered_map<Addr, PfRead> pfInflight;
+
+    /**
+     * Prefetches sent to the media, and their line. They are kept by
+     * request, as a device cache behind a DCOH answers the lines it
+     * holds dirty with a packet of its own.
+     */
+    std::unordered_map<RequestPtr, Addr> pfReads;
+
+    /** Number of requests held for a prefetch, per M2S channel. */
+    std::array<unsigned, NumCXLMemChannels> pfHeld = {};
+
+    /**
+     * LD of the last read the prefetcher was trained on, whose window
+     * the prefetches of a pooled device are taken to be in.
+     */
+    unsigned pfLd = 0;
+
+    /** The buffer as the prefetcher sees it. */
+    struct PrefetchAccessor : public CacheAccessor
+    {
+        const CXLPrefetchBuffer &buffer;
+
+        PrefetchAccessor(const CXLPrefetchBuffer &_buffer)
+            : buffer(_buffer)
+        { }
+
+        Addr line(Addr addr) const
+        {
+            return addr & ~Addr(buffer.blkSize - 1);
+        }
+
+        bool inCache(Addr addr, bool is_secure) const override
+        { return buffer.pfBuffer.count(line(addr)); }
+
+        bool inMissQueue(Addr addr, bool is_secure) const override
+        { return buffer.pfInflight.count(line(addr)); }
+
+        bool hasBeenPrefetched(Addr addr, bool is_secure) const override
+        { return inCache(addr, is_secure) || inMissQueue(addr, is_secure); }
+
+        bool hasBeenPrefetched(Addr addr, bool is_secure,
+                               RequestorID requestor) const override
+        { return hasBeenPrefetched(addr, is_secure); }
+
+        bool coalesce() const override { return false; }
+    } pfAccessor;
+
+    /** Probes the prefetcher listens to. */
+    ProbePointArg<CacheAccessProbeArg> *ppHit = nullptr;
+    ProbePointArg<CacheAccessProbeArg> *ppMiss = nullptr;
+    ProbePointArg<CacheAccessProbeArg> *ppFill = nullptr;
+
+    EventFunctionWrapper prefetchEvent;
+
+    struct PrefetchStats : public statistics::Group
+    {
+        PrefetchStats(statistics::Group *parent);
+
+        statistics::Scalar pfIssued;
+        statistics::Scalar pfHits;
+        statistics::Scalar pfLateHits;
+        statistics::Scalar pfMisses;
+        statistics::Scalar pfUnused;
+        statistics::Scalar pfDropped;
+        statistics::Scalar pfWastedBytes;
+        statistics::Formula pfAccuracy;
+        statistics::Formula pfCoverage;
+    } stats;
+};
+
+} // namespace gem5
+
+#endif // __DEV_STORAGE_CXL_PREFETCH_BUFFER_HH__
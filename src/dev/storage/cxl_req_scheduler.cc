@@ -0,0 +1,62 @@
+/**
+ * @file
+ * Implementation of the scheduler picking the requests a CXL memory
+ * device sends to its media.
+ */
+
+#include "dev/storage/cxl_req_scheduler.hh"
+
+#include <cassert>
+
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+CXLReqScheduler::CXLReqScheduler(const std::string &_name,
+                                 CXLMemScheduler _policy,
+                                 unsigned _line_size, unsigned _write_high,
+                                 unsigned _write_low, unsigned _banks,
+                                 Addr _interleave)
+    : Named(_name), policy(_policy), lineMask(~Addr(_line_size - 1)),
+    writeHigh(_write_high), writeLow(_write_low), banks(_banks),
+    interleave(_interleave), bankInflight(_banks, 0)
+{
+    fatal_if(writeLow > writeHigh,
+             "%s: the write low threshold is above the high one.\n", name());
+    fatal_if(banks == 0 || interleave == 0,
+             "%s: the scheduler needs at least one bank.\n", name());
+}
+
+bool
+CXLReqScheduler::updateDrain(unsigned writes)
+{
+    if (!reorders())
+        return false;
+
+    if (!draining && writes >= writeHigh) {
+        draining = true;
+        return true;
+    }
+    if (draining && writes <= writeLow)
+        draining = false;
+    return false;
+}
+
+void
+CXLReqScheduler::sent(Addr addr)
+{
+    if (policy == CXLMemScheduler::BankAware)
+        ++bankInflight[bank(addr)];
+}
+
+void
+CXLReqScheduler::done(Addr addr)
+{
+    if (policy == CXLMemScheduler::BankAware) {
+        assert(bankInflight[bank(addr)]);
+        --bankInflight[bank(addr)];
+    }
+}
+
+} // namespace gem5
@@ -0,0 +1,165 @@
+/**
+ * @file
+ * Declaration of the scheduler picking the requests a CXL memory device
+ * sends to its media.
+ */
+
+#ifndef __DEV_STORAGE_CXL_REQ_SCHEDULER_HH__
+#define __DEV_STORAGE_CXL_REQ_SCHEDULER_HH__
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/named.hh"
+#include "base/types.hh"
+#include "enums/CXLMemScheduler.hh"
+
+namespace gem5
+{
+
+/**
+ * Picks the next request of the request queue of a CXL memory device
+ * to send to the media. FIFO keeps the arrival order. ReadFirst sends
+ * ready reads ahead of the writes, until the writes pile up and are
+ * drained ahead of the reads. BankAware does the same, and prefers the
+ * bank with the fewest accesses in flight among the candidates. A
+ * request is never sent ahead of an older one to the same line if
+ * either of them writes.
+ */
+class CXLReqScheduler : public Named
+{
+  public:
+
+    /** What the scheduler sees of a queued request. */
+    struct Entry
+    {
+        Addr addr;
+        bool write;
+        /** Tick the request is ready to be sent at. */
+        Tick ready;
+    };
+
+    /**
+     * Constructor for the CXLReqScheduler.
+     *
+     * @param _name the name of the queue, for the error messages
+     * @param _policy the policy picking the requests
+     * @param _line_size the cache line size
+     * @param _write_high queued writes at which they are drained
+     * @param _write_low queued writes down to which they are drained
+     * @param _banks the banks of the media
+     * @param _interleave bytes mapped to a bank before the next one
+     */
+    CXLReqScheduler(const std::string &_name, CXLMemScheduler _policy,
+                    unsigned _line_size, unsigned _write_high,
+                    unsigned _write_low, unsigned _banks, Addr _interleave);
+
+    /** If requests may be sent ahead of older ones. */
+    bool reorders() const { return policy != CXLMemScheduler::FIFO; }
+
+    /** The bank of the media an address maps to. */
+    unsigned bank(Addr addr) const { return (addr / interleave) % banks; }
+
+    /**
+     * Start draining the writes once they pile up, and stop once they
+     * are few again.
+     *
+     * @param writes the number of writes queued
+     * @return true if a drain starts
+     */
+    bool updateDrain(unsigned writes);
+
+    /** Count an access sent to, and answered by, the media. */
+    void sent(Addr addr);
+    void done(Addr addr);
+
+    /**
+     * Pick the next request to send to the media.
+     *
+     * @param queue the queued requests, oldest first
+     * @param view gives the Entry of an element of the queue
+     * @param now the current tick
+     * @param next_ready set to the tick the first request that is not
+     *        ready yet will be
+     * @return the position in the queue, -1 if none is ready
+     */
+    template <typename Queue, typename View>
+    int pick(const Queue &queue, View view, Tick now,
+             Tick &next_ready) const;
+
+  private:
+
+    const CXLMemScheduler policy;
+
+    const Addr lineMask;
+
+    const unsigned writeHigh;
+    const unsigned writeLow;
+
+    const unsigned banks;
+    const Addr interleave;
+
+    /** If the writes are being drained. */
+    bool draining = false;
+
+    /** Accesses in flight at the media, per bank. */
+    std::vector<unsigned> bankInflight;
+};
+
+template <typename Queue, typename View>
+int
+CXLReqScheduler::pick(const Queue &queue, View view, Tick now,
+                      Tick &next_ready) const
+{
+    next_ready = MaxTick;
+
+    if (policy == CXLMemScheduler::FIFO) {
+        Tick ready = view(queue.front()).ready;
+        if (ready <= now)
+            return 0;
+        next_ready = ready;
+        return -1;
+    }
+
+    int best = -1;
+    bool best_other = true;
+    unsigned best_load = 0;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        const Entry req = view(queue[i]);
+        if (req.ready > now) {
+            next_ready = std::min(next_ready, req.ready);
+            continue;
+        }
+
+        // keep the order of the accesses to a line that write
+        const Addr line = req.addr & lineMask;
+        bool hazard = false;
+        for (size_t j = 0; !hazard && j < i; ++j) {
+            const Entry older = view(queue[j]);
+            hazard = (older.addr & lineMask) == line &&
+                (older.write || req.write);
+        }
+        if (hazard)
+            continue;
+
+        // reads go first unless the writes are drained, and the
+        // bank-aware policy then prefers the least busy bank, the
+        // oldest request wins a tie
+        bool other = req.write != draining;
+        unsigned load = policy == CXLMemScheduler::BankAware ?
+            bankInflight[bank(req.addr)] : 0;
+        if (best < 0 || other < best_other ||
+            (other == best_other && load < best_load)) {
+            best = i;
+            best_other = other;
+            best_load = load;
+        }
+    }
+
+    return best;
+}
+
+} // namespace gem5
+
+#endif // __DEV_STORAGE_CXL_REQ_SCHEDULER_HH__
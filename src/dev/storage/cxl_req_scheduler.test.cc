@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dev/storage/cxl_req_scheduler.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+typedef CXLReqScheduler::Entry Entry;
+
+const auto view = [](const Entry &entry) { return entry; };
+
+CXLReqScheduler
+makeScheduler(CXLMemScheduler policy)
+{
+    // drain at 4 queued writes, down to 1, over 4 banks of 1 KiB
+    return CXLReqScheduler("sched", policy, 64, 4, 1, 4, 1024);
+}
+
+} // anonymous namespace
+
+/** FIFO sends the oldest request, once it is ready. */
+TEST(CXLReqSchedulerTest, Fifo)
+{
+    auto sched = makeScheduler(CXLMemScheduler::FIFO);
+    EXPECT_FALSE(sched.reorders());
+
+    std::vector<Entry> queue = {{0x0, true, 10}, {0x40, false, 0}};
+    Tick next_ready;
+    EXPECT_EQ(sched.pick(queue, view, 5, next_ready), -1);
+    EXPECT_EQ(next_ready, 10);
+    EXPECT_EQ(sched.pick(queue, view, 10, next_ready), 0);
+    EXPECT_EQ(next_ready, MaxTick);
+
+    // FIFO never drains
+    EXPECT_FALSE(sched.updateDrain(100));
+}
+
+/** Reads pass the older writes, the oldest read first. */
+TEST(CXLReqSchedulerTest, ReadFirst)
+{
+    auto sched = makeScheduler(CXLMemScheduler::ReadFirst);
+    EXPECT_TRUE(sched.reorders());
+
+    std::vector<Entry> queue = {
+        {0x0, true, 0}, {0x40, false, 0}, {0x80, false, 0}};
+    Tick next_ready;
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 1);
+
+    // a write goes once there are no reads
+    queue = {{0x0, true, 0}, {0x40, true, 0}};
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+}
+
+/** Requests that are not ready wait, and set the next tick to try. */
+TEST(CXLReqSchedulerTest, NotReady)
+{
+    auto sched = makeScheduler(CXLMemScheduler::ReadFirst);
+
+    std::vector<Entry> queue = {
+        {0x0, true, 0}, {0x40, false, 30}, {0x80, false, 20}};
+    Tick next_ready;
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+    EXPECT_EQ(next_ready, 20);
+
+    queue.erase(queue.begin());
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), -1);
+    EXPECT_EQ(next_ready, 20);
+    EXPECT_EQ(sched.pick(queue, view, 20, next_ready), 1);
+    EXPECT_EQ(next_ready, 30);
+}
+
+/** No request passes an older one to its line if either writes. */
+TEST(CXLReqSchedulerTest, LineOrder)
+{
+    auto sched = makeScheduler(CXLMemScheduler::ReadFirst);
+
+    std::vector<Entry> queue = {{0x0, true, 0}, {0x8, false, 0}};
+    Tick next_ready;
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+
+    // reads of a line may pass each other
+    queue = {{0x0, true, 0}, {0x40, false, 0}, {0x48, false, 0}};
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 1);
+
+    // a write does not pass an older read of its line while draining
+    sched.updateDrain(4);
+    queue = {{0x0, false, 0}, {0x8, true, 0}, {0x40, true, 0}};
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 2);
+}
+
+/** The writes are drained from the high to the low threshold. */
+TEST(CXLReqSchedulerTest, Drain)
+{
+    auto sched = makeScheduler(CXLMemScheduler::ReadFirst);
+
+    std::vector<Entry> queue = {{0x0, false, 0}, {0x40, true, 0}};
+    Tick next_ready;
+    EXPECT_FALSE(sched.updateDrain(3));
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+
+    EXPECT_TRUE(sched.updateDrain(4));
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 1);
+
+    // a drain starts once, and goes on down to the low threshold
+    EXPECT_FALSE(sched.updateDrain(5));
+    EXPECT_FALSE(sched.updateDrain(2));
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 1);
+
+    EXPECT_FALSE(sched.updateDrain(1));
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+}
+
+/** The bank-aware policy prefers the least busy bank. */
+TEST(CXLReqSchedulerTest, BankAware)
+{
+    auto sched = makeScheduler(CXLMemScheduler::BankAware);
+    EXPECT_EQ(sched.bank(0x0), 0);
+    EXPECT_EQ(sched.bank(0x400), 1);
+    EXPECT_EQ(sched.bank(0x1000), 0);
+
+    std::vector<Entry> queue = {{0x0, false, 0}, {0x400, false, 0}};
+    Tick next_ready;
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+
+    sched.sent(0x1000);
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 1);
+
+    // a read in a busy bank still goes ahead of a write
+    queue = {{0x0, false, 0}, {0x400, true, 0}};
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+
+    sched.done(0x1000);
+    queue = {{0x0, false, 0}, {0x400, false, 0}};
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+}
+
+/** ReadFirst does not look at the banks. */
+TEST(CXLReqSchedulerTest, ReadFirstIgnoresBanks)
+{
+    auto sched = makeScheduler(CXLMemScheduler::ReadFirst);
+
+    sched.sent(0x0);
+    std::vector<Entry> queue = {{0x0, false, 0}, {0x400, false, 0}};
+    Tick next_ready;
+    EXPECT_EQ(sched.pick(queue, view, 0, next_ready), 0);
+    sched.done(0x0);
+}
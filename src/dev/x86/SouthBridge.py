@@ -102,7 +102,10 @@ class SouthBridge(SimObject):
         self.cmos.pio = bus.mem_side_ports
         self.dma1.pio = bus.mem_side_ports
         self.ide.pio = bus.mem_side_ports
-        self.cxlmemory.cxl_rsp_port = bus.mem_side_ports
+        # The CXL.mem port is normally linked to a dedicated CXL root
+        # port, only fall back to the I/O bus when it is not.
+        if not self.cxlmemory.cxl_rsp_port.peer:
+            self.cxlmemory.cxl_rsp_port = bus.mem_side_ports
         if dma_ports.count(self.ide.dma) == 0:
             self.ide.dma = bus.cpu_side_ports
         if dma_ports.count(self.cxlmemory.dma) == 0:
@@ -38,6 +38,7 @@
 
 from m5.objects.ClockedObject import ClockedObject
 from m5.params import *
+from m5.proxy import *
 
 
 class Bridge(ClockedObject):
@@ -65,13 +66,19 @@ class Bridge(ClockedObject):
         [AllMemory], "Address ranges to pass through the bridge"
     )
 
+
+class CXLLinkGen(Enum):
+    vals = ["PCIe5", "PCIe6"]
+
+
 class CXLBridge(ClockedObject):
     type = "CXLBridge"
     cxx_header = "mem/cxl_bridge.hh"
     cxx_class = "gem5::CXLBridge"
 
-    mem_side_port = RequestPort(
-        "This port sends requests and receives responses"
+    mem_side_port = VectorRequestPort(
+        "Root ports, each sends requests to and receives responses "
+        "from one CXL device"
     )
     master = DeprecatedParam(
         mem_side_port, "`master` is now called `mem_side_port`"
@@ -85,8 +92,77 @@ class CXLBridge(ClockedObject):
 
     req_fifo_depth= Param.Unsigned(48, "The number of requests to buffer")
     resp_fifo_depth = Param.Unsigned(48, "The number of responses to buffer")
+    rwd_fifo_depth = Param.Unsigned(48, "The number of writes (M2S RwD) to buffer, req_fifo_depth is then the number of reads (M2S Req)")
+    ndr_fifo_depth = Param.Unsigned(48, "The number of write responses (S2M NDR) to buffer, resp_fifo_depth is then the number of read responses (S2M DRS)")
+    m2s_req_credits = Param.Unsigned(0, "M2S Req credits the device advertises on the link of a root port, reads wait for one while the writes go on, 0 for untracked")
+    m2s_rwd_credits = Param.Unsigned(0, "M2S RwD credits the device advertises on the link of a root port, writes wait for one while the reads go on, 0 for untracked")
     bridge_lat = Param.Latency("50ns", "The latency of this bridge")
     proto_proc_lat = Param.Latency("14ns", "Conversion latency of cxl protocol in bridge")
+    link_lanes = Param.Unsigned(16, "Number of lanes of the CXL link")
+    link_gen = Param.CXLLinkGen(
+        "PCIe5", "PCIe generation (per-lane rate) of the CXL link"
+    )
+    flit_size = Param.Unsigned(68, "CXL flit size in bytes (68 or 256)")
     ranges = VectorParam.AddrRange(
         [AllMemory], "Address ranges to pass through the bridge"
     )
+    hdm_ranges = VectorParam.AddrRange(
+        [],
+        "HDM decoder range of each root port, in mem_side_port order, "
+        "possibly interleaved; empty for a single device behind the last "
+        "range in ranges",
+    )
+
+    system = Param.System(Parent.any, "System the bridge belongs to")
+    dram_port = RequestPort(
+        "Port to host DRAM, for the pages migrated out of the CXL memory"
+    )
+    migration_region = Param.AddrRange(
+        "0",
+        "Host DRAM reserved for pages migrated out of the CXL memory, "
+        "empty to disable page migration",
+    )
+    migration_page_size = Param.MemorySize(
+        "4KiB", "Granularity of page migration"
+    )
+    migration_interval = Param.Latency(
+        "100us", "Interval between two rounds of page migration"
+    )
+    migration_threshold = Param.Unsigned(
+        64, "Accesses in an interval that make a CXL page hot"
+    )
+    migration_batch = Param.Unsigned(
+        16, "Maximum number of pages promoted per round"
+    )
+    migration_copy_depth = Param.Unsigned(
+        16, "Maximum number of line reads a page copy has in flight"
+    )
+    migration_sources = VectorParam.CXLMemory(
+        [], "CXL memory devices whose page hotness drives the migration"
+    )
+    latency_breakdown = Param.Bool(
+        False,
+        "Break the latency of every CXL access that needs a response down "
+        "into the stages of its way through the bridge and the device",
+    )
+    latency_trace = Param.String(
+        "",
+        "File in the output directory the stages of every access broken "
+        "down are written to, in binary; empty for none",
+    )
+    qos_throttle = Param.Bool(
+        False,
+        "Throttle the host requests to a CXL device by the DevLoad its "
+        "responses report, as in the CXL QoS telemetry",
+    )
+    qos_interval = Param.Latency(
+        "200ns", "Interval the throttling is adjusted at most once in"
+    )
+    qos_step = Param.Latency(
+        "2ns",
+        "Step the gap between two host requests on a root port grows by "
+        "on a moderate overload and shrinks by on a light load",
+    )
+    qos_max_gap = Param.Latency(
+        "200ns", "Largest gap kept between two host requests on a root port"
+    )
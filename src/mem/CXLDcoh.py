@@ -0,0 +1,56 @@
+from m5.objects.Bridge import CXLLinkGen
+from m5.objects.ClockedObject import ClockedObject
+from m5.params import *
+from m5.proxy import *
+
+
+class CXLBias(ScopedEnum):
+    vals = ["HostBias", "DeviceBias"]
+
+
+class CXLDcoh(ClockedObject):
+    type = "CXLDcoh"
+    cxx_header = "mem/cxl_dcoh.hh"
+    cxx_class = "gem5::CXLDcoh"
+
+    cpu_side_port = ResponsePort(
+        "Port facing the device-side cache, receives its requests and "
+        "snoops it"
+    )
+    host_port = RequestPort(
+        "CXL.cache port, connect to a coherent crossbar of the host"
+    )
+    hdm_port = ResponsePort(
+        "Receives the host's CXL.mem accesses to the device-attached "
+        "memory, connect to the memory port of the device controller"
+    )
+    mem_side_port = RequestPort("Port towards the device-attached memory")
+
+    system = Param.System(Parent.any, "System we belong to")
+
+    hdm_range = Param.AddrRange("Address range of the device-attached memory")
+    bias_granularity = Param.MemorySize(
+        "4KiB", "Granularity at which the bias of the memory is tracked"
+    )
+    default_bias = Param.CXLBias(
+        "HostBias", "Bias of the device-attached memory out of reset"
+    )
+    auto_bias_flip = Param.Bool(
+        True,
+        "Flip a page to device bias when the device accesses it, and back "
+        "to host bias when the host reads it",
+    )
+    latency = Param.Latency(
+        "10ns", "Latency of the DCOH for a message in either direction"
+    )
+    bias_flip_latency = Param.Latency(
+        "200ns",
+        "Fixed cost of a bias flip on top of flushing the page from the "
+        "other side's caches",
+    )
+
+    link_lanes = Param.Unsigned(16, "Number of lanes of the CXL.cache link")
+    link_gen = Param.CXLLinkGen(
+        "PCIe5", "PCIe generation (per-lane rate) of the CXL.cache link"
+    )
+    flit_size = Param.Unsigned(68, "CXL flit size in bytes (68 or 256)")
@@ -0,0 +1,44 @@
+from m5.objects.ClockedObject import ClockedObject
+from m5.params import *
+from m5.proxy import *
+
+
+class CXLDramCacheTags(ScopedEnum):
+    vals = ["Sram", "Ecc"]
+
+
+class CXLDramCache(ClockedObject):
+    type = "CXLDramCache"
+    cxx_header = "mem/cxl_dram_cache.hh"
+    cxx_class = "gem5::CXLDramCache"
+
+    cpu_side_port = ResponsePort(
+        "Receives the host's accesses to the CXL memory, connect to the "
+        "memory bus"
+    )
+    cxl_side_port = RequestPort(
+        "Port towards the CXL memory, connect to the CXL host bridge"
+    )
+    dram_port = RequestPort(
+        "Port towards the data array in host DRAM, connect to the memory "
+        "bus"
+    )
+
+    system = Param.System(Parent.any, "System we belong to")
+
+    dram_region = Param.AddrRange("Host DRAM holding the data array")
+    assoc = Param.Unsigned(1, "Associativity, 1 for a direct-mapped cache")
+    tags = Param.CXLDramCacheTags(
+        "Sram",
+        "Where the tags live: in an SRAM tag store of the controller, or "
+        "in the ECC bits of the data array next to each line",
+    )
+    latency = Param.Latency(
+        "5ns", "Latency of the controller for a message in either direction"
+    )
+    tag_latency = Param.Latency(
+        "2ns", "Lookup latency of the SRAM tag store"
+    )
+    max_accesses = Param.Unsigned(
+        64, "Host accesses the controller holds at most"
+    )
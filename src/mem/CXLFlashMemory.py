@@ -0,0 +1,37 @@
+from m5.objects.AbstractMemory import *
+from m5.params import *
+
+
+class CXLFlashMemory(AbstractMemory):
+    type = "CXLFlashMemory"
+    cxx_header = "mem/cxl_flash_mem.hh"
+    cxx_class = "gem5::memory::CXLFlashMemory"
+
+    port = ResponsePort("This port sends responses and receives requests")
+
+    page_size = Param.MemorySize("4KiB", "Size of a flash page")
+    cache_size = Param.MemorySize(
+        "512MiB", "Size of the internal DRAM cache of flash pages"
+    )
+    cache_latency = Param.Latency(
+        "80ns", "Latency of the controller and the internal DRAM cache"
+    )
+    bandwidth = Param.MemoryBandwidth(
+        "25.6GiB/s", "Combined read and write bandwidth of the DRAM cache"
+    )
+
+    # The defaults are those of low-latency SLC flash
+    read_latency = Param.Latency("3us", "Time to sense a page on a die")
+    program_latency = Param.Latency("100us", "Time to program a page")
+    channels = Param.Unsigned(8, "Number of flash channels")
+    dies_per_channel = Param.Unsigned(4, "Number of dies on a channel")
+    channel_bandwidth = Param.MemoryBandwidth(
+        "1.2GB/s", "Bandwidth of a flash channel"
+    )
+    write_buffer_size = Param.Unsigned(
+        256, "Pages the write buffer holds until they are programmed"
+    )
+
+    def controller(self):
+        # The flash media has no MemCtrl in front of it
+        return self
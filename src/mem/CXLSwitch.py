@@ -0,0 +1,45 @@
+from m5.objects.Bridge import CXLLinkGen
+from m5.objects.ClockedObject import ClockedObject
+from m5.params import *
+
+
+class CXLSwitchArbitration(ScopedEnum):
+    vals = ["RoundRobin", "OldestFirst", "FixedPriority"]
+
+
+class CXLSwitch(ClockedObject):
+    type = "CXLSwitch"
+    cxx_header = "mem/cxl_switch.hh"
+    cxx_class = "gem5::CXLSwitch"
+
+    usp_port = VectorResponsePort(
+        "Upstream switch ports, each linked to a host root port. The "
+        "index of the port is the LD-ID of the host at pooled devices"
+    )
+    dsp_port = VectorRequestPort(
+        "Downstream switch ports, each linked to a CXL device"
+    )
+
+    port_latency = Param.Latency(
+        "25ns", "Port-to-port latency of a packet crossing the switch"
+    )
+    ingress_depth = Param.Unsigned(
+        32,
+        "Number of packets buffered at the ingress of a port, these are "
+        "the credits advertised to the link partner",
+    )
+    egress_depth = Param.Unsigned(
+        32,
+        "Number of packets buffered at the egress of a port, these are "
+        "the credits the ingress ports arbitrate for",
+    )
+    arbitration = Param.CXLSwitchArbitration(
+        "RoundRobin",
+        "Arbitration between the ingress ports competing for an egress port",
+    )
+
+    link_lanes = Param.Unsigned(16, "Number of lanes of the CXL links")
+    link_gen = Param.CXLLinkGen(
+        "PCIe5", "PCIe generation (per-lane rate) of the CXL links"
+    )
+    flit_size = Param.Unsigned(68, "CXL flit size in bytes (68 or 256)")
@@ -46,10 +46,17 @@
 
 #include "mem/cxl_bridge.hh"
 
+#include "base/cprintf.hh"
+#include "base/intmath.hh"
 #include "base/trace.hh"
 #include "debug/Bridge.hh"
 #include "params/Bridge.hh"
 #include "debug/CXLMemory.hh"
+#include "dev/storage/cxl_memory.hh"
+#include "sim/sim_exit.hh"
+#include "sim/system.hh"
+#include <algorithm>
+#include <cstdint>
 #include <iterator>
 
 namespace gem5
@@ -57,42 +64,122 @@ namespace gem5
 
 CXLBridge::BridgeResponsePort::BridgeResponsePort(const std::string& _name,
                                          CXLBridge& _bridge,
-                                         BridgeRequestPort& _memSidePort,
                                          Cycles _bridge_lat, Cycles _proto_proc_lat,
-                                         int _resp_limit, std::vector<AddrRange> _ranges)
+                                         int _drs_limit, int _ndr_limit,
+                                         std::vector<AddrRange> _ranges)
     : ResponsePort(_name), bridge(_bridge),
-      memSidePort(_memSidePort), bridge_lat(_bridge_lat),
+      bridge_lat(_bridge_lat),
       proto_proc_lat(_proto_proc_lat),
       ranges(_ranges.begin(), _ranges.end()),
-      outstandingResponses(0), retryReq(false), respQueueLimit(_resp_limit),
+      outstandingResponses{0, 0}, retryReq(false), stalledPort(nullptr),
+      stalledChannel(CXLReqChannel),
+      respQueueLimit{unsigned(_drs_limit), unsigned(_ndr_limit)},
       sendEvent([this]{ trySendTiming(); }, _name)
 {
     for (auto i=ranges.begin(); i!=ranges.end(); i++)
         DPRINTF(CXLMemory, "BridgeResponsePort.ranges = %s\n", i->to_string());
-
-    cxl_range = ranges.back();
-    DPRINTF(CXLMemory, "cxl_mem_start = 0x%lx, cxl_mem_end = 0x%lx\n", cxl_range.start(), cxl_range.end());
 }
 
 CXLBridge::BridgeRequestPort::BridgeRequestPort(const std::string& _name,
                                            CXLBridge& _bridge,
                                            BridgeResponsePort& _cpuSidePort,
-                                           Cycles _bridge_lat, Cycles _proto_proc_lat, int _req_limit)
+                                           Cycles _bridge_lat, Cycles _proto_proc_lat, int _req_limit,
+                                           int _rwd_limit, int _req_credits, int _rwd_credits,
+                                           AddrRange _hdm_range, const CXLLink &_m2s_link)
     : RequestPort(_name), bridge(_bridge),
       cpuSidePort(_cpuSidePort),
-      bridge_lat(_bridge_lat), proto_proc_lat(_proto_proc_lat), reqQueueLimit(_req_limit),
-      sendEvent([this]{ trySendTiming(); }, _name)
+      bridge_lat(_bridge_lat), proto_proc_lat(_proto_proc_lat),
+      reqQueueLimit{unsigned(_req_limit), unsigned(_rwd_limit)},
+      linkCredits{unsigned(_req_credits), unsigned(_rwd_credits)},
+      m2sLink(_m2s_link),
+      sendEvent([this]{ trySendTiming(); }, _name),
+      hdmRange(_hdm_range)
+{
+    DPRINTF(CXLMemory, "%s: HDM range %s\n", _name, hdmRange.to_string());
+}
+
+CXLBridge::DramPort::DramPort(const std::string& _name, CXLBridge& _bridge)
+    : QueuedRequestPort(_name, _reqQueue, _snoopRespQueue),
+      _reqQueue(_bridge, *this), _snoopRespQueue(_bridge, *this),
+      bridge(_bridge)
 {
+    // the redirected host requests are bounded by the response queue,
+    // but the writebacks among them are not
+    _reqQueue.disableSanityCheck();
 }
 
 CXLBridge::CXLBridge(const Params &p)
     : ClockedObject(p),
-      cpuSidePort(p.name + ".cpu_side_port", *this, memSidePort,
-                ticksToCycles(p.bridge_lat), ticksToCycles(p.proto_proc_lat), p.resp_fifo_depth, p.ranges),
-      memSidePort(p.name + ".mem_side_port", *this, cpuSidePort,
-                ticksToCycles(p.bridge_lat), ticksToCycles(p.proto_proc_lat), p.req_fifo_depth),      
+      cpuSidePort(p.name + ".cpu_side_port", *this,
+                ticksToCycles(p.bridge_lat), ticksToCycles(p.proto_proc_lat), p.resp_fifo_depth,
+                p.ndr_fifo_depth, p.ranges),
+      dramPort(p.name + ".dram_port", *this),
+      system(p.system),
+      bridgeLat(ticksToCycles(p.bridge_lat)),
+      protoProcLat(ticksToCycles(p.proto_proc_lat)),
+      blkSize(p.system->cacheLineSize()),
+      requestorId(p.system->getRequestorId(this)),
+      migRegion(p.migration_region),
+      migPageSize(p.migration_page_size),
+      migInterval(p.migration_interval),
+      migThreshold(p.migration_threshold),
+      migBatch(p.migration_batch),
+      migCopyDepth(p.migration_copy_depth),
+      migSources(p.migration_sources.begin(), p.migration_sources.end()),
+      migrateEvent([this]{ selectMigrations(); }, name() + ".migrate"),
+      copyEvent([this]{ issueCopies(); }, name() + ".copy"),
+      latBreakdown(p.latency_breakdown || !p.latency_trace.empty()),
+      qosThrottle(p.qos_throttle), qosInterval(p.qos_interval),
+      qosStep(p.qos_step), qosMaxGap(p.qos_max_gap),
       stats(*this)
 {
+    fatal_if(p.port_mem_side_port_connection_count == 0,
+             "%s: the bridge needs at least one memory-side port.\n", name());
+    fatal_if(!p.hdm_ranges.empty() &&
+             p.hdm_ranges.size() != p.port_mem_side_port_connection_count,
+             "%s: need one HDM range per memory-side port.\n", name());
+
+    // one root port, each with its own link, per HDM decoder target;
+    // without explicit HDM ranges the last range passed through the
+    // bridge is the CXL memory behind a single root port
+    for (int i = 0; i < p.port_mem_side_port_connection_count; ++i) {
+        AddrRange hdm_range = p.hdm_ranges.empty() ? p.ranges.back() :
+            p.hdm_ranges[i];
+        memSidePorts.push_back(new BridgeRequestPort(
+                    csprintf("%s.mem_side_port[%d]", name(), i), *this,
+                    cpuSidePort, ticksToCycles(p.bridge_lat),
+                    ticksToCycles(p.proto_proc_lat), p.req_fifo_depth,
+                    p.rwd_fifo_depth, p.m2s_req_credits, p.m2s_rwd_credits,
+                    hdm_range,
+                    CXLLink(p.link_lanes,
+                            p.link_gen == enums::PCIe6 ? 64 : 32,
+                            p.flit_size)));
+    }
+
+    if (migrationOn()) {
+        fatal_if(!isPowerOf2(migPageSize) || migPageSize < blkSize ||
+                 migRegion.interleaved() || migRegion.size() % migPageSize,
+                 "%s: the migration region must be a contiguous multiple "
+                 "of the migration page size.\n", name());
+        fatal_if(migSources.empty() || migCopyDepth == 0,
+                 "%s: page migration needs hotness sources and a copy "
+                 "depth.\n", name());
+        frameOwner.resize(migRegion.size() / migPageSize, MaxAddr);
+        frameHits.resize(frameOwner.size(), 0);
+    }
+
+    if (!p.latency_trace.empty()) {
+        latTrace = simout.create(p.latency_trace, true);
+        registerExitCallback([this]() { latTrace->stream()->flush(); });
+    }
+}
+
+CXLBridge::~CXLBridge()
+{
+    for (auto port : memSidePorts)
+        delete port;
+    if (latTrace)
+        simout.close(latTrace);
 }
 
 CXLBridge::CXLBridgeStats::CXLBridgeStats(CXLBridge &_bridge)
@@ -112,34 +199,124 @@ CXLBridge::CXLBridgeStats::CXLBridgeStats(CXLBridge &_bridge)
                "Number of times the request send succeeded"),
       ADD_STAT(rspSendSucceed, statistics::units::Count::get(),
                "Number of times the response send succeeded"),
+      ADD_STAT(reqCreditBypass, statistics::units::Count::get(),
+               "Number of requests sent ahead of older ones waiting for "
+               "link credits of the other channel"),
       ADD_STAT(reqQueueLenDist, "Request queue length distribution (Count)"),
       ADD_STAT(rspQueueLenDist, "Response queue length distribution (Count)"),
       ADD_STAT(rspOutStandDist, "outstandingResponses distribution (Count)"),
       ADD_STAT(reqQueueLatDist, "Response queue latency distribution (Tick)"),
-      ADD_STAT(rspQueueLatDist, "Response queue latency distribution (Tick)")
+      ADD_STAT(rspQueueLatDist, "Response queue latency distribution (Tick)"),
+      ADD_STAT(linkMsgs, statistics::units::Count::get(),
+               "Number of CXL.mem messages sent on the M2S link"),
+      ADD_STAT(linkFlits, statistics::units::Count::get(),
+               "Number of flits sent on the M2S link"),
+      ADD_STAT(linkDelay, statistics::units::Tick::get(),
+               "Total time M2S messages spent waiting for and being "
+               "serialised onto the link"),
+      ADD_STAT(avgLinkDelay, statistics::units::Rate<
+                    statistics::units::Tick, statistics::units::Count>::get(),
+               "Average M2S link delay per message",
+               linkDelay / linkMsgs),
+      ADD_STAT(devLoad, statistics::units::Count::get(),
+               "Number of S2M responses by the DevLoad they reported"),
+      ADD_STAT(qosGap, statistics::units::Tick::get(),
+               "Gap kept between host requests on a root port, sampled "
+               "when it is adjusted"),
+      ADD_STAT(qosDelay, statistics::units::Tick::get(),
+               "Total time host requests were held back by the DevLoad "
+               "throttling"),
+      ADD_STAT(biSnoops, statistics::units::Count::get(),
+               "Number of back-invalidate snoops passed on to the host"),
+      ADD_STAT(biSnoopsDirty, statistics::units::Count::get(),
+               "Number of back-invalidate snoops the host answered with "
+               "dirty data"),
+      ADD_STAT(migPromotions, statistics::units::Count::get(),
+               "Number of pages migrated from the CXL memory to host DRAM"),
+      ADD_STAT(migDemotions, statistics::units::Count::get(),
+               "Number of pages migrated from host DRAM back to the CXL "
+               "memory"),
+      ADD_STAT(migRetries, statistics::units::Count::get(),
+               "Number of page copies started over as the host wrote "
+               "the page"),
+      ADD_STAT(migAborts, statistics::units::Count::get(),
+               "Number of page copies given up"),
+      ADD_STAT(migCxlBytes, statistics::units::Byte::get(),
+               "Bytes the page copies read from and wrote to the CXL "
+               "memory"),
+      ADD_STAT(migDramBytes, statistics::units::Byte::get(),
+               "Bytes the page copies read from and wrote to host DRAM"),
+      ADD_STAT(migRedirected, statistics::units::Count::get(),
+               "Number of host accesses sent to a migrated page"),
+      ADD_STAT(migLatency, statistics::units::Tick::get(),
+               "Time a page copy takes"),
+      ADD_STAT(latHost, statistics::units::Tick::get(),
+               "Time from a request being made to it reaching the bridge, "
+               "through the cache misses and buses"),
+      ADD_STAT(latBridgeReq, statistics::units::Tick::get(),
+               "Time a request spends in the bridge, up to the end of its "
+               "serialisation on the link"),
+      ADD_STAT(latToDevice, statistics::units::Tick::get(),
+               "Time from a request leaving the bridge to the device "
+               "accepting it"),
+      ADD_STAT(latDeviceReq, statistics::units::Tick::get(),
+               "Time a request spends in the device until the media "
+               "controller accepts it"),
+      ADD_STAT(latMedia, statistics::units::Tick::get(),
+               "Time the media controller takes to respond"),
+      ADD_STAT(latDeviceRsp, statistics::units::Tick::get(),
+               "Time a response spends in the device"),
+      ADD_STAT(latToHost, statistics::units::Tick::get(),
+               "Time from a response leaving the device to it reaching "
+               "the bridge"),
+      ADD_STAT(latBridgeRsp, statistics::units::Tick::get(),
+               "Time a response spends in the bridge"),
+      ADD_STAT(latTotal, statistics::units::Tick::get(),
+               "Time from a request reaching the bridge to its response "
+               "leaving it")
 {
+    devLoad
+        .init(NumCXLDevLoads)
+        .subname(CXLLightLoad, "light")
+        .subname(CXLOptimalLoad, "optimal")
+        .subname(CXLModerateOverload, "moderate")
+        .subname(CXLSevereOverload, "severe")
+        .flags(statistics::nozero);
+    qosGap
+        .init()
+        .flags(statistics::nozero);
+    migLatency
+        .init()
+        .flags(statistics::nozero);
+    for (auto hist : {&latHost, &latBridgeReq, &latToDevice, &latDeviceReq,
+                      &latMedia, &latDeviceRsp, &latToHost, &latBridgeRsp,
+                      &latTotal}) {
+        hist->init().flags(statistics::nozero);
+    }
     reqQueueLenDist
-        .init(0, 129, 10)
+        .init()
         .flags(statistics::nozero);
     rspQueueLenDist
-        .init(0, 129, 10)
+        .init()
         .flags(statistics::nozero);
     rspOutStandDist
-        .init(0, 129, 10)
+        .init()
         .flags(statistics::nozero);
     reqQueueLatDist
-        .init(62000, 119999, 1000)
+        .init()
         .flags(statistics::nozero);
     rspQueueLatDist
-        .init(62000, 119999, 1000)
+        .init()
         .flags(statistics::nozero);
 }
 
 Port &
 CXLBridge::getPort(const std::string &if_name, PortID idx)
 {
-    if (if_name == "mem_side_port")
-        return memSidePort;
+    if (if_name == "mem_side_port" && idx < memSidePorts.size())
+        return *memSidePorts[idx];
+    else if (if_name == "dram_port")
+        return dramPort;
     else if (if_name == "cpu_side_port")
         return cpuSidePort;
     else
@@ -151,17 +328,45 @@ void
 CXLBridge::init()
 {
     // make sure both sides are connected and have the same block size
-    if (!cpuSidePort.isConnected() || !memSidePort.isConnected())
+    if (!cpuSidePort.isConnected())
         fatal("Both ports of a bridge must be connected.\n");
+    for (auto port : memSidePorts) {
+        if (!port->isConnected())
+            fatal("Both ports of a bridge must be connected.\n");
+    }
+
+    fatal_if(migrationOn() && !dramPort.isConnected(),
+             "%s: page migration needs the DRAM port connected.\n", name());
+    for (auto src : migSources) {
+        fatal_if(!src->hotnessPageSize(), "%s: %s does not track page "
+                 "hotness.\n", name(), src->name());
+    }
 
     // notify the request side  of our address ranges
     cpuSidePort.sendRangeChange();
 }
 
+void
+CXLBridge::startup()
+{
+    if (migrationOn())
+        schedule(migrateEvent, curTick() + migInterval);
+}
+
+CXLBridge::BridgeRequestPort&
+CXLBridge::hdmDecode(Addr addr) const
+{
+    for (auto port : memSidePorts) {
+        if (port->hdmRange.contains(addr))
+            return *port;
+    }
+    return *memSidePorts.front();
+}
+
 bool
-CXLBridge::BridgeResponsePort::respQueueFull() const
+CXLBridge::BridgeResponsePort::respQueueFull(CXLMemChannel channel) const
 {
-    if (outstandingResponses == respQueueLimit) {
+    if (outstandingResponses[channel] == respQueueLimit[channel]) {
         bridge.stats.rspQueFullEvents++;
         return true;
     } else {
@@ -170,14 +375,9 @@ CXLBridge::BridgeResponsePort::respQueueFull() const
 }
 
 bool
-CXLBridge::BridgeRequestPort::reqQueueFull() const
+CXLBridge::BridgeRequestPort::reqQueueFull(CXLMemChannel channel) const
 {
-    if (transmitList.size() == reqQueueLimit) {
-        bridge.stats.reqQueFullEvents++;
-        return true;
-    } else {
-        return false;
-    }
+    return queued[channel] == reqQueueLimit[channel];
 }
 
 bool
@@ -190,14 +390,32 @@ CXLBridge::BridgeRequestPort::recvTimingResp(PacketPtr pkt)
 
     DPRINTF(Bridge, "Request queue size: %d\n", transmitList.size());
 
+    // the response hands the link credit of its request back
+    const CXLMemChannel channel = cxlChannel(pkt);
+    if (linkCredits[channel]) {
+        assert(creditsInUse[channel] != 0);
+        --creditsInUse[channel];
+        schedSend();
+    }
+
+    // the line reads and writes of page copies end here
+    if (bridge.copyResponse(pkt))
+        return true;
+
+    CXLLatencyExtension::stamp(pkt, CXLLatencyExtension::BridgeRspIn);
+
     // technically the packet only reaches us after the header delay,
     // and typically we also need to deserialise any payload (unless
     // the two sides of the bridge are synchronous)
     Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
     pkt->headerDelay = pkt->payloadDelay = 0;
     auto total_delay = bridge_lat;
-    if (pkt->getAddr() >= cpuSidePort.cxl_range.start() && pkt->getAddr() < cpuSidePort.cxl_range.end()) {
+    if (hdmRange.contains(pkt->getAddr())) {
         total_delay = bridge_lat + proto_proc_lat;
+        if (pkt->cxl_cmd == MemCmd::S2MDRS ||
+            pkt->cxl_cmd == MemCmd::S2MNDR) {
+            recvDevLoad(static_cast<CXLDevLoad>(pkt->cxl_dev_load));
+        }
         if (pkt->cxl_cmd == MemCmd::S2MDRS) {
             assert(pkt->isRead());
         }
@@ -230,29 +448,46 @@ CXLBridge::BridgeResponsePort::recvTimingReq(PacketPtr pkt)
     if (retryReq)
         return false;
 
-    DPRINTF(Bridge, "Response queue size: %d outresp: %d\n",
-            transmitList.size(), outstandingResponses);
+    DPRINTF(Bridge, "Response queue size: %d outresp: %d/%d\n",
+            transmitList.size(), outstandingResponses[CXLReqChannel],
+            outstandingResponses[CXLRwDChannel]);
+
+    // route the request to the root port whose HDM decoder claims
+    // the address
+    BridgeRequestPort &mem_side_port = bridge.hdmDecode(pkt->getAddr());
+
+    // reads and writes are queued and answered on channels of their
+    // own, so a burst of writebacks does not keep the reads out
+    CXLMemChannel channel = cxlChannel(pkt);
 
     // if the request queue is full then there is no hope
-    if (memSidePort.reqQueueFull()) {
+    if (mem_side_port.reqQueueFull(channel)) {
         DPRINTF(Bridge, "Request queue full\n");
+        bridge.stats.reqQueFullEvents++;
         retryReq = true;
+        stalledPort = &mem_side_port;
+        stalledChannel = channel;
     } else {
         // look at the response queue if we expect to see a response
         bool expects_response = pkt->needsResponse();
         if (expects_response) {
-            if (respQueueFull()) {
+            if (respQueueFull(channel)) {
                 DPRINTF(Bridge, "Response queue full\n");
                 retryReq = true;
+                stalledPort = nullptr;
+                stalledChannel = channel;
             } else {
                 // ok to send the request with space for the response
                 DPRINTF(Bridge, "Reserving space for response\n");
-                assert(outstandingResponses != respQueueLimit);
-                ++outstandingResponses;
+                assert(outstandingResponses[channel] !=
+                       respQueueLimit[channel]);
+                ++outstandingResponses[channel];
 
                 // no need to set retryReq to false as this is already the
                 // case
-                bridge.stats.rspOutStandDist.sample(outstandingResponses);
+                bridge.stats.rspOutStandDist.sample(
+                    outstandingResponses[CXLReqChannel] +
+                    outstandingResponses[CXLRwDChannel]);
             }
         }
 
@@ -263,8 +498,24 @@ CXLBridge::BridgeResponsePort::recvTimingReq(PacketPtr pkt)
             // synchronous)
             Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
             pkt->headerDelay = pkt->payloadDelay = 0;
+
+            if (bridge.latBreakdown && expects_response) {
+                auto trace = std::make_shared<CXLLatencyExtension>(
+                    pkt->getAddr(), pkt->isWrite(), pkt->req->time());
+                trace->ticks[CXLLatencyExtension::BridgeIn] = curTick();
+                pkt->setExtension(trace);
+            }
+
+            // a migrated page lives in host DRAM
+            if (bridge.redirect(pkt, bridge.clockEdge(bridge_lat) +
+                                receive_delay)) {
+                if (!expects_response)
+                    pendingDelete.reset(pkt);
+                return true;
+            }
+
             auto total_delay = bridge_lat;
-            if (pkt->getAddr() >= cxl_range.start() && pkt->getAddr() < cxl_range.end()) {
+            if (mem_side_port.hdmRange.contains(pkt->getAddr())) {
                 total_delay = bridge_lat + proto_proc_lat;
                 if (pkt->isRead())
                     pkt->cxl_cmd = MemCmd::M2SReq;
@@ -272,11 +523,17 @@ CXLBridge::BridgeResponsePort::recvTimingReq(PacketPtr pkt)
                     pkt->cxl_cmd = MemCmd::M2SRwD;
                 else
                     DPRINTF(CXLMemory, "the cmd of packet is %s, not a read or write.\n", pkt->cmd.toString());
-                DPRINTF(CXLMemory, "recvTimingReq: %s addr 0x%x, when tick%ld\n", 
-                    pkt->cmdString(), pkt->getAddr(), bridge.clockEdge(total_delay) + receive_delay);
             }
-            memSidePort.schedTimingReq(pkt, bridge.clockEdge(total_delay) +
-                                      receive_delay);
+            Tick when = bridge.clockEdge(total_delay) + receive_delay;
+            if (pkt->cxl_cmd == MemCmd::M2SReq ||
+                pkt->cxl_cmd == MemCmd::M2SRwD) {
+                // the request is serialised onto the link once it has
+                // a link credit
+                when = mem_side_port.throttle(when);
+                DPRINTF(CXLMemory, "recvTimingReq: %s addr 0x%x, when tick%ld\n",
+                    pkt->cmdString(), pkt->getAddr(), when);
+            }
+            mem_side_port.schedTimingReq(pkt, when);
         }
     }
 
@@ -288,9 +545,11 @@ CXLBridge::BridgeResponsePort::recvTimingReq(PacketPtr pkt)
 }
 
 void
-CXLBridge::BridgeResponsePort::retryStalledReq()
+CXLBridge::BridgeResponsePort::retryStalledReq(const BridgeRequestPort *port,
+                                               CXLMemChannel channel)
 {
-    if (retryReq) {
+    if (retryReq && (!stalledPort ||
+                     (stalledPort == port && stalledChannel == channel))) {
         DPRINTF(Bridge, "Request waiting for retry, now retrying\n");
         retryReq = false;
         sendRetryReq();
@@ -301,19 +560,21 @@ CXLBridge::BridgeResponsePort::retryStalledReq()
 void
 CXLBridge::BridgeRequestPort::schedTimingReq(PacketPtr pkt, Tick when)
 {
-    // If we're about to put this packet at the head of the queue, we
-    // need to schedule an event to do the transmit.  Otherwise there
-    // should already be an event scheduled for sending the head
-    // packet.
-    if (transmitList.empty()) {
-        bridge.schedule(sendEvent, when);
-    }
+    // The send event may be scheduled for a later tick, when a request
+    // on the link arrives, or a request waiting for link credits of the
+    // other channel may keep it from being scheduled at all, so we make
+    // sure it runs when this one is ready. Unless the queue waits for a
+    // retry.
+    schedSend(when);
 
-    assert(transmitList.size() != reqQueueLimit);
+    CXLMemChannel channel = cxlChannel(pkt);
+    assert(queued[channel] != reqQueueLimit[channel]);
 
     transmitList.emplace_back(pkt, when);
+    ++queued[channel];
 
-    bridge.stats.reqQueueLenDist.sample(transmitList.size());
+    bridge.stats.reqQueueLenDist.sample(transmitList.size() +
+                                        linkList.size());
 }
 
 
@@ -333,48 +594,140 @@ CXLBridge::BridgeResponsePort::schedTimingResp(PacketPtr pkt, Tick when)
     bridge.stats.rspQueueLenDist.sample(transmitList.size());
 }
 
+int
+CXLBridge::BridgeRequestPort::pickRequest(Tick &next_ready) const
+{
+    next_ready = MaxTick;
+
+    // only requests waiting for link credits are passed, so without
+    // tracked credits this is the head of the queue
+    for (size_t i = 0; i < transmitList.size(); ++i) {
+        const DeferredPacket &req = transmitList[i];
+        if (noCredit(cxlChannel(req.pkt)))
+            continue;
+        if (req.tick > curTick()) {
+            next_ready = req.tick;
+            return -1;
+        }
+
+        // keep the order of the accesses to a line that write
+        Addr line = req.pkt->getAddr() & ~Addr(bridge.blkSize - 1);
+        bool hazard = false;
+        for (size_t j = 0; !hazard && j < i; ++j) {
+            PacketPtr older = transmitList[j].pkt;
+            hazard = (older->getAddr() & ~Addr(bridge.blkSize - 1)) ==
+                line && (older->isWrite() || req.pkt->isWrite());
+        }
+        if (!hazard)
+            return i;
+    }
+    return -1;
+}
+
+void
+CXLBridge::BridgeRequestPort::schedSend()
+{
+    Tick when = MaxTick;
+    if (!linkList.empty())
+        when = linkList.front().tick;
+    if (!transmitList.empty())
+        when = std::min(when, transmitList.front().tick);
+    if (when != MaxTick)
+        schedSend(std::max(when, bridge.clockEdge()));
+}
+
+void
+CXLBridge::BridgeRequestPort::schedSend(Tick when)
+{
+    if (waitingRetry)
+        return;
+
+    when = std::max(when, curTick());
+    if (!sendEvent.scheduled()) {
+        DPRINTF(Bridge, "Scheduling next send\n");
+        bridge.schedule(sendEvent, when);
+    } else if (when < sendEvent.when()) {
+        DPRINTF(Bridge, "Scheduling next send earlier\n");
+        bridge.reschedule(sendEvent, when);
+    }
+}
+
 void
 CXLBridge::BridgeRequestPort::trySendTiming()
 {
-    assert(!transmitList.empty());
+    assert(!transmitList.empty() || !linkList.empty());
+
+    // the requests that may go take their link credit and are put on
+    // the link in the order they are picked, so a read that passes
+    // writes waiting for credits does not wait for their flits either
+    Tick next_ready;
+    int index;
+    while ((index = pickRequest(next_ready)) >= 0) {
+        DeferredPacket req = transmitList[index];
+        assert(req.tick <= curTick());
+
+        PacketPtr pkt = req.pkt;
+        const CXLMemChannel channel = cxlChannel(pkt);
+
+        if (index > 0)
+            bridge.stats.reqCreditBypass++;
+
+        // the request holds a link credit until its response
+        if (pkt->needsResponse() && linkCredits[channel])
+            ++creditsInUse[channel];
+
+        Tick arrival = curTick();
+        if (pkt->cxl_cmd == MemCmd::M2SReq ||
+            pkt->cxl_cmd == MemCmd::M2SRwD) {
+            arrival = transmit(pkt, arrival);
+        }
+        DPRINTF(Bridge, "trySend request addr 0x%x on the link until "
+                "tick %d\n", pkt->getAddr(), arrival);
 
-    DeferredPacket req = transmitList.front();
+        transmitList.erase(transmitList.begin() + index);
+        linkList.emplace_back(pkt, arrival);
+    }
 
-    assert(req.tick <= curTick());
+    while (!linkList.empty() && linkList.front().tick <= curTick()) {
+        PacketPtr pkt = linkList.front().pkt;
+        const CXLMemChannel channel = cxlChannel(pkt);
 
-    PacketPtr pkt = req.pkt;
+        DPRINTF(Bridge, "trySend request addr 0x%x, queue size %d\n",
+                pkt->getAddr(), transmitList.size() + linkList.size());
 
-    DPRINTF(Bridge, "trySend request addr 0x%x, queue size %d\n",
-            pkt->getAddr(), transmitList.size());
+        CXLLatencyExtension::stamp(pkt, CXLLatencyExtension::BridgeOut);
+        if (!sendTimingReq(pkt)) {
+            // we try again once we receive a retry
+            bridge.stats.reqSendFaild++;
+            waitingRetry = true;
+            return;
+        }
 
-    if (sendTimingReq(pkt)) {
         // send successful
         bridge.stats.reqSendSucceed++;
 
-        transmitList.pop_front();
+        linkList.pop_front();
+        --queued[channel];
 
-        bridge.stats.reqQueueLenDist.sample(transmitList.size());
+        bridge.stats.reqQueueLenDist.sample(transmitList.size() +
+                                            linkList.size());
         DPRINTF(Bridge, "trySend request successful\n");
 
-        // If there are more packets to send, schedule event to try again.
-        if (!transmitList.empty()) {
-            DeferredPacket next_req = transmitList.front();
-            DPRINTF(Bridge, "Scheduling next send\n");
-            bridge.schedule(sendEvent, std::max(next_req.tick,
-                                                bridge.clockEdge()));
-        }
-
         // if we have stalled a request due to a full request queue,
         // then send a retry at this point, also note that if the
         // request we stalled was waiting for the response queue
         // rather than the request queue we might stall it again
-        cpuSidePort.retryStalledReq();
-    } else {
-        bridge.stats.reqSendFaild++;
+        cpuSidePort.retryStalledReq(this, channel);
     }
 
-    // if the send failed, then we try again once we receive a retry,
-    // and therefore there is no need to take any action
+    // wait for the next request to reach the device, or to get ready,
+    // the requests waiting for link credits are tried again when the
+    // responses hand them back
+    Tick when = next_ready;
+    if (!linkList.empty())
+        when = std::min(when, linkList.front().tick);
+    if (when != MaxTick)
+        schedSend(when);
 }
 
 void
@@ -387,23 +740,30 @@ CXLBridge::BridgeResponsePort::trySendTiming()
     assert(resp.tick <= curTick());
 
     PacketPtr pkt = resp.pkt;
+    const CXLMemChannel channel = cxlChannel(pkt);
 
     DPRINTF(Bridge, "trySend response addr 0x%x, outstanding %d\n",
-            pkt->getAddr(), outstandingResponses);
+            pkt->getAddr(), outstandingResponses[channel]);
 
+    // the requestor may delete the packet as soon as it has it
+    auto trace = pkt->getExtension<CXLLatencyExtension>();
     if (sendTimingResp(pkt)) {
         // send successful
         bridge.stats.rspSendSucceed++;
+        if (trace)
+            bridge.recordLatency(*trace);
 
         transmitList.pop_front();
 
         bridge.stats.rspQueueLenDist.sample(transmitList.size());
         DPRINTF(Bridge, "trySend response successful\n");
 
-        assert(outstandingResponses != 0);
-        --outstandingResponses;
+        assert(outstandingResponses[channel] != 0);
+        --outstandingResponses[channel];
 
-        bridge.stats.rspOutStandDist.sample(outstandingResponses);
+        bridge.stats.rspOutStandDist.sample(
+            outstandingResponses[CXLReqChannel] +
+            outstandingResponses[CXLRwDChannel]);
 
         // If there are more packets to send, schedule event to try again.
         if (!transmitList.empty()) {
@@ -413,10 +773,12 @@ CXLBridge::BridgeResponsePort::trySendTiming()
                                                 bridge.clockEdge()));
         }
 
-        // if there is space in the request queue and we were stalling
-        // a request, it will definitely be possible to accept it now
-        // since there is guaranteed space in the response queue
-        if (!memSidePort.reqQueueFull() && retryReq) {
+        // if a request stalled on the responses of this channel, or on
+        // a request queue with space by now, it will definitely be
+        // possible to accept it now
+        if (retryReq && (stalledPort ?
+                         !stalledPort->reqQueueFull(stalledChannel) :
+                         stalledChannel == channel)) {
             DPRINTF(Bridge, "Request waiting for retry, now retrying\n");
             retryReq = false;
             sendRetryReq();
@@ -433,6 +795,7 @@ CXLBridge::BridgeResponsePort::trySendTiming()
 void
 CXLBridge::BridgeRequestPort::recvReqRetry()
 {
+    waitingRetry = false;
     trySendTiming();
 }
 
@@ -442,12 +805,66 @@ CXLBridge::BridgeResponsePort::recvRespRetry()
     trySendTiming();
 }
 
+void
+CXLBridge::BridgeRequestPort::recvTimingSnoopReq(PacketPtr pkt)
+{
+    DPRINTF(CXLMemory, "recvTimingSnoopReq: %s addr 0x%x\n",
+            pkt->cmdString(), pkt->getAddr());
+
+    // back-invalidate snoops are express snoops, the host caches see
+    // them right away and the time they take is accumulated in the
+    // header delay
+    bridge.stats.biSnoops++;
+    pkt->headerDelay += (bridge_lat + proto_proc_lat) * bridge.clockPeriod();
+    cpuSidePort.sendTimingSnoopReq(pkt);
+}
+
+Tick
+CXLBridge::BridgeRequestPort::recvAtomicSnoop(PacketPtr pkt)
+{
+    bridge.stats.biSnoops++;
+    Tick snoop_delay = cpuSidePort.sendAtomicSnoop(pkt);
+    if (pkt->cacheResponding())
+        bridge.stats.biSnoopsDirty++;
+    return (bridge_lat + proto_proc_lat) * bridge.clockPeriod() +
+        snoop_delay;
+}
+
+bool
+CXLBridge::BridgeResponsePort::recvTimingSnoopResp(PacketPtr pkt)
+{
+    DPRINTF(CXLMemory, "recvTimingSnoopResp: %s addr 0x%x\n",
+            pkt->cmdString(), pkt->getAddr());
+
+    // the host answers a back-invalidate snoop with a BIRsp, and a
+    // line it held dirty goes back to the device as an M2SRwD
+    BridgeRequestPort &mem_side_port = bridge.hdmDecode(pkt->getAddr());
+    Tick when = bridge.clockEdge(bridge_lat + proto_proc_lat) +
+        pkt->headerDelay + pkt->payloadDelay;
+    pkt->cxl_cmd = MemCmd::M2SBIRsp;
+    when = mem_side_port.transmit(pkt, when);
+    if (pkt->hasData()) {
+        bridge.stats.biSnoopsDirty++;
+        pkt->cxl_cmd = MemCmd::M2SRwD;
+        when = mem_side_port.transmit(pkt, when);
+    }
+    pkt->headerDelay = when - curTick();
+    pkt->payloadDelay = 0;
+    return mem_side_port.sendTimingSnoopResp(pkt);
+}
+
 Tick
 CXLBridge::BridgeResponsePort::recvAtomic(PacketPtr pkt)
 {
     panic_if(pkt->cacheResponding(), "Should not see packets where cache "
              "is responding");
-    if (pkt->getAddr() >= cxl_range.start() && pkt->getAddr() < cxl_range.end()) {
+
+    Tick redirect_delay;
+    if (bridge.redirectAtomic(pkt, redirect_delay))
+        return bridge_lat * bridge.clockPeriod() + redirect_delay;
+
+    BridgeRequestPort &mem_side_port = bridge.hdmDecode(pkt->getAddr());
+    if (mem_side_port.hdmRange.contains(pkt->getAddr())) {
         DPRINTF(CXLMemory, "the cmd of pkt is %s, addrRange is %s.\n",
             pkt->cmd.toString(), pkt->getAddrRange().to_string());
         if (pkt->isRead())
@@ -456,12 +873,13 @@ CXLBridge::BridgeResponsePort::recvAtomic(PacketPtr pkt)
             pkt->cxl_cmd = MemCmd::M2SRwD;
         else
             DPRINTF(CXLMemory, "the cmd of packet is %s, not a read or write.\n", pkt->cmd.toString());
-        Tick access_delay = memSidePort.sendAtomic(pkt);
+        Tick access_delay = mem_side_port.sendAtomic(pkt);
         Tick total_delay = (bridge_lat + proto_proc_lat) * bridge.clockPeriod() + access_delay;
         return total_delay;
     }
     else {
-        return bridge_lat * bridge.clockPeriod() + memSidePort.sendAtomic(pkt);
+        return bridge_lat * bridge.clockPeriod() +
+            mem_side_port.sendAtomic(pkt);
     }
 }
 
@@ -469,8 +887,23 @@ Tick
 CXLBridge::BridgeResponsePort::recvAtomicBackdoor(
     PacketPtr pkt, MemBackdoorPtr &backdoor)
 {
-    return bridge_lat * bridge.clockPeriod() + memSidePort.sendAtomicBackdoor(
-        pkt, backdoor);
+    // a backdoor would bypass the indirection table
+    if (bridge.migrationOn())
+        return recvAtomic(pkt);
+
+    // the access that asks for the backdoor pays the way to the device
+    // like any other, the device decides whether to hand one out
+    BridgeRequestPort &mem_side_port = bridge.hdmDecode(pkt->getAddr());
+    Cycles delay = bridge_lat;
+    if (mem_side_port.hdmRange.contains(pkt->getAddr())) {
+        delay += proto_proc_lat;
+        if (pkt->isRead())
+            pkt->cxl_cmd = MemCmd::M2SReq;
+        else if (pkt->isWrite())
+            pkt->cxl_cmd = MemCmd::M2SRwD;
+    }
+    return delay * bridge.clockPeriod() +
+        mem_side_port.sendAtomicBackdoor(pkt, backdoor);
 }
 
 void
@@ -486,39 +919,436 @@ CXLBridge::BridgeResponsePort::recvFunctional(PacketPtr pkt)
         }
     }
 
-    // also check the request port's request queue
-    if (memSidePort.trySatisfyFunctional(pkt)) {
+    // also check the request queue of the root port the address
+    // decodes to
+    BridgeRequestPort &mem_side_port = bridge.hdmDecode(pkt->getAddr());
+    if (mem_side_port.trySatisfyFunctional(pkt)) {
         return;
     }
 
     pkt->popLabel();
 
+    // a migrated page lives in host DRAM
+    if (bridge.migrationOn()) {
+        Addr page = roundDown(pkt->getAddr(), bridge.migPageSize);
+        auto it = bridge.remap.find(page);
+        if (it != bridge.remap.end()) {
+            Addr addr = pkt->getAddr();
+            pkt->setAddr(bridge.frameAddr(it->second) + addr - page);
+            bridge.dramPort.sendFunctional(pkt);
+            pkt->setAddr(addr);
+            return;
+        }
+    }
+
     // fall through if pkt still not satisfied
-    memSidePort.sendFunctional(pkt);
+    mem_side_port.sendFunctional(pkt);
 }
 
 void
 CXLBridge::BridgeResponsePort::recvMemBackdoorReq(
     const MemBackdoorReq &req, MemBackdoorPtr &backdoor)
 {
-    memSidePort.sendMemBackdoorReq(req, backdoor);
+    if (!bridge.migrationOn())
+        bridge.hdmDecode(req.range().start()).sendMemBackdoorReq(req,
+                                                                 backdoor);
+}
+
+Tick
+CXLBridge::BridgeRequestPort::transmit(PacketPtr pkt, Tick when)
+{
+    // serialise the message onto the M2S direction of this root
+    // port's link, which is where the link width shows up
+    uint64_t flits = m2sLink.flitsSent();
+    Tick sent = m2sLink.transmit(pkt, when);
+    bridge.stats.linkMsgs++;
+    bridge.stats.linkFlits += m2sLink.flitsSent() - flits;
+    bridge.stats.linkDelay += sent - when;
+    return sent;
+}
+
+Tick
+CXLBridge::BridgeRequestPort::throttle(Tick when)
+{
+    if (!bridge.qosThrottle || qosGap == 0)
+        return when;
+
+    // the requests leave the root port no closer than the gap, and
+    // the ones that wait fill the request queue, which pushes back on
+    // the host
+    Tick issue = std::max(when, qosNextIssue);
+    bridge.stats.qosDelay += issue - when;
+    qosNextIssue = issue + qosGap;
+    return issue;
+}
+
+void
+CXLBridge::BridgeRequestPort::recvDevLoad(CXLDevLoad load)
+{
+    bridge.stats.devLoad[load]++;
+    if (!bridge.qosThrottle)
+        return;
+
+    qosLoad = std::max(qosLoad, load);
+    if (curTick() < qosLastAdjust + bridge.qosInterval)
+        return;
+
+    // back off by a step for a moderate overload and twice as fast
+    // for a severe one, hold the rate at an optimal load, and give a
+    // step back when the device is lightly loaded
+    switch (qosLoad) {
+      case CXLLightLoad:
+        qosGap -= std::min(qosGap, bridge.qosStep);
+        break;
+      case CXLOptimalLoad:
+        break;
+      case CXLModerateOverload:
+        qosGap += bridge.qosStep;
+        break;
+      default:
+        qosGap = 2 * qosGap + bridge.qosStep;
+        break;
+    }
+    qosGap = std::min(qosGap, bridge.qosMaxGap);
+    bridge.stats.qosGap.sample(qosGap);
+
+    DPRINTF(Bridge, "%s: DevLoad %d, request gap %d\n", name(), qosLoad,
+            qosGap);
+
+    qosLoad = CXLLightLoad;
+    qosLastAdjust = curTick();
 }
 
 bool
 CXLBridge::BridgeRequestPort::trySatisfyFunctional(PacketPtr pkt)
 {
-    bool found = false;
-    auto i = transmitList.begin();
+    for (const auto &list : {&linkList, &transmitList}) {
+        for (const DeferredPacket &req : *list) {
+            if (pkt->trySatisfyFunctional(req.pkt)) {
+                pkt->makeResponse();
+                return true;
+            }
+        }
+    }
 
-    while (i != transmitList.end() && !found) {
-        if (pkt->trySatisfyFunctional((*i).pkt)) {
-            pkt->makeResponse();
-            found = true;
+    return false;
+}
+
+bool
+CXLBridge::DramPort::recvTimingResp(PacketPtr pkt)
+{
+    if (bridge.copyResponse(pkt))
+        return true;
+
+    auto it = bridge.redirects.find(pkt);
+    if (it == bridge.redirects.end()) {
+        // the write of a request that needs no response
+        delete pkt;
+        return true;
+    }
+
+    // answer the host request with the access to its copy
+    PacketPtr orig = it->second;
+    bridge.redirects.erase(it);
+    if (orig->isRead())
+        orig->setData(pkt->getConstPtr<uint8_t>());
+    orig->makeResponse();
+    Tick when = bridge.clockEdge(bridge.bridgeLat) + pkt->headerDelay +
+        pkt->payloadDelay;
+    delete pkt;
+    bridge.cpuSidePort.schedTimingResp(orig, when);
+    return true;
+}
+
+bool
+CXLBridge::redirect(PacketPtr pkt, Tick when)
+{
+    if (!migrationOn())
+        return false;
+
+    Addr page = roundDown(pkt->getAddr(), migPageSize);
+    if (pkt->isWrite() && !migJobs.empty() && migJobs.front().page == page)
+        migJobs.front().dirty = true;
+
+    auto it = remap.find(page);
+    if (it == remap.end() || !(pkt->isRead() || pkt->isWrite()))
+        return false;
+
+    RequestPtr req = std::make_shared<Request>(
+        frameAddr(it->second) + pkt->getAddr() - page, pkt->getSize(), 0,
+        requestorId);
+    PacketPtr access = new Packet(req, pkt->isRead() ? MemCmd::ReadReq :
+                                  MemCmd::WriteReq);
+    access->allocate();
+    if (pkt->isWrite())
+        access->setData(pkt->getConstPtr<uint8_t>());
+    if (pkt->needsResponse())
+        redirects[access] = pkt;
+
+    frameHits[it->second]++;
+    stats.migRedirected++;
+    dramPort.schedTimingReq(access, when);
+    return true;
+}
+
+bool
+CXLBridge::redirectAtomic(PacketPtr pkt, Tick &delay)
+{
+    if (!migrationOn())
+        return false;
+
+    Addr page = roundDown(pkt->getAddr(), migPageSize);
+    auto it = remap.find(page);
+    if (it == remap.end() || !(pkt->isRead() || pkt->isWrite()))
+        return false;
+
+    RequestPtr req = std::make_shared<Request>(
+        frameAddr(it->second) + pkt->getAddr() - page, pkt->getSize(), 0,
+        requestorId);
+    Packet access(req, pkt->isRead() ? MemCmd::ReadReq : MemCmd::WriteReq);
+    access.dataStatic(pkt->getPtr<uint8_t>());
+
+    frameHits[it->second]++;
+    stats.migRedirected++;
+    delay = dramPort.sendAtomic(&access);
+    if (pkt->needsResponse())
+        pkt->makeResponse();
+    return true;
+}
+
+void
+CXLBridge::selectMigrations()
+{
+    // the copy engine only runs with the timing memory system, and one
+    // round of copies at a time
+    if (system->isTimingMode() && migJobs.empty()) {
+        std::vector<std::pair<Addr, uint32_t>> hot;
+        for (auto src : migSources) {
+            auto pages = src->hotPages(migBatch, migThreshold);
+            hot.insert(hot.end(), pages.begin(), pages.end());
         }
-        ++i;
+        std::stable_sort(hot.begin(), hot.end(),
+            [](const auto &a, const auto &b) { return a.second > b.second; });
+
+        std::unordered_set<unsigned> taken;
+        for (const auto &[addr, count] : hot) {
+            if (taken.size() == migBatch)
+                break;
+            Addr page = roundDown(addr, migPageSize);
+            if (remap.count(page))
+                continue;
+
+            // a free frame, or else the coldest frame if it is colder
+            // than the page, which then goes back to the CXL memory
+            int frame = -1;
+            for (unsigned f = 0; f < frameOwner.size(); ++f) {
+                if (taken.count(f))
+                    continue;
+                if (frameOwner[f] == MaxAddr) {
+                    frame = f;
+                    break;
+                }
+                if (frameHits[f] < count &&
+                    (frame < 0 || frameHits[f] < frameHits[frame])) {
+                    frame = f;
+                }
+            }
+            if (frame < 0)
+                break;
+
+            taken.insert(frame);
+            if (frameOwner[frame] != MaxAddr)
+                migJobs.emplace_back(frameOwner[frame], frame, false);
+            migJobs.emplace_back(page, frame, true);
+            DPRINTF(CXLMemory, "migrate page 0x%x (%d accesses) to frame "
+                    "%d\n", page, count, frame);
+        }
+        startJob();
     }
 
-    return found;
+    // age the accesses to the frames
+    for (auto &hits : frameHits)
+        hits >>= 1;
+
+    schedule(migrateEvent, curTick() + migInterval);
+}
+
+void
+CXLBridge::startJob()
+{
+    while (!migJobs.empty()) {
+        MigrationJob &job = migJobs.front();
+        // a promotion whose frame could not be freed is dropped
+        if (job.promote &&
+            (frameOwner[job.frame] != MaxAddr || remap.count(job.page))) {
+            migJobs.pop_front();
+            continue;
+        }
+        job.start = curTick();
+        issueCopies();
+        return;
+    }
+}
+
+bool
+CXLBridge::sendCopy(PacketPtr pkt, bool to_cxl)
+{
+    if (to_cxl) {
+        BridgeRequestPort &port = hdmDecode(pkt->getAddr());
+        if (port.reqQueueFull(cxlChannel(pkt)))
+            return false;
+        pkt->cxl_cmd = pkt->isRead() ? MemCmd::M2SReq : MemCmd::M2SRwD;
+        port.schedTimingReq(pkt, clockEdge(protoProcLat));
+        stats.migCxlBytes += pkt->getSize();
+    } else {
+        dramPort.schedTimingReq(pkt, clockEdge());
+        stats.migDramBytes += pkt->getSize();
+    }
+    copyReqs.insert(pkt->req);
+    return true;
+}
+
+void
+CXLBridge::issueCopies()
+{
+    if (migJobs.empty())
+        return;
+
+    MigrationJob &job = migJobs.front();
+    const Addr src = job.promote ? job.page : frameAddr(job.frame);
+
+    // writes first, they free up room in the copy
+    while (!copyWrites.empty()) {
+        if (!sendCopy(copyWrites.front(), !job.promote)) {
+            if (!copyEvent.scheduled())
+                schedule(copyEvent, clockEdge(Cycles(1)));
+            return;
+        }
+        copyWrites.pop_front();
+    }
+
+    while (job.nextLine < migPageSize / blkSize &&
+           job.inFlight < migCopyDepth) {
+        RequestPtr req = std::make_shared<Request>(
+            src + job.nextLine * blkSize, blkSize, 0, requestorId);
+        PacketPtr pkt = new Packet(req, MemCmd::ReadReq);
+        pkt->allocate();
+        if (!sendCopy(pkt, job.promote)) {
+            delete pkt;
+            if (!copyEvent.scheduled())
+                schedule(copyEvent, clockEdge(Cycles(1)));
+            return;
+        }
+        ++job.nextLine;
+        ++job.inFlight;
+    }
+}
+
+bool
+CXLBridge::copyResponse(PacketPtr pkt)
+{
+    if (!copyReqs.erase(pkt->req))
+        return false;
+
+    assert(!migJobs.empty());
+    MigrationJob &job = migJobs.front();
+
+    if (pkt->isRead()) {
+        // the line read turns into the write of its copy
+        const Addr src = job.promote ? job.page : frameAddr(job.frame);
+        const Addr dst = job.promote ? frameAddr(job.frame) : job.page;
+        RequestPtr req = std::make_shared<Request>(
+            dst + pkt->getAddr() - src, blkSize, 0, requestorId);
+        PacketPtr write = new Packet(req, MemCmd::WriteReq);
+        write->allocate();
+        write->setData(pkt->getConstPtr<uint8_t>());
+        copyWrites.push_back(write);
+        delete pkt;
+        issueCopies();
+        return true;
+    }
+
+    delete pkt;
+    --job.inFlight;
+    if (++job.done == migPageSize / blkSize)
+        finishJob();
+    else
+        issueCopies();
+    return true;
+}
+
+void
+CXLBridge::finishJob()
+{
+    MigrationJob &job = migJobs.front();
+
+    if (job.dirty) {
+        // the host wrote the page behind the copy, which is only
+        // consistent once it copies a page nobody writes to
+        if (++job.retries <= migMaxRetries) {
+            DPRINTF(CXLMemory, "page 0x%x written while copied, "
+                    "starting over\n", job.page);
+            stats.migRetries++;
+            job.nextLine = job.done = 0;
+            job.dirty = false;
+            issueCopies();
+            return;
+        }
+        stats.migAborts++;
+    } else if (job.promote) {
+        remap[job.page] = job.frame;
+        frameOwner[job.frame] = job.page;
+        frameHits[job.frame] = 0;
+        stats.migPromotions++;
+    } else {
+        remap.erase(job.page);
+        frameOwner[job.frame] = MaxAddr;
+        stats.migDemotions++;
+    }
+
+    DPRINTF(CXLMemory, "page 0x%x %s frame %d\n", job.page,
+            job.promote ? "moved to" : "moved back from", job.frame);
+    stats.migLatency.sample(curTick() - job.start);
+    migJobs.pop_front();
+    startJob();
+}
+
+void
+CXLBridge::recordLatency(const CXLLatencyExtension &trace)
+{
+    using Point = CXLLatencyExtension;
+    const Tick stages[CXLLatencyRecord::NumStages] = {
+        trace.ticks[Point::BridgeIn] - trace.issue,
+        trace.between(Point::BridgeIn, Point::BridgeOut),
+        trace.between(Point::BridgeOut, Point::DeviceIn),
+        trace.between(Point::DeviceIn, Point::MediaIn),
+        trace.between(Point::MediaIn, Point::MediaOut),
+        trace.between(Point::MediaOut, Point::DeviceOut),
+        trace.between(Point::DeviceOut, Point::BridgeRspIn),
+        trace.ticks[Point::BridgeRspIn] == MaxTick ? MaxTick :
+            curTick() - trace.ticks[Point::BridgeRspIn]
+    };
+    statistics::LogHistogram *hists[CXLLatencyRecord::NumStages] = {
+        &stats.latHost, &stats.latBridgeReq, &stats.latToDevice,
+        &stats.latDeviceReq, &stats.latMedia, &stats.latDeviceRsp,
+        &stats.latToHost, &stats.latBridgeRsp
+    };
+
+    CXLLatencyRecord record{};
+    record.addr = trace.addr;
+    record.bridgeIn = trace.ticks[Point::BridgeIn];
+    record.flags = trace.write ? 1 : 0;
+    for (int i = 0; i < CXLLatencyRecord::NumStages; ++i) {
+        if (stages[i] != MaxTick)
+            hists[i]->sample(stages[i]);
+        record.stages[i] = std::min<Tick>(stages[i], UINT32_MAX);
+    }
+    stats.latTotal.sample(curTick() - trace.ticks[Point::BridgeIn]);
+
+    if (latTrace) {
+        latTrace->stream()->write(reinterpret_cast<const char *>(&record),
+                                  sizeof(record));
+    }
 }
 
 AddrRangeList
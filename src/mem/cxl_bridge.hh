@@ -47,17 +47,43 @@
 #ifndef __MEM_CXL_BRIDGE_HH__
 #define __MEM_CXL_BRIDGE_HH__
 
+#include <array>
 #include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "base/output.hh"
 #include "base/types.hh"
 #include "base/statistics.hh"
+#include "mem/cxl_latency.hh"
+#include "mem/cxl_link.hh"
 #include "mem/port.hh"
+#include "mem/qport.hh"
 #include "params/CXLBridge.hh"
 #include "sim/clocked_object.hh"
 
 namespace gem5
 {
 
+class CXLMemory;
+class System;
+
+/**
+ * The CXL host bridge/root port. Requests to the CXL ranges are
+ * converted to CXL.mem messages and sent over the CXL link to the
+ * device on the memory side, which is normally linked directly to the
+ * bridge rather than through the I/O bus. Any other range passed
+ * through the bridge only pays the bridge latency.
+ *
+ * The bridge can also migrate hot pages of the CXL memory into a
+ * region of host DRAM reserved for it, like hardware-managed memory
+ * tiering does. The hotness counters of the CXL devices pick the
+ * pages, a copy engine moves them line by line through both media,
+ * and an indirection table in the bridge sends the host accesses to
+ * a migrated page to its copy in host DRAM. When the region is full
+ * the coldest page goes back to the CXL memory to make room.
+ */
 class CXLBridge : public ClockedObject
 {
   protected:
@@ -71,8 +97,8 @@ class CXLBridge : public ClockedObject
 
       public:
 
-        const Tick tick;
-        const PacketPtr pkt;
+        Tick tick;
+        PacketPtr pkt;
 
         DeferredPacket(PacketPtr _pkt, Tick _tick) : tick(_tick), pkt(_pkt)
         { }
@@ -95,11 +121,6 @@ class CXLBridge : public ClockedObject
         /** The bridge to which this port belongs. */
         CXLBridge& bridge;
 
-        /**
-         * Request port on the other side of the bridge.
-         */
-        BridgeRequestPort& memSidePort;
-
         /** Minimum request delay though this bridge. */
         const Cycles bridge_lat;
 
@@ -117,14 +138,23 @@ class CXLBridge : public ClockedObject
          */
         std::deque<DeferredPacket> transmitList;
 
-        /** Counter to track the outstanding responses. */
-        unsigned int outstandingResponses;
+        /**
+         * Counters to track the outstanding responses, of the reads
+         * (S2M DRS) and of the writes (S2M NDR).
+         */
+        std::array<unsigned int, NumCXLMemChannels> outstandingResponses;
 
         /** If we should send a retry when space becomes available. */
         bool retryReq;
 
-        /** Max queue size for reserved responses. */
-        unsigned int respQueueLimit;
+        /** The request port the stalled request was decoded to. */
+        BridgeRequestPort *stalledPort;
+
+        /** The channel the stalled request waits for. */
+        CXLMemChannel stalledChannel;
+
+        /** Max queue sizes for reserved responses, per channel. */
+        const std::array<unsigned int, NumCXLMemChannels> respQueueLimit;
 
         /**
          * Upstream caches need this packet until true is returned, so
@@ -133,11 +163,12 @@ class CXLBridge : public ClockedObject
         std::unique_ptr<Packet> pendingDelete;
 
         /**
-         * Is this side blocked from accepting new response packets.
+         * Is this side blocked from accepting new response packets of a
+         * channel.
          *
          * @return true if the reserved space has reached the set limit
          */
-        bool respQueueFull() const;
+        bool respQueueFull(CXLMemChannel channel) const;
 
         /**
          * Handle send event, scheduled when the packet at the head of
@@ -156,16 +187,16 @@ class CXLBridge : public ClockedObject
          *
          * @param _name the port name including the owner
          * @param _bridge the structural owner
-         * @param _memSidePort the request port on the other
-         *                       side of the bridge
          * @param _bridge_lat the delay in cycles from receiving to sending
          * @param _proto_proc_lat the conversion delay of cxl protocol in bridge
-         * @param _resp_limit the size of the response queue
+         * @param _drs_limit the responses reserved for reads
+         * @param _ndr_limit the responses reserved for writes
          * @param _ranges a number of address ranges to forward
          */
         BridgeResponsePort(const std::string& _name, CXLBridge& _bridge,
-                        BridgeRequestPort& _memSidePort, Cycles _bridge_lat, Cycles _proto_proc_lat,
-                        int _resp_limit, std::vector<AddrRange> _ranges);
+                        Cycles _bridge_lat, Cycles _proto_proc_lat,
+                        int _drs_limit, int _ndr_limit,
+                        std::vector<AddrRange> _ranges);
 
         /**
          * Queue a response packet to be sent out later and also schedule
@@ -179,11 +210,14 @@ class CXLBridge : public ClockedObject
         /**
          * Retry any stalled request that we have failed to accept at
          * an earlier point in time. This call will do nothing if no
-         * request is waiting.
+         * request is waiting, or if it waits for the request queue of
+         * another port or channel than the one freed.
+         *
+         * @param port the request port that sent a request
+         * @param channel the channel of the request it sent
          */
-        void retryStalledReq();
-
-        AddrRange cxl_range;
+        void retryStalledReq(const BridgeRequestPort *port,
+                             CXLMemChannel channel);
 
       protected:
 
@@ -215,6 +249,11 @@ class CXLBridge : public ClockedObject
             const MemBackdoorReq &req, MemBackdoorPtr &backdoor) override;
 
 
+        /** When receiving a back-invalidate snoop response from the
+            host, send it over the link of the root port the address
+            decodes to. */
+        bool recvTimingSnoopResp(PacketPtr pkt) override;
+
         /** When receiving a address range request the peer port,
             pass it to the bridge. */
         AddrRangeList getAddrRanges() const override;
@@ -253,16 +292,85 @@ class CXLBridge : public ClockedObject
          */
         std::deque<DeferredPacket> transmitList;
 
-        /** Max queue size for request packets */
-        const unsigned int reqQueueLimit;
+        /**
+         * Requests that took their link credit and are serialised onto
+         * the link, in the order they reach the device, with the tick
+         * they arrive at. They count against the queue until then.
+         */
+        std::deque<DeferredPacket> linkList;
+
+        /** Max queue sizes for M2S Req and M2S RwD request packets */
+        const std::array<unsigned int, NumCXLMemChannels> reqQueueLimit;
+
+        /** Requests of each channel in the queue. */
+        std::array<unsigned int, NumCXLMemChannels> queued = {};
 
         /**
-         * Handle send event, scheduled when the packet at the head of
-         * the outbound queue is ready to transmit (for timing
-         * accesses only).
+         * Link credits of the M2S Req and RwD channels, as the device
+         * advertises them, or 0 if the bridge does not track them.
+         */
+        const std::array<unsigned int, NumCXLMemChannels> linkCredits;
+
+        /** Link credits of each channel held by requests in flight. */
+        std::array<unsigned int, NumCXLMemChannels> creditsInUse = {};
+
+        /** If the device refused a request and we wait for a retry. */
+        bool waitingRetry = false;
+
+        /** Transmitter of the M2S direction of this root port's link. */
+        CXLLink m2sLink;
+
+        /**
+         * Time kept between two host requests sent on the link, to
+         * throttle them by the load the device reports.
+         */
+        Tick qosGap = 0;
+
+        /** Tick the next host request may be sent at. */
+        Tick qosNextIssue = 0;
+
+        /** Highest DevLoad reported since the gap was last adjusted. */
+        CXLDevLoad qosLoad = CXLLightLoad;
+
+        /** Tick the gap was last adjusted. */
+        Tick qosLastAdjust = 0;
+
+        /** If a request of a channel has to wait for a link credit. */
+        bool
+        noCredit(CXLMemChannel channel) const
+        {
+            return linkCredits[channel] &&
+                creditsInUse[channel] >= linkCredits[channel];
+        }
+
+        /**
+         * Pick the oldest ready request whose channel has a link credit
+         * and that no older request to its line has to go before.
+         *
+         * @param next_ready set to the tick the next request gets ready,
+         * or MaxTick if none is waiting for its tick
+         *
+         * @return index of the request in the queue, -1 if none
+         */
+        int pickRequest(Tick &next_ready) const;
+
+        /**
+         * Handle send event, scheduled when a packet of the outbound
+         * queue is ready to transmit (for timing accesses only). The
+         * requests that may go are serialised onto the link, and the
+         * ones that reached the other end are sent to the device.
          */
         void trySendTiming();
 
+        /** Schedule the send event for the next request, if any. */
+        void schedSend();
+
+        /**
+         * Schedule the send event at a tick, or move it there if it is
+         * scheduled later, unless the queue waits for a retry.
+         */
+        void schedSend(Tick when);
+
         /** Send event for the request queue. */
         EventFunctionWrapper sendEvent;
 
@@ -277,18 +385,32 @@ class CXLBridge : public ClockedObject
          * the bridge
          * @param _bridge_lat the delay in cycles from receiving to sending
          * @param _proto_proc_lat the conversion delay of cxl protocol in bridge
-         * @param _req_limit the size of the request queue
+         * @param _req_limit the size of the queue for reads
+         * @param _rwd_limit the size of the queue for writes
+         * @param _req_credits the M2S Req link credits, 0 if untracked
+         * @param _rwd_credits the M2S RwD link credits, 0 if untracked
+         * @param _hdm_range the HDM decoder target range of this port
+         * @param _m2s_link the M2S transmitter of this port's CXL link
          */
         BridgeRequestPort(const std::string& _name, CXLBridge& _bridge,
                          BridgeResponsePort& _cpuSidePort, Cycles _bridge_lat,
-                         Cycles _proto_proc_lat, int _req_limit);
+                         Cycles _proto_proc_lat, int _req_limit,
+                         int _rwd_limit, int _req_credits, int _rwd_credits,
+                         AddrRange _hdm_range, const CXLLink &_m2s_link);
+
+        /**
+         * Host-managed device memory routed to this port by the HDM
+         * decoders, possibly interleaved with the other ports.
+         */
+        const AddrRange hdmRange;
 
         /**
-         * Is this side blocked from accepting new request packets.
+         * Is this side blocked from accepting new request packets of a
+         * channel.
          *
          * @return true if the occupied space has reached the set limit
          */
-        bool reqQueueFull() const;
+        bool reqQueueFull(CXLMemChannel channel) const;
 
         /**
          * Queue a request packet to be sent out later and also schedule
@@ -309,6 +431,32 @@ class CXLBridge : public ClockedObject
          */
         bool trySatisfyFunctional(PacketPtr pkt);
 
+        /**
+         * Serialise a CXL.mem request onto the link of this port.
+         *
+         * @param pkt the request to send
+         * @param when tick when the request is ready to be sent
+         *
+         * @return tick when the request has been received by the device
+         */
+        Tick transmit(PacketPtr pkt, Tick when);
+
+        /**
+         * Hold a host request back by the gap the DevLoad of the device
+         * asks for, if the host throttles its requests.
+         *
+         * @param when tick when the request is ready to be sent
+         *
+         * @return tick when the request may be sent
+         */
+        Tick throttle(Tick when);
+
+        /**
+         * Take in the DevLoad of a response, and adjust the gap at
+         * most once per interval to the highest load seen.
+         */
+        void recvDevLoad(CXLDevLoad load);
+
       protected:
 
         /** When receiving a timing request from the peer port,
@@ -318,13 +466,220 @@ class CXLBridge : public ClockedObject
         /** When receiving a retry request from the peer port,
             pass it to the bridge. */
         void recvReqRetry() override;
+
+        /** When receiving a back-invalidate snoop from the device,
+            pass it on to the host. */
+        void recvTimingSnoopReq(PacketPtr pkt) override;
+
+        /** When receiving an atomic back-invalidate snoop from the
+            device, pass it on to the host. */
+        Tick recvAtomicSnoop(PacketPtr pkt) override;
+    };
+
+    /**
+     * Port towards the host memory, through which the bridge reaches
+     * the pages it migrated to host DRAM.
+     */
+    class DramPort : public QueuedRequestPort
+    {
+
+      private:
+
+        ReqPacketQueue _reqQueue;
+        SnoopRespPacketQueue _snoopRespQueue;
+
+        /** The bridge to which this port belongs. */
+        CXLBridge& bridge;
+
+      public:
+
+        DramPort(const std::string& _name, CXLBridge& _bridge);
+
+      protected:
+
+        bool recvTimingResp(PacketPtr pkt) override;
+    };
+
+    /** A page being copied between the CXL memory and host DRAM. */
+    struct MigrationJob
+    {
+        MigrationJob(Addr _page, unsigned _frame, bool _promote)
+            : page(_page), frame(_frame), promote(_promote)
+        { }
+
+        /** The CXL page and the frame of host DRAM it goes to or from. */
+        const Addr page;
+        const unsigned frame;
+
+        /** Copy from the CXL memory to host DRAM, or back. */
+        const bool promote;
+
+        /** Tick the copy started. */
+        Tick start = 0;
+
+        /** Lines whose read was issued, in flight, and written. */
+        unsigned nextLine = 0;
+        unsigned inFlight = 0;
+        unsigned done = 0;
+
+        /** If the host wrote the page while it was copied. */
+        bool dirty = false;
+
+        /** Number of times the copy started over. */
+        unsigned retries = 0;
     };
 
     /** Response port of the bridge. */
     BridgeResponsePort cpuSidePort;
 
-    /** Request port of the bridge. */
-    BridgeRequestPort memSidePort;
+    /**
+     * Request ports of the bridge, one root port per HDM decoder
+     * target.
+     */
+    std::vector<BridgeRequestPort*> memSidePorts;
+
+    /**
+     * Decode an address to the root port it is routed to. Addresses
+     * outside of the HDM ranges are sent through the first port.
+     */
+    BridgeRequestPort& hdmDecode(Addr addr) const;
+
+    /** Port towards host DRAM for the migrated pages. */
+    DramPort dramPort;
+
+    /** The system the bridge is in. */
+    System *system;
+
+    /** Latencies the traffic the bridge makes itself sees. */
+    const Cycles bridgeLat;
+    const Cycles protoProcLat;
+
+    /** Cache line size of the system. */
+    const unsigned blkSize;
+
+    /** Requestor ID of the copies and redirected accesses. */
+    const RequestorID requestorId;
+
+    /** Host DRAM reserved for migrated pages, empty if migration is off. */
+    const AddrRange migRegion;
+
+    /** Size of a migrated page. */
+    const Addr migPageSize;
+
+    /** Period of the selection of pages to migrate. */
+    const Tick migInterval;
+
+    /** Hotness a page needs to be migrated. */
+    const uint32_t migThreshold;
+
+    /** Pages migrated per interval at most. */
+    const unsigned migBatch;
+
+    /** Lines a page copy keeps in flight. */
+    const unsigned migCopyDepth;
+
+    /** Times a copy starts over before it is given up. */
+    static constexpr unsigned migMaxRetries = 4;
+
+    /** The devices whose hotness counters pick the pages. */
+    const std::vector<CXLMemory *> migSources;
+
+    /** CXL page held in each frame of the region, MaxAddr if none. */
+    std::vector<Addr> frameOwner;
+
+    /** Accesses to each frame, halved every interval. */
+    std::vector<uint64_t> frameHits;
+
+    /** The indirection table, frame of every migrated CXL page. */
+    std::unordered_map<Addr, unsigned> remap;
+
+    /** Copies to do, the one at the front is in progress. */
+    std::deque<MigrationJob> migJobs;
+
+    /** Line reads and writes of the copies in flight. */
+    std::unordered_set<RequestPtr> copyReqs;
+
+    /** Line writes that wait for room in a request queue. */
+    std::deque<PacketPtr> copyWrites;
+
+    /** Host requests sent to host DRAM, by the access made for them. */
+    std::unordered_map<PacketPtr, PacketPtr> redirects;
+
+    /** Is page migration on. */
+    bool migrationOn() const { return migRegion.size() != 0; }
+
+    /** Host DRAM address of a frame of the region. */
+    Addr frameAddr(unsigned frame) const
+    {
+        return migRegion.start() + frame * migPageSize;
+    }
+
+    /**
+     * Send a host request to a migrated page to its copy in host DRAM,
+     * and note a write to the page being copied.
+     *
+     * @return false if the page is not migrated
+     */
+    bool redirect(PacketPtr pkt, Tick when);
+
+    /** Atomic counterpart of redirect. */
+    bool redirectAtomic(PacketPtr pkt, Tick &delay);
+
+    /** Pick the pages to migrate, once per interval. */
+    void selectMigrations();
+
+    /** Start the next copy that is still valid. */
+    void startJob();
+
+    /** Issue the line reads and writes of the copy in progress. */
+    void issueCopies();
+
+    /**
+     * Send a line read or write of a copy to the CXL memory or host
+     * DRAM.
+     *
+     * @return false if the root port has no room for it
+     */
+    bool sendCopy(PacketPtr pkt, bool to_cxl);
+
+    /**
+     * Handle the response to a line read or write of a copy.
+     *
+     * @return false if the packet is no copy
+     */
+    bool copyResponse(PacketPtr pkt);
+
+    /** Switch the indirection table once a copy is done. */
+    void finishJob();
+
+    /** Event of the page selection. */
+    EventFunctionWrapper migrateEvent;
+
+    /** Event that retries the copy when a root port was full. */
+    EventFunctionWrapper copyEvent;
+
+    /** Is the latency of the accesses broken down. */
+    const bool latBreakdown;
+
+    /** Binary trace of the breakdowns, nullptr if none. */
+    OutputStream *latTrace = nullptr;
+
+    /** Does the host throttle its requests by the DevLoad. */
+    const bool qosThrottle;
+
+    /** Interval the throttling is adjusted at most once in. */
+    const Tick qosInterval;
+
+    /** Step the gap between requests is adjusted by, and its limit. */
+    const Tick qosStep;
+    const Tick qosMaxGap;
+
+    /**
+     * Account the stages of an access whose response leaves the bridge.
+     *
+     * @param trace the points the access passed
+     */
+    void recordLatency(const CXLLatencyExtension &trace);
 
     struct CXLBridgeStats : public statistics::Group
     {
@@ -337,11 +692,38 @@ class CXLBridge : public ClockedObject
         statistics::Scalar rspSendFaild;
         statistics::Scalar reqSendSucceed;
         statistics::Scalar rspSendSucceed;
-        statistics::Distribution reqQueueLenDist;
-        statistics::Distribution rspQueueLenDist;
-        statistics::Distribution rspOutStandDist;
-        statistics::Distribution reqQueueLatDist;
-        statistics::Distribution rspQueueLatDist;
+        statistics::Scalar reqCreditBypass;
+        statistics::LogHistogram reqQueueLenDist;
+        statistics::LogHistogram rspQueueLenDist;
+        statistics::LogHistogram rspOutStandDist;
+        statistics::LogHistogram reqQueueLatDist;
+        statistics::LogHistogram rspQueueLatDist;
+        statistics::Scalar linkMsgs;
+        statistics::Scalar linkFlits;
+        statistics::Scalar linkDelay;
+        statistics::Formula avgLinkDelay;
+        statistics::Vector devLoad;
+        statistics::LogHistogram qosGap;
+        statistics::Scalar qosDelay;
+        statistics::Scalar biSnoops;
+        statistics::Scalar biSnoopsDirty;
+        statistics::Scalar migPromotions;
+        statistics::Scalar migDemotions;
+        statistics::Scalar migRetries;
+        statistics::Scalar migAborts;
+        statistics::Scalar migCxlBytes;
+        statistics::Scalar migDramBytes;
+        statistics::Scalar migRedirected;
+        statistics::LogHistogram migLatency;
+        statistics::LogHistogram latHost;
+        statistics::LogHistogram latBridgeReq;
+        statistics::LogHistogram latToDevice;
+        statistics::LogHistogram latDeviceReq;
+        statistics::LogHistogram latMedia;
+        statistics::LogHistogram latDeviceRsp;
+        statistics::LogHistogram latToHost;
+        statistics::LogHistogram latBridgeRsp;
+        statistics::LogHistogram latTotal;
     };
 
     CXLBridgeStats stats;
@@ -353,9 +735,12 @@ class CXLBridge : public ClockedObject
 
     void init() override;
 
+    void startup() override;
+
     typedef CXLBridgeParams Params;
 
     CXLBridge(const Params &p);
+    ~CXLBridge();
 };
 
 } // namespace gem5
@@ -0,0 +1,600 @@
+/**
+ * @file
+ * Implementation of the device coherency agent (DCOH) of a CXL Type-2
+ * device.
+ */
+
+#include "mem/cxl_dcoh.hh"
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CXLDcoh.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+CXLDcoh::CpuSidePort::CpuSidePort(const std::string& _name, CXLDcoh& _dcoh)
+    : QueuedResponsePort(_name, _respQueue),
+      _respQueue(_dcoh, *this), dcoh(_dcoh)
+{
+}
+
+CXLDcoh::HostPort::HostPort(const std::string& _name, CXLDcoh& _dcoh)
+    : QueuedRequestPort(_name, _reqQueue, _snoopRespQueue),
+      _reqQueue(_dcoh, *this), _snoopRespQueue(_dcoh, *this), dcoh(_dcoh)
+{
+}
+
+CXLDcoh::HdmPort::HdmPort(const std::string& _name, CXLDcoh& _dcoh)
+    : QueuedResponsePort(_name, _respQueue),
+      _respQueue(_dcoh, *this), dcoh(_dcoh)
+{
+}
+
+CXLDcoh::MemSidePort::MemSidePort(const std::string& _name, CXLDcoh& _dcoh)
+    : QueuedRequestPort(_name, _reqQueue, _snoopRespQueue),
+      _reqQueue(_dcoh, *this), _snoopRespQueue(_dcoh, *this), dcoh(_dcoh)
+{
+}
+
+CXLDcoh::CXLDcoh(const Params &p)
+    : ClockedObject(p),
+      cpuSidePort(p.name + ".cpu_side_port", *this),
+      hostPort(p.name + ".host_port", *this),
+      hdmPort(p.name + ".hdm_port", *this),
+      memSidePort(p.name + ".mem_side_port", *this),
+      hdmRange(p.hdm_range),
+      biasGranularity(p.bias_granularity),
+      autoBiasFlip(p.auto_bias_flip),
+      latency(ticksToCycles(p.latency)),
+      biasFlipLatency(p.bias_flip_latency),
+      blkSize(p.system->cacheLineSize()),
+      requestorId(p.system->getRequestorId(this)),
+      d2hLink(p.link_lanes, p.link_gen == enums::PCIe6 ? 64 : 32,
+              p.flit_size),
+      h2dLink(p.link_lanes, p.link_gen == enums::PCIe6 ? 64 : 32,
+              p.flit_size),
+      stats(*this)
+{
+    fatal_if(hdmRange.interleaved(),
+             "%s: the HDM range of a DCOH cannot be interleaved.\n", name());
+    fatal_if(!isPowerOf2(biasGranularity) || biasGranularity < blkSize,
+             "%s: the bias granularity must be a power of two no smaller "
+             "than a cache line.\n", name());
+    deviceBias.assign(divCeil(hdmRange.size(), biasGranularity),
+                      p.default_bias == CXLBias::DeviceBias);
+}
+
+CXLDcoh::CXLDcohStats::CXLDcohStats(CXLDcoh &_dcoh)
+    : statistics::Group(&_dcoh),
+
+      ADD_STAT(d2hReqs, statistics::units::Count::get(),
+               "Number of D2H requests sent to the host, per opcode"),
+      ADD_STAT(h2dSnoops, statistics::units::Count::get(),
+               "Number of H2D snoops forwarded to the device cache, per "
+               "opcode"),
+      ADD_STAT(snoopsFiltered, statistics::units::Count::get(),
+               "Number of host snoops to pages in device bias that were "
+               "not sent to the device"),
+      ADD_STAT(localReqs, statistics::units::Count::get(),
+               "Number of device requests served in device bias without "
+               "the host"),
+      ADD_STAT(hostHdmReqs, statistics::units::Count::get(),
+               "Number of host accesses to the device-attached memory"),
+      ADD_STAT(hdmSnoops, statistics::units::Count::get(),
+               "Number of host accesses to pages in device bias checked "
+               "against the device cache"),
+      ADD_STAT(flipsToDevice, statistics::units::Count::get(),
+               "Number of pages flipped from host to device bias"),
+      ADD_STAT(flipsToHost, statistics::units::Count::get(),
+               "Number of pages flipped from device to host bias"),
+      ADD_STAT(flipsAborted, statistics::units::Count::get(),
+               "Number of flips to device bias given up as the host read "
+               "the page during the flush"),
+      ADD_STAT(flipLatency, statistics::units::Tick::get(),
+               "Time from a device access to a page in host bias until "
+               "the page is in device bias")
+{
+    d2hReqs
+        .init(cxl_cache::NumD2HReqOpcodes)
+        .flags(statistics::nozero);
+    for (int i = 0; i < cxl_cache::NumD2HReqOpcodes; i++)
+        d2hReqs.subname(i, cxl_cache::d2hReqNames[i]);
+    h2dSnoops
+        .init(cxl_cache::NumH2DReqOpcodes)
+        .flags(statistics::nozero);
+    for (int i = 0; i < cxl_cache::NumH2DReqOpcodes; i++)
+        h2dSnoops.subname(i, cxl_cache::h2dReqNames[i]);
+    flipLatency
+        .init()
+        .flags(statistics::nozero);
+}
+
+Port &
+CXLDcoh::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "cpu_side_port")
+        return cpuSidePort;
+    else if (if_name == "host_port")
+        return hostPort;
+    else if (if_name == "hdm_port")
+        return hdmPort;
+    else if (if_name == "mem_side_port")
+        return memSidePort;
+    else
+        return ClockedObject::getPort(if_name, idx);
+}
+
+void
+CXLDcoh::init()
+{
+    if (!cpuSidePort.isConnected() || !hostPort.isConnected() ||
+        !hdmPort.isConnected() || !memSidePort.isConnected())
+        fatal("All ports of %s must be connected.\n", name());
+
+    cpuSidePort.sendRangeChange();
+    hdmPort.sendRangeChange();
+}
+
+Tick
+CXLDcoh::transmit(CXLLink &link, MemCmd hdr, MemCmd data, PacketPtr pkt,
+                  Tick ready)
+{
+    Tick when = link.transmit(hdr, 0, ready);
+    if (pkt->hasData())
+        when = link.transmit(data, pkt->getSize(), ready);
+    return when;
+}
+
+bool
+CXLDcoh::handleDeviceReq(PacketPtr pkt)
+{
+    // the device cache is the only one above us, there is nobody to
+    // snoop on the way down
+    assert(!pkt->cacheResponding());
+
+    DPRINTF(CXLDcoh, "%s: %s\n", __func__, pkt->print());
+
+    Tick ready = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    if (!hdmRange.contains(pkt->getAddr())) {
+        sendD2H(pkt, ready);
+        return true;
+    }
+
+    const Addr pg = page(pkt->getAddr());
+    auto flip = flips.find(pg);
+    if (flip != flips.end()) {
+        flip->second.waiting.push_back(pkt);
+    } else if (deviceBias[pg]) {
+        sendLocal(pkt, ready);
+    } else if (autoBiasFlip && !pkt->isEviction()) {
+        startFlip(pg);
+        flips[pg].waiting.push_back(pkt);
+    } else {
+        sendD2H(pkt, ready);
+    }
+    return true;
+}
+
+void
+CXLDcoh::sendD2H(PacketPtr pkt, Tick ready)
+{
+    stats.d2hReqs[cxl_cache::d2hReqOpcode(pkt)]++;
+    if (pkt->needsResponse())
+        d2hOutstanding.insert(pkt->req);
+    hostPort.schedTimingReq(pkt, transmit(d2hLink, MemCmd::D2HReq,
+                                          MemCmd::D2HData, pkt, ready));
+}
+
+void
+CXLDcoh::sendLocal(PacketPtr pkt, Tick ready)
+{
+    ++stats.localReqs;
+
+    // as the point of coherency of the pages in device bias we only
+    // pass reads and writes on to the memory, like a crossbar at the
+    // point of coherency, and terminate all other coherency requests
+    if (pkt->isRead() || pkt->isWrite()) {
+        if (pkt->needsResponse())
+            localOutstanding.insert(pkt->req);
+        memSidePort.schedTimingReq(pkt, ready);
+    } else if (pkt->needsResponse()) {
+        pkt->makeResponse();
+        cpuSidePort.schedTimingResp(pkt, ready);
+    } else {
+        pendingDelete.reset(pkt);
+    }
+}
+
+void
+CXLDcoh::startFlip(Addr pg)
+{
+    const Addr base = hdmRange.start() + pg * biasGranularity;
+
+    DPRINTF(CXLDcoh, "Flipping page %#x to device bias\n", base);
+
+    BiasFlip &flip = flips[pg];
+    flip.start = curTick();
+    flip.outstanding = biasGranularity / blkSize;
+
+    // flush every line of the page from the host caches, dirty lines
+    // are written back to the memory through the host
+    const Tick ready = clockEdge(latency);
+    for (Addr addr = base; addr < base + biasGranularity; addr += blkSize) {
+        RequestPtr req = std::make_shared<Request>(
+            addr, blkSize,
+            Request::CLEAN | Request::INVALIDATE | Request::DST_POC,
+            requestorId);
+        PacketPtr flush = new Packet(req, MemCmd::CleanInvalidReq);
+        flushes[req] = pg;
+        stats.d2hReqs[cxl_cache::CLFlush]++;
+        hostPort.schedTimingReq(flush,
+                                d2hLink.transmit(MemCmd::D2HReq, 0, ready));
+    }
+}
+
+void
+CXLDcoh::finishFlip(Addr pg)
+{
+    auto it = flips.find(pg);
+    assert(it != flips.end());
+    BiasFlip flip = std::move(it->second);
+    flips.erase(it);
+
+    const Tick ready = clockEdge(latency) + biasFlipLatency;
+    if (flip.aborted) {
+        DPRINTF(CXLDcoh, "Flip of page %#x to device bias aborted\n",
+                hdmRange.start() + pg * biasGranularity);
+        ++stats.flipsAborted;
+        for (auto pkt : flip.waiting)
+            sendD2H(pkt, ready);
+    } else {
+        deviceBias[pg] = true;
+        ++stats.flipsToDevice;
+        stats.flipLatency.sample(ready - flip.start);
+        for (auto pkt : flip.waiting)
+            sendLocal(pkt, ready);
+    }
+}
+
+bool
+CXLDcoh::handleHostResp(PacketPtr pkt)
+{
+    auto flush = flushes.find(pkt->req);
+    if (flush != flushes.end()) {
+        const Addr pg = flush->second;
+        flushes.erase(flush);
+        delete pkt;
+        if (--flips[pg].outstanding == 0)
+            finishFlip(pg);
+        return true;
+    }
+
+    DPRINTF(CXLDcoh, "%s: %s\n", __func__, pkt->print());
+
+    d2hOutstanding.erase(pkt->req);
+
+    Tick ready = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    cpuSidePort.schedTimingResp(pkt, transmit(h2dLink, MemCmd::H2DRsp,
+                                              MemCmd::H2DData, pkt, ready));
+    return true;
+}
+
+bool
+CXLDcoh::handleHdmReq(PacketPtr pkt)
+{
+    DPRINTF(CXLDcoh, "%s: %s\n", __func__, pkt->print());
+
+    ++stats.hostHdmReqs;
+
+    Tick ready = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    // requests of the device itself reach its memory through the host
+    // when the page is in host bias, the device cache must not see them
+    // again
+    const bool own = d2hOutstanding.count(pkt->req);
+    const Addr addr = pkt->getAddr();
+
+    if (!own && hdmRange.contains(addr) && pkt->isRead()) {
+        // the host may cache the line it reads, so the page cannot
+        // become device bias with the flush we started
+        auto flip = flips.find(page(addr));
+        if (flip != flips.end())
+            flip->second.aborted = true;
+    }
+
+    if (!own && !pkt->isEviction() && inDeviceBias(addr)) {
+        // the host holds no copies of a page in device bias and did not
+        // snoop the device, so we check the device cache ourselves
+        ++stats.hdmSnoops;
+        assert(pkt->snoopDelay == 0);
+        cpuSidePort.sendTimingSnoopReq(pkt);
+        ready += pkt->snoopDelay;
+        pkt->snoopDelay = 0;
+
+        if (pkt->isRead()) {
+            deviceBias[page(addr)] = false;
+            ++stats.flipsToHost;
+            ready += biasFlipLatency;
+        }
+
+        if (pkt->cacheResponding()) {
+            // the device cache answers with its snoop response, the
+            // memory is not accessed
+            hdmSnoops[pkt->req] = ready;
+            pendingDelete.reset(pkt);
+            return true;
+        }
+    }
+
+    memSidePort.schedTimingReq(pkt, ready);
+    return true;
+}
+
+bool
+CXLDcoh::handleMemResp(PacketPtr pkt)
+{
+    DPRINTF(CXLDcoh, "%s: %s\n", __func__, pkt->print());
+
+    Tick ready = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    auto local = localOutstanding.find(pkt->req);
+    if (local != localOutstanding.end()) {
+        localOutstanding.erase(local);
+        cpuSidePort.schedTimingResp(pkt, ready);
+    } else {
+        hdmPort.schedTimingResp(pkt, ready);
+    }
+    return true;
+}
+
+void
+CXLDcoh::handleHostSnoop(PacketPtr pkt)
+{
+    if (inDeviceBias(pkt->getAddr())) {
+        ++stats.snoopsFiltered;
+        return;
+    }
+
+    DPRINTF(CXLDcoh, "%s: %s\n", __func__, pkt->print());
+
+    stats.h2dSnoops[cxl_cache::h2dReqOpcode(pkt)]++;
+
+    // snoops are express, the time to get across the link is part of
+    // the time the snoop takes, and other snoopers may already have
+    // reported theirs
+    const uint32_t snoop_delay = pkt->snoopDelay;
+    const Tick h2d = h2dLink.transmit(MemCmd::H2DReq, 0,
+                                      clockEdge(latency)) - curTick();
+    pkt->snoopDelay = 0;
+    cpuSidePort.sendTimingSnoopReq(pkt);
+    pkt->snoopDelay = std::max<Tick>(snoop_delay, h2d + pkt->snoopDelay);
+}
+
+bool
+CXLDcoh::handleSnoopResp(PacketPtr pkt)
+{
+    DPRINTF(CXLDcoh, "%s: %s\n", __func__, pkt->print());
+
+    Tick ready = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    auto hdm_snoop = hdmSnoops.find(pkt->req);
+    if (hdm_snoop != hdmSnoops.end()) {
+        ready = std::max(ready, hdm_snoop->second);
+        hdmSnoops.erase(hdm_snoop);
+        hdmPort.schedTimingResp(pkt, ready);
+    } else {
+        hostPort.schedTimingSnoopResp(pkt, transmit(d2hLink, MemCmd::D2HRsp,
+                                                    MemCmd::D2HData, pkt,
+                                                    ready));
+    }
+    return true;
+}
+
+Tick
+CXLDcoh::atomicDeviceReq(PacketPtr pkt)
+{
+    Tick lat = latency * clockPeriod();
+    const Addr addr = pkt->getAddr();
+
+    if (hdmRange.contains(addr)) {
+        const Addr pg = page(addr);
+        if (!deviceBias[pg] && autoBiasFlip && !pkt->isEviction()) {
+            const Addr base = hdmRange.start() + pg * biasGranularity;
+            Tick flush_lat = 0;
+            for (Addr a = base; a < base + biasGranularity; a += blkSize) {
+                RequestPtr req = std::make_shared<Request>(
+                    a, blkSize,
+                    Request::CLEAN | Request::INVALIDATE | Request::DST_POC,
+                    requestorId);
+                Packet flush(req, MemCmd::CleanInvalidReq);
+                stats.d2hReqs[cxl_cache::CLFlush]++;
+                flush_lat = std::max(flush_lat, hostPort.sendAtomic(&flush));
+            }
+            deviceBias[pg] = true;
+            ++stats.flipsToDevice;
+            stats.flipLatency.sample(flush_lat + biasFlipLatency);
+            lat += flush_lat + biasFlipLatency;
+        }
+
+        if (deviceBias[pg]) {
+            ++stats.localReqs;
+            if (pkt->isRead() || pkt->isWrite())
+                return lat + memSidePort.sendAtomic(pkt);
+            if (pkt->needsResponse())
+                pkt->makeResponse();
+            return lat;
+        }
+    }
+
+    stats.d2hReqs[cxl_cache::d2hReqOpcode(pkt)]++;
+    d2hOutstanding.insert(pkt->req);
+    lat += d2hLink.flitTime() + hostPort.sendAtomic(pkt) +
+        h2dLink.flitTime();
+    d2hOutstanding.erase(pkt->req);
+    return lat;
+}
+
+Tick
+CXLDcoh::atomicHdmReq(PacketPtr pkt)
+{
+    ++stats.hostHdmReqs;
+
+    Tick lat = latency * clockPeriod();
+    const Addr addr = pkt->getAddr();
+
+    if (!d2hOutstanding.count(pkt->req) && !pkt->isEviction() &&
+        inDeviceBias(addr)) {
+        ++stats.hdmSnoops;
+        lat += cpuSidePort.sendAtomicSnoop(pkt);
+        if (pkt->isRead()) {
+            deviceBias[page(addr)] = false;
+            ++stats.flipsToHost;
+            lat += biasFlipLatency;
+        }
+        if (pkt->cacheResponding())
+            return lat;
+    }
+
+    return lat + memSidePort.sendAtomic(pkt);
+}
+
+bool
+CXLDcoh::CpuSidePort::recvTimingReq(PacketPtr pkt)
+{
+    return dcoh.handleDeviceReq(pkt);
+}
+
+bool
+CXLDcoh::CpuSidePort::recvTimingSnoopResp(PacketPtr pkt)
+{
+    return dcoh.handleSnoopResp(pkt);
+}
+
+Tick
+CXLDcoh::CpuSidePort::recvAtomic(PacketPtr pkt)
+{
+    return dcoh.atomicDeviceReq(pkt);
+}
+
+void
+CXLDcoh::CpuSidePort::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    if (!trySatisfyFunctional(pkt) &&
+        !dcoh.hostPort.trySatisfyFunctional(pkt) &&
+        !dcoh.memSidePort.trySatisfyFunctional(pkt)) {
+        if (dcoh.inDeviceBias(pkt->getAddr()))
+            dcoh.memSidePort.sendFunctional(pkt);
+        else
+            dcoh.hostPort.sendFunctional(pkt);
+    }
+
+    pkt->popLabel();
+}
+
+AddrRangeList
+CXLDcoh::CpuSidePort::getAddrRanges() const
+{
+    return dcoh.hostPort.getAddrRanges();
+}
+
+bool
+CXLDcoh::HostPort::recvTimingResp(PacketPtr pkt)
+{
+    return dcoh.handleHostResp(pkt);
+}
+
+void
+CXLDcoh::HostPort::recvTimingSnoopReq(PacketPtr pkt)
+{
+    dcoh.handleHostSnoop(pkt);
+}
+
+Tick
+CXLDcoh::HostPort::recvAtomicSnoop(PacketPtr pkt)
+{
+    if (dcoh.inDeviceBias(pkt->getAddr())) {
+        ++dcoh.stats.snoopsFiltered;
+        return 0;
+    }
+
+    dcoh.stats.h2dSnoops[cxl_cache::h2dReqOpcode(pkt)]++;
+    return dcoh.h2dLink.flitTime() + dcoh.cpuSidePort.sendAtomicSnoop(pkt) +
+        dcoh.d2hLink.flitTime();
+}
+
+void
+CXLDcoh::HostPort::recvFunctionalSnoop(PacketPtr pkt)
+{
+    // functional snoops are not filtered by bias, a device cache may
+    // still hold lines of a page after it flipped to host bias
+    if (!trySatisfyFunctional(pkt))
+        dcoh.cpuSidePort.sendFunctionalSnoop(pkt);
+}
+
+void
+CXLDcoh::HostPort::recvRangeChange()
+{
+    dcoh.cpuSidePort.sendRangeChange();
+}
+
+bool
+CXLDcoh::HdmPort::recvTimingReq(PacketPtr pkt)
+{
+    return dcoh.handleHdmReq(pkt);
+}
+
+Tick
+CXLDcoh::HdmPort::recvAtomic(PacketPtr pkt)
+{
+    return dcoh.atomicHdmReq(pkt);
+}
+
+void
+CXLDcoh::HdmPort::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    if (!trySatisfyFunctional(pkt) &&
+        !dcoh.memSidePort.trySatisfyFunctional(pkt)) {
+        if (dcoh.inDeviceBias(pkt->getAddr()))
+            dcoh.cpuSidePort.sendFunctionalSnoop(pkt);
+        if (!pkt->isResponse())
+            dcoh.memSidePort.sendFunctional(pkt);
+    }
+
+    pkt->popLabel();
+}
+
+AddrRangeList
+CXLDcoh::HdmPort::getAddrRanges() const
+{
+    return dcoh.memSidePort.getAddrRanges();
+}
+
+bool
+CXLDcoh::MemSidePort::recvTimingResp(PacketPtr pkt)
+{
+    return dcoh.handleMemResp(pkt);
+}
+
+void
+CXLDcoh::MemSidePort::recvRangeChange()
+{
+    dcoh.hdmPort.sendRangeChange();
+}
+
+} // namespace gem5
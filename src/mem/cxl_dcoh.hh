@@ -0,0 +1,325 @@
+/**
+ * @file
+ * Declaration of the device coherency agent (DCOH) of a CXL Type-2
+ * device, which keeps a device-side cache coherent with the host over
+ * CXL.cache and manages the bias of the device-attached memory.
+ */
+
+#ifndef __MEM_CXL_DCOH_HH__
+#define __MEM_CXL_DCOH_HH__
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/addr_range.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "enums/CXLBias.hh"
+#include "mem/cxl_link.hh"
+#include "mem/packet_queue.hh"
+#include "mem/protocol/cxl_cache.hh"
+#include "mem/qport.hh"
+#include "params/CXLDcoh.hh"
+#include "sim/clocked_object.hh"
+
+namespace gem5
+{
+
+/**
+ * The DCOH sits between the device-side cache of a CXL Type-2 device
+ * and the host, and in front of the device-attached memory (HDM).
+ *
+ * Requests of the device cache go to the host as D2H requests over a
+ * CXL.cache link, and the host snoops the device cache with H2D
+ * requests through the coherent crossbar the DCOH is attached to, like
+ * any other snooping cache. Host accesses to the HDM arrive over
+ * CXL.mem from the device's memory controller.
+ *
+ * The HDM is tracked in pages that are either in host bias or in
+ * device bias. In host bias the device reaches its own memory through
+ * the host like any other memory, so that the host resolves coherency.
+ * In device bias the host holds no copies, the device accesses the
+ * memory directly, the host does not snoop the device for it, and the
+ * DCOH resolves a host access against the device cache itself. A
+ * device access to a page in host bias flips it to device bias by
+ * flushing the page from the host caches, a host read of a page in
+ * device bias flips it back to host bias. The cost of these flips is
+ * the bias-flip cost of accelerator-attached memory.
+ */
+class CXLDcoh : public ClockedObject
+{
+  protected:
+
+    /** Port facing the device-side cache. */
+    class CpuSidePort : public QueuedResponsePort
+    {
+
+      private:
+
+        RespPacketQueue _respQueue;
+
+        CXLDcoh& dcoh;
+
+      public:
+
+        CpuSidePort(const std::string& _name, CXLDcoh& _dcoh);
+
+      protected:
+
+        bool recvTimingReq(PacketPtr pkt) override;
+
+        bool recvTimingSnoopResp(PacketPtr pkt) override;
+
+        Tick recvAtomic(PacketPtr pkt) override;
+
+        void recvFunctional(PacketPtr pkt) override;
+
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    /** CXL.cache port towards the coherent crossbar of the host. */
+    class HostPort : public QueuedRequestPort
+    {
+
+      private:
+
+        ReqPacketQueue _reqQueue;
+        SnoopRespPacketQueue _snoopRespQueue;
+
+        CXLDcoh& dcoh;
+
+      public:
+
+        HostPort(const std::string& _name, CXLDcoh& _dcoh);
+
+      protected:
+
+        bool isSnooping() const override { return true; }
+
+        bool recvTimingResp(PacketPtr pkt) override;
+
+        void recvTimingSnoopReq(PacketPtr pkt) override;
+
+        Tick recvAtomicSnoop(PacketPtr pkt) override;
+
+        void recvFunctionalSnoop(PacketPtr pkt) override;
+
+        void recvRangeChange() override;
+    };
+
+    /** Port receiving the host's CXL.mem accesses to the HDM. */
+    class HdmPort : public QueuedResponsePort
+    {
+
+      private:
+
+        RespPacketQueue _respQueue;
+
+        CXLDcoh& dcoh;
+
+      public:
+
+        HdmPort(const std::string& _name, CXLDcoh& _dcoh);
+
+      protected:
+
+        bool recvTimingReq(PacketPtr pkt) override;
+
+        Tick recvAtomic(PacketPtr pkt) override;
+
+        void recvFunctional(PacketPtr pkt) override;
+
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    /** Port towards the device-attached memory. */
+    class MemSidePort : public QueuedRequestPort
+    {
+
+      private:
+
+        ReqPacketQueue _reqQueue;
+        SnoopRespPacketQueue _snoopRespQueue;
+
+        CXLDcoh& dcoh;
+
+      public:
+
+        MemSidePort(const std::string& _name, CXLDcoh& _dcoh);
+
+      protected:
+
+        bool recvTimingResp(PacketPtr pkt) override;
+
+        void recvRangeChange() override;
+    };
+
+    /** A flip of a page from host to device bias in progress. */
+    struct BiasFlip
+    {
+        /** Tick the flip started. */
+        Tick start;
+
+        /** Flushes of the page from the host still outstanding. */
+        unsigned outstanding;
+
+        /** If the host read the page during the flush. */
+        bool aborted = false;
+
+        /** Device requests waiting for the flip to complete. */
+        std::vector<PacketPtr> waiting;
+    };
+
+    CpuSidePort cpuSidePort;
+    HostPort hostPort;
+    HdmPort hdmPort;
+    MemSidePort memSidePort;
+
+    /** The device-attached memory. */
+    const AddrRange hdmRange;
+
+    /** Granularity of the bias table. */
+    const Addr biasGranularity;
+
+    /** Flip pages to device bias when the device accesses them. */
+    const bool autoBiasFlip;
+
+    /** Latency of the DCOH for a message in either direction. */
+    const Cycles latency;
+
+    /** Fixed cost of a bias flip on top of the flushes it needs. */
+    const Tick biasFlipLatency;
+
+    /** Cache line size of the system. */
+    const unsigned blkSize;
+
+    /** Requestor ID of the flushes issued for bias flips. */
+    const RequestorID requestorId;
+
+    /** Transmitters of the two directions of the CXL.cache link. */
+    CXLLink d2hLink;
+    CXLLink h2dLink;
+
+    /** Per page of the HDM, true if it is in device bias. */
+    std::vector<bool> deviceBias;
+
+    /** Pages flipping from host to device bias. */
+    std::unordered_map<Addr, BiasFlip> flips;
+
+    /**
+     * Flushes issued for a bias flip, by request as the response may
+     * come back in another packet, with the page they belong to.
+     */
+    std::unordered_map<RequestPtr, Addr> flushes;
+
+    /** Device requests outstanding at the host. */
+    std::unordered_set<RequestPtr> d2hOutstanding;
+
+    /** Device requests outstanding at the device-attached memory. */
+    std::unordered_set<RequestPtr> localOutstanding;
+
+    /**
+     * Host accesses the device cache committed to respond to, with the
+     * earliest tick the response may leave.
+     */
+    std::unordered_map<RequestPtr, Tick> hdmSnoops;
+
+    /**
+     * Packets the DCOH does not pass on, as the crossbars do they are
+     * only deleted when the next one arrives, once the sender is done
+     * with them.
+     */
+    std::unique_ptr<Packet> pendingDelete;
+
+    /** Index of the page of an HDM address in the bias table. */
+    Addr page(Addr addr) const
+    {
+        return (addr - hdmRange.start()) / biasGranularity;
+    }
+
+    /** If an address is in the HDM and its page in device bias. */
+    bool inDeviceBias(Addr addr) const
+    {
+        return hdmRange.contains(addr) && deviceBias[page(addr)];
+    }
+
+    /** Handle a request of the device cache in timing mode. */
+    bool handleDeviceReq(PacketPtr pkt);
+
+    /**
+     * Serialise a message onto a CXL.cache link, as a header on one
+     * channel followed by the data on another if the packet has any.
+     */
+    Tick transmit(CXLLink &link, MemCmd hdr, MemCmd data, PacketPtr pkt,
+                  Tick ready);
+
+    /** Send a request of the device cache to the host. */
+    void sendD2H(PacketPtr pkt, Tick ready);
+
+    /**
+     * Terminate a request of the device cache at the DCOH, which is
+     * the point of coherency of the HDM in device bias, or send it on
+     * to the device-attached memory.
+     */
+    void sendLocal(PacketPtr pkt, Tick ready);
+
+    /** Start flipping a page to device bias. */
+    void startFlip(Addr pg);
+
+    /** Complete a flip once all its flushes are done. */
+    void finishFlip(Addr pg);
+
+    /** Handle a host access to the HDM in timing mode. */
+    bool handleHdmReq(PacketPtr pkt);
+
+    /** Handle a response of the host to a device request or flush. */
+    bool handleHostResp(PacketPtr pkt);
+
+    /** Handle a response of the device-attached memory. */
+    bool handleMemResp(PacketPtr pkt);
+
+    /** Handle a snoop of the host, from the coherent crossbar. */
+    void handleHostSnoop(PacketPtr pkt);
+
+    /** Handle a snoop response of the device cache. */
+    bool handleSnoopResp(PacketPtr pkt);
+
+    /** Atomic counterparts of the above. */
+    Tick atomicDeviceReq(PacketPtr pkt);
+    Tick atomicHdmReq(PacketPtr pkt);
+
+    struct CXLDcohStats : public statistics::Group
+    {
+        CXLDcohStats(CXLDcoh &dcoh);
+
+        statistics::Vector d2hReqs;
+        statistics::Vector h2dSnoops;
+        statistics::Scalar snoopsFiltered;
+        statistics::Scalar localReqs;
+        statistics::Scalar hostHdmReqs;
+        statistics::Scalar hdmSnoops;
+        statistics::Scalar flipsToDevice;
+        statistics::Scalar flipsToHost;
+        statistics::Scalar flipsAborted;
+        statistics::LogHistogram flipLatency;
+    };
+
+    CXLDcohStats stats;
+
+  public:
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+    void init() override;
+
+    typedef CXLDcohParams Params;
+
+    CXLDcoh(const Params &p);
+};
+
+} // namespace gem5
+
+#endif //__MEM_CXL_DCOH_HH__
@@ -0,0 +1,529 @@
+/**
+ * @file
+ * Implementation of a memory-side cache that keeps lines of the CXL
+ * memory in a slice of host DRAM.
+ */
+
+#include "mem/cxl_dram_cache.hh"
+
+#include <cstring>
+
+#include "base/chunk_generator.hh"
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CXLDramCache.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+CXLDramCache::CpuSidePort::CpuSidePort(const std::string& _name,
+                                       CXLDramCache& _cache)
+    : QueuedResponsePort(_name, _respQueue),
+      _respQueue(_cache, *this), cache(_cache)
+{
+}
+
+CXLDramCache::MemSidePort::MemSidePort(const std::string& _name,
+                                       CXLDramCache& _cache)
+    : QueuedRequestPort(_name, _reqQueue, _snoopRespQueue),
+      _reqQueue(_cache, *this), _snoopRespQueue(_cache, *this),
+      cache(_cache)
+{
+}
+
+CXLDramCache::CXLDramCache(const Params &p)
+    : ClockedObject(p),
+      cpuSidePort(p.name + ".cpu_side_port", *this),
+      cxlSidePort(p.name + ".cxl_side_port", *this),
+      dramPort(p.name + ".dram_port", *this),
+      dramRegion(p.dram_region),
+      assoc(p.assoc),
+      tagsInDram(p.tags == CXLDramCacheTags::Ecc),
+      latency(ticksToCycles(p.latency)),
+      tagLatency(ticksToCycles(p.tag_latency)),
+      maxAccesses(p.max_accesses),
+      blkSize(p.system->cacheLineSize()),
+      requestorId(p.system->getRequestorId(this)),
+      numSets(assoc ? dramRegion.size() / (assoc * blkSize) : 0),
+      tags(numSets, assoc, blkSize),
+      stats(*this)
+{
+    fatal_if(dramRegion.interleaved(),
+             "%s: the DRAM region cannot be interleaved.\n", name());
+    fatal_if(!numSets || dramRegion.size() % (assoc * blkSize),
+             "%s: the DRAM region must hold a whole number of sets.\n",
+             name());
+    fatal_if(tagsInDram && assoc != 1,
+             "%s: tags in the ECC bits need a direct-mapped cache.\n",
+             name());
+    fatal_if(!maxAccesses, "%s: max_accesses must be positive.\n", name());
+}
+
+CXLDramCache::CXLDramCacheStats::CXLDramCacheStats(CXLDramCache &_cache)
+    : statistics::Group(&_cache),
+
+      ADD_STAT(readHits, statistics::units::Count::get(),
+               "Number of host reads that hit"),
+      ADD_STAT(readMisses, statistics::units::Count::get(),
+               "Number of host reads that missed"),
+      ADD_STAT(writeHits, statistics::units::Count::get(),
+               "Number of host writes that hit"),
+      ADD_STAT(writeMisses, statistics::units::Count::get(),
+               "Number of host writes that missed"),
+      ADD_STAT(uncached, statistics::units::Count::get(),
+               "Number of host requests passed through uncached"),
+      ADD_STAT(fills, statistics::units::Count::get(),
+               "Number of lines filled in from the CXL memory"),
+      ADD_STAT(writebacks, statistics::units::Count::get(),
+               "Number of dirty lines written back to the CXL memory"),
+      ADD_STAT(setConflicts, statistics::units::Count::get(),
+               "Number of host requests that waited for a busy set"),
+      ADD_STAT(dramBytes, statistics::units::Byte::get(),
+               "Bytes read from and written to host DRAM"),
+      ADD_STAT(cxlBytes, statistics::units::Byte::get(),
+               "Bytes read from and written to the CXL memory"),
+      ADD_STAT(hitRate, statistics::units::Ratio::get(),
+               "Ratio of host accesses that hit",
+               (readHits + writeHits) /
+               (readHits + writeHits + readMisses + writeMisses)),
+      ADD_STAT(accessLatency, statistics::units::Tick::get(),
+               "Time from the start of a host access until all its data "
+               "movement is done")
+{
+    accessLatency
+        .init()
+        .flags(statistics::nozero);
+}
+
+Port &
+CXLDramCache::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "cpu_side_port")
+        return cpuSidePort;
+    else if (if_name == "cxl_side_port")
+        return cxlSidePort;
+    else if (if_name == "dram_port")
+        return dramPort;
+    else
+        return ClockedObject::getPort(if_name, idx);
+}
+
+void
+CXLDramCache::init()
+{
+    if (!cpuSidePort.isConnected() || !cxlSidePort.isConnected() ||
+        !dramPort.isConnected())
+        fatal("All ports of %s must be connected.\n", name());
+
+    cpuSidePort.sendRangeChange();
+}
+
+CXLDramCache::Access
+CXLDramCache::lookup(PacketPtr pkt)
+{
+    const Addr line = lineAddr(pkt->getAddr());
+    panic_if(lineAddr(pkt->getAddr() + pkt->getSize() - 1) != line,
+             "%s: %s crosses a line boundary.\n", name(), pkt->print());
+
+    // only whole lines are worth the fill
+    const auto res = tags.access(line, pkt->isWrite(),
+                                 pkt->getSize() == blkSize, curTick());
+
+    Access acc;
+    acc.pkt = pkt;
+    acc.set = res.set;
+    acc.way = res.way;
+    acc.hit = res.hit;
+    acc.allocate = res.allocate;
+    acc.victim = res.victim;
+    acc.start = curTick();
+
+    if (pkt->isRead())
+        ++(acc.hit ? stats.readHits : stats.readMisses);
+    else
+        ++(acc.hit ? stats.writeHits : stats.writeMisses);
+
+    DPRINTF(CXLDramCache, "%s %s set %d way %d%s\n", pkt->print(),
+            acc.hit ? "hit" : "miss", acc.set, acc.way,
+            acc.victim != MaxAddr ? " dirty victim" : "");
+    return acc;
+}
+
+bool
+CXLDramCache::handleRequest(PacketPtr pkt)
+{
+    // the cache sits below the point of coherency
+    assert(!pkt->cacheResponding());
+
+    if (cacheable(pkt) && numAccesses == maxAccesses) {
+        retryReq = true;
+        return false;
+    }
+
+    Tick when = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    if (!cacheable(pkt)) {
+        ++stats.uncached;
+        cxlSidePort.schedTimingReq(pkt, when);
+        return true;
+    }
+    ++numAccesses;
+
+    const unsigned set = setOf(pkt->getAddr());
+    if (active.count(set)) {
+        ++stats.setConflicts;
+        waiting[set].push_back(pkt);
+        return true;
+    }
+
+    startAccess(pkt, when);
+    return true;
+}
+
+void
+CXLDramCache::startAccess(PacketPtr pkt, Tick when)
+{
+    Access &acc = active.emplace(setOf(pkt->getAddr()),
+                                 lookup(pkt)).first->second;
+
+    if (tagsInDram) {
+        // the tag comes with the line, so every access starts with a
+        // read of the way from host DRAM
+        send(acc, Step::Probe, dramPort, wayAddr(acc.set, acc.way),
+             blkSize, MemCmd::ReadReq, nullptr, when);
+    } else {
+        proceed(acc, when + cyclesToTicks(tagLatency), nullptr);
+    }
+}
+
+void
+CXLDramCache::proceed(Access &acc, Tick when, const uint8_t *frame)
+{
+    PacketPtr pkt = acc.pkt;
+    const Addr addr = pkt->getAddr();
+    const Addr offset = addr - lineAddr(addr);
+    const Addr way_addr = wayAddr(acc.set, acc.way);
+
+    if (acc.hit) {
+        if (pkt->isWrite()) {
+            send(acc, Step::Write, dramPort, way_addr + offset,
+                 pkt->getSize(), MemCmd::WriteReq,
+                 pkt->getConstPtr<uint8_t>(), when);
+        } else if (frame) {
+            respond(acc, frame + offset);
+        } else {
+            send(acc, Step::Read, dramPort, way_addr, blkSize,
+                 MemCmd::ReadReq, nullptr, when);
+        }
+        return;
+    }
+
+    if (acc.victim != MaxAddr) {
+        if (frame) {
+            send(acc, Step::VictimWrite, cxlSidePort, acc.victim, blkSize,
+                 MemCmd::WriteReq, frame, when);
+        } else {
+            acc.victimPending = true;
+            send(acc, Step::VictimRead, dramPort, way_addr, blkSize,
+                 MemCmd::ReadReq, nullptr, when);
+        }
+    }
+
+    if (!acc.allocate) {
+        send(acc, Step::Forward, cxlSidePort, addr, pkt->getSize(),
+             pkt->isRead() ? MemCmd::ReadReq : MemCmd::WriteReq,
+             pkt->isWrite() ? pkt->getConstPtr<uint8_t>() : nullptr, when);
+    } else if (pkt->isRead()) {
+        send(acc, Step::Fetch, cxlSidePort, lineAddr(addr), blkSize,
+             MemCmd::ReadReq, nullptr, when);
+    } else if (!acc.victimPending) {
+        // a write overwrites the way once the victim is out of it
+        send(acc, Step::Write, dramPort, way_addr, blkSize,
+             MemCmd::WriteReq, pkt->getConstPtr<uint8_t>(), when);
+    }
+}
+
+void
+CXLDramCache::send(Access &acc, Step step, MemSidePort &port, Addr addr,
+                   unsigned size, MemCmd cmd, const uint8_t *data, Tick when)
+{
+    RequestPtr req = std::make_shared<Request>(addr, size, 0, requestorId);
+    PacketPtr pkt = new Packet(req, cmd);
+    pkt->allocate();
+    if (data)
+        pkt->setData(data);
+
+    if (step == Step::Fill)
+        ++stats.fills;
+    else if (step == Step::VictimWrite)
+        ++stats.writebacks;
+    (&port == &dramPort ? stats.dramBytes : stats.cxlBytes) += size;
+
+    inflight.emplace(req, std::make_pair(&acc, step));
+    ++acc.outstanding;
+    port.schedTimingReq(pkt, when);
+}
+
+void
+CXLDramCache::respond(Access &acc, const uint8_t *data)
+{
+    PacketPtr pkt = acc.pkt;
+    acc.pkt = nullptr;
+
+    // writebacks were held until their data was written
+    if (!pkt->needsResponse()) {
+        delete pkt;
+        return;
+    }
+
+    if (pkt->isRead())
+        pkt->setData(data);
+    pkt->makeResponse();
+    cpuSidePort.schedTimingResp(pkt, clockEdge(latency));
+}
+
+bool
+CXLDramCache::handleResponse(PacketPtr pkt)
+{
+    Tick when = clockEdge(latency) + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    auto it = inflight.find(pkt->req);
+    if (it == inflight.end()) {
+        // a request that passed through the cache
+        cpuSidePort.schedTimingResp(pkt, when);
+        return true;
+    }
+
+    Access &acc = *it->second.first;
+    const Step step = it->second.second;
+    inflight.erase(it);
+    --acc.outstanding;
+
+    const uint8_t *data = pkt->hasData() ? pkt->getConstPtr<uint8_t>() :
+        nullptr;
+    const Addr offset = acc.pkt ?
+        acc.pkt->getAddr() - lineAddr(acc.pkt->getAddr()) : 0;
+    const Addr way_addr = wayAddr(acc.set, acc.way);
+
+    switch (step) {
+      case Step::Probe:
+        proceed(acc, when, data);
+        break;
+      case Step::Read:
+        respond(acc, data + offset);
+        break;
+      case Step::Write:
+      case Step::Forward:
+        respond(acc, data);
+        break;
+      case Step::VictimRead:
+        acc.victimPending = false;
+        send(acc, Step::VictimWrite, cxlSidePort, acc.victim, blkSize,
+             MemCmd::WriteReq, data, when);
+        if (!acc.fillData.empty()) {
+            send(acc, Step::Fill, dramPort, way_addr, blkSize,
+                 MemCmd::WriteReq, acc.fillData.data(), when);
+        } else if (acc.pkt && acc.pkt->isWrite()) {
+            send(acc, Step::Write, dramPort, way_addr, blkSize,
+                 MemCmd::WriteReq, acc.pkt->getConstPtr<uint8_t>(), when);
+        }
+        break;
+      case Step::Fetch:
+        // the host gets the line without waiting for the fill
+        respond(acc, data + offset);
+        if (acc.victimPending) {
+            acc.fillData.assign(data, data + blkSize);
+        } else {
+            send(acc, Step::Fill, dramPort, way_addr, blkSize,
+                 MemCmd::WriteReq, data, when);
+        }
+        break;
+      case Step::VictimWrite:
+      case Step::Fill:
+        break;
+    }
+
+    delete pkt;
+    if (!acc.outstanding)
+        finishAccess(acc);
+    return true;
+}
+
+void
+CXLDramCache::finishAccess(Access &acc)
+{
+    assert(!acc.pkt);
+    const unsigned set = acc.set;
+    stats.accessLatency.sample(curTick() - acc.start);
+    active.erase(set);
+    --numAccesses;
+
+    auto it = waiting.find(set);
+    if (it != waiting.end()) {
+        PacketPtr pkt = it->second.front();
+        it->second.pop_front();
+        if (it->second.empty())
+            waiting.erase(it);
+        startAccess(pkt, clockEdge(latency));
+    }
+
+    if (retryReq) {
+        retryReq = false;
+        cpuSidePort.sendRetryReq();
+    }
+}
+
+Tick
+CXLDramCache::atomicAccess(MemSidePort &port, Addr addr, unsigned size,
+                           MemCmd cmd, uint8_t *data)
+{
+    RequestPtr req = std::make_shared<Request>(addr, size, 0, requestorId);
+    Packet pkt(req, cmd);
+    pkt.dataStatic(data);
+    (&port == &dramPort ? stats.dramBytes : stats.cxlBytes) += size;
+    return port.sendAtomic(&pkt);
+}
+
+Tick
+CXLDramCache::atomicRequest(PacketPtr pkt)
+{
+    Tick lat = 2 * cyclesToTicks(latency);
+    if (!cacheable(pkt)) {
+        ++stats.uncached;
+        return lat + cxlSidePort.sendAtomic(pkt);
+    }
+
+    Access acc = lookup(pkt);
+    const Addr addr = pkt->getAddr();
+    const Addr offset = addr - lineAddr(addr);
+    const Addr way_addr = wayAddr(acc.set, acc.way);
+    uint8_t *host_data = pkt->getPtr<uint8_t>();
+    std::vector<uint8_t> frame(blkSize);
+
+    if (tagsInDram) {
+        lat += atomicAccess(dramPort, way_addr, blkSize, MemCmd::ReadReq,
+                            frame.data());
+    } else {
+        lat += cyclesToTicks(tagLatency);
+    }
+
+    // the victim writeback and the fill are off the critical path
+    if (acc.hit && pkt->isWrite()) {
+        lat += atomicAccess(dramPort, way_addr + offset, pkt->getSize(),
+                            MemCmd::WriteReq, host_data);
+    } else if (acc.hit && tagsInDram) {
+        std::memcpy(host_data, frame.data() + offset, pkt->getSize());
+    } else if (acc.hit) {
+        lat += atomicAccess(dramPort, way_addr + offset, pkt->getSize(),
+                            MemCmd::ReadReq, host_data);
+    } else {
+        if (acc.victim != MaxAddr) {
+            if (!tagsInDram) {
+                atomicAccess(dramPort, way_addr, blkSize, MemCmd::ReadReq,
+                             frame.data());
+            }
+            ++stats.writebacks;
+            atomicAccess(cxlSidePort, acc.victim, blkSize, MemCmd::WriteReq,
+                         frame.data());
+        }
+        if (!acc.allocate) {
+            lat += atomicAccess(cxlSidePort, addr, pkt->getSize(),
+                                pkt->isRead() ? MemCmd::ReadReq :
+                                MemCmd::WriteReq, host_data);
+        } else if (pkt->isRead()) {
+            lat += atomicAccess(cxlSidePort, lineAddr(addr), blkSize,
+                                MemCmd::ReadReq, frame.data());
+            std::memcpy(host_data, frame.data() + offset, pkt->getSize());
+            ++stats.fills;
+            atomicAccess(dramPort, way_addr, blkSize, MemCmd::WriteReq,
+                         frame.data());
+        } else {
+            lat += atomicAccess(dramPort, way_addr, blkSize,
+                                MemCmd::WriteReq, host_data);
+        }
+    }
+
+    if (pkt->needsResponse())
+        pkt->makeResponse();
+    return lat;
+}
+
+void
+CXLDramCache::functionalAccess(PacketPtr pkt)
+{
+    for (ChunkGenerator gen(pkt->getAddr(), pkt->getSize(), blkSize);
+         !gen.done(); gen.next()) {
+        const Addr line = lineAddr(gen.addr());
+        const int way = tags.findWay(line);
+        const Addr addr = way < 0 ? gen.addr() :
+            wayAddr(setOf(line), way) + gen.addr() - line;
+        RequestPtr req = std::make_shared<Request>(addr, gen.size(), 0,
+                                                   requestorId);
+        Packet chunk(req, pkt->cmd);
+        chunk.dataStatic(pkt->getPtr<uint8_t>() + gen.complete());
+        (way < 0 ? cxlSidePort : dramPort).sendFunctional(&chunk);
+    }
+
+    if (pkt->needsResponse())
+        pkt->makeResponse();
+}
+
+bool
+CXLDramCache::CpuSidePort::recvTimingReq(PacketPtr pkt)
+{
+    return cache.handleRequest(pkt);
+}
+
+Tick
+CXLDramCache::CpuSidePort::recvAtomic(PacketPtr pkt)
+{
+    return cache.atomicRequest(pkt);
+}
+
+Tick
+CXLDramCache::CpuSidePort::recvAtomicBackdoor(PacketPtr pkt,
+                                              MemBackdoorPtr &backdoor)
+{
+    return cache.atomicRequest(pkt);
+}
+
+void
+CXLDramCache::CpuSidePort::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    if (!trySatisfyFunctional(pkt) &&
+        !cache.cxlSidePort.trySatisfyFunctional(pkt)) {
+        if (cache.cacheable(pkt))
+            cache.functionalAccess(pkt);
+        else
+            cache.cxlSidePort.sendFunctional(pkt);
+    }
+
+    pkt->popLabel();
+}
+
+AddrRangeList
+CXLDramCache::CpuSidePort::getAddrRanges() const
+{
+    return cache.cxlSidePort.getAddrRanges();
+}
+
+bool
+CXLDramCache::MemSidePort::recvTimingResp(PacketPtr pkt)
+{
+    return cache.handleResponse(pkt);
+}
+
+void
+CXLDramCache::MemSidePort::recvRangeChange()
+{
+    if (this == &cache.cxlSidePort)
+        cache.cpuSidePort.sendRangeChange();
+}
+
+} // namespace gem5
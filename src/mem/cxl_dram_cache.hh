@@ -0,0 +1,299 @@
+/**
+ * @file
+ * Declaration of a memory-side cache that keeps lines of the CXL memory
+ * in a slice of host DRAM.
+ */
+
+#ifndef __MEM_CXL_DRAM_CACHE_HH__
+#define __MEM_CXL_DRAM_CACHE_HH__
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "base/addr_range.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "mem/cxl_dram_cache_tags.hh"
+#include "mem/packet_queue.hh"
+#include "mem/qport.hh"
+#include "params/CXLDramCache.hh"
+#include "sim/clocked_object.hh"
+
+namespace gem5
+{
+
+/**
+ * A memory-side cache in front of the CXL memory, whose data array is a
+ * region of host DRAM. It sits between the memory bus of the host and
+ * the CXL host bridge, and reaches its data array through the memory
+ * bus like any other requestor of host memory, so the hits, fills and
+ * writebacks show up at the host memory controllers as well as on the
+ * CXL link.
+ *
+ * The cache is direct-mapped or set-associative with a line per cache
+ * line of the system. It is write-back and allocates on full-line reads
+ * and writes, partial accesses that miss go to the CXL memory. The tags
+ * are either in an SRAM tag store in the controller, which costs a
+ * lookup latency, or in the ECC bits of the data array as in a
+ * tag-and-data cache, where every access first reads the line from host
+ * DRAM to learn whether it hits, and the victim comes with that read.
+ *
+ * Accesses to a set are handled one at a time, in order.
+ */
+class CXLDramCache : public ClockedObject
+{
+  protected:
+
+    /** Port facing the memory bus of the host. */
+    class CpuSidePort : public QueuedResponsePort
+    {
+
+      private:
+
+        RespPacketQueue _respQueue;
+
+        CXLDramCache& cache;
+
+      public:
+
+        CpuSidePort(const std::string& _name, CXLDramCache& _cache);
+
+      protected:
+
+        bool recvTimingReq(PacketPtr pkt) override;
+
+        Tick recvAtomic(PacketPtr pkt) override;
+
+        /** There is no backdoor, lines may live in host DRAM. */
+        Tick recvAtomicBackdoor(PacketPtr pkt,
+                                MemBackdoorPtr &backdoor) override;
+
+        void recvFunctional(PacketPtr pkt) override;
+
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    /** Port towards the CXL host bridge, or towards host DRAM. */
+    class MemSidePort : public QueuedRequestPort
+    {
+
+      private:
+
+        ReqPacketQueue _reqQueue;
+        SnoopRespPacketQueue _snoopRespQueue;
+
+        CXLDramCache& cache;
+
+      public:
+
+        MemSidePort(const std::string& _name, CXLDramCache& _cache);
+
+      protected:
+
+        bool recvTimingResp(PacketPtr pkt) override;
+
+        void recvRangeChange() override;
+    };
+
+    /** What a packet the cache sends itself does for an access. */
+    enum class Step
+    {
+        /** Read of the line with its tag from host DRAM. */
+        Probe,
+        /** Read or write of the line in host DRAM on a hit. */
+        Read,
+        Write,
+        /** Read of a dirty victim from host DRAM. */
+        VictimRead,
+        /** Write of a dirty victim back to the CXL memory. */
+        VictimWrite,
+        /** Read of the missing line from the CXL memory. */
+        Fetch,
+        /** Write of the fetched line into host DRAM. */
+        Fill,
+        /** Access that does not allocate, sent to the CXL memory. */
+        Forward
+    };
+
+    /** A host access in progress. */
+    struct Access
+    {
+        /** The host request, until it is responded to. */
+        PacketPtr pkt;
+
+        unsigned set;
+        unsigned way;
+
+        bool hit;
+
+        /** If the line is brought into the cache on a miss. */
+        bool allocate;
+
+        /** Dirty line to write back to the CXL memory, or MaxAddr. */
+        Addr victim;
+
+        /**
+         * If the victim is still being read out of its way, the fetched
+         * line then waits here to be filled in.
+         */
+        bool victimPending = false;
+        std::vector<uint8_t> fillData;
+
+        /** Packets sent for the access still awaiting a response. */
+        unsigned outstanding = 0;
+
+        /** Tick the access started. */
+        Tick start;
+    };
+
+    CpuSidePort cpuSidePort;
+    MemSidePort cxlSidePort;
+    MemSidePort dramPort;
+
+    /** Host DRAM holding the data array. */
+    const AddrRange dramRegion;
+
+    /** Number of ways per set. */
+    const unsigned assoc;
+
+    /** If the tags are in the ECC bits of the data array. */
+    const bool tagsInDram;
+
+    /** Latency of the controller for a message in either direction. */
+    const Cycles latency;
+
+    /** Lookup latency of the SRAM tag store. */
+    const Cycles tagLatency;
+
+    /** Host accesses the controller holds at most. */
+    const unsigned maxAccesses;
+
+    /** Cache line size of the system. */
+    const unsigned blkSize;
+
+    /** Requestor ID of the packets the cache sends itself. */
+    const RequestorID requestorId;
+
+    /** Number of sets. */
+    const unsigned numSets;
+
+    /** The tags, assoc ways per set. */
+    CXLDramCacheTagStore tags;
+
+    /** The access in progress at each busy set. */
+    std::unordered_map<unsigned, Access> active;
+
+    /** Host requests waiting for a busy set. */
+    std::unordered_map<unsigned, std::deque<PacketPtr>> waiting;
+
+    /** Host accesses held, in progress or waiting. */
+    unsigned numAccesses = 0;
+
+    /** If a host request was refused and needs a retry. */
+    bool retryReq = false;
+
+    /**
+     * Requests the cache sent, with the access and step they are for.
+     * They are kept by request rather than by packet, as a device cache
+     * behind a DCOH may answer with a packet of its own.
+     */
+    std::unordered_map<RequestPtr, std::pair<Access *, Step>> inflight;
+
+    Addr lineAddr(Addr addr) const { return addr & ~Addr(blkSize - 1); }
+
+    unsigned setOf(Addr addr) const { return tags.setOf(addr); }
+
+    /** Host DRAM address of a way. */
+    Addr wayAddr(unsigned set, unsigned way) const
+    {
+        return dramRegion.start() + (Addr(set) * assoc + way) * blkSize;
+    }
+
+    /**
+     * Look a host access up and update the tags for it, as if all its
+     * data movement was done.
+     */
+    Access lookup(PacketPtr pkt);
+
+    /**
+     * If a request is cached, others pass through the cache. Atomic
+     * read-modify-writes only reach memory when they are uncacheable.
+     */
+    bool cacheable(PacketPtr pkt) const
+    {
+        return pkt->isRead() != pkt->isWrite();
+    }
+
+    /** Handle a host request in timing mode. */
+    bool handleRequest(PacketPtr pkt);
+
+    /** Start the access of a host request to a free set. */
+    void startAccess(PacketPtr pkt, Tick when);
+
+    /**
+     * Move the data of an access once it is known whether it hits.
+     *
+     * @param frame the line read from host DRAM with its tag, if the
+     * tags are in the ECC bits
+     */
+    void proceed(Access &acc, Tick when, const uint8_t *frame);
+
+    /** Send a packet for an access. */
+    void send(Access &acc, Step step, MemSidePort &port, Addr addr,
+              unsigned size, MemCmd cmd, const uint8_t *data, Tick when);
+
+    /** Respond to the host request of an access. */
+    void respond(Access &acc, const uint8_t *line);
+
+    /** Handle a response of the host bridge or host DRAM. */
+    bool handleResponse(PacketPtr pkt);
+
+    /** Free the set of an access that is done. */
+    void finishAccess(Access &acc);
+
+    /** Atomic counterpart of handleRequest. */
+    Tick atomicRequest(PacketPtr pkt);
+
+    /** Send an atomic packet the cache makes itself. */
+    Tick atomicAccess(MemSidePort &port, Addr addr, unsigned size,
+                      MemCmd cmd, uint8_t *data);
+
+    /** Functional counterpart of handleRequest, line by line. */
+    void functionalAccess(PacketPtr pkt);
+
+    struct CXLDramCacheStats : public statistics::Group
+    {
+        CXLDramCacheStats(CXLDramCache &cache);
+
+        statistics::Scalar readHits;
+        statistics::Scalar readMisses;
+        statistics::Scalar writeHits;
+        statistics::Scalar writeMisses;
+        statistics::Scalar uncached;
+        statistics::Scalar fills;
+        statistics::Scalar writebacks;
+        statistics::Scalar setConflicts;
+        statistics::Scalar dramBytes;
+        statistics::Scalar cxlBytes;
+        statistics::Formula hitRate;
+        statistics::LogHistogram accessLatency;
+    };
+
+    CXLDramCacheStats stats;
+
+  public:
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+    void init() override;
+
+    typedef CXLDramCacheParams Params;
+
+    CXLDramCache(const Params &p);
+};
+
+} // namespace gem5
+
+#endif //__MEM_CXL_DRAM_CACHE_HH__
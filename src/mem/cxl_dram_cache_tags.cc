@@ -0,0 +1,76 @@
+/**
+ * @file
+ * Implementation of the tags of the memory-side DRAM cache in front of
+ * the CXL memory.
+ */
+
+#include "mem/cxl_dram_cache_tags.hh"
+
+namespace gem5
+{
+
+CXLDramCacheTagStore::CXLDramCacheTagStore(unsigned _num_sets,
+                                           unsigned _assoc,
+                                           unsigned _line_size)
+    : numSets(_num_sets), assoc(_assoc), lineSize(_line_size),
+      ways(Addr(_num_sets) * _assoc)
+{
+}
+
+int
+CXLDramCacheTagStore::findWay(Addr line) const
+{
+    const unsigned set = setOf(line);
+    for (unsigned w = 0; w < assoc; w++) {
+        if (ways[set * assoc + w].line == line)
+            return w;
+    }
+    return -1;
+}
+
+CXLDramCacheTagStore::Lookup
+CXLDramCacheTagStore::access(Addr line, bool is_write, bool allocate,
+                             Tick now)
+{
+    Lookup res;
+    res.set = setOf(line);
+    res.victim = MaxAddr;
+
+    const int way = findWay(line);
+    res.hit = way >= 0;
+    res.allocate = false;
+    if (res.hit) {
+        res.way = way;
+    } else {
+        // an invalid way, or else the least recently used one
+        res.way = 0;
+        for (unsigned w = 0; w < assoc; w++) {
+            const Way &cand = ways[res.set * assoc + w];
+            if (cand.line == MaxAddr) {
+                res.way = w;
+                break;
+            }
+            if (cand.lastUse < ways[res.set * assoc + res.way].lastUse)
+                res.way = w;
+        }
+
+        res.allocate = allocate;
+        if (res.allocate) {
+            Way &victim = ways[res.set * assoc + res.way];
+            if (victim.line != MaxAddr && victim.dirty)
+                res.victim = victim.line;
+            victim.line = line;
+            victim.dirty = false;
+        }
+    }
+
+    if (res.hit || res.allocate) {
+        Way &entry = ways[res.set * assoc + res.way];
+        entry.lastUse = now;
+        entry.dirty |= is_write;
+    }
+
+    return res;
+}
+
+} // namespace gem5
@@ -0,0 +1,93 @@
+/**
+ * @file
+ * Declaration of the tags of the memory-side DRAM cache in front of
+ * the CXL memory.
+ */
+
+#ifndef __MEM_CXL_DRAM_CACHE_TAGS_HH__
+#define __MEM_CXL_DRAM_CACHE_TAGS_HH__
+
+#include <vector>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/**
+ * The tags of a direct-mapped or set-associative cache with a line per
+ * cache line of the system and LRU replacement, whether they are kept
+ * in an SRAM tag store or in the ECC bits of the data array.
+ */
+class CXLDramCacheTagStore
+{
+  public:
+
+    /** What a lookup found, and what it did to the tags. */
+    struct Lookup
+    {
+        unsigned set;
+        unsigned way;
+
+        bool hit;
+
+        /** If the line was put into the way on a miss. */
+        bool allocate;
+
+        /** Dirty line the allocation evicted, or MaxAddr. */
+        Addr victim;
+    };
+
+    /**
+     * Constructor for the CXLDramCacheTagStore.
+     *
+     * @param _num_sets the number of sets
+     * @param _assoc the number of ways per set
+     * @param _line_size the cache line size
+     */
+    CXLDramCacheTagStore(unsigned _num_sets, unsigned _assoc,
+                         unsigned _line_size);
+
+    unsigned setOf(Addr addr) const { return (addr / lineSize) % numSets; }
+
+    /** Way holding a line, or -1 on a miss. */
+    int findWay(Addr line) const;
+
+    /**
+     * Look an access of a line up and update the tags for it. A hit,
+     * and a miss that allocates, make the way the most recently used,
+     * and a write makes it dirty. A miss takes an invalid way, or else
+     * the least recently used one.
+     *
+     * @param line the address of the line
+     * @param is_write if the access writes
+     * @param allocate if a miss puts the line into the cache
+     * @param now the tick of the access
+     */
+    Lookup access(Addr line, bool is_write, bool allocate, Tick now);
+
+  private:
+
+    /** A way of a set, and the line it holds. */
+    struct Way
+    {
+        /** Address of the line, MaxAddr if the way is invalid. */
+        Addr line = MaxAddr;
+
+        bool dirty = false;
+
+        /** Tick of the last access, for LRU replacement. */
+        Tick lastUse = 0;
+    };
+
+    const unsigned numSets;
+    const unsigned assoc;
+    const unsigned lineSize;
+
+    /** The ways, assoc per set. */
+    std::vector<Way> ways;
+};
+
+} // namespace gem5
+
+#endif // __MEM_CXL_DRAM_CACHE_TAGS_HH__
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "mem/cxl_dram_cache_tags.hh"
+
+using namespace gem5;
+
+/** Lines map to the sets in turn. */
+TEST(CXLDramCacheTagStoreTest, SetOf)
+{
+    CXLDramCacheTagStore tags(4, 2, 64);
+    EXPECT_EQ(tags.setOf(0x0), 0);
+    EXPECT_EQ(tags.setOf(0x40), 1);
+    EXPECT_EQ(tags.setOf(0xff), 3);
+    EXPECT_EQ(tags.setOf(0x100), 0);
+}
+
+/** A miss that allocates makes the next access hit. */
+TEST(CXLDramCacheTagStoreTest, MissThenHit)
+{
+    CXLDramCacheTagStore tags(4, 2, 64);
+    EXPECT_EQ(tags.findWay(0x40), -1);
+
+    auto res = tags.access(0x40, false, true, 1);
+    EXPECT_FALSE(res.hit);
+    EXPECT_TRUE(res.allocate);
+    EXPECT_EQ(res.set, 1);
+    EXPECT_EQ(res.victim, MaxAddr);
+    EXPECT_EQ(tags.findWay(0x40), res.way);
+
+    res = tags.access(0x40, false, true, 2);
+    EXPECT_TRUE(res.hit);
+    EXPECT_FALSE(res.allocate);
+}
+
+/** A miss that does not allocate leaves the tags alone. */
+TEST(CXLDramCacheTagStoreTest, NoAllocate)
+{
+    CXLDramCacheTagStore tags(4, 2, 64);
+
+    auto res = tags.access(0x40, true, false, 1);
+    EXPECT_FALSE(res.hit);
+    EXPECT_FALSE(res.allocate);
+    EXPECT_EQ(tags.findWay(0x40), -1);
+}
+
+/** A miss takes an invalid way before evicting a valid one. */
+TEST(CXLDramCacheTagStoreTest, InvalidWayFirst)
+{
+    CXLDramCacheTagStore tags(1, 2, 64);
+
+    auto first = tags.access(0x0, false, true, 1);
+    auto second = tags.access(0x40, false, true, 2);
+    EXPECT_NE(first.way, second.way);
+    EXPECT_EQ(second.victim, MaxAddr);
+    EXPECT_NE(tags.findWay(0x0), -1);
+    EXPECT_NE(tags.findWay(0x40), -1);
+}
+
+/** The least recently used way is the victim. */
+TEST(CXLDramCacheTagStoreTest, Lru)
+{
+    CXLDramCacheTagStore tags(1, 2, 64);
+
+    tags.access(0x0, false, true, 1);
+    tags.access(0x40, false, true, 2);
+    tags.access(0x0, false, true, 3);
+
+    auto res = tags.access(0x80, false, true, 4);
+    EXPECT_FALSE(res.hit);
+    EXPECT_EQ(res.way, 1);
+    EXPECT_EQ(tags.findWay(0x40), -1);
+    EXPECT_NE(tags.findWay(0x0), -1);
+}
+
+/** Only a dirty victim is reported for a writeback. */
+TEST(CXLDramCacheTagStoreTest, DirtyVictim)
+{
+    CXLDramCacheTagStore tags(1, 1, 64);
+
+    tags.access(0x0, false, true, 1);
+    auto res = tags.access(0x40, true, true, 2);
+    EXPECT_EQ(res.victim, MaxAddr);
+
+    // the written line is dirty, and a read hit does not clean it
+    tags.access(0x40, false, true, 3);
+    res = tags.access(0x80, false, true, 4);
+    EXPECT_EQ(res.victim, 0x40);
+
+    // the line filled by a read is clean
+    res = tags.access(0xc0, false, true, 5);
+    EXPECT_EQ(res.victim, MaxAddr);
+}
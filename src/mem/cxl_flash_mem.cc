@@ -0,0 +1,400 @@
+/**
+ * @file
+ * Implementation of a flash-backed media model for a memory-semantic SSD
+ * behind a CXL memory device.
+ */
+
+#include "mem/cxl_flash_mem.hh"
+
+#include <algorithm>
+#include <iterator>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CXLFlashMemory.hh"
+#include "debug/Drain.hh"
+
+namespace gem5
+{
+
+namespace memory
+{
+
+CXLFlashMemory::CXLFlashMemory(const CXLFlashMemoryParams &p) :
+    AbstractMemory(p),
+    port(name() + ".port", *this),
+    pageSize(p.page_size),
+    cachePages(p.cache_size / p.page_size),
+    cacheLatency(p.cache_latency),
+    bandwidth(p.bandwidth),
+    readLatency(p.read_latency),
+    pageTransfer(p.page_size * p.channel_bandwidth),
+    pages(cachePages, p.channels, p.channels * p.dies_per_channel,
+          readLatency, p.program_latency, pageTransfer,
+          p.write_buffer_size),
+    isBusy(false), retryReq(false), retryResp(false),
+    releaseEvent([this]{ release(); }, name()),
+    bufferEvent([this]{ bufferFreed(); }, name()),
+    dequeueEvent([this]{ dequeue(); }, name()),
+    flashStats(*this)
+{
+    fatal_if(!p.channels || !p.dies_per_channel, "%s: needs at least one "
+             "channel and one die per channel.\n", name());
+    fatal_if(!cachePages, "%s: the DRAM cache must hold at least a page.\n",
+             name());
+    fatal_if(!p.write_buffer_size, "%s: the write buffer must hold at "
+             "least a page.\n", name());
+}
+
+CXLFlashMemory::FlashStats::FlashStats(CXLFlashMemory &mem)
+    : statistics::Group(&mem),
+
+      ADD_STAT(readHits, statistics::units::Count::get(),
+               "Number of reads that hit in the DRAM cache"),
+      ADD_STAT(readMisses, statistics::units::Count::get(),
+               "Number of reads that fetched their page from flash"),
+      ADD_STAT(readsCoalesced, statistics::units::Count::get(),
+               "Number of reads that waited for the fetch of their page"),
+      ADD_STAT(bufferHits, statistics::units::Count::get(),
+               "Number of reads served from the write buffer"),
+      ADD_STAT(writesMerged, statistics::units::Count::get(),
+               "Number of writes merged into a page not yet programmed"),
+      ADD_STAT(pageReads, statistics::units::Count::get(),
+               "Number of pages read from flash"),
+      ADD_STAT(pagePrograms, statistics::units::Count::get(),
+               "Number of pages programmed to flash"),
+      ADD_STAT(bufferFull, statistics::units::Count::get(),
+               "Number of writes refused as the write buffer was full"),
+      ADD_STAT(hitRate, statistics::units::Ratio::get(),
+               "Ratio of reads that hit in the DRAM cache or write buffer",
+               (readHits + bufferHits) /
+               (readHits + bufferHits + readMisses + readsCoalesced)),
+      ADD_STAT(readLatency, statistics::units::Tick::get(),
+               "Time from accepting a read until its response is ready")
+{
+    readLatency
+        .init()
+        .flags(statistics::nozero);
+}
+
+void
+CXLFlashMemory::init()
+{
+    AbstractMemory::init();
+
+    if (port.isConnected()) {
+        port.sendRangeChange();
+    }
+}
+
+void
+CXLFlashMemory::readPage(Addr page, Tick &ready)
+{
+    switch (pages.read(page, curTick(), ready)) {
+      case CXLFlashPages::BufferHit:
+        ++flashStats.bufferHits;
+        break;
+      case CXLFlashPages::ReadHit:
+        ++flashStats.readHits;
+        break;
+      case CXLFlashPages::ReadCoalesced:
+        ++flashStats.readsCoalesced;
+        break;
+      default:
+        ++flashStats.readMisses;
+        ++flashStats.pageReads;
+        DPRINTF(CXLFlashMemory, "Read of page %#x on die %u ready at "
+                "%llu\n", page, pages.dieOf(page), ready);
+        break;
+    }
+}
+
+bool
+CXLFlashMemory::writePage(Addr page)
+{
+    Tick done;
+    switch (pages.write(page, curTick(), done)) {
+      case CXLFlashPages::WriteMerged:
+        ++flashStats.writesMerged;
+        return true;
+      case CXLFlashPages::BufferFull:
+        ++flashStats.bufferFull;
+        return false;
+      default:
+        ++flashStats.pagePrograms;
+        DPRINTF(CXLFlashMemory, "Program of page %#x on die %u done at "
+                "%llu\n", page, pages.dieOf(page), done);
+        return true;
+    }
+}
+
+Tick
+CXLFlashMemory::atomicLatency(PacketPtr pkt)
+{
+    Addr page = pageOf(pkt->getAddr());
+
+    switch (pages.atomicAccess(page, pkt->isWrite())) {
+      case CXLFlashPages::BufferHit:
+        ++flashStats.bufferHits;
+        return cacheLatency;
+      case CXLFlashPages::ReadHit:
+        ++flashStats.readHits;
+        return cacheLatency;
+      case CXLFlashPages::ReadMiss:
+        ++flashStats.readMisses;
+        ++flashStats.pageReads;
+        return readLatency + pageTransfer + cacheLatency;
+      default:
+        return cacheLatency;
+    }
+}
+
+Tick
+CXLFlashMemory::recvAtomic(PacketPtr pkt)
+{
+    panic_if(pkt->cacheResponding(), "Should not see packets where cache "
+             "is responding");
+
+    Tick latency = atomicLatency(pkt);
+    access(pkt);
+    return latency;
+}
+
+Tick
+CXLFlashMemory::recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr &_backdoor)
+{
+    Tick latency = recvAtomic(pkt);
+    getBackdoor(_backdoor);
+    return latency;
+}
+
+void
+CXLFlashMemory::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    functionalAccess(pkt);
+
+    bool done = false;
+    auto p = packetQueue.begin();
+    while (!done && p != packetQueue.end()) {
+        done = pkt->trySatisfyFunctional(p->pkt);
+        ++p;
+    }
+
+    pkt->popLabel();
+}
+
+void
+CXLFlashMemory::recvMemBackdoorReq(const MemBackdoorReq &req,
+        MemBackdoorPtr &_backdoor)
+{
+    getBackdoor(_backdoor);
+}
+
+bool
+CXLFlashMemory::recvTimingReq(PacketPtr pkt)
+{
+    panic_if(pkt->cacheResponding(), "Should not see packets where cache "
+             "is responding");
+
+    panic_if(!(pkt->isRead() || pkt->isWrite()),
+             "Should only see read and writes at memory controller, "
+             "saw %s to %#llx\n", pkt->cmdString(), pkt->getAddr());
+
+    if (retryReq)
+        return false;
+
+    if (isBusy) {
+        retryReq = true;
+        return false;
+    }
+
+    pages.retirePrograms(curTick());
+
+    Addr page = pageOf(pkt->getAddr());
+    Tick ready = curTick();
+    if (pkt->isWrite()) {
+        if (!writePage(page)) {
+            // Retry once the first page in the buffer is programmed.
+            retryReq = true;
+            if (!bufferEvent.scheduled())
+                schedule(bufferEvent, pages.firstProgramDone());
+            return false;
+        }
+    } else {
+        readPage(page, ready);
+    }
+
+    Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    // The DRAM cache limits the rate requests are accepted at, as the
+    // bandwidth of a SimpleMemory does.
+    Tick duration = pkt->getSize() * bandwidth;
+    if (duration != 0) {
+        schedule(releaseEvent, curTick() + duration);
+        isBusy = true;
+    }
+
+    bool needsResponse = pkt->needsResponse();
+    bool isRead = !pkt->isWrite();
+    access(pkt);
+
+    if (needsResponse) {
+        assert(pkt->isResponse());
+
+        Tick when_to_send = ready + receive_delay + cacheLatency;
+        if (isRead)
+            flashStats.readLatency.sample(when_to_send - curTick());
+
+        // Hits overtake misses, but never an earlier access to the same
+        // address.
+        auto i = packetQueue.end();
+        while (i != packetQueue.begin()) {
+            auto prev = std::prev(i);
+            if (prev->tick <= when_to_send || prev->pkt->matchAddr(pkt))
+                break;
+            i = prev;
+        }
+        packetQueue.emplace(i, pkt, when_to_send);
+
+        if (!retryResp) {
+            Tick head = std::max(packetQueue.front().tick, curTick());
+            if (!dequeueEvent.scheduled())
+                schedule(dequeueEvent, head);
+            else if (dequeueEvent.when() > head)
+                reschedule(dequeueEvent, head);
+        }
+    } else {
+        pendingDelete.reset(pkt);
+    }
+
+    return true;
+}
+
+void
+CXLFlashMemory::release()
+{
+    assert(isBusy);
+    isBusy = false;
+    if (retryReq) {
+        retryReq = false;
+        port.sendRetryReq();
+    }
+}
+
+void
+CXLFlashMemory::bufferFreed()
+{
+    // If the cache is busy, its release sends the retry.
+    if (retryReq && !isBusy) {
+        retryReq = false;
+        port.sendRetryReq();
+    }
+}
+
+void
+CXLFlashMemory::dequeue()
+{
+    assert(!packetQueue.empty());
+    DeferredPacket deferred_pkt = packetQueue.front();
+
+    retryResp = !port.sendTimingResp(deferred_pkt.pkt);
+
+    if (!retryResp) {
+        packetQueue.pop_front();
+
+        if (!packetQueue.empty()) {
+            reschedule(dequeueEvent,
+                       std::max(packetQueue.front().tick, curTick()), true);
+        } else if (drainState() == DrainState::Draining) {
+            DPRINTF(Drain, "Draining of CXLFlashMemory complete\n");
+            signalDrainDone();
+        }
+    }
+}
+
+void
+CXLFlashMemory::recvRespRetry()
+{
+    assert(retryResp);
+
+    dequeue();
+}
+
+Port &
+CXLFlashMemory::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name != "port") {
+        return AbstractMemory::getPort(if_name, idx);
+    } else {
+        return port;
+    }
+}
+
+DrainState
+CXLFlashMemory::drain()
+{
+    if (!packetQueue.empty()) {
+        DPRINTF(Drain, "CXLFlashMemory Queue has requests, waiting to "
+                "drain\n");
+        return DrainState::Draining;
+    } else {
+        return DrainState::Drained;
+    }
+}
+
+CXLFlashMemory::MemoryPort::MemoryPort(const std::string& _name,
+                                       CXLFlashMemory& _memory)
+    : ResponsePort(_name), mem(_memory)
+{ }
+
+AddrRangeList
+CXLFlashMemory::MemoryPort::getAddrRanges() const
+{
+    AddrRangeList ranges;
+    ranges.push_back(mem.getAddrRange());
+    return ranges;
+}
+
+Tick
+CXLFlashMemory::MemoryPort::recvAtomic(PacketPtr pkt)
+{
+    return mem.recvAtomic(pkt);
+}
+
+Tick
+CXLFlashMemory::MemoryPort::recvAtomicBackdoor(
+        PacketPtr pkt, MemBackdoorPtr &_backdoor)
+{
+    return mem.recvAtomicBackdoor(pkt, _backdoor);
+}
+
+void
+CXLFlashMemory::MemoryPort::recvFunctional(PacketPtr pkt)
+{
+    mem.recvFunctional(pkt);
+}
+
+void
+CXLFlashMemory::MemoryPort::recvMemBackdoorReq(const MemBackdoorReq &req,
+        MemBackdoorPtr &backdoor)
+{
+    mem.recvMemBackdoorReq(req, backdoor);
+}
+
+bool
+CXLFlashMemory::MemoryPort::recvTimingReq(PacketPtr pkt)
+{
+    return mem.recvTimingReq(pkt);
+}
+
+void
+CXLFlashMemory::MemoryPort::recvRespRetry()
+{
+    mem.recvRespRetry();
+}
+
+} // namespace memory
+} // namespace gem5
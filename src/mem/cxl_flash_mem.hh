@@ -0,0 +1,199 @@
+/**
+ * @file
+ * Declaration of a flash-backed media model for a memory-semantic SSD
+ * behind a CXL memory device.
+ */
+
+#ifndef __MEM_CXL_FLASH_MEM_HH__
+#define __MEM_CXL_FLASH_MEM_HH__
+
+#include <list>
+#include <memory>
+
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "mem/abstract_mem.hh"
+#include "mem/cxl_flash_pages.hh"
+#include "mem/port.hh"
+#include "params/CXLFlashMemory.hh"
+
+namespace gem5
+{
+
+namespace memory
+{
+
+/**
+ * The media of a memory-semantic SSD, NAND flash behind an internal
+ * DRAM cache, as the media controller of a CXL memory device sees it.
+ *
+ * The flash is read and programmed a page at a time, on dies that hang
+ * off a number of channels, a page on the die its page number selects.
+ * A read that hits a page in the DRAM cache, or in the write buffer,
+ * is served at the latency of the cache. A read that misses senses the
+ * page on its die, moves it over the channel into the cache, evicting
+ * the least recently used page, and is served from there. Reads of a
+ * page whose fetch is under way wait for that fetch.
+ *
+ * Writes are acknowledged once they are in the write buffer, which
+ * holds whole pages. A page is moved to its die and programmed as soon
+ * as the die is free, and writes to it merge until then. A write that
+ * finds the buffer full of pages not yet programmed is refused, and
+ * retried when the first of them is. Programs and reads share the dies
+ * and channels in the order they come, without suspending a program.
+ *
+ * The timing of the dies and channels is worked out when a request is
+ * accepted, the data is always read and written straight away.
+ */
+class CXLFlashMemory : public AbstractMemory
+{
+
+  private:
+
+    /** A response waiting for the tick it is ready at. */
+    class DeferredPacket
+    {
+
+      public:
+
+        const Tick tick;
+        const PacketPtr pkt;
+
+        DeferredPacket(PacketPtr _pkt, Tick _tick) : tick(_tick), pkt(_pkt)
+        { }
+    };
+
+    class MemoryPort : public ResponsePort
+    {
+      private:
+        CXLFlashMemory& mem;
+
+      public:
+        MemoryPort(const std::string& _name, CXLFlashMemory& _memory);
+
+      protected:
+        Tick recvAtomic(PacketPtr pkt) override;
+        Tick recvAtomicBackdoor(
+                PacketPtr pkt, MemBackdoorPtr &_backdoor) override;
+        void recvFunctional(PacketPtr pkt) override;
+        void recvMemBackdoorReq(const MemBackdoorReq &req,
+                MemBackdoorPtr &backdoor) override;
+        bool recvTimingReq(PacketPtr pkt) override;
+        void recvRespRetry() override;
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    MemoryPort port;
+
+    /** Bytes per flash page. */
+    const Addr pageSize;
+
+    /** Pages the DRAM cache holds. */
+    const uint64_t cachePages;
+
+    /** Latency of the DRAM cache and the controller in front of it. */
+    const Tick cacheLatency;
+
+    /** Ticks per byte of the DRAM cache, 0 for no limit. */
+    const double bandwidth;
+
+    /** Time to sense a page on a die. */
+    const Tick readLatency;
+
+    /** Time to move a page over a channel. */
+    const Tick pageTransfer;
+
+    /** The DRAM cache, the write buffer, and the dies and channels. */
+    CXLFlashPages pages;
+
+    /** Responses in the order they are sent. */
+    std::list<DeferredPacket> packetQueue;
+
+    /** If the DRAM cache is busy with an access. */
+    bool isBusy;
+
+    /** If a request was refused and needs a retry. */
+    bool retryReq;
+
+    /** If a response was refused and we wait for a retry. */
+    bool retryResp;
+
+    /** Release the cache after being busy, and retry a request. */
+    void release();
+
+    EventFunctionWrapper releaseEvent;
+
+    /** Retry a request that found the write buffer full. */
+    void bufferFreed();
+
+    EventFunctionWrapper bufferEvent;
+
+    /** Send the response at the head of the queue. */
+    void dequeue();
+
+    EventFunctionWrapper dequeueEvent;
+
+    /** Held until the requestor is done with it, as in SimpleMemory. */
+    std::unique_ptr<Packet> pendingDelete;
+
+    Addr pageOf(Addr addr) const { return addr / pageSize; }
+
+    /**
+     * Read a page and count what it found.
+     *
+     * @param ready set to the tick the page is readable from the cache
+     */
+    void readPage(Addr page, Tick &ready);
+
+    /**
+     * Write a page and count what it found.
+     *
+     * @return false if the write buffer is full
+     */
+    bool writePage(Addr page);
+
+    /** Latency of an access in atomic mode, from the tags alone. */
+    Tick atomicLatency(PacketPtr pkt);
+
+    struct FlashStats : public statistics::Group
+    {
+        FlashStats(CXLFlashMemory &mem);
+
+        statistics::Scalar readHits;
+        statistics::Scalar readMisses;
+        statistics::Scalar readsCoalesced;
+        statistics::Scalar bufferHits;
+        statistics::Scalar writesMerged;
+        statistics::Scalar pageReads;
+        statistics::Scalar pagePrograms;
+        statistics::Scalar bufferFull;
+        statistics::Formula hitRate;
+        statistics::LogHistogram readLatency;
+    };
+
+    FlashStats flashStats;
+
+  public:
+
+    CXLFlashMemory(const CXLFlashMemoryParams &p);
+
+    DrainState drain() override;
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+    void init() override;
+
+  protected:
+    Tick recvAtomic(PacketPtr pkt);
+    Tick recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr &_backdoor);
+    void recvFunctional(PacketPtr pkt);
+    void recvMemBackdoorReq(const MemBackdoorReq &req,
+            MemBackdoorPtr &backdoor);
+    bool recvTimingReq(PacketPtr pkt);
+    void recvRespRetry();
+};
+
+} // namespace memory
+} // namespace gem5
+
+#endif //__MEM_CXL_FLASH_MEM_HH__
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * Implementation of the page timing of the flash media of a
+ * memory-semantic SSD.
+ */
+
+#include "mem/cxl_flash_pages.hh"
+
+#include <algorithm>
+
+namespace gem5
+{
+
+namespace memory
+{
+
+CXLFlashPages::CXLFlashPages(uint64_t _cache_pages, unsigned _channels,
+                             unsigned _dies, Tick _read_latency,
+                             Tick _program_latency, Tick _page_transfer,
+                             unsigned _write_buffer_size)
+    : cachePages(_cache_pages), channels(_channels), dies(_dies),
+    readLatency(_read_latency), programLatency(_program_latency),
+    pageTransfer(_page_transfer), writeBufferSize(_write_buffer_size),
+    dieFree(dies, 0), channelFree(channels, 0)
+{
+}
+
+void
+CXLFlashPages::retirePrograms(Tick now)
+{
+    auto done = writeBuffer.upper_bound(now);
+    for (auto it = writeBuffer.begin(); it != done; ) {
+        auto buffered = bufferedPages.find(it->second);
+        if (buffered != bufferedPages.end() &&
+            buffered->second.program == it) {
+            bufferedPages.erase(buffered);
+        }
+        it = writeBuffer.erase(it);
+    }
+}
+
+void
+CXLFlashPages::touchPage(Addr page, Tick ready)
+{
+    auto it = cache.find(page);
+    if (it != cache.end()) {
+        lruList.splice(lruList.begin(), lruList, it->second.lru);
+        it->second.ready = std::min(it->second.ready, ready);
+        return;
+    }
+
+    if (cache.size() >= cachePages) {
+        cache.erase(lruList.back());
+        lruList.pop_back();
+    }
+    lruList.push_front(page);
+    cache[page] = CachedPage{lruList.begin(), ready};
+}
+
+CXLFlashPages::Outcome
+CXLFlashPages::read(Addr page, Tick now, Tick &ready)
+{
+    if (bufferedPages.count(page)) {
+        ready = now;
+        return BufferHit;
+    }
+
+    auto it = cache.find(page);
+    if (it != cache.end()) {
+        lruList.splice(lruList.begin(), lruList, it->second.lru);
+        ready = std::max(it->second.ready, now);
+        return it->second.ready > now ? ReadCoalesced : ReadHit;
+    }
+
+    // Sense the page on its die, then move it over the channel into
+    // the cache, the die holds the page in its register until then.
+    unsigned die = dieOf(page);
+    unsigned channel = channelOf(page);
+    Tick sensed = std::max(now, dieFree[die]) + readLatency;
+    ready = std::max(sensed, channelFree[channel]) + pageTransfer;
+    dieFree[die] = ready;
+    channelFree[channel] = ready;
+
+    touchPage(page, ready);
+    return ReadMiss;
+}
+
+CXLFlashPages::Outcome
+CXLFlashPages::write(Addr page, Tick now, Tick &done)
+{
+    auto buffered = bufferedPages.find(page);
+    if (buffered != bufferedPages.end() && buffered->second.start > now) {
+        touchPage(page, now);
+        return WriteMerged;
+    }
+
+    if (writeBuffer.size() >= writeBufferSize)
+        return BufferFull;
+
+    // Move the page to its die once both are free, and program it.
+    unsigned die = dieOf(page);
+    unsigned channel = channelOf(page);
+    Tick start = std::max({now, dieFree[die], channelFree[channel]});
+    Tick moved = start + pageTransfer;
+    done = moved + programLatency;
+    channelFree[channel] = moved;
+    dieFree[die] = done;
+
+    bufferedPages[page] = BufferedPage{writeBuffer.emplace(done, page),
+                                       start};
+    touchPage(page, now);
+    return WriteProgrammed;
+}
+
+CXLFlashPages::Outcome
+CXLFlashPages::atomicAccess(Addr page, bool is_write)
+{
+    if (is_write) {
+        touchPage(page, 0);
+        return WriteMerged;
+    }
+
+    if (bufferedPages.count(page))
+        return BufferHit;
+
+    bool hit = cache.count(page);
+    touchPage(page, 0);
+    return hit ? ReadHit : ReadMiss;
+}
+
+} // namespace memory
+} // namespace gem5
@@ -0,0 +1,161 @@
+/**
+ * @file
+ * Declaration of the page timing of the flash media of a
+ * memory-semantic SSD.
+ */
+
+#ifndef __MEM_CXL_FLASH_PAGES_HH__
+#define __MEM_CXL_FLASH_PAGES_HH__
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+namespace memory
+{
+
+/**
+ * The pages of the flash media of a memory-semantic SSD: the DRAM cache
+ * of pages in front of the flash, the write buffer of pages being
+ * programmed, and the dies and channels the page reads and programs
+ * take their turns on. It works out when the page of an access is
+ * ready, the data itself is kept by the memory.
+ */
+class CXLFlashPages
+{
+  public:
+
+    /** What an access of a page found. */
+    enum Outcome
+    {
+        /** A read of a page in the DRAM cache. */
+        ReadHit,
+        /** A read of a page whose fetch is under way. */
+        ReadCoalesced,
+        /** A read of a page in the write buffer. */
+        BufferHit,
+        /** A read that fetches its page from flash. */
+        ReadMiss,
+        /** A write to a page whose program has not started. */
+        WriteMerged,
+        /** A write that schedules the program of its page. */
+        WriteProgrammed,
+        /** A write refused as the write buffer is full. */
+        BufferFull
+    };
+
+    /**
+     * Constructor for the CXLFlashPages.
+     *
+     * @param _cache_pages pages the DRAM cache holds
+     * @param _channels the channels of the flash
+     * @param _dies the dies of the flash, over all the channels
+     * @param _read_latency time to sense a page on a die
+     * @param _program_latency time to program a page on a die
+     * @param _page_transfer time to move a page over a channel
+     * @param _write_buffer_size pages the write buffer holds
+     */
+    CXLFlashPages(uint64_t _cache_pages, unsigned _channels, unsigned _dies,
+                  Tick _read_latency, Tick _program_latency,
+                  Tick _page_transfer, unsigned _write_buffer_size);
+
+    unsigned dieOf(Addr page) const { return page % dies; }
+
+    unsigned channelOf(Addr page) const { return dieOf(page) % channels; }
+
+    /** Drop the pages from the write buffer that are programmed. */
+    void retirePrograms(Tick now);
+
+    /**
+     * Read a page, fetching it from its die if it is in neither the
+     * DRAM cache nor the write buffer.
+     *
+     * @param ready set to the tick the page is readable from the cache
+     */
+    Outcome read(Addr page, Tick now, Tick &ready);
+
+    /**
+     * Put a page into the write buffer, merging with a program that
+     * has not started, or schedule its program.
+     *
+     * @param done set to the tick a new program is done at
+     */
+    Outcome write(Addr page, Tick now, Tick &done);
+
+    /**
+     * Access a page in atomic mode, from the tags alone: a read misses
+     * if its page is in neither the cache nor the write buffer, and a
+     * write is taken into the cache as merged. The dies and channels
+     * are not modelled.
+     */
+    Outcome atomicAccess(Addr page, bool is_write);
+
+    /** Tick the first program in the write buffer is done at. */
+    Tick firstProgramDone() const { return writeBuffer.begin()->first; }
+
+  private:
+
+    /** A page in the DRAM cache. */
+    struct CachedPage
+    {
+        /** Position in the LRU list, most recently used at the front. */
+        std::list<Addr>::iterator lru;
+
+        /** Tick the page is in the cache at, once its fetch is done. */
+        Tick ready;
+    };
+
+    /** A page in the write buffer, with its latest program. */
+    struct BufferedPage
+    {
+        /** Entry of the program in the write buffer. */
+        std::multimap<Tick, Addr>::iterator program;
+
+        /** Tick the program starts at, writes merge until then. */
+        Tick start;
+    };
+
+    /**
+     * Make a page the most recently used in the DRAM cache, inserting
+     * it, ready at the given tick, if it is not there.
+     */
+    void touchPage(Addr page, Tick ready);
+
+    const uint64_t cachePages;
+
+    const unsigned channels;
+    const unsigned dies;
+
+    const Tick readLatency;
+    const Tick programLatency;
+    const Tick pageTransfer;
+
+    const unsigned writeBufferSize;
+
+    /** The pages in the DRAM cache, and their LRU order. */
+    std::unordered_map<Addr, CachedPage> cache;
+    std::list<Addr> lruList;
+
+    /** Ticks each die and each channel is busy until. */
+    std::vector<Tick> dieFree;
+    std::vector<Tick> channelFree;
+
+    /**
+     * The programs in the write buffer by the tick they are done at, a
+     * page rewritten after its program started has more than one.
+     */
+    std::multimap<Tick, Addr> writeBuffer;
+    std::unordered_map<Addr, BufferedPage> bufferedPages;
+};
+
+} // namespace memory
+} // namespace gem5
+
+#endif // __MEM_CXL_FLASH_PAGES_HH__
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "mem/cxl_flash_pages.hh"
+
+using namespace gem5;
+using namespace gem5::memory;
+
+namespace
+{
+
+// 2 pages of cache, 2 channels of 2 dies, tR 100, tPROG 500, a page
+// transfer of 10 and 2 pages of write buffer
+CXLFlashPages
+makePages()
+{
+    return CXLFlashPages(2, 2, 4, 100, 500, 10, 2);
+}
+
+} // anonymous namespace
+
+/** Pages are spread over the dies, and the dies over the channels. */
+TEST(CXLFlashPagesTest, Placement)
+{
+    auto pages = makePages();
+    EXPECT_EQ(pages.dieOf(0), 0);
+    EXPECT_EQ(pages.dieOf(5), 1);
+    EXPECT_EQ(pages.channelOf(2), 0);
+    EXPECT_EQ(pages.channelOf(3), 1);
+}
+
+/** A miss senses the page and moves it, the next read hits. */
+TEST(CXLFlashPagesTest, ReadMissThenHit)
+{
+    auto pages = makePages();
+    Tick ready;
+    EXPECT_EQ(pages.read(0, 0, ready), CXLFlashPages::ReadMiss);
+    EXPECT_EQ(ready, 110);
+
+    EXPECT_EQ(pages.read(0, 200, ready), CXLFlashPages::ReadHit);
+    EXPECT_EQ(ready, 200);
+}
+
+/** A read of a page being fetched waits for that fetch. */
+TEST(CXLFlashPagesTest, ReadCoalesced)
+{
+    auto pages = makePages();
+    Tick ready;
+    pages.read(0, 0, ready);
+    EXPECT_EQ(pages.read(0, 50, ready), CXLFlashPages::ReadCoalesced);
+    EXPECT_EQ(ready, 110);
+}
+
+/** Reads of a die take turns, and of a channel share it. */
+TEST(CXLFlashPagesTest, DieAndChannel)
+{
+    auto pages = makePages();
+    Tick ready;
+
+    // the die senses one page after the other
+    pages.read(0, 0, ready);
+    EXPECT_EQ(pages.read(4, 0, ready), CXLFlashPages::ReadMiss);
+    EXPECT_EQ(ready, 220);
+
+    // another die of the channel senses at once, and waits for it
+    EXPECT_EQ(pages.read(2, 0, ready), CXLFlashPages::ReadMiss);
+    EXPECT_EQ(ready, 230);
+
+    // a die of the other channel does not wait
+    EXPECT_EQ(pages.read(1, 0, ready), CXLFlashPages::ReadMiss);
+    EXPECT_EQ(ready, 110);
+}
+
+/** The least recently used page leaves the cache. */
+TEST(CXLFlashPagesTest, Lru)
+{
+    auto pages = makePages();
+    Tick ready;
+    pages.read(0, 0, ready);
+    pages.read(1, 0, ready);
+    pages.read(0, 1000, ready);
+    pages.read(3, 1000, ready);
+
+    EXPECT_EQ(pages.read(0, 2000, ready), CXLFlashPages::ReadHit);
+    EXPECT_EQ(pages.read(1, 2000, ready), CXLFlashPages::ReadMiss);
+}
+
+/** Writes merge until the program starts, and fill the buffer. */
+TEST(CXLFlashPagesTest, WriteBuffer)
+{
+    auto pages = makePages();
+    Tick done;
+
+    // the die is busy with a read, so the program waits
+    Tick ready;
+    pages.read(0, 0, ready);
+    EXPECT_EQ(pages.write(4, 0, done), CXLFlashPages::WriteProgrammed);
+    EXPECT_EQ(done, 620);
+    EXPECT_EQ(pages.write(4, 50, done), CXLFlashPages::WriteMerged);
+
+    // a rewrite once the program started programs the page again
+    EXPECT_EQ(pages.write(4, 110, done), CXLFlashPages::WriteProgrammed);
+    EXPECT_EQ(done, 1130);
+    EXPECT_EQ(pages.firstProgramDone(), 620);
+
+    EXPECT_EQ(pages.write(1, 110, done), CXLFlashPages::BufferFull);
+
+    // the first program retires and frees its entry
+    pages.retirePrograms(620);
+    EXPECT_EQ(pages.firstProgramDone(), 1130);
+    EXPECT_EQ(pages.write(1, 620, done), CXLFlashPages::WriteProgrammed);
+}
+
+/** Reads of a page in the write buffer are served from it. */
+TEST(CXLFlashPagesTest, BufferHit)
+{
+    auto pages = makePages();
+    Tick done, ready;
+    pages.write(0, 0, done);
+
+    EXPECT_EQ(pages.read(0, 10, ready), CXLFlashPages::BufferHit);
+    EXPECT_EQ(ready, 10);
+
+    pages.retirePrograms(done);
+    EXPECT_EQ(pages.read(0, done, ready), CXLFlashPages::ReadHit);
+}
+
+/** Atomic accesses only look at the tags. */
+TEST(CXLFlashPagesTest, Atomic)
+{
+    auto pages = makePages();
+    EXPECT_EQ(pages.atomicAccess(0, false), CXLFlashPages::ReadMiss);
+    EXPECT_EQ(pages.atomicAccess(0, false), CXLFlashPages::ReadHit);
+    EXPECT_EQ(pages.atomicAccess(1, true), CXLFlashPages::WriteMerged);
+    EXPECT_EQ(pages.atomicAccess(1, false), CXLFlashPages::ReadHit);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * Declaration of the packet extension that records when an access passes
+ * the stages of the CXL memory path, for a latency breakdown.
+ */
+
+#ifndef __MEM_CXL_LATENCY_HH__
+#define __MEM_CXL_LATENCY_HH__
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "base/extensible.hh"
+#include "base/types.hh"
+#include "mem/packet.hh"
+#include "sim/cur_tick.hh"
+
+namespace gem5
+{
+
+/**
+ * The ticks an access passed the points of the CXL memory path at. The
+ * CXL host bridge puts it on the requests it breaks the latency down
+ * for, the CXL memory device stamps the points inside the device, and
+ * the bridge reads them all back when the response leaves it. A point
+ * the access did not pass, as for a page migrated to host DRAM, stays
+ * at MaxTick.
+ */
+class CXLLatencyExtension : public Extension<Packet, CXLLatencyExtension>
+{
+  public:
+
+    enum Point
+    {
+        /** Request accepted by, and sent on from, the host bridge. */
+        BridgeIn,
+        BridgeOut,
+        /** Request accepted into the request queue of the device. */
+        DeviceIn,
+        /** Request accepted by the media controller. */
+        MediaIn,
+        /** Response of the media controller. */
+        MediaOut,
+        /** Response sent on from the device. */
+        DeviceOut,
+        /** Response received by the host bridge. */
+        BridgeRspIn,
+        NumPoints
+    };
+
+    CXLLatencyExtension(Addr _addr, bool _write, Tick _issue)
+        : addr(_addr), write(_write), issue(_issue)
+    {
+        ticks.fill(MaxTick);
+    }
+
+    std::unique_ptr<ExtensionBase>
+    clone() const override
+    {
+        return std::make_unique<CXLLatencyExtension>(*this);
+    }
+
+    /** Stamp a point on a packet, if its latency is broken down. */
+    static void
+    stamp(PacketPtr pkt, Point point)
+    {
+        auto ext = pkt->getExtension<CXLLatencyExtension>();
+        if (ext)
+            ext->ticks[point] = curTick();
+    }
+
+    /** Time between two points, MaxTick if either was not passed. */
+    Tick
+    between(Point from, Point to) const
+    {
+        if (ticks[from] == MaxTick || ticks[to] == MaxTick)
+            return MaxTick;
+        return ticks[to] - ticks[from];
+    }
+
+    /** Address and direction of the access. */
+    const Addr addr;
+    const bool write;
+
+    /** Tick the request was made, before it missed in the caches. */
+    const Tick issue;
+
+    std::array<Tick, NumPoints> ticks;
+};
+
+/**
+ * A record of the binary latency trace of the host bridge, one per
+ * access, in the byte order of the simulating host. The stages are in
+ * ticks, saturated to 32 bits, and all ones for a stage the access did
+ * not go through.
+ */
+struct CXLLatencyRecord
+{
+    enum Stage
+    {
+        /** Request made to host bridge, the cache misses and buses. */
+        Host,
+        /** Queueing, protocol conversion and link in the bridge. */
+        BridgeReq,
+        /** Flight to the device, through a switch if there is one. */
+        ToDevice,
+        /** Request queue of the device. */
+        DeviceReq,
+        /** Media controller and media. */
+        Media,
+        /** Response queue and link of the device. */
+        DeviceRsp,
+        /** Flight back to the host bridge. */
+        ToHost,
+        /** Response queue of the bridge. */
+        BridgeRsp,
+        NumStages
+    };
+
+    uint64_t addr;
+
+    /** Tick the request reached the host bridge. */
+    uint64_t bridgeIn;
+
+    uint32_t stages[NumStages];
+
+    /** Bit 0 is set for a write. */
+    uint32_t flags;
+
+    /** Zero, pads the record to a multiple of its alignment. */
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CXLLatencyRecord) == 56,
+              "The latency trace records must have no implicit padding.");
+
+} // namespace gem5
+
+#endif //__MEM_CXL_LATENCY_HH__
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * Implementation of a flit-level serialisation model for one direction
+ * of a CXL link.
+ */
+
+#include "mem/cxl_link.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+namespace
+{
+
+/** Size of a flit slot, both 68B and 256B flits use 16B slots. */
+constexpr unsigned slotBits = 128;
+
+/** Size of a cache line carried by M2SRwD and S2MDRS. */
+constexpr unsigned lineBytes = 64;
+
+/**
+ * Serialisation time of one flit on a link of the given width and
+ * rate. Up to 32 GT/s the PHY uses 128b/130b encoding, at 64 GT/s the
+ * 256B flit carries its own CRC and FEC and there is no additional
+ * encoding overhead.
+ */
+Tick
+flitSerialisationTime(unsigned lanes, unsigned gtps, unsigned flit_bytes,
+                      double ticks_per_ns)
+{
+    fatal_if(flit_bytes != 68 && flit_bytes != 256,
+             "CXL flit size must be 68 or 256 bytes, got %d\n", flit_bytes);
+    fatal_if(flit_bytes == 68 && gtps > 32,
+             "68B flits are only defined up to 32 GT/s\n");
+    fatal_if(lanes == 0 || lanes > 16 || !isPowerOf2(lanes),
+             "CXL link width must be x1, x2, x4, x8 or x16, got x%d\n",
+             lanes);
+
+    double wire_bits = flit_bytes * 8.0;
+    if (gtps <= 32)
+        wire_bits = wire_bits * 130 / 128;
+    double ns = wire_bits / (double(lanes) * gtps);
+    return std::max<Tick>(1, std::llround(ns * ticks_per_ns));
+}
+
+} // anonymous namespace
+
+CXLLink::CXLLink(unsigned _lanes, unsigned _gtps, unsigned _flit_bytes,
+                 double _ticks_per_ns)
+    : payloadBits(_flit_bytes == 68 ? 4 * slotBits : 15 * slotBits),
+      flitTicks(flitSerialisationTime(_lanes, _gtps, _flit_bytes,
+                                      _ticks_per_ns)),
+      flitStart(0), nextFree(0), flitUsed(payloadBits), flits(0)
+{
+}
+
+unsigned
+CXLLink::headerBits(MemCmd cmd)
+{
+    // header sizes of the CXL.mem and CXL.cache messages in the 68B
+    // flit slot formats, the 256B formats differ by a handful of bits
+    // only
+    switch (cmd.toInt()) {
+      case MemCmd::M2SReq:
+      case MemCmd::M2SRwD:
+        return 87;
+      case MemCmd::S2MNDR:
+        return 30;
+      case MemCmd::S2MDRS:
+        return 40;
+      case MemCmd::D2HReq:
+        return 79;
+      case MemCmd::D2HRsp:
+        return 20;
+      case MemCmd::D2HData:
+        return 17;
+      case MemCmd::H2DReq:
+        return 72;
+      case MemCmd::H2DRsp:
+        return 32;
+      case MemCmd::H2DData:
+        return 24;
+      case MemCmd::S2MBISnp:
+        return 84;
+      case MemCmd::M2SBIRsp:
+        return 40;
+      default:
+        return slotBits;
+    }
+}
+
+void
+CXLLink::openFlit(Tick ready)
+{
+    flitStart = std::max(ready, nextFree);
+    nextFree = flitStart + flitTicks;
+    // the 68B flit spends the first 32 bits of slot 0 on the flit
+    // header, the 256B flit keeps its header outside the slots
+    flitUsed = payloadBits == 4 * slotBits ? 32 : 0;
+    ++flits;
+}
+
+Tick
+CXLLink::transmit(MemCmd cmd, unsigned data_bytes, Tick ready)
+{
+    const unsigned hdr_bits = headerBits(cmd);
+
+    // a flit that is already on the wire cannot absorb the message,
+    // and headers never straddle two flits
+    if (flitStart < ready || flitUsed + hdr_bits > payloadBits)
+        openFlit(ready);
+    flitUsed += hdr_bits;
+
+    // data always starts on a slot boundary and is sent in whole
+    // slots, possibly rolling over into the next flits
+    unsigned data_bits = divCeil(data_bytes, lineBytes) * lineBytes * 8;
+    if (data_bits)
+        flitUsed = std::min(roundUp(flitUsed, slotBits), payloadBits);
+    while (data_bits > 0) {
+        if (flitUsed == payloadBits)
+            openFlit(ready);
+        unsigned chunk = std::min(data_bits, payloadBits - flitUsed);
+        flitUsed += chunk;
+        data_bits -= chunk;
+    }
+
+    return flitStart + flitTicks;
+}
+
+Tick
+CXLLink::transmit(PacketPtr pkt, Tick ready)
+{
+    const MemCmd cmd = pkt->cxl_cmd;
+    bool has_data = cmd == MemCmd::M2SRwD || cmd == MemCmd::S2MDRS ||
+        cmd == MemCmd::D2HData || cmd == MemCmd::H2DData;
+    return transmit(cmd, has_data ? pkt->getSize() : 0, ready);
+}
+
+} // namespace gem5
@@ -0,0 +1,136 @@
+/**
+ * @file
+ * Declaration of a flit-level serialisation model for one direction
+ * of a CXL link.
+ */
+
+#ifndef __MEM_CXL_LINK_HH__
+#define __MEM_CXL_LINK_HH__
+
+#include <cstdint>
+
+#include "base/types.hh"
+#include "mem/packet.hh"
+#include "sim/core.hh"
+
+namespace gem5
+{
+
+/**
+ * The DevLoad indication of the CXL QoS telemetry, which a CXL memory
+ * device puts in its S2M responses for the host to throttle its
+ * requests by.
+ */
+enum CXLDevLoad : uint8_t
+{
+    CXLLightLoad,
+    CXLOptimalLoad,
+    CXLModerateOverload,
+    CXLSevereOverload,
+    NumCXLDevLoads
+};
+
+/**
+ * The CXL.mem channels that hold their own credits, a request and its
+ * response use the pools of the same index: reads take an M2S Req and
+ * an S2M DRS credit, writes an M2S RwD and an S2M NDR credit.
+ */
+enum CXLMemChannel
+{
+    CXLReqChannel,
+    CXLRwDChannel,
+    NumCXLMemChannels
+};
+
+/** The channel of a request or of its response. */
+inline CXLMemChannel
+cxlChannel(PacketPtr pkt)
+{
+    return pkt->isWrite() ? CXLRwDChannel : CXLReqChannel;
+}
+
+/**
+ * Models the transmitter of one direction (M2S or S2M) of a CXL.mem
+ * link, or (H2D or D2H) of a CXL.cache link. Messages are packed into
+ * flits: headers are packed by bits into the slots of a flit and may
+ * not straddle two flits, while the 64B data payload of M2SRwD,
+ * S2MDRS, D2HData and H2DData is carried in whole slots and
+ * may roll over into the following flits, as the CXL slot formats
+ * allow. A flit that has been assembled but not yet put on the wire
+ * (because the link is still busy serialising earlier flits) keeps
+ * accepting messages, which is how small NDR/Req headers end up
+ * sharing flits under load while an idle link sends partially filled
+ * flits.
+ */
+class CXLLink
+{
+  public:
+
+    /**
+     * Constructor for the CXLLink.
+     *
+     * @param _lanes the link width (x1 to x16)
+     * @param _gtps the per-lane rate in GT/s (32 for PCIe 5, 64 for
+     *        PCIe 6)
+     * @param _flit_bytes the flit size, 68 or 256 bytes
+     * @param _ticks_per_ns the resolution of the simulated time
+     */
+    CXLLink(unsigned _lanes, unsigned _gtps, unsigned _flit_bytes,
+            double _ticks_per_ns=sim_clock::as_float::ns);
+
+    /**
+     * Serialise a message onto the link.
+     *
+     * @param cmd the CXL.mem message class (M2SReq, M2SRwD, S2MNDR,
+     *        S2MDRS, S2MBISnp or M2SBIRsp) or CXL.cache channel (D2HReq, D2HRsp, D2HData,
+     *        H2DReq, H2DRsp or H2DData)
+     * @param data_bytes size of the data payload, zero if none
+     * @param ready tick at which the message is ready to be sent
+     *
+     * @return the tick at which the last flit carrying the message
+     *         has been received on the other side
+     */
+    Tick transmit(MemCmd cmd, unsigned data_bytes, Tick ready);
+
+    /**
+     * Serialise a packet onto the link using its cxl_cmd as the
+     * message class.
+     */
+    Tick transmit(PacketPtr pkt, Tick ready);
+
+    /** Time it takes to serialise one flit. */
+    Tick flitTime() const { return flitTicks; }
+
+    /** Number of flits put on the link so far. */
+    uint64_t flitsSent() const { return flits; }
+
+    /** Header size in bits of a CXL.mem or CXL.cache message. */
+    static unsigned headerBits(MemCmd cmd);
+
+  private:
+
+    /** Open a new flit that starts no earlier than ready. */
+    void openFlit(Tick ready);
+
+    /** Bits available for slots in one flit. */
+    const unsigned payloadBits;
+
+    /** Serialisation time of one flit. */
+    const Tick flitTicks;
+
+    /** Tick at which the most recently opened flit goes on the wire. */
+    Tick flitStart;
+
+    /** Tick at which the link is done with all assembled flits. */
+    Tick nextFree;
+
+    /** Bits already occupied in the most recently opened flit. */
+    unsigned flitUsed;
+
+    /** Counter of the flits sent on the link. */
+    uint64_t flits;
+};
+
+} // namespace gem5
+
+#endif //__MEM_CXL_LINK_HH__
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include "base/gtest/logging.hh"
+#include "mem/cxl_link.hh"
+
+using namespace gem5;
+
+/** One tick per picosecond, the default resolution. */
+constexpr double ticksPerNs = 1000.0;
+
+/** Flit times of a x16 link, see flitSerialisationTime. */
+constexpr Tick flit68 = 1079;  // 544 bits * 130 / 128 at 512 Gb/s
+constexpr Tick flit256 = 2000; // 2048 bits at 1024 Gb/s
+
+/** The header sizes of the CXL.mem messages packed into the flits. */
+TEST(CXLLinkTest, HeaderBits)
+{
+    EXPECT_EQ(CXLLink::headerBits(MemCmd::M2SReq), 87);
+    EXPECT_EQ(CXLLink::headerBits(MemCmd::M2SRwD), 87);
+    EXPECT_EQ(CXLLink::headerBits(MemCmd::S2MNDR), 30);
+    EXPECT_EQ(CXLLink::headerBits(MemCmd::S2MDRS), 40);
+    // anything else takes a whole slot
+    EXPECT_EQ(CXLLink::headerBits(MemCmd::ReadReq), 128);
+}
+
+/** The serialisation time of a flit for the widths, rates and sizes. */
+TEST(CXLLinkTest, FlitTime)
+{
+    EXPECT_EQ(CXLLink(16, 32, 68, ticksPerNs).flitTime(), flit68);
+    EXPECT_EQ(CXLLink(4, 32, 68, ticksPerNs).flitTime(), 4316);
+    EXPECT_EQ(CXLLink(1, 32, 68, ticksPerNs).flitTime(), 17266);
+    EXPECT_EQ(CXLLink(16, 64, 256, ticksPerNs).flitTime(), flit256);
+    EXPECT_EQ(CXLLink(4, 64, 256, ticksPerNs).flitTime(), 8000);
+    // PCIe 5 still pays for the 128b/130b encoding on 256B flits
+    EXPECT_EQ(CXLLink(16, 32, 256, ticksPerNs).flitTime(), 4063);
+    EXPECT_EQ(CXLLink(4, 32, 256, ticksPerNs).flitTime(), 16250);
+}
+
+/** Flit sizes, rates and widths the link does not support. */
+TEST(CXLLinkTest, InvalidConfig)
+{
+    EXPECT_ANY_THROW(CXLLink(16, 32, 128, ticksPerNs));
+    EXPECT_ANY_THROW(CXLLink(16, 64, 68, ticksPerNs));
+    EXPECT_ANY_THROW(CXLLink(0, 32, 68, ticksPerNs));
+    EXPECT_ANY_THROW(CXLLink(6, 32, 68, ticksPerNs));
+    EXPECT_ANY_THROW(CXLLink(32, 32, 68, ticksPerNs));
+}
+
+/**
+ * Messages ready at the same tick share a 68B flit, which has 480 bits
+ * left after its flit header: five 87-bit requests fit, the sixth opens
+ * the next flit.
+ */
+TEST(CXLLinkTest, ReqSharing68)
+{
+    CXLLink link(16, 32, 68, ticksPerNs);
+    for (int i = 0; i < 5; i++)
+        EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), flit68);
+    EXPECT_EQ(link.flitsSent(), 1);
+
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), 2 * flit68);
+    EXPECT_EQ(link.flitsSent(), 2);
+}
+
+/** Sixteen 30-bit NDRs fit in a 68B flit. */
+TEST(CXLLinkTest, NDRSharing68)
+{
+    CXLLink link(16, 32, 68, ticksPerNs);
+    for (int i = 0; i < 16; i++)
+        EXPECT_EQ(link.transmit(MemCmd::S2MNDR, 0, 0), flit68);
+    EXPECT_EQ(link.flitsSent(), 1);
+
+    EXPECT_EQ(link.transmit(MemCmd::S2MNDR, 0, 0), 2 * flit68);
+    EXPECT_EQ(link.flitsSent(), 2);
+}
+
+/**
+ * A 256B flit has 15 slots and no flit header in them, 22 requests fit.
+ */
+TEST(CXLLinkTest, ReqSharing256)
+{
+    CXLLink link(16, 64, 256, ticksPerNs);
+    for (int i = 0; i < 22; i++)
+        EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), flit256);
+    EXPECT_EQ(link.flitsSent(), 1);
+
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), 2 * flit256);
+    EXPECT_EQ(link.flitsSent(), 2);
+}
+
+/**
+ * The data of a DRS starts on the slot after its header and spills
+ * over into the next 68B flit, where the header of the next DRS shares
+ * the slot left after the spilled data.
+ */
+TEST(CXLLinkTest, DataSpill68)
+{
+    CXLLink link(16, 32, 68, ticksPerNs);
+
+    // 32 + 40 header bits, then 3 of the 4 data slots
+    EXPECT_EQ(link.transmit(MemCmd::S2MDRS, 64, 0), 2 * flit68);
+    EXPECT_EQ(link.flitsSent(), 2);
+
+    // the second flit holds the last data slot of the first DRS, the
+    // header of the second, and 2 of its data slots
+    EXPECT_EQ(link.transmit(MemCmd::S2MDRS, 64, 0), 3 * flit68);
+    EXPECT_EQ(link.flitsSent(), 3);
+}
+
+/** A payload larger than a line rolls over into several flits. */
+TEST(CXLLinkTest, LargeData68)
+{
+    CXLLink link(16, 32, 68, ticksPerNs);
+
+    // 3 data slots in the first flit, then 4 + 4 + 4 + 1
+    EXPECT_EQ(link.transmit(MemCmd::M2SRwD, 256, 0), 5 * flit68);
+    EXPECT_EQ(link.flitsSent(), 5);
+
+    // a request still fits after the last data slot
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), 5 * flit68);
+    EXPECT_EQ(link.flitsSent(), 5);
+}
+
+/**
+ * Three RwDs, each a header slot and four data slots, fill a 256B flit
+ * exactly, the fourth goes in the next one.
+ */
+TEST(CXLLinkTest, DataSpill256)
+{
+    CXLLink link(16, 64, 256, ticksPerNs);
+    for (int i = 0; i < 3; i++)
+        EXPECT_EQ(link.transmit(MemCmd::M2SRwD, 64, 0), flit256);
+    EXPECT_EQ(link.flitsSent(), 1);
+
+    EXPECT_EQ(link.transmit(MemCmd::M2SRwD, 64, 0), 2 * flit256);
+    EXPECT_EQ(link.flitsSent(), 2);
+}
+
+/** Headers and data of the different messages share one flit. */
+TEST(CXLLinkTest, MixedSharing68)
+{
+    CXLLink link(16, 32, 68, ticksPerNs);
+
+    // 32 + 87 + 30 bits, the DRS header ends in slot 1, its data takes
+    // slots 2 and 3 and spills two slots into the next flit
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), flit68);
+    EXPECT_EQ(link.transmit(MemCmd::S2MNDR, 0, 0), flit68);
+    EXPECT_EQ(link.transmit(MemCmd::S2MDRS, 64, 0), 2 * flit68);
+    EXPECT_EQ(link.flitsSent(), 2);
+
+    // the two slots left in the second flit take two more requests, a
+    // third does not fit
+    for (int i = 0; i < 2; i++)
+        EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), 2 * flit68);
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), 3 * flit68);
+    EXPECT_EQ(link.flitsSent(), 3);
+}
+
+/**
+ * A message that is ready after the current flit went on the wire
+ * cannot join it, it waits for the link and opens a flit of its own.
+ */
+TEST(CXLLinkTest, LateMessage)
+{
+    CXLLink link(16, 32, 68, ticksPerNs);
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 0), flit68);
+
+    // ready while the first flit is being serialised
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 10), 2 * flit68);
+    EXPECT_EQ(link.flitsSent(), 2);
+
+    // ready at the tick the second flit starts, so it may still join
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, flit68), 2 * flit68);
+    EXPECT_EQ(link.flitsSent(), 2);
+
+    // ready once the link is idle, the flit starts straight away
+    EXPECT_EQ(link.transmit(MemCmd::M2SReq, 0, 10 * flit68),
+              11 * flit68);
+    EXPECT_EQ(link.flitsSent(), 3);
+}
@@ -0,0 +1,550 @@
+/**
+ * @file
+ * Implementation of a CXL switch that fans the CXL.mem traffic of one
+ * or more host root ports out to several CXL devices.
+ */
+
+#include "mem/cxl_switch.hh"
+
+#include <algorithm>
+
+#include "base/cprintf.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CXLSwitch.hh"
+
+namespace gem5
+{
+
+bool
+CXLSwitch::PortBuffers::trySatisfyFunctional(PacketPtr pkt)
+{
+    for (auto &dp : ingress) {
+        if (pkt->trySatisfyFunctional(dp.pkt))
+            return true;
+    }
+    for (auto &dp : egress) {
+        if (pkt->trySatisfyFunctional(dp.pkt))
+            return true;
+    }
+    return false;
+}
+
+CXLSwitch::UpstreamPort::UpstreamPort(const std::string& _name,
+                                      CXLSwitch& _cxlSwitch, PortID _id,
+                                      const CXLLink &_link)
+    : ResponsePort(_name), cxlSwitch(_cxlSwitch),
+      sendEvent([this]{ trySendTiming(); }, _name),
+      id(_id), buffers(_link)
+{
+}
+
+CXLSwitch::DownstreamPort::DownstreamPort(const std::string& _name,
+                                          CXLSwitch& _cxlSwitch,
+                                          PortID _id, const CXLLink &_link)
+    : RequestPort(_name), cxlSwitch(_cxlSwitch),
+      sendEvent([this]{ trySendTiming(); }, _name),
+      id(_id), buffers(_link)
+{
+}
+
+CXLSwitch::CXLSwitch(const Params &p)
+    : ClockedObject(p),
+      portLatency(ticksToCycles(p.port_latency)),
+      ingressDepth(p.ingress_depth), egressDepth(p.egress_depth),
+      arbitration(p.arbitration),
+      arbitrateEvent([this]{ arbitrate(); }, name()),
+      stats(*this)
+{
+    fatal_if(ingressDepth == 0 || egressDepth == 0,
+             "%s: the port buffers need at least one credit.\n", name());
+
+    // all links of the switch run with the same configuration
+    CXLLink link(p.link_lanes, p.link_gen == enums::PCIe6 ? 64 : 32,
+                 p.flit_size);
+
+    for (int i = 0; i < p.port_usp_port_connection_count; ++i) {
+        uspPorts.push_back(new UpstreamPort(
+                    csprintf("%s.usp_port[%d]", name(), i), *this, i, link));
+        uspBuffers.push_back(&uspPorts.back()->buffers);
+    }
+    for (int i = 0; i < p.port_dsp_port_connection_count; ++i) {
+        dspPorts.push_back(new DownstreamPort(
+                    csprintf("%s.dsp_port[%d]", name(), i), *this, i, link));
+        dspBuffers.push_back(&dspPorts.back()->buffers);
+    }
+}
+
+CXLSwitch::~CXLSwitch()
+{
+    for (auto port : uspPorts)
+        delete port;
+    for (auto port : dspPorts)
+        delete port;
+}
+
+CXLSwitch::CXLSwitchStats::CXLSwitchStats(CXLSwitch &_cxlSwitch)
+    : statistics::Group(&_cxlSwitch),
+
+      ADD_STAT(reqPkts, statistics::units::Count::get(),
+               "Number of requests received on the upstream ports"),
+      ADD_STAT(rspPkts, statistics::units::Count::get(),
+               "Number of responses received on the downstream ports"),
+      ADD_STAT(biSnoops, statistics::units::Count::get(),
+               "Number of back-invalidate snoops received on the "
+               "downstream ports"),
+      ADD_STAT(ingressFullEvents, statistics::units::Count::get(),
+               "Number of times a packet was refused for lack of ingress "
+               "credits"),
+      ADD_STAT(holBlockedPkts, statistics::units::Count::get(),
+               "Number of packets queued behind an ingress head waiting "
+               "for a full egress port while their own egress port had "
+               "credits left"),
+      ADD_STAT(arbWait, statistics::units::Tick::get(),
+               "Total time ingress heads waited for an egress credit"),
+      ADD_STAT(arbGrants, statistics::units::Count::get(),
+               "Number of packets granted an egress credit"),
+      ADD_STAT(avgArbWait, statistics::units::Rate<
+                    statistics::units::Tick, statistics::units::Count>::get(),
+               "Average time an ingress head waited for an egress credit",
+               arbWait / arbGrants),
+      ADD_STAT(reqHopLat, statistics::units::Tick::get(),
+               "Time requests spent crossing the switch"),
+      ADD_STAT(rspHopLat, statistics::units::Tick::get(),
+               "Time responses spent crossing the switch"),
+      ADD_STAT(reqEgressLen, statistics::units::Count::get(),
+               "Downstream egress buffer occupancy on grant"),
+      ADD_STAT(rspEgressLen, statistics::units::Count::get(),
+               "Upstream egress buffer occupancy on grant")
+{
+    reqHopLat
+        .init()
+        .flags(statistics::nozero);
+    rspHopLat
+        .init()
+        .flags(statistics::nozero);
+    reqEgressLen
+        .init()
+        .flags(statistics::nozero);
+    rspEgressLen
+        .init()
+        .flags(statistics::nozero);
+}
+
+Port &
+CXLSwitch::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "usp_port" && idx < uspPorts.size())
+        return *uspPorts[idx];
+    else if (if_name == "dsp_port" && idx < dspPorts.size())
+        return *dspPorts[idx];
+    else
+        return ClockedObject::getPort(if_name, idx);
+}
+
+void
+CXLSwitch::init()
+{
+    for (auto port : dspPorts) {
+        if (!port->isConnected())
+            fatal("%s is not connected.\n", port->name());
+        port->ranges = port->getAddrRanges();
+    }
+    for (auto port : uspPorts) {
+        if (!port->isConnected())
+            fatal("%s is not connected.\n", port->name());
+        port->sendRangeChange();
+    }
+}
+
+CXLSwitch::DownstreamPort&
+CXLSwitch::decode(Addr addr) const
+{
+    for (auto port : dspPorts) {
+        for (const auto &range : port->ranges) {
+            if (range.contains(addr))
+                return *port;
+        }
+    }
+    panic("%s: no CXL device claims address %#x.\n", name(), addr);
+}
+
+void
+CXLSwitch::checkHeadOfLine(const PortBuffers &in,
+                           const std::vector<PortBuffers*> &egress,
+                           PortID dest)
+{
+    if (in.ingress.empty())
+        return;
+
+    PortID head_dest = in.ingress.front().dest;
+    if (head_dest != dest &&
+        egress[head_dest]->egress.size() >= egressDepth &&
+        egress[dest]->egress.size() < egressDepth) {
+        stats.holBlockedPkts++;
+    }
+}
+
+bool
+CXLSwitch::UpstreamPort::recvTimingReq(PacketPtr pkt)
+{
+    panic_if(pkt->cacheResponding(), "Should not see packets where cache "
+             "is responding");
+
+    // the sender runs out of credits once the ingress buffer is full,
+    // and it has to wait for the retry once we committed to it
+    if (buffers.retryPending ||
+        buffers.ingress.size() >= cxlSwitch.ingressDepth) {
+        DPRINTF(CXLSwitch, "%s: no ingress credit for %s addr %#x\n",
+                name(), pkt->cmdString(), pkt->getAddr());
+        if (!buffers.retryPending)
+            cxlSwitch.stats.ingressFullEvents++;
+        buffers.retryPending = true;
+        return false;
+    }
+
+    // the port a request enters through tells a pooled device which
+    // host, i.e. which of its logical devices, the request is from
+    pkt->cxl_ld_id = id;
+
+    DownstreamPort &dsp = cxlSwitch.decode(pkt->getAddr());
+    if (pkt->needsResponse()) {
+        assert(cxlSwitch.routeTo.find(pkt->req) == cxlSwitch.routeTo.end());
+        cxlSwitch.routeTo[pkt->req] = id;
+    }
+
+    Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+    Tick ready = cxlSwitch.clockEdge() + receive_delay;
+
+    DPRINTF(CXLSwitch, "%s: %s addr %#x to %s, ready at %d\n", name(),
+            pkt->cmdString(), pkt->getAddr(), dsp.name(), ready);
+
+    cxlSwitch.checkHeadOfLine(buffers, cxlSwitch.dspBuffers, dsp.id);
+    buffers.ingress.emplace_back(pkt, curTick(), ready, dsp.id);
+    cxlSwitch.stats.reqPkts++;
+    cxlSwitch.scheduleArbitration(ready);
+
+    return true;
+}
+
+bool
+CXLSwitch::DownstreamPort::recvTimingResp(PacketPtr pkt)
+{
+    if (buffers.retryPending ||
+        buffers.ingress.size() >= cxlSwitch.ingressDepth) {
+        DPRINTF(CXLSwitch, "%s: no ingress credit for %s addr %#x\n",
+                name(), pkt->cmdString(), pkt->getAddr());
+        if (!buffers.retryPending)
+            cxlSwitch.stats.ingressFullEvents++;
+        buffers.retryPending = true;
+        return false;
+    }
+
+    const auto route_lookup = cxlSwitch.routeTo.find(pkt->req);
+    assert(route_lookup != cxlSwitch.routeTo.end());
+    PortID usp_id = route_lookup->second;
+    cxlSwitch.routeTo.erase(route_lookup);
+
+    Tick receive_delay = pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+    Tick ready = cxlSwitch.clockEdge() + receive_delay;
+
+    DPRINTF(CXLSwitch, "%s: %s addr %#x to %s, ready at %d\n", name(),
+            pkt->cmdString(), pkt->getAddr(),
+            cxlSwitch.uspPorts[usp_id]->name(), ready);
+
+    cxlSwitch.checkHeadOfLine(buffers, cxlSwitch.uspBuffers, usp_id);
+    buffers.ingress.emplace_back(pkt, curTick(), ready, usp_id);
+    cxlSwitch.stats.rspPkts++;
+    cxlSwitch.scheduleArbitration(ready);
+
+    return true;
+}
+
+void
+CXLSwitch::scheduleArbitration(Tick when)
+{
+    when = std::max(when, curTick());
+    if (!arbitrateEvent.scheduled())
+        schedule(arbitrateEvent, when);
+    else if (when < arbitrateEvent.when())
+        reschedule(arbitrateEvent, when);
+}
+
+Tick
+CXLSwitch::grant(const std::vector<PortBuffers*> &ingress,
+                 const std::vector<PortBuffers*> &egress,
+                 statistics::LogHistogram &queue_len)
+{
+    Tick next_ready = MaxTick;
+
+    for (PortID e = 0; e < egress.size(); ++e) {
+        PortBuffers &out = *egress[e];
+
+        while (out.egress.size() < egressDepth) {
+            // pick one of the ingress ports whose head is ready and
+            // routed to this egress port
+            int winner = -1;
+            for (unsigned k = 0; k < ingress.size(); ++k) {
+                unsigned i = k;
+                if (arbitration == CXLSwitchArbitration::RoundRobin)
+                    i = (out.rrNext + k) % ingress.size();
+
+                const auto &in = ingress[i]->ingress;
+                if (in.empty() || in.front().dest != e)
+                    continue;
+                if (in.front().tick > curTick()) {
+                    next_ready = std::min(next_ready, in.front().tick);
+                    continue;
+                }
+
+                if (winner < 0) {
+                    winner = i;
+                    if (arbitration != CXLSwitchArbitration::OldestFirst)
+                        break;
+                } else if (in.front().entry <
+                           ingress[winner]->ingress.front().entry) {
+                    winner = i;
+                }
+            }
+            if (winner < 0)
+                break;
+
+            DeferredPacket dp = ingress[winner]->ingress.front();
+            ingress[winner]->ingress.pop_front();
+            out.rrNext = (winner + 1) % ingress.size();
+
+            stats.arbWait += curTick() - dp.tick;
+            stats.arbGrants++;
+
+            // cross the switch and serialise onto the egress link
+            Tick when = out.link.transmit(dp.pkt, clockEdge(portLatency));
+            out.egress.emplace_back(dp.pkt, dp.entry, when, e);
+            queue_len.sample(out.egress.size());
+        }
+    }
+
+    return next_ready;
+}
+
+void
+CXLSwitch::arbitrate()
+{
+    // requests flow from the upstream to the downstream ports and
+    // responses the other way round
+    Tick next_ready = std::min(
+        grant(uspBuffers, dspBuffers, stats.reqEgressLen),
+        grant(dspBuffers, uspBuffers, stats.rspEgressLen));
+
+    for (auto port : uspPorts) {
+        if (!port->buffers.egress.empty())
+            port->schedSend(port->buffers.egress.front().tick);
+    }
+    for (auto port : dspPorts) {
+        if (!port->buffers.egress.empty())
+            port->schedSend(port->buffers.egress.front().tick);
+    }
+
+    // hand out the ingress credits that were freed
+    for (auto port : uspPorts) {
+        if (port->buffers.retryPending &&
+            port->buffers.ingress.size() < ingressDepth) {
+            port->buffers.retryPending = false;
+            port->sendRetryReq();
+        }
+    }
+    for (auto port : dspPorts) {
+        if (port->buffers.retryPending &&
+            port->buffers.ingress.size() < ingressDepth) {
+            port->buffers.retryPending = false;
+            port->sendRetryResp();
+        }
+    }
+
+    if (next_ready != MaxTick)
+        scheduleArbitration(next_ready);
+}
+
+void
+CXLSwitch::UpstreamPort::schedSend(Tick when)
+{
+    if (!buffers.sendBlocked && !sendEvent.scheduled())
+        cxlSwitch.schedule(sendEvent,
+                           std::max(when, cxlSwitch.clockEdge()));
+}
+
+void
+CXLSwitch::DownstreamPort::schedSend(Tick when)
+{
+    if (!buffers.sendBlocked && !sendEvent.scheduled())
+        cxlSwitch.schedule(sendEvent,
+                           std::max(when, cxlSwitch.clockEdge()));
+}
+
+void
+CXLSwitch::UpstreamPort::trySendTiming()
+{
+    assert(!buffers.egress.empty());
+
+    DeferredPacket resp = buffers.egress.front();
+
+    assert(resp.tick <= curTick());
+
+    if (sendTimingResp(resp.pkt)) {
+        buffers.egress.pop_front();
+        cxlSwitch.stats.rspHopLat.sample(curTick() - resp.entry);
+
+        if (!buffers.egress.empty())
+            schedSend(buffers.egress.front().tick);
+
+        // the freed egress credit may unblock an ingress port
+        cxlSwitch.scheduleArbitration(curTick());
+    } else {
+        buffers.sendBlocked = true;
+    }
+}
+
+void
+CXLSwitch::DownstreamPort::trySendTiming()
+{
+    assert(!buffers.egress.empty());
+
+    DeferredPacket req = buffers.egress.front();
+
+    assert(req.tick <= curTick());
+
+    if (sendTimingReq(req.pkt)) {
+        buffers.egress.pop_front();
+        cxlSwitch.stats.reqHopLat.sample(curTick() - req.entry);
+
+        if (!buffers.egress.empty())
+            schedSend(buffers.egress.front().tick);
+
+        // the freed egress credit may unblock an ingress port
+        cxlSwitch.scheduleArbitration(curTick());
+    } else {
+        buffers.sendBlocked = true;
+    }
+}
+
+void
+CXLSwitch::UpstreamPort::recvRespRetry()
+{
+    buffers.sendBlocked = false;
+    trySendTiming();
+}
+
+void
+CXLSwitch::DownstreamPort::recvReqRetry()
+{
+    buffers.sendBlocked = false;
+    trySendTiming();
+}
+
+void
+CXLSwitch::DownstreamPort::recvTimingSnoopReq(PacketPtr pkt)
+{
+    // a pooled device names the host it snoops by the LD-ID, which
+    // is the index of the USP linked to that host
+    assert(pkt->cxl_ld_id < cxlSwitch.uspPorts.size());
+    UpstreamPort &usp = *cxlSwitch.uspPorts[pkt->cxl_ld_id];
+
+    DPRINTF(CXLSwitch, "%s: %s addr %#x to %s\n", name(),
+            pkt->cmdString(), pkt->getAddr(), usp.name());
+
+    cxlSwitch.stats.biSnoops++;
+    pkt->headerDelay += cxlSwitch.cyclesToTicks(cxlSwitch.portLatency);
+    usp.sendTimingSnoopReq(pkt);
+}
+
+Tick
+CXLSwitch::DownstreamPort::recvAtomicSnoop(PacketPtr pkt)
+{
+    assert(pkt->cxl_ld_id < cxlSwitch.uspPorts.size());
+    cxlSwitch.stats.biSnoops++;
+    return 2 * cxlSwitch.cyclesToTicks(cxlSwitch.portLatency) +
+        cxlSwitch.uspPorts[pkt->cxl_ld_id]->sendAtomicSnoop(pkt);
+}
+
+bool
+CXLSwitch::UpstreamPort::recvTimingSnoopResp(PacketPtr pkt)
+{
+    pkt->headerDelay += cxlSwitch.cyclesToTicks(cxlSwitch.portLatency);
+    return cxlSwitch.decode(pkt->getAddr()).sendTimingSnoopResp(pkt);
+}
+
+void
+CXLSwitch::DownstreamPort::recvRangeChange()
+{
+    ranges = getAddrRanges();
+    for (auto port : cxlSwitch.uspPorts) {
+        if (port->isConnected())
+            port->sendRangeChange();
+    }
+}
+
+Tick
+CXLSwitch::UpstreamPort::recvAtomic(PacketPtr pkt)
+{
+    panic_if(pkt->cacheResponding(), "Should not see packets where cache "
+             "is responding");
+
+    pkt->cxl_ld_id = id;
+
+    // the request and the response both cross the switch
+    return 2 * cxlSwitch.cyclesToTicks(cxlSwitch.portLatency) +
+        cxlSwitch.decode(pkt->getAddr()).sendAtomic(pkt);
+}
+
+Tick
+CXLSwitch::UpstreamPort::recvAtomicBackdoor(
+    PacketPtr pkt, MemBackdoorPtr &backdoor)
+{
+    pkt->cxl_ld_id = id;
+    return 2 * cxlSwitch.cyclesToTicks(cxlSwitch.portLatency) +
+        cxlSwitch.decode(pkt->getAddr()).sendAtomicBackdoor(pkt, backdoor);
+}
+
+void
+CXLSwitch::UpstreamPort::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    // check the packets buffered anywhere in the switch
+    for (auto buffers : cxlSwitch.uspBuffers) {
+        if (buffers->trySatisfyFunctional(pkt)) {
+            pkt->makeResponse();
+            return;
+        }
+    }
+    for (auto buffers : cxlSwitch.dspBuffers) {
+        if (buffers->trySatisfyFunctional(pkt)) {
+            pkt->makeResponse();
+            return;
+        }
+    }
+
+    pkt->popLabel();
+
+    pkt->cxl_ld_id = id;
+    cxlSwitch.decode(pkt->getAddr()).sendFunctional(pkt);
+}
+
+void
+CXLSwitch::UpstreamPort::recvMemBackdoorReq(
+    const MemBackdoorReq &req, MemBackdoorPtr &backdoor)
+{
+    cxlSwitch.decode(req.range().start()).sendMemBackdoorReq(req, backdoor);
+}
+
+AddrRangeList
+CXLSwitch::UpstreamPort::getAddrRanges() const
+{
+    AddrRangeList ranges;
+    for (auto port : cxlSwitch.dspPorts)
+        ranges.insert(ranges.end(), port->ranges.begin(), port->ranges.end());
+    return ranges;
+}
+
+} // namespace gem5
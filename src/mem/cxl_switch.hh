@@ -0,0 +1,297 @@
+/**
+ * @file
+ * Declaration of a CXL switch that fans the CXL.mem traffic of one or
+ * more host root ports out to several CXL devices.
+ */
+
+#ifndef __MEM_CXL_SWITCH_HH__
+#define __MEM_CXL_SWITCH_HH__
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "base/addr_range.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "enums/CXLSwitchArbitration.hh"
+#include "mem/cxl_link.hh"
+#include "mem/port.hh"
+#include "params/CXLSwitch.hh"
+#include "sim/clocked_object.hh"
+
+namespace gem5
+{
+
+/**
+ * A CXL switch with upstream switch ports (USPs) linked to host root
+ * ports and downstream switch ports (DSPs) linked to CXL devices.
+ * Every port has an ingress buffer, whose free entries are the credits
+ * the link partner may use, and an egress buffer. Packets are moved
+ * from the head of an ingress buffer to the egress buffer of the port
+ * they are routed to when that egress buffer has a free entry, the
+ * ingress ports competing for an egress port are arbitrated according
+ * to the configured policy. As the ingress buffers are FIFOs, a packet
+ * that waits for a congested egress port blocks all the packets behind
+ * it, which is the head-of-line blocking of the switch. Requests are
+ * routed by the address ranges of the devices and responses back to
+ * the USP the request came from. Back-invalidate snoops of a device
+ * go to the USP of the logical device they are for, and bypass the
+ * buffers like any snoop does.
+ */
+class CXLSwitch : public ClockedObject
+{
+  protected:
+
+    /**
+     * A deferred packet stores a packet along with the port it is
+     * routed to, the tick it entered the switch and the tick it is
+     * ready for the next step.
+     */
+    class DeferredPacket
+    {
+
+      public:
+
+        const Tick entry;
+        const Tick tick;
+        const PacketPtr pkt;
+        const PortID dest;
+
+        DeferredPacket(PacketPtr _pkt, Tick _entry, Tick _tick,
+                       PortID _dest)
+            : entry(_entry), tick(_tick), pkt(_pkt), dest(_dest)
+        { }
+    };
+
+    /**
+     * The ingress and egress buffers of a switch port together with the
+     * transmitter of its link.
+     */
+    class PortBuffers
+    {
+
+      public:
+
+        PortBuffers(const CXLLink &_link) : link(_link) { }
+
+        /** Packets received on the port, waiting for arbitration. */
+        std::deque<DeferredPacket> ingress;
+
+        /** Packets granted to the port, waiting to be sent. */
+        std::deque<DeferredPacket> egress;
+
+        /** Transmitter of the outgoing direction of the port's link. */
+        CXLLink link;
+
+        /** If we should send a retry when an ingress credit frees up. */
+        bool retryPending = false;
+
+        /** If the egress head was refused and we wait for a retry. */
+        bool sendBlocked = false;
+
+        /** Next ingress port to consider in round-robin arbitration. */
+        unsigned rrNext = 0;
+
+        /**
+         * Check a functional request against the packets in both
+         * buffers.
+         *
+         * @return true if we find a match
+         */
+        bool trySatisfyFunctional(PacketPtr pkt);
+    };
+
+    /**
+     * Upstream switch port, receives requests from a host root port and
+     * sends the responses back.
+     */
+    class UpstreamPort : public ResponsePort
+    {
+
+      private:
+
+        /** The switch to which this port belongs. */
+        CXLSwitch& cxlSwitch;
+
+        /** Handle send event of the egress buffer. */
+        void trySendTiming();
+
+        /** Send event for the egress buffer. */
+        EventFunctionWrapper sendEvent;
+
+      public:
+
+        UpstreamPort(const std::string& _name, CXLSwitch& _cxlSwitch,
+                     PortID _id, const CXLLink &_link);
+
+        /** Index of the port in usp_port. */
+        const PortID id;
+
+        /** Ingress and egress buffers of the port. */
+        PortBuffers buffers;
+
+        /** Schedule a send of the egress head if there is none. */
+        void schedSend(Tick when);
+
+      protected:
+
+        bool recvTimingReq(PacketPtr pkt) override;
+
+        void recvRespRetry() override;
+
+        bool recvTimingSnoopResp(PacketPtr pkt) override;
+
+        Tick recvAtomic(PacketPtr pkt) override;
+
+        Tick recvAtomicBackdoor(
+            PacketPtr pkt, MemBackdoorPtr &backdoor) override;
+
+        void recvFunctional(PacketPtr pkt) override;
+
+        void recvMemBackdoorReq(
+            const MemBackdoorReq &req, MemBackdoorPtr &backdoor) override;
+
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    /**
+     * Downstream switch port, sends requests to a CXL device and
+     * receives its responses.
+     */
+    class DownstreamPort : public RequestPort
+    {
+
+      private:
+
+        /** The switch to which this port belongs. */
+        CXLSwitch& cxlSwitch;
+
+        /** Handle send event of the egress buffer. */
+        void trySendTiming();
+
+        /** Send event for the egress buffer. */
+        EventFunctionWrapper sendEvent;
+
+      public:
+
+        DownstreamPort(const std::string& _name, CXLSwitch& _cxlSwitch,
+                       PortID _id, const CXLLink &_link);
+
+        /** Index of the port in dsp_port. */
+        const PortID id;
+
+        /** Ingress and egress buffers of the port. */
+        PortBuffers buffers;
+
+        /** Address ranges of the device linked to this port. */
+        AddrRangeList ranges;
+
+        /** Schedule a send of the egress head if there is none. */
+        void schedSend(Tick when);
+
+      protected:
+
+        bool recvTimingResp(PacketPtr pkt) override;
+
+        void recvReqRetry() override;
+
+        void recvTimingSnoopReq(PacketPtr pkt) override;
+
+        Tick recvAtomicSnoop(PacketPtr pkt) override;
+
+        void recvRangeChange() override;
+    };
+
+    std::vector<UpstreamPort*> uspPorts;
+    std::vector<DownstreamPort*> dspPorts;
+
+    /** Port-to-port latency of the switch. */
+    const Cycles portLatency;
+
+    /** Credits of the ingress and egress buffers of every port. */
+    const unsigned ingressDepth;
+    const unsigned egressDepth;
+
+    /** Arbitration between ingress ports competing for an egress. */
+    const CXLSwitchArbitration arbitration;
+
+    /** USP each outstanding request came from. */
+    std::unordered_map<RequestPtr, PortID> routeTo;
+
+    /** Find the DSP whose device claims the address. */
+    DownstreamPort& decode(Addr addr) const;
+
+    /**
+     * Move packets from the ingress to the egress buffers while there
+     * are credits left, arbitrating between the ingress ports that
+     * compete for the same egress port.
+     */
+    void arbitrate();
+
+    /** Arbitration event. */
+    EventFunctionWrapper arbitrateEvent;
+
+    /** Run the arbitration no later than the given tick. */
+    void scheduleArbitration(Tick when);
+
+    /**
+     * Grant the egress buffers of one side of the switch to the ingress
+     * buffers of the other side.
+     *
+     * @param ingress the ingress buffers competing for the egress ports
+     * @param egress the egress buffers, indexed by port
+     * @return the earliest tick an ingress head that is not ready yet
+     *         becomes ready, MaxTick if there is none
+     */
+    Tick grant(const std::vector<PortBuffers*> &ingress,
+               const std::vector<PortBuffers*> &egress,
+               statistics::LogHistogram &queue_len);
+
+    /**
+     * Count a packet that is stuck behind the head of its ingress
+     * buffer although its own egress port has credits left.
+     */
+    void checkHeadOfLine(const PortBuffers &in,
+                         const std::vector<PortBuffers*> &egress,
+                         PortID dest);
+
+    std::vector<PortBuffers*> uspBuffers;
+    std::vector<PortBuffers*> dspBuffers;
+
+    struct CXLSwitchStats : public statistics::Group
+    {
+        CXLSwitchStats(CXLSwitch &cxlSwitch);
+
+        statistics::Scalar reqPkts;
+        statistics::Scalar rspPkts;
+        statistics::Scalar biSnoops;
+        statistics::Scalar ingressFullEvents;
+        statistics::Scalar holBlockedPkts;
+        statistics::Scalar arbWait;
+        statistics::Scalar arbGrants;
+        statistics::Formula avgArbWait;
+        statistics::LogHistogram reqHopLat;
+        statistics::LogHistogram rspHopLat;
+        statistics::LogHistogram reqEgressLen;
+        statistics::LogHistogram rspEgressLen;
+    };
+
+    CXLSwitchStats stats;
+
+  public:
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+    void init() override;
+
+    typedef CXLSwitchParams Params;
+
+    CXLSwitch(const Params &p);
+    ~CXLSwitch();
+};
+
+} // namespace gem5
+
+#endif //__MEM_CXL_SWITCH_HH__
@@ -245,7 +245,25 @@ MemCmd::commandInfo[] =
     /* M2SRwd */
     { {IsWrite, IsRequest, NeedsResponse, HasData}, S2MNDR, "M2SRwd"},
     /* S2MNDR */
-    { {IsWrite, IsResponse}, InvalidCmd, "S2MNDR" }
+    { {IsWrite, IsResponse}, InvalidCmd, "S2MNDR" },
+    // for cxl.cache extended
+    /* D2HReq */
+    { {IsRead, IsRequest, NeedsResponse}, H2DData, "D2HReq" },
+    /* H2DData */
+    { {IsRead, IsResponse, HasData}, InvalidCmd, "H2DData" },
+    /* D2HData */
+    { {IsWrite, IsRequest, NeedsResponse, HasData}, H2DRsp, "D2HData" },
+    /* H2DRsp */
+    { {IsWrite, IsResponse}, InvalidCmd, "H2DRsp" },
+    /* H2DReq */
+    { {IsRequest, NeedsResponse}, D2HRsp, "H2DReq" },
+    /* D2HRsp */
+    { {IsResponse}, InvalidCmd, "D2HRsp" },
+    // for cxl.mem back-invalidation
+    /* S2MBISnp */
+    { {IsRequest, NeedsResponse}, M2SBIRsp, "S2MBISnp" },
+    /* M2SBIRsp */
+    { {IsResponse}, InvalidCmd, "M2SBIRsp" }
 };
 
 AddrRange
@@ -157,6 +157,16 @@ class MemCmd
         S2MDRS, // Data Response        (read resp)
         M2SRwD, // Requset with Data    (write)
         S2MNDR, // No Data Response     (write resp)
+        // cxl.cache extended
+        D2HReq,  // Device to Host Request  (read / ownership)
+        H2DData, // Host to Device Data     (read resp)
+        D2HData, // Device to Host Data     (write / evict)
+        H2DRsp,  // Host to Device Response (write resp)
+        H2DReq,  // Host to Device Request  (snoop)
+        D2HRsp,  // Device to Host Response (snoop resp)
+        // cxl.mem back-invalidation (HDM-DB)
+        S2MBISnp, // Back-Invalidate Snoop
+        M2SBIRsp, // Back-Invalidate Response
         NUM_MEM_CMDS
     };
 
@@ -381,6 +391,15 @@ class Packet : public Printable, public Extensible<Packet>
 
     MemCmd cxl_cmd;
 
+    /// The logical device (LD-ID) of a pooled CXL device that the
+    /// packet is destined to, set by the CXL switch port the packet
+    /// entered through.
+    uint8_t cxl_ld_id = 0;
+
+    /// The DevLoad field of an S2M response, the load the CXL device
+    /// reports to the host for QoS telemetry (see CXLDevLoad).
+    uint8_t cxl_dev_load = 0;
+
     const PacketId id;
 
     /// A pointer to the original request.
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * Opcodes of the CXL.cache D2H and H2D request channels and their
+ * mapping from the gem5 classic memory commands.
+ */
+
+#ifndef __MEM_PROTOCOL_CXL_CACHE_HH__
+#define __MEM_PROTOCOL_CXL_CACHE_HH__
+
+#include <cstdint>
+
+#include "mem/packet.hh"
+
+namespace gem5
+{
+
+namespace cxl_cache
+{
+
+/** Opcodes of the D2H request channel. */
+enum D2HReqOpcode : uint8_t
+{
+    RdCurr,
+    RdOwn,
+    RdShared,
+    RdAny,
+    RdOwnNoData,
+    ItoMWr,
+    WrCur,
+    CLFlush,
+    CleanEvict,
+    DirtyEvict,
+    CleanEvictNoData,
+    NumD2HReqOpcodes
+};
+
+/** Opcodes of the H2D request (snoop) channel. */
+enum H2DReqOpcode : uint8_t
+{
+    SnpData,
+    SnpInv,
+    SnpCur,
+    NumH2DReqOpcodes
+};
+
+static constexpr const char *d2hReqNames[NumD2HReqOpcodes] = {
+    "RdCurr", "RdOwn", "RdShared", "RdAny", "RdOwnNoData", "ItoMWr",
+    "WrCur", "CLFlush", "CleanEvict", "DirtyEvict", "CleanEvictNoData"
+};
+
+static constexpr const char *h2dReqNames[NumH2DReqOpcodes] = {
+    "SnpData", "SnpInv", "SnpCur"
+};
+
+/**
+ * The D2H request a device cache issues for a request it sends
+ * towards the host.
+ */
+inline D2HReqOpcode
+d2hReqOpcode(const PacketPtr pkt)
+{
+    switch (pkt->cmd.toInt()) {
+      case MemCmd::ReadSharedReq:
+        return RdShared;
+      case MemCmd::ReadCleanReq:
+        return RdAny;
+      case MemCmd::ReadExReq:
+        return RdOwn;
+      case MemCmd::UpgradeReq:
+      case MemCmd::SCUpgradeReq:
+      case MemCmd::InvalidateReq:
+        return RdOwnNoData;
+      case MemCmd::WriteLineReq:
+        return ItoMWr;
+      case MemCmd::CleanInvalidReq:
+        return CLFlush;
+      case MemCmd::WritebackDirty:
+        return DirtyEvict;
+      case MemCmd::WritebackClean:
+        return CleanEvict;
+      case MemCmd::CleanEvict:
+        return CleanEvictNoData;
+      default:
+        return pkt->isWrite() ? WrCur : RdCurr;
+    }
+}
+
+/** The H2D snoop the host sends for a request it snoops a device for. */
+inline H2DReqOpcode
+h2dReqOpcode(const PacketPtr pkt)
+{
+    if (pkt->needsWritable() || pkt->isInvalidate())
+        return SnpInv;
+    // reads that do not allocate in the requesting cache only need the
+    // current data, all others leave the device with a shared copy
+    return pkt->cmd == MemCmd::ReadReq ? SnpCur : SnpData;
+}
+
+} // namespace cxl_cache
+} // namespace gem5
+
+#endif //__MEM_PROTOCOL_CXL_CACHE_HH__
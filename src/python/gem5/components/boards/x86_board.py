@@ -25,24 +25,57 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+from math import (
+    ceil,
+    log2,
+)
 from typing import (
     List,
+    Optional,
     Sequence,
+    Tuple,
+    Union,
 )
 
 from m5.objects import (
     Addr,
     AddrRange,
     BaseXBar,
+    BDI,
+    BOPPrefetcher,
     Bridge,
+    Cache,
+    CPack,
     CXLBridge,
+    CXLDcoh,
+    CXLDramCache,
+    CXLFlashMemory,
     CXLMemBar,
+    CXLMemory,
+    CXLSwitch,
     CowDiskImage,
+    DRAMInterface,
+    FPC,
+    HeteroMemCtrl,
     IdeDisk,
     IOXBar,
+    MemCtrl,
+    NVMInterface,
     Pc,
     Port,
     RawDiskImage,
+    SignaturePathPrefetcher,
+    SimObject,
+    StridePrefetcher,
+    X86ACPICedt,
+    X86ACPICedtCFMWS,
+    X86ACPIHmat,
+    X86ACPIHmatLocality,
+    X86ACPIHmatProximityDomain,
+    X86ACPISlit,
+    X86ACPISrat,
+    X86ACPISratLAPICAffinity,
+    X86ACPISratMemAffinity,
     X86E820Entry,
     X86FsLinux,
     X86IntelMPBus,
@@ -51,6 +84,7 @@ from m5.objects import (
     X86IntelMPIOIntAssignment,
     X86IntelMPProcessor,
     X86SMBiosBiosInformation,
+    ZeroCompressor,
 )
 from m5.params import Latency
 from m5.util.convert import toMemorySize
@@ -74,15 +108,353 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
     * Much of the I/O subsystem is hard coded.
     """
 
+    # The compressors a CXL device can compress its media with.
+    _cxl_compressors = {
+        "BDI": BDI,
+        "CPack": CPack,
+        "FPC": FPC,
+        "Zero": ZeroCompressor,
+    }
+
+    # The prefetchers a CXL device can read its media ahead with.
+    _cxl_prefetchers = {
+        "Stride": StridePrefetcher,
+        "BOP": BOPPrefetcher,
+        "SPP": SignaturePathPrefetcher,
+    }
+
     def __init__(
         self,
         clk_freq: str,
         processor: AbstractProcessor,
         memory: AbstractMemorySystem,
         cache_hierarchy: AbstractCacheHierarchy,
-        cxl_memory: AbstractMemorySystem,
+        cxl_memory: Union[AbstractMemorySystem, List[AbstractMemorySystem]],
         is_asic: bool,
+        cxl_link_lanes: int = 16,
+        cxl_link_gen: str = "PCIe5",
+        cxl_flit_size: int = 68,
+        cxl_intlv_granularity: int = 4096,
+        cxl_proto_proc_lats: Optional[List[str]] = None,
+        cxl_switch: bool = False,
+        cxl_pool_hosts: int = 1,
+        cxl_dc_block_size: str = "256MiB",
+        cxl_accelerator: Optional[SimObject] = None,
+        cxl_device_cache_size: str = "1MiB",
+        cxl_pool_shared_blocks: int = 0,
+        cxl_snoop_filter_entries: int = 0,
+        cxl_hotness_page_size: Optional[str] = None,
+        cxl_hotness_decay: str = "0ns",
+        cxl_migration_region_size: Optional[str] = None,
+        cxl_migration_interval: str = "100us",
+        cxl_migration_threshold: int = 64,
+        cxl_dram_cache_size: Optional[str] = None,
+        cxl_dram_cache_assoc: int = 1,
+        cxl_dram_cache_tags: str = "Sram",
+        cxl_backdoor_media_latency: str = "0ns",
+        cxl_preload: Sequence[Tuple[str, int]] = (),
+        cxl_latency_breakdown: bool = False,
+        cxl_latency_trace: Optional[str] = None,
+        cxl_scheduler: str = "FIFO",
+        cxl_qos_throttle: bool = False,
+        cxl_numa: bool = True,
+        cxl_compressor: Optional[str] = None,
+        cxl_compression_page_size: Optional[str] = None,
+        cxl_prefetcher: Optional[str] = None,
+        cxl_prefetch_buffer_entries: int = 64,
+        cxl_nmp_buffer_size: Optional[str] = None,
     ) -> None:
+        """
+        :param cxl_memory: The media of the CXL Type-3 device, or a list
+                           with the media of each device. Multiple devices
+                           must be of equal size and are interleaved by
+                           the host bridge HDM decoder, one way per device
+                           (1, 2, 4, 8 or 16 ways). The media may be DRAM,
+                           NVM, DRAM and NVM behind a HeteroMemCtrl, a
+                           SimpleMemory, or CXLFlashMemory.
+        :param cxl_link_lanes: The width of the CXL link (x1 to x16).
+        :param cxl_link_gen: The PCIe generation of the CXL link, either
+                             "PCIe5" (32 GT/s) or "PCIe6" (64 GT/s).
+        :param cxl_flit_size: The CXL flit size in bytes, 68 or 256.
+        :param cxl_intlv_granularity: The HDM interleave granularity in
+                                      bytes, a power of two from 256B to
+                                      16KB.
+        :param cxl_proto_proc_lats: The protocol processing latency of each
+                                    CXL device, defaults to the ASIC or
+                                    FPGA latency for all devices.
+        :param cxl_switch: Put the CXL devices behind a CXL switch linked to
+                           a single root port instead of giving each device
+                           its own root port.
+        :param cxl_pool_hosts: The number of host partitions sharing a single
+                               pooled CXL device through a CXL switch. Each
+                               partition gets its own root port and a window
+                               as large as the device, backed by dynamic
+                               capacity the partitions initially split
+                               evenly; the device mailbox reassigns it.
+        :param cxl_dc_block_size: The dynamic capacity block size of a
+                                  pooled device.
+        :param cxl_accelerator: A requestor with a `port`, e.g. a traffic
+                                generator, that turns the CXL device into a
+                                Type-2 device. Its requests go through a
+                                device-side cache and the device coherency
+                                agent (DCOH), which keeps the cache coherent
+                                with the host over CXL.cache and manages the
+                                bias of the device-attached memory. Needs a
+                                classic cache hierarchy.
+        :param cxl_device_cache_size: The size of the device-side cache of a
+                                      Type-2 device.
+        :param cxl_pool_shared_blocks: The number of dynamic capacity blocks
+                                       of a pooled device that every
+                                       partition maps at the start of its
+                                       window, as memory shared between the
+                                       partitions.
+        :param cxl_snoop_filter_entries: The number of lines the snoop filter
+                                         of each CXL device tracks, which
+                                         makes it an HDM-DB device that
+                                         back-invalidates the host copies of
+                                         the lines it evicts or hands to
+                                         another partition. 0 leaves the
+                                         devices HDM-H.
+        :param cxl_hotness_page_size: The page size at which each CXL device
+                                      counts the accesses to its media, for
+                                      tiering studies. The counters are
+                                      mapped in BAR3 and dumped as the
+                                      pageHotness statistic. None turns the
+                                      tracker off.
+        :param cxl_hotness_decay: The period after which the hotness
+                                  counters are halved, 0 never decays them.
+        :param cxl_migration_region_size: The size of the host DRAM, taken
+                                          from the top of the first memory
+                                          range and hidden from the OS,
+                                          into which the CXL host bridge
+                                          migrates hot pages of the CXL
+                                          memory, at the granularity of the
+                                          hotness tracker (4KiB unless set).
+                                          None turns page migration off.
+        :param cxl_migration_interval: The interval between two rounds of
+                                       page migration.
+        :param cxl_migration_threshold: The number of accesses in an
+                                        interval that make a CXL page a
+                                        candidate for migration.
+        :param cxl_dram_cache_size: The size of the host DRAM, taken from
+                                    the top of the first memory range and
+                                    hidden from the OS, that caches the
+                                    CXL memory as a memory-side cache in
+                                    front of the CXL host bridge. None
+                                    turns the cache off. It cannot be
+                                    combined with page migration or a
+                                    snoop filter.
+        :param cxl_dram_cache_assoc: The associativity of the DRAM cache, 1
+                                     for a direct-mapped cache.
+        :param cxl_dram_cache_tags: Where the tags of the DRAM cache live,
+                                    "Sram" for a tag store in the cache
+                                    controller or "Ecc" for the ECC bits
+                                    of host DRAM next to each line, which
+                                    needs a direct-mapped cache.
+        :param cxl_backdoor_media_latency: The media latency each CXL device
+                                           charges for an atomic access it
+                                           serves straight through the
+                                           backdoor of its media, which
+                                           keeps atomic fast-forwarding
+                                           fast while it still pays the
+                                           CXL latency. 0 sends atomic
+                                           accesses to the media.
+        :param cxl_preload: Host files copied into the CXL memory before
+                            the simulation starts, each with its offset
+                            from the start of the CXL memory, or of the
+                            media of a pooled device. Loading large
+                            datasets this way skips reading them from the
+                            disk image in the simulation.
+        :param cxl_latency_breakdown: Break the latency of every CXL access
+                                      down into the stages of its way from
+                                      the host bridge to the media and
+                                      back, in histograms of the host
+                                      bridge.
+        :param cxl_latency_trace: A file in the output directory the
+                                  breakdown of every access is written to
+                                  in binary, which turns the breakdown on.
+        :param cxl_scheduler: The policy each CXL device picks the next
+                              request for its media with, "FIFO",
+                              "ReadFirst", which sends reads ahead of
+                              writes until the writes pile up, or
+                              "BankAware", which also spreads the
+                              requests over the banks of the media.
+        :param cxl_qos_throttle: Let the host bridge throttle the requests
+                                 to each CXL device by the DevLoad the
+                                 device reports in its responses, as in
+                                 the CXL QoS telemetry, rather than only
+                                 stalling the host once the queues are
+                                 full.
+        :param cxl_numa: Describe the CXL memory to the OS as a NUMA node
+                         without processors in the ACPI SRAT, with its
+                         distance in the SLIT, its latency and bandwidth
+                         in the HMAT, and its window in the CEDT, all
+                         estimated from the configured host bridge, link,
+                         devices and media.
+        :param cxl_compressor: Compress the data of the media of each CXL
+                               device inline with "BDI", "CPack", "FPC"
+                               or "Zero", or None for no compression.
+        :param cxl_compression_page_size: Compress the media in pages of
+                                          this size rather than in lines.
+        :param cxl_prefetcher: Read the media of each CXL device ahead of
+                               the hosts into a prefetch buffer, with the
+                               "Stride", "BOP" or "SPP" prefetcher trained
+                               on the M2S reads, or None for no prefetching.
+        :param cxl_prefetch_buffer_entries: Lines the prefetch buffer of
+                                            each device holds.
+        :param cxl_nmp_buffer_size: Give each CXL device a near-memory
+                                    processing engine, driven through the
+                                    command queue registers in BAR4, that
+                                    works on this much data at a time, or
+                                    None for no engine. It cannot be
+                                    combined with pooling, an
+                                    accelerator, page migration or a DRAM
+                                    cache.
+        """
+        # Both ends of the CXL link serialise flits with the same link
+        # configuration, set up once the board creates the CXL devices.
+        self._cxl_link_params = {
+            "link_lanes": cxl_link_lanes,
+            "link_gen": cxl_link_gen,
+            "flit_size": cxl_flit_size,
+        }
+
+        if not isinstance(cxl_memory, (list, tuple)):
+            cxl_memory = [cxl_memory]
+        num_devs = len(cxl_memory)
+        if num_devs not in [1, 2, 4, 8, 16]:
+            raise ValueError(
+                "The HDM decoder interleaves 1, 2, 4, 8 or 16 CXL devices, "
+                f"got {num_devs}."
+            )
+        if any(m.get_size() != cxl_memory[0].get_size() for m in cxl_memory):
+            raise ValueError("Interleaved CXL devices must be of equal size.")
+        if (
+            cxl_intlv_granularity < 256
+            or cxl_intlv_granularity > 16384
+            or cxl_intlv_granularity & (cxl_intlv_granularity - 1)
+        ):
+            raise ValueError(
+                "The HDM interleave granularity must be a power of two "
+                f"from 256B to 16KB, got {cxl_intlv_granularity}B."
+            )
+        if cxl_proto_proc_lats is not None and len(
+            cxl_proto_proc_lats
+        ) != num_devs:
+            raise ValueError(
+                "Need one protocol processing latency per CXL device."
+            )
+        self._cxl_intlv_granularity = cxl_intlv_granularity
+        self._cxl_proto_proc_lats = cxl_proto_proc_lats
+        if cxl_pool_hosts < 1 or cxl_pool_hosts > 1 and num_devs > 1:
+            raise ValueError(
+                "CXL pooling shares a single CXL device between the hosts."
+            )
+        self._cxl_use_switch = cxl_switch or cxl_pool_hosts > 1
+        self._cxl_pool_hosts = cxl_pool_hosts
+        self._cxl_dc_block_size = toMemorySize(cxl_dc_block_size)
+        if cxl_pool_shared_blocks and cxl_pool_hosts == 1:
+            raise ValueError("Shared CXL memory needs a pooled CXL device.")
+        self._cxl_pool_shared_blocks = cxl_pool_shared_blocks
+        if cxl_snoop_filter_entries and cache_hierarchy.is_ruby():
+            raise ValueError(
+                "Back-invalidation snoops the classic host caches."
+            )
+        self._cxl_snoop_filter_entries = cxl_snoop_filter_entries
+        self._cxl_hotness_page_size = (
+            toMemorySize(cxl_hotness_page_size)
+            if cxl_hotness_page_size is not None
+            else 0
+        )
+        self._cxl_hotness_decay = cxl_hotness_decay
+        self._cxl_migration_region_size = (
+            toMemorySize(cxl_migration_region_size)
+            if cxl_migration_region_size is not None
+            else 0
+        )
+        if self._cxl_migration_region_size:
+            if (
+                cxl_pool_hosts > 1
+                or cxl_accelerator is not None
+                or cache_hierarchy.is_ruby()
+            ):
+                raise ValueError(
+                    "Page migration needs unpooled CXL memory devices and "
+                    "a classic cache hierarchy."
+                )
+            if not self._cxl_hotness_page_size:
+                self._cxl_hotness_page_size = 4096
+            if self._cxl_migration_region_size % self._cxl_hotness_page_size:
+                raise ValueError(
+                    "The migration region must be a multiple of the "
+                    "hotness page size."
+                )
+        self._cxl_migration_interval = cxl_migration_interval
+        self._cxl_migration_threshold = cxl_migration_threshold
+        self._cxl_dram_cache_size = (
+            toMemorySize(cxl_dram_cache_size)
+            if cxl_dram_cache_size is not None
+            else 0
+        )
+        if self._cxl_dram_cache_size and (
+            self._cxl_migration_region_size
+            or cxl_snoop_filter_entries
+            or cache_hierarchy.is_ruby()
+        ):
+            # the lines the DRAM cache holds are unknown to the snoop
+            # filter of the device, and it cannot take its snoops
+            raise ValueError(
+                "The DRAM cache needs a classic cache hierarchy and cannot "
+                "be combined with page migration or a snoop filter."
+            )
+        self._cxl_dram_cache_assoc = cxl_dram_cache_assoc
+        self._cxl_dram_cache_tags = cxl_dram_cache_tags
+        self._cxl_backdoor_media_latency = cxl_backdoor_media_latency
+        self._cxl_preload = list(cxl_preload)
+        self._cxl_latency_breakdown = cxl_latency_breakdown
+        self._cxl_latency_trace = cxl_latency_trace
+        self._cxl_scheduler = cxl_scheduler
+        self._cxl_qos_throttle = cxl_qos_throttle
+        self._cxl_numa = cxl_numa
+        if cxl_compressor and cxl_compressor not in self._cxl_compressors:
+            raise ValueError(
+                f"Unknown CXL compressor {cxl_compressor}, choose one of "
+                f"{', '.join(self._cxl_compressors)}."
+            )
+        self._cxl_compressor = cxl_compressor
+        self._cxl_compression_page_size = cxl_compression_page_size
+        if cxl_prefetcher and cxl_prefetcher not in self._cxl_prefetchers:
+            raise ValueError(
+                f"Unknown CXL prefetcher {cxl_prefetcher}, choose one of "
+                f"{', '.join(self._cxl_prefetchers)}."
+            )
+        self._cxl_prefetcher = cxl_prefetcher
+        self._cxl_prefetch_buffer_entries = cxl_prefetch_buffer_entries
+        if cxl_nmp_buffer_size and (
+            cxl_pool_hosts > 1
+            or cxl_accelerator is not None
+            or self._cxl_migration_region_size
+            or self._cxl_dram_cache_size
+        ):
+            # the engine works on the CXL media, and would miss the lines
+            # a device cache, promoted pages or the DRAM cache hold
+            raise ValueError(
+                "The NMP engine needs an unpooled CXL device without an "
+                "accelerator, page migration or a DRAM cache."
+            )
+        self._cxl_nmp_buffer_size = cxl_nmp_buffer_size
+        if cxl_accelerator is not None and (
+            num_devs > 1 or cxl_pool_hosts > 1 or cache_hierarchy.is_ruby()
+        ):
+            raise ValueError(
+                "A CXL accelerator needs a single, unpooled CXL device and "
+                "a classic cache hierarchy."
+            )
+        self._cxl_accelerator = cxl_accelerator
+        self._cxl_device_cache_size = cxl_device_cache_size
+        # The CXL memory the host OS is told about, as (start, size).
+        self._cxl_host_ranges = []
+
         super().__init__(
             clk_freq=clk_freq,
             processor=processor,
@@ -127,8 +499,21 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
         interrupts_address_space_base = 0xA000000000000000
         APIC_range_size = 1 << 12
 
+        # CXL.mem goes through a dedicated CXL host bridge that is linked
+        # straight to the CXL devices, one root port each, so it does not
+        # contend with PIO, PCI config and DMA traffic on the I/O bus.
+        self.cxl_host_bridge = CXLBridge(bridge_lat="50ns", proto_proc_lat="12ns", req_fifo_depth=128, resp_fifo_depth=128, rwd_fifo_depth=128, ndr_fifo_depth=128,
+                                         **self._cxl_link_params)
+        self.cxl_host_bridge.latency_breakdown = self._cxl_latency_breakdown
+        self.cxl_host_bridge.qos_throttle = self._cxl_qos_throttle
+        if self._cxl_latency_trace is not None:
+            self.cxl_host_bridge.latency_trace = self._cxl_latency_trace
+
         # Setup memory system specific settings.
         if self.get_cache_hierarchy().is_ruby():
+            # The CXL window gets a directory of its own, whose memory
+            # port is the CXL host bridge, see get_mem_ports().
+            self._setup_cxl_devices()
             self.pc.attachIO(self.get_io_bus(), [self.pc.south_bridge.ide.dma, self.pc.south_bridge.cxlmemory.dma])
         else:
             # # Constants similar to x86_traits.hh
@@ -137,13 +522,19 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
             interrupts_address_space_base = 0xA000000000000000
             APIC_range_size = 1 << 12
 
-            # Configure CXLBridge
-            self.bridge = CXLBridge(bridge_lat="50ns", proto_proc_lat="12ns", req_fifo_depth=128, resp_fifo_depth=128)
+            # Non-CXL ranges keep going through a plain bridge onto the
+            # I/O bus. Allow it to pass through:
+            #  1) kernel configured PCI device memory map address: address
+            #     range [0xC0000000, 0xFFFF0000). (The upper 64kB are
+            #     reserved for m5ops.)
+            #  2) everything in the IO address range up to the local APIC,
+            #     and
+            #  3) then the entire PCI address space and beyond.
+            self.bridge = Bridge(delay="50ns")
             self.bridge.mem_side_port = self.get_io_bus().cpu_side_ports
             self.bridge.cpu_side_port = (
                 self.get_cache_hierarchy().get_mem_side_port()
             )
-
             self.bridge.ranges = [
                 AddrRange(0xC0000000, 0xFFFF0000),
                 AddrRange(
@@ -152,31 +543,15 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
                 AddrRange(pci_config_address_space_base, Addr.max),
             ]
 
-            # Configure CXL Device
-            cxl_mem_start = 0x100000000
-            cxl_dram = self.get_cxl_memory()
-            cxl_mem_range = AddrRange(Addr(cxl_mem_start), size=cxl_dram.get_size())
-            self.bridge.ranges.append(cxl_mem_range)
-            self.pc.south_bridge.cxlmemory.cxl_mem_range = cxl_mem_range
-            cxl_dram.set_memory_range([cxl_mem_range])
-            cxl_abstract_mems = []
-            for mc in cxl_dram.get_memory_controllers():
-                cxl_abstract_mems.append(mc.dram)
-            self.memories.extend(cxl_abstract_mems)
-            self.cxl_mem_bus = CXLMemBar()
-            self.cxl_mem_bus.cpu_side_ports = self.pc.south_bridge.cxlmemory.mem_req_port
-            for _, port in cxl_dram.get_mem_ports():
-                self.cxl_mem_bus.mem_side_ports = port
-
-            self.pc.south_bridge.cxlmemory.BAR0.size = cxl_dram.get_size_str()
-            if self._is_asic:
-                self.pc.south_bridge.cxlmemory.proto_proc_lat = Latency("15ns")
-                self.pc.south_bridge.cxlmemory.rsp_size = 48
-                self.pc.south_bridge.cxlmemory.req_size = 48
+            if self._cxl_dram_cache_size:
+                self._setup_cxl_dram_cache()
             else:
-                self.pc.south_bridge.cxlmemory.proto_proc_lat = Latency("60ns")
-                self.pc.south_bridge.cxlmemory.rsp_size = 36
-                self.pc.south_bridge.cxlmemory.req_size = 36
+                self.cxl_host_bridge.cpu_side_port = (
+                    self.get_cache_hierarchy().get_mem_side_port()
+                )
+            self._setup_cxl_devices()
+            if self._cxl_migration_region_size:
+                self._setup_cxl_migration()
 
             self.apicbridge = Bridge(delay="50ns")
             self.apicbridge.cpu_side_port = self.get_io_bus().mem_side_ports
@@ -269,6 +644,12 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
         self.workload.intel_mp_table.base_entries = base_entries
         self.workload.intel_mp_table.ext_entries = ext_entries
 
+        # The OS must not use the host DRAM CXL pages are migrated to, or
+        # that caches the CXL memory
+        reserved_size = (
+            self._cxl_migration_region_size or self._cxl_dram_cache_size
+        )
+        usable_size = self.mem_ranges[0].size() - 0x100000 - reserved_size
         entries = [
             # Mark the first megabyte of memory as reserved
             X86E820Entry(addr=0, size="639kB", range_type=1),
@@ -276,20 +657,492 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
             # Mark the rest of physical memory as available
             X86E820Entry(
                 addr=0x100000,
-                size=f"{self.mem_ranges[0].size() - 0x100000:d}B",
+                size=f"{usable_size:d}B",
                 range_type=1,
             ),
         ]
+        if reserved_size:
+            entries.append(
+                X86E820Entry(
+                    addr=self.mem_ranges[0].end.value - reserved_size,
+                    size=f"{reserved_size}B",
+                    range_type=2,
+                )
+            )
 
         # Reserve the last 16kB of the 32-bit address space for m5ops
         entries.append(
             X86E820Entry(addr=0xFFFF0000, size="64kB", range_type=2)
         )
 
-        entries.append(X86E820Entry(addr=0x100000000, size=f"{cxl_mem_range.size()}B", range_type=1))
+        for start, size in self._cxl_host_ranges:
+            entries.append(
+                X86E820Entry(addr=start, size=f"{size}B", range_type=1)
+            )
 
         self.workload.e820_table.entries = entries
 
+        if self._cxl_numa:
+            self._setup_acpi_numa()
+
+    @staticmethod
+    def _memory_attributes(
+        memory: AbstractMemorySystem,
+    ) -> Optional[Tuple[float, float]]:
+        """Estimates the idle read latency, in seconds, and the peak
+        bandwidth, in bytes per second, of a memory system from the timing
+        of its controllers, or returns None for controllers whose timing
+        is not known.
+        """
+        latency = 0.0
+        bandwidth = 0.0
+        for ctrl in memory.get_memory_controllers():
+            if isinstance(ctrl, MemCtrl):
+                # The interfaces of a hybrid controller share its channel.
+                ctrl_bandwidth = 0.0
+                for intf in X86Board._memory_media(ctrl):
+                    if isinstance(intf, DRAMInterface):
+                        access = intf.tRCD.value + intf.tCL.value
+                    elif isinstance(intf, NVMInterface):
+                        access = intf.tREAD.value + intf.tSEND.value
+                    else:
+                        return None
+                    latency = max(
+                        latency,
+                        ctrl.static_frontend_latency.value
+                        + ctrl.static_backend_latency.value
+                        + access
+                        + intf.tBURST.value,
+                    )
+                    burst = (
+                        int(intf.device_bus_width)
+                        * int(intf.devices_per_rank)
+                        * int(intf.burst_length)
+                        / 8
+                    )
+                    ctrl_bandwidth = max(
+                        ctrl_bandwidth, burst / intf.tBURST.value
+                    )
+                bandwidth += ctrl_bandwidth
+            elif isinstance(ctrl, CXLFlashMemory):
+                # A read that misses the DRAM cache, and the lower of
+                # the cache and the flash channels.
+                latency = max(
+                    latency,
+                    ctrl.read_latency.value
+                    + int(ctrl.page_size) / float(ctrl.channel_bandwidth)
+                    + ctrl.cache_latency.value,
+                )
+                bandwidth += min(
+                    float(ctrl.bandwidth),
+                    int(ctrl.channels) * float(ctrl.channel_bandwidth),
+                )
+            elif hasattr(ctrl, "bandwidth"):
+                latency = max(latency, ctrl.latency.value)
+                bandwidth += float(ctrl.bandwidth)
+            else:
+                return None
+        return latency, bandwidth
+
+    @staticmethod
+    def _memory_media(ctrl: SimObject) -> List[SimObject]:
+        """Returns the abstract memories holding the data of a memory
+        controller: the interfaces of a MemCtrl, or the controller itself
+        for the memories that have none, e.g. a SimpleMemory.
+        """
+        if isinstance(ctrl, HeteroMemCtrl):
+            return [ctrl.dram, ctrl.nvm]
+        if isinstance(ctrl, MemCtrl):
+            return [ctrl.dram]
+        return [ctrl]
+
+    def _setup_acpi_numa(self):
+        """Puts the processors and host DRAM into proximity domain 0, and
+        the CXL memory into proximity domain 1 without processors, so a
+        stock kernel onlines the CXL memory as a NUMA node of its own.
+
+        The latency and bandwidth of the CXL memory add the host bridge,
+        the link, the switch if any, and the devices to those of the
+        media. The bandwidth is the lower of the media and the links.
+        """
+        num_cores = self.get_processor().get_num_cores()
+        bridge = self.cxl_host_bridge
+        cxl_devs = [self.pc.south_bridge.cxlmemory]
+        cxl_devs.extend(getattr(self, "cxl_expanders", []))
+
+        # The bridge and the devices process the request and the response,
+        # and the link carries a flit each way.
+        link_gen = self._cxl_link_params["link_gen"]
+        flit_size = self._cxl_link_params["flit_size"]
+        link_bandwidth = (
+            self._cxl_link_params["link_lanes"]
+            * (64e9 if link_gen == "PCIe6" else 32e9)
+            / 8
+        )
+        cxl_extra = 2 * (
+            bridge.bridge_lat.value
+            + bridge.proto_proc_lat.value
+            + max(dev.proto_proc_lat.value for dev in cxl_devs)
+            + flit_size / link_bandwidth
+        )
+        if self._cxl_use_switch:
+            cxl_extra += 2 * self.cxl_switch.port_latency.value
+        # The slots of a flit, without its header, CRC and FEC, carry data.
+        links = 1 if self._cxl_use_switch else len(cxl_devs)
+        link_bandwidth *= (64 if flit_size == 68 else 240) / flit_size
+
+        host = self._memory_attributes(self.get_memory())
+        media = [self._memory_attributes(m) for m in self.get_cxl_memories()]
+
+        srat_records = [
+            X86ACPISratLAPICAffinity(proximity_domain=0, apic_id=i)
+            for i in range(num_cores)
+        ]
+        srat_records.append(
+            X86ACPISratMemAffinity(
+                proximity_domain=0,
+                base=self.mem_ranges[0].start,
+                size=f"{self.mem_ranges[0].size()}B",
+            )
+        )
+        # The capacity a pooled device hands out later is hot-plugged
+        # anywhere in the window of the partition.
+        num_hosts = self._cxl_pool_hosts
+        window_size = self._cxl_window.size() // num_hosts
+        for start, size in self._cxl_host_ranges:
+            srat_records.append(
+                X86ACPISratMemAffinity(
+                    proximity_domain=1,
+                    base=start,
+                    size=f"{window_size if num_hosts > 1 else size}B",
+                    flags=3 if num_hosts > 1 else 1,
+                )
+            )
+        tables = [X86ACPISrat(records=srat_records)]
+
+        if host is None or None in media:
+            distance = 20
+        else:
+            cxl_latency = max(lat for lat, _ in media) + cxl_extra
+            cxl_bandwidth = min(
+                sum(bw for _, bw in media), links * link_bandwidth
+            )
+            distance = min(max(round(10 * cxl_latency / host[0]), 11), 254)
+
+            # Latencies in ns, in units of 1000ps, and bandwidths in MB/s,
+            # in units that fit the entries into 16 bits.
+            bandwidths = [host[1] / 1e6, cxl_bandwidth / 1e6]
+            bandwidth_unit = max(1, ceil(max(bandwidths) / 0xFFFE))
+            tables.append(
+                X86ACPIHmat(
+                    records=[
+                        X86ACPIHmatProximityDomain(
+                            flags=1, initiator_domain=0, memory_domain=0
+                        ),
+                        X86ACPIHmatProximityDomain(memory_domain=1),
+                        X86ACPIHmatLocality(
+                            data_type=0,
+                            entry_base_unit=1000,
+                            initiator_domains=[0],
+                            target_domains=[0, 1],
+                            entries=[
+                                max(1, round(host[0] * 1e9)),
+                                max(1, round(cxl_latency * 1e9)),
+                            ],
+                        ),
+                        X86ACPIHmatLocality(
+                            data_type=3,
+                            entry_base_unit=bandwidth_unit,
+                            initiator_domains=[0],
+                            target_domains=[0, 1],
+                            entries=[
+                                max(1, round(bw / bandwidth_unit))
+                                for bw in bandwidths
+                            ],
+                        ),
+                    ]
+                )
+            )
+        tables.append(
+            X86ACPISlit(localities=2, distances=[10, distance, distance, 10])
+        )
+
+        # The host bridge, UID 0, decodes the whole window, Type-3 memory
+        # that is volatile and only coherent with the host, unless the
+        # device is a Type-2 accelerator.
+        tables.append(
+            X86ACPICedt(
+                records=[
+                    X86ACPICedtCFMWS(
+                        base=self._cxl_window.start,
+                        size=f"{self._cxl_window.size()}B",
+                        restrictions=(
+                            0x5 if self._cxl_accelerator is not None else 0x6
+                        ),
+                        targets=[0],
+                    )
+                ]
+            )
+        )
+
+        rsdp = self.workload.acpi_description_table_pointer
+        for table in tables:
+            table.oem_id = "gem5"
+            rsdp.rsdt.entries.append(table)
+            rsdp.xsdt.entries.append(table)
+        rsdp.oem_id = "gem5"
+
+    def _setup_cxl_devices(self):
+        """Creates the CXL Type-3 devices, one per CXL memory, and maps
+        them into a single window of host physical memory. With more than
+        one device the window is interleaved across the devices at the
+        HDM decoder granularity, and each device sits behind its own root
+        port and link of the host bridge, or behind a downstream port of a
+        CXL switch that is linked to a single root port.
+
+        A device pooled between host partitions instead has one window per
+        partition, each behind its own root port and upstream switch port,
+        and the media sits above the windows at device physical addresses.
+        """
+        cxl_mems = self.get_cxl_memories()
+        num_devs = len(cxl_mems)
+        num_hosts = self._cxl_pool_hosts
+        cxl_mem_start = 0x100000000
+        cxl_mem_size = sum(m.get_size() for m in cxl_mems)
+        cxl_window = AddrRange(
+            Addr(cxl_mem_start), size=cxl_mem_size * num_hosts
+        )
+        self.cxl_host_bridge.ranges = [cxl_window]
+        self._cxl_window = cxl_window
+        # DMA from I/O devices reaches the CXL range through the I/O
+        # cache and the memory bus, like any other memory.
+        self.mem_ranges.append(cxl_window)
+
+        # The first device is the one on the south bridge, any further
+        # devices go on the same PCI bus.
+        cxl_devs = [self.pc.south_bridge.cxlmemory]
+        if num_devs > 1:
+            self.cxl_expanders = [
+                CXLMemory(pci_func=0, pci_dev=7 + i, pci_bus=0)
+                for i in range(num_devs - 1)
+            ]
+            for dev in self.cxl_expanders:
+                dev.pio = self.get_io_bus().mem_side_ports
+                dev.dma = self.get_io_bus().cpu_side_ports
+            cxl_devs.extend(self.cxl_expanders)
+        self.cxl_mem_bus = [CXLMemBar() for _ in range(num_devs)]
+        if self._cxl_use_switch:
+            self.cxl_switch = CXLSwitch(**self._cxl_link_params)
+            host_windows = [
+                AddrRange(
+                    Addr(cxl_mem_start + i * cxl_mem_size), size=cxl_mem_size
+                )
+                for i in range(num_hosts)
+            ]
+            for _ in host_windows:
+                self.cxl_host_bridge.mem_side_port = (
+                    self.cxl_switch.usp_port
+                )
+            self.cxl_host_bridge.hdm_ranges = host_windows
+
+        intlv_bits = int(log2(num_devs))
+        intlv_low_bit = int(log2(self._cxl_intlv_granularity))
+        hdm_ranges = []
+        for i, (dev, cxl_dram) in enumerate(zip(cxl_devs, cxl_mems)):
+            if intlv_bits:
+                dev_range = AddrRange(
+                    start=cxl_mem_start,
+                    size=cxl_mem_size,
+                    intlvHighBit=intlv_low_bit + intlv_bits - 1,
+                    intlvBits=intlv_bits,
+                    intlvMatch=i,
+                )
+            else:
+                dev_range = cxl_window
+            hdm_ranges.append(dev_range)
+            if self._cxl_use_switch:
+                self.cxl_switch.dsp_port = dev.cxl_rsp_port
+            else:
+                self.cxl_host_bridge.mem_side_port = dev.cxl_rsp_port
+
+            dev.cxl_mem_range = dev_range
+            if num_hosts > 1:
+                # Every partition may get up to the whole device, and
+                # starts out with an even share of its capacity.
+                dc_blocks = cxl_dram.get_size() // self._cxl_dc_block_size
+                shared_blocks = self._cxl_pool_shared_blocks
+                initial_blocks = (dc_blocks - shared_blocks) // num_hosts
+                dpa_range = AddrRange(
+                    Addr(cxl_mem_start + num_hosts * cxl_mem_size),
+                    size=cxl_dram.get_size(),
+                )
+                dev.ld_ranges = host_windows
+                dev.dc_block_size = f"{self._cxl_dc_block_size}B"
+                dev.dpa_range = dpa_range
+                dev.dc_shared_blocks = shared_blocks
+                dev.dc_initial_blocks = [initial_blocks] * num_hosts
+                cxl_dram.set_memory_range([dpa_range])
+                for window in host_windows:
+                    self._cxl_host_ranges.append(
+                        (
+                            window.start.value,
+                            (shared_blocks + initial_blocks)
+                            * self._cxl_dc_block_size,
+                        )
+                    )
+            else:
+                cxl_dram.set_memory_range([dev_range])
+            for mc in cxl_dram.get_memory_controllers():
+                self.memories.extend(self._memory_media(mc))
+            if self._cxl_accelerator is None:
+                self.cxl_mem_bus[i].cpu_side_ports = dev.mem_req_port
+            for _, port in cxl_dram.get_mem_ports():
+                self.cxl_mem_bus[i].mem_side_ports = port
+
+            dev.BAR0.size = f"{cxl_dram.get_size()}B"
+            dev.snoop_filter_entries = self._cxl_snoop_filter_entries
+            dev.backdoor_media_latency = self._cxl_backdoor_media_latency
+            dev.scheduler = self._cxl_scheduler
+            if self._cxl_compressor:
+                dev.compressor = self._cxl_compressors[self._cxl_compressor]()
+                if self._cxl_compression_page_size:
+                    dev.compression_page_size = self._cxl_compression_page_size
+            if self._cxl_prefetcher:
+                dev.prefetcher = self._cxl_prefetchers[self._cxl_prefetcher]()
+                dev.prefetch_buffer_entries = (
+                    self._cxl_prefetch_buffer_entries
+                )
+            if self._cxl_nmp_buffer_size:
+                dev.nmp_buffer_size = self._cxl_nmp_buffer_size
+            # Every way of an interleaved set copies its own chunks.
+            dev.preload_files = [path for path, _ in self._cxl_preload]
+            dev.preload_offsets = [off for _, off in self._cxl_preload]
+            if self._cxl_hotness_page_size:
+                # The counters follow the registers in BAR3, whose size
+                # has to be a power of two.
+                pages = -(-cxl_dram.get_size() // self._cxl_hotness_page_size)
+                bar_size = 1 << (0x40 + 4 * pages - 1).bit_length()
+                dev.hotness_page_size = f"{self._cxl_hotness_page_size}B"
+                dev.hotness_decay = self._cxl_hotness_decay
+                dev.BAR3.size = f"{max(bar_size, 4096)}B"
+            for param, value in self._cxl_link_params.items():
+                setattr(dev, param, value)
+            if self._is_asic:
+                dev.proto_proc_lat = Latency("15ns")
+                dev.rsp_size = 48
+                dev.req_size = 48
+                dev.ndr_size = 48
+                dev.rwd_size = 48
+            else:
+                dev.proto_proc_lat = Latency("60ns")
+                dev.rsp_size = 36
+                dev.req_size = 36
+                dev.ndr_size = 36
+                dev.rwd_size = 36
+            if self._cxl_proto_proc_lats is not None:
+                dev.proto_proc_lat = Latency(self._cxl_proto_proc_lats[i])
+        if not self._cxl_use_switch:
+            self.cxl_host_bridge.hdm_ranges = hdm_ranges
+            # A request holds a response slot of the device until its
+            # response, so the root ports hand out the reads and the
+            # writes the credits of the device, each on its own.
+            self.cxl_host_bridge.m2s_req_credits = cxl_devs[0].rsp_size
+            self.cxl_host_bridge.m2s_rwd_credits = cxl_devs[0].ndr_size
+        if num_hosts == 1:
+            self._cxl_host_ranges.append((cxl_mem_start, cxl_mem_size))
+        if self._cxl_accelerator is not None:
+            self._setup_cxl_accelerator(cxl_devs[0], cxl_window)
+
+    def _reserve_host_dram(self, size: int) -> AddrRange:
+        """The range of the given size at the top of the first host memory
+        range, which the E820 map hides from the OS.
+        """
+        if size >= self.mem_ranges[0].size() - 0x100000:
+            raise ValueError("The reserved host DRAM does not fit.")
+        return AddrRange(Addr(self.mem_ranges[0].end.value - size), size=size)
+
+    def _setup_cxl_dram_cache(self):
+        """Puts a memory-side cache between the memory bus and the CXL host
+        bridge, whose data array is a region at the top of the first host
+        memory range that it reaches through the memory bus.
+        """
+        self.cxl_dram_cache = CXLDramCache(
+            dram_region=self._reserve_host_dram(self._cxl_dram_cache_size),
+            assoc=self._cxl_dram_cache_assoc,
+            tags=self._cxl_dram_cache_tags,
+        )
+        self.cxl_dram_cache.cpu_side_port = (
+            self.get_cache_hierarchy().get_mem_side_port()
+        )
+        self.cxl_dram_cache.cxl_side_port = self.cxl_host_bridge.cpu_side_port
+        self.cxl_dram_cache.dram_port = (
+            self.get_cache_hierarchy().get_cpu_side_port()
+        )
+
+    def _setup_cxl_migration(self):
+        """Lets the CXL host bridge migrate hot pages of the CXL devices
+        into a region at the top of the first host memory range, which it
+        reaches through the host's memory bus. The hotness counters of the
+        devices pick the pages.
+        """
+        bridge = self.cxl_host_bridge
+        bridge.migration_region = self._reserve_host_dram(
+            self._cxl_migration_region_size
+        )
+        bridge.migration_page_size = f"{self._cxl_hotness_page_size}B"
+        bridge.migration_interval = self._cxl_migration_interval
+        bridge.migration_threshold = self._cxl_migration_threshold
+        bridge.migration_sources = [self.pc.south_bridge.cxlmemory] + list(
+            getattr(self, "cxl_expanders", [])
+        )
+        bridge.dram_port = self.get_cache_hierarchy().get_cpu_side_port()
+
+    def _setup_cxl_accelerator(self, dev: CXLMemory, hdm_range: AddrRange):
+        """Turns a CXL device into a Type-2 device with an accelerator.
+        The accelerator sits behind a device-side cache and the DCOH, which
+        joins the host's coherent memory bus over CXL.cache and sits in
+        front of the device-attached memory, where it sees the host's
+        CXL.mem accesses.
+        """
+        self.cxl_accelerator = self._cxl_accelerator
+        self.cxl_dev_cache = Cache(
+            size=self._cxl_device_cache_size,
+            assoc=8,
+            tag_latency=2,
+            data_latency=2,
+            response_latency=2,
+            mshrs=16,
+            tgts_per_mshr=20,
+            writeback_clean=False,
+        )
+        self.cxl_dcoh = CXLDcoh(hdm_range=hdm_range, **self._cxl_link_params)
+
+        self.cxl_accelerator.port = self.cxl_dev_cache.cpu_side
+        self.cxl_dev_cache.mem_side = self.cxl_dcoh.cpu_side_port
+        self.cxl_dcoh.host_port = self.get_cache_hierarchy().get_cpu_side_port()
+
+        # Put the DCOH between the device controller and its memory.
+        self.cxl_dcoh.hdm_port = dev.mem_req_port
+        self.cxl_dcoh.mem_side_port = self.cxl_mem_bus[0].cpu_side_ports
+
+    def get_cxl_memories(self) -> List[AbstractMemorySystem]:
+        """Get the media of each of the CXL devices on this board."""
+        cxl_memory = self.get_cxl_memory()
+        if isinstance(cxl_memory, AbstractMemorySystem):
+            return [cxl_memory]
+        return list(cxl_memory)
+
+    @overrides(AbstractSystemBoard)
+    def get_mem_ports(self) -> Sequence[Tuple[AddrRange, Port]]:
+        mem_ports = list(self.get_memory().get_mem_ports())
+        if self.get_cache_hierarchy().is_ruby():
+            # A Ruby directory serves the CXL window like any other memory,
+            # its requests take the CXL host bridge and links to the media.
+            mem_ports.append(
+                (self._cxl_window, self.cxl_host_bridge.cpu_side_port)
+            )
+        return mem_ports
+
     @overrides(AbstractSystemBoard)
     def has_io_bus(self) -> bool:
         return True
@@ -327,7 +1180,7 @@ class X86Board(AbstractSystemBoard, KernelDiskWorkload):
         memory.set_memory_range([data_range])
         cpu_abstract_mems = []
         for mc in memory.get_memory_controllers():
-            cpu_abstract_mems.append(mc.dram)
+            cpu_abstract_mems.extend(self._memory_media(mc))
         self.memories = cpu_abstract_mems
         # Add the address range for the IO
         self.mem_ranges = [
@@ -46,7 +46,13 @@ class SimpleDirectory(AbstractNode):
         network: RubyNetwork,
         cache_line_size: int,
         clk_domain: ClockDomain,
+        enable_dmt: bool = True,
     ):
+        """
+        :param enable_dmt: If the memory controllers (SNF) send the data of
+                           a read straight to the requestor (direct memory
+                           transfer) rather than through the home node.
+        """
         super().__init__(network, cache_line_size)
 
         # Dummy cache
@@ -65,7 +71,7 @@ class SimpleDirectory(AbstractNode):
 
         # Set up home node that allows three hop protocols
         self.is_HN = True
-        self.enable_DMT = True
+        self.enable_DMT = enable_dmt
         self.enable_DCT = True
 
         # "Owned state"
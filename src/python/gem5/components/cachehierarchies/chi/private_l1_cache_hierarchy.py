@@ -64,18 +64,28 @@ class PrivateL1CacheHierarchy(AbstractRubyCacheHierarchy):
     and as many memory controllers (SNF) as memory channels. The directory does
     not have an associated cache.
 
+    A board that exposes CXL memory as a memory port gets a memory controller
+    for it as well, a subordinate node whose accesses go through the CXL host
+    bridge, which turns them into CXL.mem M2S requests and S2M responses on
+    the CXL link. With direct memory transfer (DMT) the data of a read goes
+    from the memory controller straight to the requestor, without it the
+    data is forwarded by the directory, which costs another network hop.
+
     The network is a simple point-to-point between all of the controllers.
     """
 
-    def __init__(self, size: str, assoc: int) -> None:
+    def __init__(self, size: str, assoc: int, enable_dmt: bool = True) -> None:
         """
         :param size: The size of the priavte I/D caches in the hierarchy.
         :param assoc: The associativity of each cache.
+        :param enable_dmt: If the directory lets the memory controllers send
+                           read data straight to the requestor.
         """
         super().__init__()
 
         self._size = size
         self._assoc = assoc
+        self._enable_dmt = enable_dmt
 
     @overrides(AbstractCacheHierarchy)
     def incorporate_cache(self, board: AbstractBoard) -> None:
@@ -96,6 +106,7 @@ class PrivateL1CacheHierarchy(AbstractRubyCacheHierarchy):
             self.ruby_system.network,
             cache_line_size=board.get_cache_line_size(),
             clk_domain=board.get_clock_domain(),
+            enable_dmt=self._enable_dmt,
         )
         self.directory.ruby_system = self.ruby_system
 
@@ -24,7 +24,9 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+from .flash import FlashMemory
 from .hbm import HBM2Stack
+from .hetero import HeteroMemory
 from .multi_channel import (
     DualChannelDDR3_1600,
     DualChannelDDR3_2133,
@@ -40,6 +42,7 @@ from .single_channel import (
     SingleChannelDDR4_2400,
     SingleChannelHBM,
     SingleChannelLPDDR3_1600,
+    SingleChannelNVM_2400,
 )
 
 try:
@@ -0,0 +1,122 @@
+# Copyright (c) 2021 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""A DRAM and an NVM channel behind a single hybrid memory controller
+"""
+
+from typing import (
+    List,
+    Optional,
+    Sequence,
+    Tuple,
+    Type,
+)
+
+from m5.objects import (
+    AddrRange,
+    DRAMInterface,
+    HeteroMemCtrl,
+    MemCtrl,
+    NVM_2400_1x64,
+    NVMInterface,
+    Port,
+)
+from m5.util.convert import toMemorySize
+
+from ...utils.override import overrides
+from ..boards.abstract_board import AbstractBoard
+from .abstract_memory_system import AbstractMemorySystem
+from .dram_interfaces.ddr4 import DDR4_2400_8x8
+
+
+class HeteroMemory(AbstractMemorySystem):
+    """A memory system of a DRAM interface and an NVM interface sharing
+    the channel of a HeteroMemCtrl. The DRAM takes the lower part of the
+    memory range and the NVM the upper part.
+    """
+
+    def __init__(
+        self,
+        dram_size: str,
+        nvm_size: str,
+        dram_interface_class: Type[DRAMInterface] = DDR4_2400_8x8,
+        nvm_interface_class: Type[NVMInterface] = NVM_2400_1x64,
+    ) -> None:
+        """
+        :param dram_size: Size of the DRAM part of the memory.
+        :param nvm_size: Size of the NVM part of the memory.
+        :param dram_interface_class: The DRAM interface type.
+        :param nvm_interface_class: The NVM interface type.
+        """
+        super().__init__()
+        self._dram_size = toMemorySize(dram_size)
+        self._nvm_size = toMemorySize(nvm_size)
+        self.mem_ctrl = HeteroMemCtrl(
+            dram=dram_interface_class(), nvm=nvm_interface_class()
+        )
+
+    @overrides(AbstractMemorySystem)
+    def incorporate_memory(self, board: AbstractBoard) -> None:
+        pass
+
+    @overrides(AbstractMemorySystem)
+    def get_mem_ports(self) -> Sequence[Tuple[AddrRange, Port]]:
+        # The controller has a single port for both ranges.
+        return [(self.mem_ctrl.dram.range, self.mem_ctrl.port)]
+
+    @overrides(AbstractMemorySystem)
+    def get_memory_controllers(self) -> List[MemCtrl]:
+        return [self.mem_ctrl]
+
+    @overrides(AbstractMemorySystem)
+    def get_size(self) -> int:
+        return self._dram_size + self._nvm_size
+
+    @overrides(AbstractMemorySystem)
+    def set_memory_range(self, ranges: List[AddrRange]) -> None:
+        if len(ranges) != 1 or ranges[0].size() != self.get_size():
+            raise Exception(
+                "Hybrid memory requires a single range which matches the "
+                "memory's size."
+            )
+        # The range may be interleaved with other memories, then both
+        # parts are interleaved the same way.
+        mem_range = ranges[0]
+        split = int(mem_range.start) + (
+            self._dram_size << int(mem_range.intlvBits)
+        )
+        self.mem_ctrl.dram.range = AddrRange(
+            start=mem_range.start,
+            end=split,
+            masks=mem_range.masks,
+            intlvMatch=mem_range.intlvMatch,
+        )
+        self.mem_ctrl.nvm.range = AddrRange(
+            start=split,
+            end=mem_range.end,
+            masks=mem_range.masks,
+            intlvMatch=mem_range.intlvMatch,
+        )
@@ -157,15 +157,30 @@ class ChanneledMemory(AbstractMemorySystem):
                 "RoRaBaChCo, RoRaBaCoCh, RoCoRaBaCh"
             )
 
-        intlv_bits = log(self._num_channels, 2)
+        intlv_bits = int(log(self._num_channels, 2))
+
+        # The range may already be interleaved, e.g. when this memory is
+        # one of several CXL devices behind an interleaving HDM decoder.
+        # Keep those bits and interleave the channels on the lowest free
+        # bits from intlv_low_bit upwards.
+        range_masks = list(self._mem_range.masks)
+        used_bits = 0
+        for mask in range_masks:
+            used_bits |= mask
+        channel_masks = []
+        bit = int(intlv_low_bit)
+        while len(channel_masks) < intlv_bits:
+            if not used_bits & (1 << bit):
+                channel_masks.append(1 << bit)
+            bit += 1
+
         for i, ctrl in enumerate(self.mem_ctrl):
             ctrl.dram.range = AddrRange(
                 start=self._mem_range.start,
-                size=self._mem_range.size(),
-                intlvHighBit=intlv_low_bit + intlv_bits - 1,
-                xorHighBit=0,
-                intlvBits=intlv_bits,
-                intlvMatch=i,
+                end=self._mem_range.end,
+                masks=range_masks + channel_masks,
+                intlvMatch=self._mem_range.intlvMatch
+                | (i << len(range_masks)),
             )
 
     @overrides(AbstractMemorySystem)
@@ -26,6 +26,8 @@
 
 from typing import Optional
 
+from m5.objects import NVM_2400_1x64
+
 from .abstract_memory_system import AbstractMemorySystem
 from .dram_interfaces.ddr3 import (
     DDR3_1600_8x8,
@@ -120,3 +122,12 @@ def DIMM_DDR5_8400(
     A single DIMM of DDR5 has two channels.
     """
     return ChanneledMemory(DDR5_8400_4x8, 2, 64, size=size)
+
+
+def SingleChannelNVM_2400(
+    size: Optional[str] = None,
+) -> AbstractMemorySystem:
+    """
+    A single channel of PCM-like NVM behind a MemCtrl.
+    """
+    return ChanneledMemory(NVM_2400_1x64, 1, 64, size=size)
@@ -39,6 +39,7 @@ from .simstat import SimStat
 from .statistic import (
     Accumulator,
     Distribution,
+    LogHistogram,
     Scalar,
     Statistic,
 )
@@ -74,6 +75,10 @@ class JsonLoader(json.JSONDecoder):
                 d.pop("type", None)
                 return Distribution(**d)
 
+            elif d["type"] == "LogHistogram":
+                d.pop("type", None)
+                return LogHistogram(**d)
+
             elif d["type"] == "Accumulator":
                 d.pop("type", None)
                 return Accumulator(**d)
@@ -87,6 +87,8 @@ class SerializableStat:
             return value.replace(microsecond=0).isoformat()
         elif isinstance(value, list):
             return [self.__process_json_value(v) for v in value]
+        elif isinstance(value, dict):
+            return {k: self.__process_json_value(v) for k, v in value.items()}
         elif isinstance(value, StorageType):
             return str(value.name)
 
@@ -27,6 +27,7 @@
 from abc import ABC
 from typing import (
     Any,
+    Dict,
     Iterable,
     List,
     Optional,
@@ -194,6 +195,60 @@ class Distribution(BaseScalarVector):
         assert self.num_bins >= 1
 
 
+class LogHistogram(BaseScalarVector):
+    """
+    A statistic type that stores a log-linear histogram. Every power of two
+    is split into buckets of equal size, and only the buckets that were
+    sampled are kept: ``value[i]`` is the count of the bucket that holds the
+    values from ``low[i]`` to ``high[i]``. The percentiles are estimated
+    from the buckets, and are NaN if nothing was sampled.
+    """
+
+    low: List[Union[float, int]]
+    high: List[Union[float, int]]
+    min: Union[float, int]
+    max: Union[float, int]
+    samples: int
+    sum: Optional[int]
+    sum_squared: Optional[int]
+    percentiles: Dict[str, float]
+
+    def __init__(
+        self,
+        value: Iterable[int],
+        low: Iterable[Union[float, int]],
+        high: Iterable[Union[float, int]],
+        min: Union[float, int],
+        max: Union[float, int],
+        samples: int,
+        sum: Optional[int] = None,
+        sum_squared: Optional[int] = None,
+        percentiles: Optional[Dict[str, float]] = None,
+        unit: Optional[str] = None,
+        description: Optional[str] = None,
+        datatype: Optional[StorageType] = None,
+    ):
+        super().__init__(
+            value=value,
+            type="LogHistogram",
+            unit=unit,
+            description=description,
+            datatype=datatype,
+        )
+
+        self.low = list(low)
+        self.high = list(high)
+        self.min = min
+        self.max = max
+        self.samples = samples
+        self.sum = sum
+        self.sum_squared = sum_squared
+        self.percentiles = dict(percentiles or {})
+
+        assert len(self.low) == len(self.value)
+        assert len(self.high) == len(self.value)
+
+
 class Accumulator(BaseScalarVector):
     """
     A statistical type representing an accumulator.
@@ -128,6 +128,8 @@ def __get_statistic(statistic: _m5.stats.Info) -> Optional[Statistic]:
         return __get_scaler(statistic)
     elif isinstance(statistic, _m5.stats.DistInfo):
         return __get_distribution(statistic)
+    elif isinstance(statistic, _m5.stats.LogHistInfo):
+        return __get_log_histogram(statistic)
     elif isinstance(statistic, _m5.stats.FormulaInfo):
         # We don't do anything with Formula's right now.
         # We may never do so, see https://gem5.atlassian.net/browse/GEM5-868.
@@ -183,6 +185,26 @@ def __get_distribution(statistic: _m5.stats.DistInfo) -> Distribution:
     )
 
 
+def __get_log_histogram(statistic: _m5.stats.LogHistInfo) -> LogHistogram:
+    # LogHistInfo uses the C++ `double`.
+    datatype = StorageType["f64"]
+
+    return LogHistogram(
+        value=statistic.values,
+        low=statistic.low,
+        high=statistic.high,
+        min=statistic.min_val,
+        max=statistic.max_val,
+        samples=statistic.samples,
+        sum=statistic.sum,
+        sum_squared=statistic.squares,
+        percentiles=dict(statistic.percentiles),
+        unit=statistic.unit,
+        description=statistic.desc,
+        datatype=datatype,
+    )
+
+
 def __get_vector(statistic: _m5.stats.VectorInfo) -> Vector:
     to_add = dict()
 
@@ -77,6 +77,7 @@ cast_stat_info(const statistics::Info *info)
     TRY_CAST(statistics::FormulaInfo);
     TRY_CAST(statistics::VectorInfo);
     TRY_CAST(statistics::DistInfo);
+    TRY_CAST(statistics::LogHistInfo);
 
     return py::cast(info);
 
@@ -216,6 +217,43 @@ pybind_init_stats(py::module_ &m_native)
             [](const statistics::DistInfo &info) { return info.data.squares; })
         ;
 
+    py::class_<statistics::LogHistInfo, statistics::Info,
+                std::unique_ptr<statistics::LogHistInfo, py::nodelete>>(
+                    m, "LogHistInfo")
+        .def_property_readonly("min_val",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.min_val;
+            })
+        .def_property_readonly("max_val",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.max_val;
+            })
+        .def_property_readonly("low",
+            [](const statistics::LogHistInfo &info) { return info.data.low; })
+        .def_property_readonly("high",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.high;
+            })
+        .def_property_readonly("values",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.cvec;
+            })
+        .def_property_readonly("sum",
+            [](const statistics::LogHistInfo &info) { return info.data.sum; })
+        .def_property_readonly("squares",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.squares;
+            })
+        .def_property_readonly("samples",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.samples;
+            })
+        .def_property_readonly("percentiles",
+            [](const statistics::LogHistInfo &info) {
+                return info.data.percentiles;
+            })
+        ;
+
     py::class_<statistics::Group,
         std::unique_ptr<statistics::Group, py::nodelete>>(m, "Group")
         .def("regStats", &statistics::Group::regStats)